@@ -121,6 +121,11 @@ typedef enum RFSessionParams
     RF_ENCODER_BLOCKING_READ          = 0x1015,
     RF_MOUSE_DATA                     = 0x1016,
     RF_DESKTOP_INTERNAL_DSP_ID        = 0x1017,
+    RF_HOST_MEMORY                    = 0x1018,
+    // Number of frames that can be in flight before rfEncodeFrame returns RF_STATUS_QUEUE_FULL. Range 2 - 16, default 3.
+    RF_PIPELINE_DEPTH                 = 0x1019,
+    // Maximum number of render targets that can be registered. Range 1 - 16, default 3.
+    RF_MAX_RENDER_TARGETS             = 0x101A,
 } RFSessionParams;
 
 
@@ -162,6 +167,46 @@ typedef enum RFEncoderParams
     RF_DIFF_ENCODER_BLOCK_S              	= 0x1154,
     RF_DIFF_ENCODER_BLOCK_T                	= 0x1155,
     RF_DIFF_ENCODER_LOCK_BUFFER             = 0x1156,
+    RF_DIFF_ENCODER_FUSED_CSC               = 0x1157,
+    RF_DIFF_ENCODER_HOST_DIFF               = 0x1158,
+    // The output contains the diff map followed by two coarser maps. Each entry of a coarser map is the maximum of
+    // 4x4 entries of the previous map, e.g. the maps cover 16x16, 64x64 and 256x256 pixels with 16x16 blocks.
+    RF_DIFF_ENCODER_PYRAMID                 = 0x1159,
+    RF_DIFF_ENCODER_OUTPUT_MODE             = 0x115A,
+    // Number of tiles the client of the tile cache encoder can store.
+    RF_TILE_CACHE_SLOTS                     = 0x115B,
+    // The diff map is preceded by an RFDiffCopyRect that describes a vertical or horizontal shift of the changed region.
+    RF_DIFF_ENCODER_SCROLL_DETECT           = 0x115C,
+    // A block is only marked as changed if the sum of absolute differences of its channels exceeds this value.
+    RF_DIFF_ENCODER_THRESHOLD               = 0x115D,
+    // Changed blocks store the mean absolute difference of their channels [1, 255] instead of 1.
+    RF_DIFF_ENCODER_MAGNITUDE               = 0x115E,
+    // Time in ms rfEncodeFrame waits for the application to retrieve a diff map if all buffers are in use (default 5).
+    // 0 returns RF_STATUS_QUEUE_FULL immediately.
+    RF_DIFF_ENCODER_QUEUE_TIMEOUT           = 0x115F,
+    // Number of diff maps that can be pending. Has to be smaller than RF_PIPELINE_DEPTH, 0 uses RF_PIPELINE_DEPTH - 1.
+    RF_DIFF_ENCODER_NUM_BUFFERS             = 0x1160,
+    // The identity encoder returns RGBA frames XORed with the previous frame and compacted on the GPU. The output starts
+    // with its size in bytes and a key frame flag, followed by a bitmap with one bit per chunk of 32 pixels that is set if
+    // the chunk changed. Each changed chunk stores a 32 bit mask of its changed pixels followed by their XORed values.
+    // Key frames are XORed with a frame of zeros. At most RF_PIPELINE_DEPTH - 1 frames can be pending.
+    RF_IDENTITY_ENCODER_COMPACT             = 0x1161,
+    // The session compresses the output of the identity and difference encoders on the CPU. The output is split into
+    // chunks of RF_OUTPUT_COMPRESSION_CHUNK_SIZE bytes that are compressed into LZ4 blocks by RF_OUTPUT_COMPRESSION_THREADS
+    // threads, 0 uses all hardware threads. rfGetEncodedFrame returns the chunk table described by RFCompressedChunk.
+    RF_OUTPUT_COMPRESSION                   = 0x1162,
+    RF_OUTPUT_COMPRESSION_CHUNK_SIZE        = 0x1163,
+    RF_OUTPUT_COMPRESSION_THREADS           = 0x1164,
+    // Number of states per block [2, 16] the difference encoder stores to detect blocks that alternate between a few
+    // states like blinking carets. Those blocks are removed from the diff map. The output is preceded by a map with one
+    // byte per block that is 1 for removed blocks, padded to a multiple of 4 bytes. 0 disables the detection.
+    RF_DIFF_ENCODER_PERIODIC_HISTORY        = 0x1165,
+    // The difference encoder keeps its output in GPU memory. Frames are retrieved with rfGetEncodedFrameCL and returned
+    // with rfReleaseEncodedFrameCL instead of rfGetEncodedFrame. Cannot be combined with scroll or periodic detection.
+    RF_DIFF_ENCODER_GPU_OUTPUT              = 0x1166,
+    // The difference encoder compares the chroma plane in addition to the luma plane if the session produces RF_NV12.
+    // NV12 cannot be combined with a threshold, magnitudes, tiles, scroll or periodic detection.
+    RF_DIFF_ENCODER_NV12_CHROMA             = 0x1167,
 
     // AVC Pre Submit parameters
     RF_ENCODER_FORCE_INTRA_REFRESH          = 0x1061,
@@ -372,7 +417,11 @@ typedef enum RFEncodePreset
 *
 * @RF_AMF:        AMD Media Foundation library encoder (HW).
 * @RF_IDENTITY:   Identity encoder which returns the captured texture.
+*                If RF_IDENTITY_ENCODER_COMPACT is set only the pixels that changed since the previous frame are returned.
 * @RF_DIFFERENCE: Difference encoder returns a difference map with 1 where the source image has changed and 0 otherwise.
+*                If RF_DIFF_ENCODER_MAGNITUDE is set changed blocks store their mean absolute difference.
+* @RF_TILE_CACHE: Tile cache encoder returns the changed blocks as references to tiles cached by the client or as new tiles.
+*                It requires RF_ASYNC_SOURCE_COPY, rfCreateEncoder fails if the application sets it to 0.
 *
 *******************************************************************************
 */
@@ -381,9 +430,165 @@ typedef enum RFEncoderID
     RF_ENCODER_UNKNOWN = -1,
     RF_AMF             =  0,
     RF_IDENTITY        =  1,
-    RF_DIFFERENCE      =  2
+    RF_DIFFERENCE      =  2,
+    RF_TILE_CACHE      =  3
 } RFEncoderID;
 
+/**
+*******************************************************************************
+* @enum RFDiffMapOutput
+* @brief This is the output format of the difference encoder. It is set with the
+*        encoder parameter RF_DIFF_ENCODER_OUTPUT_MODE.
+*
+* @RF_DIFF_MAP_BYTES: One byte per block, 1 if the block has changed and 0 otherwise.
+* @RF_DIFF_MAP_BITS:  One bit per block. Each row of blocks starts at a new byte,
+*                     the first block of a byte is stored in the least significant bit.
+*                     If RF_DIFF_ENCODER_PYRAMID is set, all levels are packed.
+* @RF_DIFF_MAP_RECTS: An unsigned int with the number of rectangles followed by an array
+*                     of RFDiffRect that cover all changed blocks. Horizontal runs of changed
+*                     blocks are merged with runs of the same extent in the following rows.
+*                     RF_DIFF_ENCODER_PYRAMID is ignored in this mode.
+* @RF_DIFF_MAP_TILES: An unsigned int with the number of changed blocks n followed by n
+*                     unsigned int block indices (row * blocks per row + column) and the
+*                     pixels of the n blocks. Each block has RF_DIFF_ENCODER_BLOCK_S x
+*                     RF_DIFF_ENCODER_BLOCK_T pixels in the format of rfGetSourceFrame
+*                     stored row by row. Pixels outside the frame are 0. Only the changed
+*                     pixels are transferred from the GPU. RF_DIFF_ENCODER_PYRAMID is
+*                     ignored in this mode.
+*
+*******************************************************************************
+*/
+typedef enum RFDiffMapOutput
+{
+    RF_DIFF_MAP_BYTES = 0,
+    RF_DIFF_MAP_BITS  = 1,
+    RF_DIFF_MAP_RECTS = 2,
+    RF_DIFF_MAP_TILES = 3
+} RFDiffMapOutput;
+
+/**
+*******************************************************************************
+* @typedef RFDiffRect
+* @brief A rectangle of changed blocks returned by the difference encoder if
+*        RF_DIFF_ENCODER_OUTPUT_MODE is RF_DIFF_MAP_RECTS. All values are in blocks.
+*
+* @uiX:      Column of the top left block.
+* @uiY:      Row of the top left block.
+* @uiWidth:  Number of blocks in x direction.
+* @uiHeight: Number of blocks in y direction.
+*
+*******************************************************************************
+*/
+typedef struct
+{
+    unsigned int    uiX;
+    unsigned int    uiY;
+    unsigned int    uiWidth;
+    unsigned int    uiHeight;
+} RFDiffRect;
+
+/**
+*******************************************************************************
+* @typedef RFDiffCopyRect
+* @brief Describes a region of the previous frame that was moved. It precedes the
+*        output of the difference encoder if RF_DIFF_ENCODER_SCROLL_DETECT is set.
+*        It is placed before the periodic map if RF_DIFF_ENCODER_PERIODIC_HISTORY is set.
+*        The client has to copy the region before it updates the changed blocks of
+*        the diff map. If uiWidth is 0 no region was moved.
+*
+* @uiSrcX:   x position of the region in the previous frame in pixels.
+* @uiSrcY:   y position of the region in the previous frame in pixels.
+* @uiWidth:  Width of the region in pixels.
+* @uiHeight: Height of the region in pixels.
+* @iDx:      Horizontal offset of the destination.
+* @iDy:      Vertical offset of the destination.
+*
+*******************************************************************************
+*/
+typedef struct
+{
+    unsigned int    uiSrcX;
+    unsigned int    uiSrcY;
+    unsigned int    uiWidth;
+    unsigned int    uiHeight;
+    int             iDx;
+    int             iDy;
+} RFDiffCopyRect;
+
+/**
+*******************************************************************************
+* @typedef RFTileCacheEntry
+* @brief Describes a changed block in the output of the tile cache encoder.
+*        The output starts with an unsigned int containing the number of entries followed
+*        by the entries. The pixels of all tiles with uiHit == 0 follow in the order of
+*        the entries. Each tile has RF_DIFF_ENCODER_BLOCK_S x RF_DIFF_ENCODER_BLOCK_T pixels,
+*        pixels outside of the frame are 0.
+*        The client stores RF_TILE_CACHE_SLOTS tiles and has to process the entries in order.
+*        The output is valid until the next call to rfGetEncodedFrame.
+*
+* @uiX:    Column of the block.
+* @uiY:    Row of the block.
+* @uiSlot: Slot of the tile cache that contains the tile.
+* @uiHit:  1 if the tile is already stored in uiSlot. 0 if the tile is new and has to be stored in uiSlot.
+*
+*******************************************************************************
+*/
+typedef struct
+{
+    unsigned int    uiX;
+    unsigned int    uiY;
+    unsigned int    uiSlot;
+    unsigned int    uiHit;
+} RFTileCacheEntry;
+
+/**
+*******************************************************************************
+* @typedef RFCompressedChunk
+* @brief Entry of the chunk table returned by rfGetEncodedFrame if RF_OUTPUT_COMPRESSION
+*        is set. The output starts with the number of chunks followed by the chunk table
+*        and the data of the chunks. Each chunk is an LZ4 block that decompresses into the
+*        next uiUncompressedSize bytes of the encoder output. Chunks with uiSize equal to
+*        uiUncompressedSize are stored uncompressed.
+*
+* @uiOffset:           Offset of the chunk data from the start of the output in bytes.
+* @uiSize:             Size of the chunk data in bytes.
+* @uiUncompressedSize: Size of the chunk after decompression in bytes.
+*
+*******************************************************************************
+*/
+typedef struct
+{
+    unsigned int    uiOffset;
+    unsigned int    uiSize;
+    unsigned int    uiUncompressedSize;
+} RFCompressedChunk;
+
+/**
+*******************************************************************************
+* @typedef RFEncodedFrameCL
+* @brief Describes an encoded frame that remains in GPU memory. It is returned by
+*        rfGetEncodedFrameCL if RF_DIFF_ENCODER_GPU_OUTPUT is set. The memory objects
+*        and the event are owned by the session and stay valid until
+*        rfReleaseEncodedFrameCL is called. Commands that read the buffers have to
+*        wait for clEvent.
+*
+* @clOutput:     cl_mem containing the diff map in the format selected by RF_DIFF_ENCODER_OUTPUT_MODE.
+* @clSource:     cl_mem containing the result buffer the diff map was computed from.
+* @clEvent:      cl_event that is complete once clOutput is written.
+* @uiOutputSize: Size of clOutput in bytes. Rectangle lists and tiles start with their count.
+* @uiSourceSize: Size of clSource in bytes.
+*
+*******************************************************************************
+*/
+typedef struct
+{
+    void*           clOutput;
+    void*           clSource;
+    void*           clEvent;
+    unsigned int    uiOutputSize;
+    unsigned int    uiSourceSize;
+} RFEncodedFrameCL;
+
 /**
 *******************************************************************************
 * @enum RFRenderTargetState
@@ -451,6 +656,9 @@ extern "C" {
     *******************************************************************************
     * @fn rfDeleteEncodeSession
     * @brief This function deletes an encoding session and frees all associated resources.
+    * The session has to be idle: other threads must have stopped calling functions of the session.
+    * Threads that are blocked in rfEncodeFrame or rfGetMouseData waiting for a desktop or mouse shape change are
+    * released, the function returns once these calls have returned.
     *
     * @param[in] session: The encoding session to be deleted.
     *
@@ -503,6 +711,9 @@ extern "C" {
     * @brief This function registers a render target that is created by the user
     *        and returns the index used for this render target in idx.
     *        The render target must have the same dimesnions as the encoder.
+    *        If the session was created with RF_HOST_MEMORY, renderTarget is a pointer
+    *        to RGBA8 pixels in system memory with a pitch of uiRTWidth * 4 bytes. The
+    *        pixels are read when rfEncodeFrame is called.
     *
     * @param[in] session:      The encoding session.
     * @param[in] renderTarget: The handle of the render target.
@@ -583,6 +794,12 @@ extern "C" {
     * @fn rfGetEncodedFrame
     * @brief This function returns the encoded frame in pBitStream and
     *        the size (in bytes) of the encoded frame in uiSize.
+    *        pBitStream stays valid until the next call to rfGetEncodedFrame
+    *        if RF_OUTPUT_COMPRESSION or RF_IDENTITY_ENCODER_COMPACT is set,
+    *        or if the difference encoder uses RF_DIFF_ENCODER_LOCK_BUFFER.
+    *        This also holds if rfEncodeFrame is called by another thread.
+    *        Otherwise the buffer can be overwritten by the next call to
+    *        rfEncodeFrame, and it has to be read before.
     *
     * @param[in] session:     The encoding session.
     * @param[out] uiSize:     The size (in bytes) of the bit stream.
@@ -612,6 +829,87 @@ extern "C" {
     */
     RFStatus RAPIDFIRE_API rfGetSourceFrame(RFEncodeSession session, unsigned int* uiSize, void** pBitStream);
 
+    /**
+    *******************************************************************************
+    * @fn  rfGetEncodedFrameCL
+    * @brief  The function returns the OpenCL buffers of the oldest encoded frame
+    *         without transferring them to system memory. Requires a RF_DIFFERENCE
+    *         encoder created with RF_DIFF_ENCODER_GPU_OUTPUT. The function does not
+    *         wait for the GPU; the application has to wait for clEvent of pFrame.
+    *         Only one frame can be retrieved at a time. It has to be released with
+    *         rfReleaseEncodedFrameCL before the next frame is retrieved.
+    *
+    * @param[in] session: The encoding session.
+    * @param[out] pFrame: The buffers and the event of the encoded frame.
+    *
+    * @return RFStatus: RF_STATUS_OK if successful; otherwise an error code.
+    *******************************************************************************
+    */
+    RFStatus RAPIDFIRE_API rfGetEncodedFrameCL(RFEncodeSession session, RFEncodedFrameCL* pFrame);
+
+    /**
+    *******************************************************************************
+    * @fn  rfReleaseEncodedFrameCL
+    * @brief  The function returns the buffers retrieved by rfGetEncodedFrameCL to
+    *         the encoder. The application must not access them afterwards.
+    *
+    * @param[in] session: The encoding session.
+    *
+    * @return RFStatus: RF_STATUS_OK if successful; otherwise an error code.
+    *******************************************************************************
+    */
+    RFStatus RAPIDFIRE_API rfReleaseEncodedFrameCL(RFEncodeSession session);
+
+    /**
+    *******************************************************************************
+    * @fn  rfCreateDiffConsumer
+    * @brief  The function creates a consumer of a RF_DIFFERENCE encoder. A consumer
+    *         accumulates the diff maps of all frames encoded since its last call to
+    *         rfGetDiffConsumerFrame. This allows several clients that read frames at
+    *         different rates to share one session. The first map returned to a new
+    *         consumer marks all blocks as changed.
+    *
+    * @param[in] session:    The encoding session.
+    * @param[out] pConsumer: The index of the new consumer.
+    *
+    * @return RFStatus: RF_STATUS_OK if successful; otherwise an error code.
+    *******************************************************************************
+    */
+    RFStatus RAPIDFIRE_API rfCreateDiffConsumer(RFEncodeSession session, unsigned int* pConsumer);
+
+    /**
+    *******************************************************************************
+    * @fn  rfDeleteDiffConsumer
+    * @brief  The function deletes a consumer created by rfCreateDiffConsumer.
+    *
+    * @param[in] session:    The encoding session.
+    * @param[in] uiConsumer: The index of the consumer.
+    *
+    * @return RFStatus: RF_STATUS_OK if successful; otherwise an error code.
+    *******************************************************************************
+    */
+    RFStatus RAPIDFIRE_API rfDeleteDiffConsumer(RFEncodeSession session, const unsigned int uiConsumer);
+
+    /**
+    *******************************************************************************
+    * @fn  rfGetDiffConsumerFrame
+    * @brief  The function returns the diff map accumulated by the consumer and
+    *         clears it. The map contains one byte per block independent of
+    *         RF_DIFF_ENCODER_OUTPUT_MODE. It includes all frames that were passed
+    *         to rfEncodeFrame before the call. Moved blocks are reported as changed
+    *         if scroll detection is enabled. The returned buffer is valid until the
+    *         next call with the same consumer.
+    *
+    * @param[in] session:    The encoding session.
+    * @param[in] uiConsumer: The index of the consumer.
+    * @param[out] uiSize:    The size (in bytes) of the diff map.
+    * @param[out] pDiffMap:  Pointer to the diff map.
+    *
+    * @return RFStatus: RF_STATUS_OK if successful; otherwise an error code.
+    *******************************************************************************
+    */
+    RFStatus RAPIDFIRE_API rfGetDiffConsumerFrame(RFEncodeSession session, const unsigned int uiConsumer, unsigned int* uiSize, void** pDiffMap);
+
     /**
     *******************************************************************************
     * @fn rfSetEncodeParameter
@@ -0,0 +1,650 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFCSCHost.h"
+
+#include <cstring>
+
+#include "RFUtils.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RF_CSC_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM) || defined(_M_ARM64)
+#define RF_CSC_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#define RF_TARGET_SSE41
+#define RF_TARGET_AVX2
+#else
+#define RF_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define RF_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+
+// Minimum number of row pairs a thread processes. Smaller images are converted by fewer threads.
+#define RF_CSC_MIN_ROWS_PER_THREAD  16
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Scalar reference implementation. The math is identical to the CSC kernels.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+static inline uint8_t rgbToY(const uint8_t* p)
+{
+    return static_cast<uint8_t>(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+}
+
+
+template <bool bNV12>
+static void convertRowPairScalar(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pY0, uint8_t* pY1, uint8_t* pU, uint8_t* pV, unsigned int uiBegin, unsigned int uiEnd)
+{
+    for (unsigned int x = uiBegin; x < uiEnd; ++x)
+    {
+        const uint8_t* p0 = pRow0 + 8 * x;
+        const uint8_t* p1 = pRow1 + 8 * x;
+
+        pY0[2 * x]     = rgbToY(p0);
+        pY0[2 * x + 1] = rgbToY(p0 + 4);
+        pY1[2 * x]     = rgbToY(p1);
+        pY1[2 * x + 1] = rgbToY(p1 + 4);
+
+        // Average color of the 2x2 quad.
+        int r = (p0[0] + p0[4] + p1[0] + p1[4]) >> 2;
+        int g = (p0[1] + p0[5] + p1[1] + p1[5]) >> 2;
+        int b = (p0[2] + p0[6] + p1[2] + p1[6]) >> 2;
+
+        uint8_t u = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        uint8_t v = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+
+        if (bNV12)
+        {
+            pU[2 * x]     = u;
+            pU[2 * x + 1] = v;
+        }
+        else
+        {
+            pU[x] = u;
+            pV[x] = v;
+        }
+    }
+}
+
+
+static void copyRowScalar(const uint8_t* pSrc, uint8_t* pDst, unsigned int uiBegin, unsigned int uiEnd, RFFormat format)
+{
+    for (unsigned int x = uiBegin; x < uiEnd; ++x)
+    {
+        const uint8_t* s = pSrc + 4 * x;
+        uint8_t*       d = pDst + 4 * x;
+
+        if (format == RF_ARGB8)
+        {
+            d[0] = s[3]; d[1] = s[0]; d[2] = s[1]; d[3] = s[2];
+        }
+        else if (format == RF_BGRA8)
+        {
+            d[0] = s[2]; d[1] = s[1]; d[2] = s[0]; d[3] = s[3];
+        }
+        else
+        {
+            d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = s[3];
+        }
+    }
+}
+
+
+static unsigned int convertRowPairNone(const uint8_t*, const uint8_t*, uint8_t*, uint8_t*, uint8_t*, uint8_t*, unsigned int)
+{
+    return 0;
+}
+
+
+static unsigned int copyRowNone(const uint8_t*, uint8_t*, unsigned int, RFFormat)
+{
+    return 0;
+}
+
+
+#ifdef RF_CSC_X86
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// SSE4.1: 8 quads (16 pixels of each row) per iteration.
+//
+// Pixels are expanded to 16 bit. _mm_madd_epi16 computes c0 * R + c1 * G and c2 * B in
+// 32 bit and _mm_hadd_epi32 adds both parts. The chroma input is the sum of the 2x2 quad
+// shifted right by 2, the same as the ushort4 average of the kernels.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+RF_TARGET_SSE41
+static inline __m128i lumaSSE41(const __m128i* pPixels)
+{
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i coefY = _mm_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0);
+    const __m128i round = _mm_set1_epi32(128);
+
+    __m128i y[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pPixels[i], zero), coefY);
+        __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pPixels[i], zero), coefY);
+
+        y[i] = _mm_srli_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), round), 8);
+    }
+
+    __m128i y01 = _mm_add_epi16(_mm_packs_epi32(y[0], y[1]), _mm_set1_epi16(16));
+    __m128i y23 = _mm_add_epi16(_mm_packs_epi32(y[2], y[3]), _mm_set1_epi16(16));
+
+    return _mm_packus_epi16(y01, y23);
+}
+
+
+RF_TARGET_SSE41
+static inline __m128i chromaSSE41(const __m128i* pAvg, const __m128i& coef)
+{
+    const __m128i round  = _mm_set1_epi32(128);
+    const __m128i offset = _mm_set1_epi32(128);
+
+    __m128i c0 = _mm_hadd_epi32(_mm_madd_epi16(pAvg[0], coef), _mm_madd_epi16(pAvg[1], coef));
+    __m128i c1 = _mm_hadd_epi32(_mm_madd_epi16(pAvg[2], coef), _mm_madd_epi16(pAvg[3], coef));
+
+    c0 = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(c0, round), 8), offset);
+    c1 = _mm_add_epi32(_mm_srai_epi32(_mm_add_epi32(c1, round), 8), offset);
+
+    return _mm_packs_epi32(c0, c1);
+}
+
+
+template <bool bNV12>
+RF_TARGET_SSE41
+static unsigned int convertRowPairSSE41(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pY0, uint8_t* pY1, uint8_t* pU, uint8_t* pV, unsigned int uiQuads)
+{
+    const __m128i zero      = _mm_setzero_si128();
+    const __m128i coefU     = _mm_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0);
+    const __m128i coefV     = _mm_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0);
+    const __m128i uvShuffle = _mm_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+
+    unsigned int x = 0;
+
+    for (; x + 8 <= uiQuads; x += 8)
+    {
+        __m128i s0[4], s1[4], avg[4];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            s0[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + 8 * x) + i);
+            s1[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + 8 * x) + i);
+
+            // Each register holds 2 quads. Add both rows and then the left and right pixel.
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(s0[i], zero), _mm_unpacklo_epi8(s1[i], zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(s0[i], zero), _mm_unpackhi_epi8(s1[i], zero));
+
+            lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+            hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+            avg[i] = _mm_srli_epi16(_mm_unpacklo_epi64(lo, hi), 2);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pY0 + 2 * x), lumaSSE41(s0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pY1 + 2 * x), lumaSSE41(s1));
+
+        // U0..U7 V0..V7
+        __m128i uv = _mm_packus_epi16(chromaSSE41(avg, coefU), chromaSSE41(avg, coefV));
+
+        if (bNV12)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pU + 2 * x), _mm_shuffle_epi8(uv, uvShuffle));
+        }
+        else
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pU + x), uv);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(pV + x), _mm_srli_si128(uv, 8));
+        }
+    }
+
+    return x;
+}
+
+
+RF_TARGET_SSE41
+static unsigned int copyRowSSE41(const uint8_t* pSrc, uint8_t* pDst, unsigned int uiPixels, RFFormat format)
+{
+    __m128i mask;
+
+    if (format == RF_ARGB8)
+    {
+        mask = _mm_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    }
+    else if (format == RF_BGRA8)
+    {
+        mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    }
+    else
+    {
+        mask = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    }
+
+    unsigned int x = 0;
+
+    for (; x + 4 <= uiPixels; x += 4)
+    {
+        __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + 4 * x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + 4 * x), _mm_shuffle_epi8(p, mask));
+    }
+
+    return x;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// AVX2: 16 quads (32 pixels of each row) per iteration.
+//
+// The AVX2 pack and horizontal add instructions work on 128 bit lanes. The results are
+// brought back into pixel order with permutes.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+RF_TARGET_AVX2
+static inline __m256i lumaAVX2(const __m256i* pPixels)
+{
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i coefY = _mm256_setr_epi16(66, 129, 25, 0, 66, 129, 25, 0, 66, 129, 25, 0, 66, 129, 25, 0);
+    const __m256i round = _mm256_set1_epi32(128);
+
+    __m256i y[4];
+
+    for (int i = 0; i < 4; ++i)
+    {
+        __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(pPixels[i], zero), coefY);
+        __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(pPixels[i], zero), coefY);
+
+        // y[i] contains the 8 luma values of pPixels[i] in order.
+        y[i] = _mm256_srli_epi32(_mm256_add_epi32(_mm256_hadd_epi32(lo, hi), round), 8);
+    }
+
+    __m256i y01 = _mm256_add_epi16(_mm256_packs_epi32(y[0], y[1]), _mm256_set1_epi16(16));
+    __m256i y23 = _mm256_add_epi16(_mm256_packs_epi32(y[2], y[3]), _mm256_set1_epi16(16));
+
+    // The packs leave the groups of 4 pixels in the order 0 2 4 6 1 3 5 7.
+    return _mm256_permutevar8x32_epi32(_mm256_packus_epi16(y01, y23), _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+
+RF_TARGET_AVX2
+static inline __m256i chromaAVX2(const __m256i* pAvg, const __m256i& coef)
+{
+    const __m256i round  = _mm256_set1_epi32(128);
+    const __m256i offset = _mm256_set1_epi32(128);
+
+    // hadd leaves the quads in the order 0 1 4 5 2 3 6 7.
+    __m256i c0 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(_mm256_madd_epi16(pAvg[0], coef), _mm256_madd_epi16(pAvg[1], coef)), 0xD8);
+    __m256i c1 = _mm256_permute4x64_epi64(_mm256_hadd_epi32(_mm256_madd_epi16(pAvg[2], coef), _mm256_madd_epi16(pAvg[3], coef)), 0xD8);
+
+    c0 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c0, round), 8), offset);
+    c1 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c1, round), 8), offset);
+
+    return _mm256_permute4x64_epi64(_mm256_packs_epi32(c0, c1), 0xD8);
+}
+
+
+template <bool bNV12>
+RF_TARGET_AVX2
+static unsigned int convertRowPairAVX2(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pY0, uint8_t* pY1, uint8_t* pU, uint8_t* pV, unsigned int uiQuads)
+{
+    const __m256i zero      = _mm256_setzero_si256();
+    const __m256i coefU     = _mm256_setr_epi16(-38, -74, 112, 0, -38, -74, 112, 0, -38, -74, 112, 0, -38, -74, 112, 0);
+    const __m256i coefV     = _mm256_setr_epi16(112, -94, -18, 0, 112, -94, -18, 0, 112, -94, -18, 0, 112, -94, -18, 0);
+    const __m256i uvShuffle = _mm256_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15,
+                                               0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+
+    unsigned int x = 0;
+
+    for (; x + 16 <= uiQuads; x += 16)
+    {
+        __m256i s0[4], s1[4], avg[4];
+
+        for (int i = 0; i < 4; ++i)
+        {
+            s0[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + 8 * x) + i);
+            s1[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + 8 * x) + i);
+
+            __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(s0[i], zero), _mm256_unpacklo_epi8(s1[i], zero));
+            __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(s0[i], zero), _mm256_unpackhi_epi8(s1[i], zero));
+
+            lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+            hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+
+            // Lane 0 holds quad 0 and 1, lane 1 holds quad 2 and 3 of this register.
+            avg[i] = _mm256_srli_epi16(_mm256_unpacklo_epi64(lo, hi), 2);
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pY0 + 2 * x), lumaAVX2(s0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pY1 + 2 * x), lumaAVX2(s1));
+
+        // Lane 0: U0..U7 V0..V7, lane 1: U8..U15 V8..V15
+        __m256i uv = _mm256_packus_epi16(chromaAVX2(avg, coefU), chromaAVX2(avg, coefV));
+
+        if (bNV12)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(pU + 2 * x), _mm256_shuffle_epi8(uv, uvShuffle));
+        }
+        else
+        {
+            uv = _mm256_permute4x64_epi64(uv, 0xD8);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pU + x), _mm256_castsi256_si128(uv));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pV + x), _mm256_extracti128_si256(uv, 1));
+        }
+    }
+
+    // Process the remaining quads with SSE.
+    return x + convertRowPairSSE41<bNV12>(pRow0 + 8 * x, pRow1 + 8 * x, pY0 + 2 * x, pY1 + 2 * x,
+                                          bNV12 ? pU + 2 * x : pU + x, bNV12 ? pV : pV + x, uiQuads - x);
+}
+
+
+RF_TARGET_AVX2
+static unsigned int copyRowAVX2(const uint8_t* pSrc, uint8_t* pDst, unsigned int uiPixels, RFFormat format)
+{
+    __m256i mask;
+
+    if (format == RF_ARGB8)
+    {
+        mask = _mm256_setr_epi8(3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, 3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+    }
+    else if (format == RF_BGRA8)
+    {
+        mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    }
+    else
+    {
+        mask = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    }
+
+    unsigned int x = 0;
+
+    for (; x + 8 <= uiPixels; x += 8)
+    {
+        __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pSrc + 4 * x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pDst + 4 * x), _mm256_shuffle_epi8(p, mask));
+    }
+
+    return x;
+}
+
+#endif // RF_CSC_X86
+
+
+#ifdef RF_CSC_NEON
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// NEON: 8 quads (16 pixels of each row) per iteration.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+static inline uint8x16_t lumaNEON(const uint8x16x4_t& p)
+{
+    uint16x8_t lo = vmull_u8(vget_low_u8(p.val[0]), vdup_n_u8(66));
+    uint16x8_t hi = vmull_u8(vget_high_u8(p.val[0]), vdup_n_u8(66));
+
+    lo = vmlal_u8(lo, vget_low_u8(p.val[1]), vdup_n_u8(129));
+    hi = vmlal_u8(hi, vget_high_u8(p.val[1]), vdup_n_u8(129));
+    lo = vmlal_u8(lo, vget_low_u8(p.val[2]), vdup_n_u8(25));
+    hi = vmlal_u8(hi, vget_high_u8(p.val[2]), vdup_n_u8(25));
+
+    // The maximum sum is 220 * 255 + 128 which fits into 16 bit.
+    lo = vaddq_u16(lo, vdupq_n_u16(128));
+    hi = vaddq_u16(hi, vdupq_n_u16(128));
+
+    return vaddq_u8(vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)), vdupq_n_u8(16));
+}
+
+
+static inline uint8x8_t chromaNEON(const int16x8_t& r, const int16x8_t& g, const int16x8_t& b, int16_t cr, int16_t cg, int16_t cb)
+{
+    int16x8_t c = vmulq_n_s16(r, cr);
+
+    c = vmlaq_n_s16(c, g, cg);
+    c = vmlaq_n_s16(c, b, cb);
+    c = vshrq_n_s16(vaddq_s16(c, vdupq_n_s16(128)), 8);
+
+    return vqmovun_s16(vaddq_s16(c, vdupq_n_s16(128)));
+}
+
+
+template <bool bNV12>
+static unsigned int convertRowPairNEON(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pY0, uint8_t* pY1, uint8_t* pU, uint8_t* pV, unsigned int uiQuads)
+{
+    unsigned int x = 0;
+
+    for (; x + 8 <= uiQuads; x += 8)
+    {
+        uint8x16x4_t p0 = vld4q_u8(pRow0 + 8 * x);
+        uint8x16x4_t p1 = vld4q_u8(pRow1 + 8 * x);
+
+        vst1q_u8(pY0 + 2 * x, lumaNEON(p0));
+        vst1q_u8(pY1 + 2 * x, lumaNEON(p1));
+
+        // Sum of the 2x2 quads divided by 4.
+        int16x8_t r = vreinterpretq_s16_u16(vshrq_n_u16(vpadalq_u8(vpaddlq_u8(p0.val[0]), p1.val[0]), 2));
+        int16x8_t g = vreinterpretq_s16_u16(vshrq_n_u16(vpadalq_u8(vpaddlq_u8(p0.val[1]), p1.val[1]), 2));
+        int16x8_t b = vreinterpretq_s16_u16(vshrq_n_u16(vpadalq_u8(vpaddlq_u8(p0.val[2]), p1.val[2]), 2));
+
+        uint8x8x2_t uv;
+
+        uv.val[0] = chromaNEON(r, g, b, -38, -74, 112);
+        uv.val[1] = chromaNEON(r, g, b, 112, -94, -18);
+
+        if (bNV12)
+        {
+            vst2_u8(pU + 2 * x, uv);
+        }
+        else
+        {
+            vst1_u8(pU + x, uv.val[0]);
+            vst1_u8(pV + x, uv.val[1]);
+        }
+    }
+
+    return x;
+}
+
+
+static unsigned int copyRowNEON(const uint8_t* pSrc, uint8_t* pDst, unsigned int uiPixels, RFFormat format)
+{
+    unsigned int x = 0;
+
+    for (; x + 16 <= uiPixels; x += 16)
+    {
+        uint8x16x4_t s = vld4q_u8(pSrc + 4 * x);
+        uint8x16x4_t d = s;
+
+        if (format == RF_ARGB8)
+        {
+            d.val[0] = s.val[3]; d.val[1] = s.val[0]; d.val[2] = s.val[1]; d.val[3] = s.val[2];
+        }
+        else if (format == RF_BGRA8)
+        {
+            d.val[0] = s.val[2]; d.val[2] = s.val[0];
+        }
+
+        vst4q_u8(pDst + 4 * x, d);
+    }
+
+    return x;
+}
+
+#endif // RF_CSC_NEON
+
+
+RFCSCHost::RFCSCHost()
+    : m_uiWidth(0)
+    , m_uiHeight(0)
+    , m_uiAlignedWidth(0)
+    , m_uiAlignedHeight(0)
+    , m_pfnRowPairNV12(convertRowPairNone)
+    , m_pfnRowPairI420(convertRowPairNone)
+    , m_pfnRowCopy(copyRowNone)
+    , m_strInstructionSet("Scalar")
+    , m_ThreadPool()
+{
+#if defined(RF_CSC_X86)
+    if (utilCpuSupportsAVX2())
+    {
+        m_pfnRowPairNV12    = convertRowPairAVX2<true>;
+        m_pfnRowPairI420    = convertRowPairAVX2<false>;
+        m_pfnRowCopy        = copyRowAVX2;
+        m_strInstructionSet = "AVX2";
+    }
+    else if (utilCpuSupportsSSE41())
+    {
+        m_pfnRowPairNV12    = convertRowPairSSE41<true>;
+        m_pfnRowPairI420    = convertRowPairSSE41<false>;
+        m_pfnRowCopy        = copyRowSSE41;
+        m_strInstructionSet = "SSE4.1";
+    }
+#elif defined(RF_CSC_NEON)
+    m_pfnRowPairNV12    = convertRowPairNEON<true>;
+    m_pfnRowPairI420    = convertRowPairNEON<false>;
+    m_pfnRowCopy        = copyRowNEON;
+    m_strInstructionSet = "NEON";
+#endif
+}
+
+
+void RFCSCHost::setDimension(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiAlignedWidth, unsigned int uiAlignedHeight)
+{
+    m_uiWidth         = uiWidth;
+    m_uiHeight        = uiHeight;
+    m_uiAlignedWidth  = uiAlignedWidth;
+    m_uiAlignedHeight = uiAlignedHeight;
+}
+
+
+bool RFCSCHost::convertToNV12(const unsigned char* pRGBA, unsigned char* pNV12, bool bMirror)
+{
+    if (!pRGBA || !pNV12)
+    {
+        return false;
+    }
+
+    // The UV plane starts after the Y plane of the real height, the same offset the kernel is using.
+    unsigned char* pUV = pNV12 + m_uiAlignedWidth * m_uiHeight;
+
+    return convertRowPairs(pRGBA, pNV12, pUV, nullptr, m_uiAlignedWidth, bMirror, true);
+}
+
+
+bool RFCSCHost::convertToI420(const unsigned char* pRGBA, unsigned char* pI420, bool bMirror)
+{
+    if (!pRGBA || !pI420)
+    {
+        return false;
+    }
+
+    unsigned char* pU = pI420 + m_uiAlignedWidth * m_uiAlignedHeight;
+    unsigned char* pV = pU + m_uiAlignedWidth * m_uiAlignedHeight / 2;
+
+    return convertRowPairs(pRGBA, pI420, pU, pV, m_uiAlignedWidth, bMirror, false);
+}
+
+
+bool RFCSCHost::copyRGBA(const unsigned char* pRGBA, unsigned char* pOut, RFFormat format, bool bMirror)
+{
+    if (!pRGBA || !pOut || m_uiWidth == 0 || m_uiHeight == 0)
+    {
+        return false;
+    }
+
+    const unsigned int uiWidth     = m_uiWidth;
+    const unsigned int uiHeight    = m_uiHeight;
+    const unsigned int uiSrcPitch  = m_uiWidth * 4;
+    const unsigned int uiDstPitch  = m_uiAlignedWidth * 4;
+    RowCopyFunction    pfnRowCopy  = m_pfnRowCopy;
+
+    m_ThreadPool.run(uiHeight, 2 * RF_CSC_MIN_ROWS_PER_THREAD, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int y = uiBegin; y < uiEnd; ++y)
+        {
+            const uint8_t* pSrc = pRGBA + (bMirror ? (uiHeight - y - 1) : y) * uiSrcPitch;
+            uint8_t*       pDst = pOut + y * uiDstPitch;
+
+            if (format == RF_RGBA8)
+            {
+                memcpy(pDst, pSrc, uiSrcPitch);
+            }
+            else
+            {
+                unsigned int x = pfnRowCopy(pSrc, pDst, uiWidth, format);
+
+                copyRowScalar(pSrc, pDst, x, uiWidth, format);
+            }
+        }
+    });
+
+    return true;
+}
+
+
+bool RFCSCHost::convertRowPairs(const unsigned char* pRGBA, unsigned char* pY, unsigned char* pU, unsigned char* pV, unsigned int uiChromaPitch, bool bMirror, bool bNV12)
+{
+    if (m_uiWidth < 2 || m_uiHeight < 2)
+    {
+        return false;
+    }
+
+    // Like the kernels, an odd last column or row is not converted.
+    const unsigned int uiQuads      = m_uiWidth / 2;
+    const unsigned int uiRowPairs   = m_uiHeight / 2;
+    const unsigned int uiHeight     = m_uiHeight;
+    const unsigned int uiSrcPitch   = m_uiWidth * 4;
+    const unsigned int uiYPitch     = m_uiAlignedWidth;
+    RowPairFunction    pfnRowPair   = bNV12 ? m_pfnRowPairNV12 : m_pfnRowPairI420;
+
+    m_ThreadPool.run(uiRowPairs, RF_CSC_MIN_ROWS_PER_THREAD, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int y = uiBegin; y < uiEnd; ++y)
+        {
+            const uint8_t* pRow0 = pRGBA + (bMirror ? (uiHeight - 2 * y - 1) : (2 * y))     * uiSrcPitch;
+            const uint8_t* pRow1 = pRGBA + (bMirror ? (uiHeight - 2 * y - 2) : (2 * y + 1)) * uiSrcPitch;
+
+            uint8_t* pY0 = pY + 2 * y * uiYPitch;
+            uint8_t* pY1 = pY0 + uiYPitch;
+            uint8_t* pU0 = pU + y * uiChromaPitch;
+            uint8_t* pV0 = pV ? pV + y * uiChromaPitch : nullptr;
+
+            unsigned int x = pfnRowPair(pRow0, pRow1, pY0, pY1, pU0, pV0, uiQuads);
+
+            if (bNV12)
+            {
+                convertRowPairScalar<true>(pRow0, pRow1, pY0, pY1, pU0, pV0, x, uiQuads);
+            }
+            else
+            {
+                convertRowPairScalar<false>(pRow0, pRow1, pY0, pY1, pU0, pV0, x, uiQuads);
+            }
+        }
+    });
+
+    return true;
+}
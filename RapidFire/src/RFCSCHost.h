@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+
+#include "RapidFire.h"
+#include "RFThreadPool.h"
+
+// RFCSCHost converts RGBA8 images that are stored in system memory on the CPU. The results are
+// bit exact with the integer BT.601 math of the OpenCL kernels in rfkernels.cl and use the same
+// buffer layout, so the output can be used in place of the result of RFContextCL::processBuffer.
+// Rows are distributed across a thread pool, each thread uses the widest instruction set
+// supported by the CPU (AVX2, SSE4.1 or NEON) and falls back to scalar code.
+class RFCSCHost
+{
+public:
+
+    RFCSCHost();
+
+    // Sets the dimension of the source image and the aligned dimension of the output buffer.
+    void            setDimension(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiAlignedWidth, unsigned int uiAlignedHeight);
+
+    // Converts tightly packed RGBA8 pixels into NV12. Matches rgbaTonv12_image2d.
+    bool            convertToNV12(const unsigned char* pRGBA, unsigned char* pNV12, bool bMirror);
+
+    // Converts tightly packed RGBA8 pixels into I420. Matches rgbaToI420_image2d.
+    bool            convertToI420(const unsigned char* pRGBA, unsigned char* pI420, bool bMirror);
+
+    // Copies tightly packed RGBA8 pixels and reorders the channels to RGBA, ARGB or BGRA.
+    // Matches copy_rgba_image2d.
+    bool            copyRGBA(const unsigned char* pRGBA, unsigned char* pOut, RFFormat format, bool bMirror);
+
+    // Returns the name of the instruction set that is used for the conversion.
+    const char*     getInstructionSet() const { return m_strInstructionSet; }
+
+    typedef unsigned int (*RowPairFunction)(const uint8_t* pRow0, const uint8_t* pRow1, uint8_t* pY0, uint8_t* pY1, uint8_t* pU, uint8_t* pV, unsigned int uiQuads);
+    typedef unsigned int (*RowCopyFunction)(const uint8_t* pSrc, uint8_t* pDst, unsigned int uiPixels, RFFormat format);
+
+private:
+
+    // Disable copy constructor.
+    RFCSCHost(const RFCSCHost& other);
+    // Disable assignment operator.
+    RFCSCHost& operator=(const RFCSCHost& rhs);
+
+    bool            convertRowPairs(const unsigned char* pRGBA, unsigned char* pY, unsigned char* pU, unsigned char* pV, unsigned int uiChromaPitch, bool bMirror, bool bNV12);
+
+    unsigned int        m_uiWidth;
+    unsigned int        m_uiHeight;
+    unsigned int        m_uiAlignedWidth;
+    unsigned int        m_uiAlignedHeight;
+
+    // Processes as many 2x2 pixel quads of a row pair as possible with SIMD instructions.
+    // Returns the number of quads that were processed.
+    RowPairFunction     m_pfnRowPairNV12;
+    RowPairFunction     m_pfnRowPairI420;
+    // Copies as many pixels as possible with SIMD instructions and returns the number of copied pixels.
+    RowCopyFunction     m_pfnRowCopy;
+
+    const char*         m_strInstructionSet;
+
+    RFThreadPool        m_ThreadPool;
+};
@@ -0,0 +1,273 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "RFCompressor.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+// Number of bits of the hash of 4 bytes that is used to find matches.
+#define RF_COMPRESS_HASH_BITS       12
+
+// A match has at least 4 bytes. The last 5 bytes of a block are literals and the last match starts at least
+// 12 bytes before the end of the block.
+#define RF_COMPRESS_MIN_MATCH       4
+#define RF_COMPRESS_LAST_LITERALS   5
+#define RF_COMPRESS_MATCH_LIMIT     12
+#define RF_COMPRESS_MAX_OFFSET      65535
+
+
+static inline unsigned int readU32(const unsigned char* p)
+{
+    unsigned int uiValue;
+
+    memcpy(&uiValue, p, sizeof(uiValue));
+
+    return uiValue;
+}
+
+
+static inline unsigned int hashU32(unsigned int uiValue)
+{
+    return (uiValue * 2654435761U) >> (32 - RF_COMPRESS_HASH_BITS);
+}
+
+
+// Writes a length that does not fit into the 4 bits of the token as a sequence of bytes.
+static inline unsigned char* writeLength(unsigned char* pDst, unsigned int uiLength)
+{
+    while (uiLength >= 255)
+    {
+        *pDst++ = 255;
+        uiLength -= 255;
+    }
+
+    *pDst++ = static_cast<unsigned char>(uiLength);
+
+    return pDst;
+}
+
+
+// Writes the literals followed by a match. If uiMatchLength is 0 only the literals are written, which ends the block.
+static unsigned char* writeSequence(unsigned char* pDst, const unsigned char* pLiterals, unsigned int uiNumLiterals, unsigned int uiOffset, unsigned int uiMatchLength)
+{
+    unsigned char* pToken = pDst++;
+
+    if (uiNumLiterals >= 15)
+    {
+        *pToken = 15 << 4;
+        pDst = writeLength(pDst, uiNumLiterals - 15);
+    }
+    else
+    {
+        *pToken = static_cast<unsigned char>(uiNumLiterals << 4);
+    }
+
+    memcpy(pDst, pLiterals, uiNumLiterals);
+    pDst += uiNumLiterals;
+
+    if (uiMatchLength == 0)
+    {
+        return pDst;
+    }
+
+    *pDst++ = static_cast<unsigned char>(uiOffset & 0xFF);
+    *pDst++ = static_cast<unsigned char>(uiOffset >> 8);
+
+    const unsigned int uiLength = uiMatchLength - RF_COMPRESS_MIN_MATCH;
+
+    if (uiLength >= 15)
+    {
+        *pToken |= 15;
+        pDst = writeLength(pDst, uiLength - 15);
+    }
+    else
+    {
+        *pToken |= static_cast<unsigned char>(uiLength);
+    }
+
+    return pDst;
+}
+
+
+RFCompressor::RFCompressor(unsigned int uiChunkSize, unsigned int uiNumThreads)
+    : m_uiChunkSize(std::max(1U, uiChunkSize))
+    , m_ThreadPool(uiNumThreads)
+{}
+
+
+unsigned int RFCompressor::compressBlock(const unsigned char* pSrc, unsigned int uiSize, unsigned char* pDst)
+{
+    // Position of the last occurrence of each hash.
+    unsigned int HashTable[1 << RF_COMPRESS_HASH_BITS];
+
+    memset(HashTable, 0, sizeof(HashTable));
+
+    const unsigned char* pIn     = pSrc;
+    const unsigned char* pAnchor = pSrc;
+    const unsigned char* pEnd    = pSrc + uiSize;
+    unsigned char*       pOut    = pDst;
+
+    if (uiSize > RF_COMPRESS_MATCH_LIMIT)
+    {
+        const unsigned char* pMatchStartLimit = pEnd - RF_COMPRESS_MATCH_LIMIT;
+        const unsigned char* pMatchEndLimit   = pEnd - RF_COMPRESS_LAST_LITERALS;
+
+        while (pIn < pMatchStartLimit)
+        {
+            const unsigned int   uiValue = readU32(pIn);
+            const unsigned int   uiHash  = hashU32(uiValue);
+            const unsigned char* pRef    = pSrc + HashTable[uiHash];
+
+            HashTable[uiHash] = static_cast<unsigned int>(pIn - pSrc);
+
+            if (pRef >= pIn || pIn - pRef > RF_COMPRESS_MAX_OFFSET || readU32(pRef) != uiValue)
+            {
+                // Skip faster through data without matches.
+                pIn += 1 + ((pIn - pAnchor) >> 6);
+                continue;
+            }
+
+            // Extend the match backwards into the pending literals.
+            while (pIn > pAnchor && pRef > pSrc && pIn[-1] == pRef[-1])
+            {
+                --pIn;
+                --pRef;
+            }
+
+            const unsigned char* pMatchEnd = pIn + RF_COMPRESS_MIN_MATCH;
+            const unsigned char* pRefEnd   = pRef + RF_COMPRESS_MIN_MATCH;
+
+            while (pMatchEnd < pMatchEndLimit && *pMatchEnd == *pRefEnd)
+            {
+                ++pMatchEnd;
+                ++pRefEnd;
+            }
+
+            pOut = writeSequence(pOut, pAnchor, static_cast<unsigned int>(pIn - pAnchor), static_cast<unsigned int>(pIn - pRef),
+                                 static_cast<unsigned int>(pMatchEnd - pIn));
+
+            pIn     = pMatchEnd;
+            pAnchor = pIn;
+        }
+    }
+
+    pOut = writeSequence(pOut, pAnchor, static_cast<unsigned int>(pEnd - pAnchor), 0, 0);
+
+    return static_cast<unsigned int>(pOut - pDst);
+}
+
+
+bool RFCompressor::compress(const void* pData, unsigned int uiSize, void* &pOutput, unsigned int& uiOutputSize)
+{
+    if (!pData)
+    {
+        return false;
+    }
+
+    const unsigned char* pSrc        = static_cast<const unsigned char*>(pData);
+    const unsigned int   uiNumChunks = (uiSize + m_uiChunkSize - 1) / m_uiChunkSize;
+    const unsigned int   uiSlotSize  = getMaxBlockSize(m_uiChunkSize);
+    const unsigned int   uiChunkSize = m_uiChunkSize;
+
+    // The buffers only grow, hence they are allocated once for a constant frame size.
+    try
+    {
+        m_Blocks.resize(static_cast<size_t>(uiNumChunks) * uiSlotSize);
+        m_BlockSizes.resize(uiNumChunks);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    unsigned char* pBlocks     = m_Blocks.data();
+    unsigned int*  pBlockSizes = m_BlockSizes.data();
+
+    m_ThreadPool.run(uiNumChunks, 1, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int i = uiBegin; i < uiEnd; ++i)
+        {
+            const unsigned int   uiBytes = std::min(uiChunkSize, uiSize - i * uiChunkSize);
+            const unsigned char* pChunk  = pSrc + static_cast<size_t>(i) * uiChunkSize;
+            unsigned char*       pBlock  = pBlocks + static_cast<size_t>(i) * uiSlotSize;
+
+            pBlockSizes[i] = compressBlock(pChunk, uiBytes, pBlock);
+
+            // Store chunks that do not shrink uncompressed.
+            if (pBlockSizes[i] >= uiBytes)
+            {
+                memcpy(pBlock, pChunk, uiBytes);
+                pBlockSizes[i] = uiBytes;
+            }
+        }
+    });
+
+    const unsigned int uiTableSize = sizeof(unsigned int) + uiNumChunks * sizeof(RFCompressedChunk);
+
+    size_t uiTotalSize = uiTableSize;
+
+    for (unsigned int i = 0; i < uiNumChunks; ++i)
+    {
+        uiTotalSize += pBlockSizes[i];
+    }
+
+    try
+    {
+        m_Output.resize(std::max(m_Output.size(), uiTotalSize));
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    unsigned char*     pDst    = m_Output.data();
+    RFCompressedChunk* pChunks = reinterpret_cast<RFCompressedChunk*>(pDst + sizeof(unsigned int));
+
+    memcpy(pDst, &uiNumChunks, sizeof(unsigned int));
+
+    unsigned int uiOffset = uiTableSize;
+
+    for (unsigned int i = 0; i < uiNumChunks; ++i)
+    {
+        pChunks[i].uiOffset           = uiOffset;
+        pChunks[i].uiSize             = pBlockSizes[i];
+        pChunks[i].uiUncompressedSize = std::min(uiChunkSize, uiSize - i * uiChunkSize);
+
+        uiOffset += pBlockSizes[i];
+    }
+
+    // Copy the blocks behind the chunk table.
+    m_ThreadPool.run(uiNumChunks, 1, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int i = uiBegin; i < uiEnd; ++i)
+        {
+            memcpy(pDst + pChunks[i].uiOffset, pBlocks + static_cast<size_t>(i) * uiSlotSize, pChunks[i].uiSize);
+        }
+    });
+
+    pOutput      = pDst;
+    uiOutputSize = static_cast<unsigned int>(uiTotalSize);
+
+    return true;
+}
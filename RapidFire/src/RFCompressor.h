@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <vector>
+
+#include "RapidFire.h"
+#include "RFThreadPool.h"
+
+// RFCompressor compresses the output of an encoder on the CPU. The buffer is split into chunks of equal size that
+// are compressed independently into LZ4 blocks by a thread pool. The output starts with the number of chunks
+// followed by one RFCompressedChunk per chunk and the data of the chunks. Chunks that do not shrink are stored
+// uncompressed. The output and the scratch buffers are kept across frames.
+class RFCompressor
+{
+public:
+
+    // Creates a compressor with uiNumThreads threads. If uiNumThreads is 0 the number of hardware threads is used.
+    RFCompressor(unsigned int uiChunkSize, unsigned int uiNumThreads);
+
+    // Compresses uiSize bytes of pData. pOutput is valid until the next call to compress.
+    bool                compress(const void* pData, unsigned int uiSize, void* &pOutput, unsigned int& uiOutputSize);
+
+    // Compresses uiSize bytes of pSrc into one LZ4 block. pDst needs to store getMaxBlockSize(uiSize) bytes.
+    // Returns the size of the block.
+    static unsigned int compressBlock(const unsigned char* pSrc, unsigned int uiSize, unsigned char* pDst);
+
+    static unsigned int getMaxBlockSize(unsigned int uiSize) { return uiSize + uiSize / 255 + 16; }
+
+    unsigned int        getChunkSize()  const { return m_uiChunkSize; }
+
+    unsigned int        getNumThreads() const { return m_ThreadPool.getNumThreads(); }
+
+private:
+
+    // Disable copy constructor.
+    RFCompressor(const RFCompressor& other);
+    // Disable assignment operator.
+    RFCompressor& operator=(const RFCompressor& rhs);
+
+    unsigned int                m_uiChunkSize;
+
+    RFThreadPool                m_ThreadPool;
+
+    // Each chunk is compressed into its own slot of getMaxBlockSize(m_uiChunkSize) bytes.
+    std::vector<unsigned char>  m_Blocks;
+    std::vector<unsigned int>   m_BlockSizes;
+
+    std::vector<unsigned char>  m_Output;
+};
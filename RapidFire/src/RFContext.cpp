@@ -37,6 +37,10 @@
 #include <CL/cl_gl.h>
 
 #include "RFError.h"
+#include "RFKernelCache.h"
+#include "RFKernelIL.h"
+#include "RFKernelTuner.h"
+#include "RFProgramRegistry.h"
 #include "RFUtils.h"
 
 #define clGetGLContextInfoKHR               clGetGLContextInfoKHR_proc
@@ -70,6 +74,13 @@ static clGetPlaneFromImageAMD_fn               pfn_clGetPlaneFromImageAMD = NULL
         } \
     }
 
+// cl_khr_il_program is not part of the OpenCL 1.2 headers.
+#ifndef CL_DEVICE_IL_VERSION_KHR
+#define CL_DEVICE_IL_VERSION_KHR            0x105B
+#endif
+
+typedef cl_program(CL_API_CALL *clCreateProgramWithILKHR_pfn) (cl_context, const void*, size_t, cl_int*);
+
 #define CSC_KERNEL_FILE_NAME    "rfkernels.cl"
 
 using namespace std;
@@ -83,6 +94,11 @@ public:
 
     const cl_platform_id id;
 
+    // Platform of contexts that read the input from system memory. These contexts do not share resources with
+    // a graphics API, so if no AMD platform is installed the first platform of any vendor is used (e.g. pocl
+    // on servers without GPU).
+    const cl_platform_id hostId;
+
     static const CLPlatform& getInstance()
     {
         /* all sessions share the same platform. */
@@ -94,10 +110,13 @@ public:
 private:
 
     CLPlatform()
-        : id(getPlatform("Advanced Micro Devices, Inc.", 12))
+        : id(getPlatform("Advanced Micro Devices, Inc.", 12, true))
+        , hostId(id ? id : getPlatform("", 12, false))
     {}
 
-    cl_platform_id CLPlatform::getPlatform(const std::string strPlatformName, unsigned int uiVersion)
+    // An empty strPlatformName matches the platform of any vendor. The interop extensions are only required
+    // by contexts that are created from a graphics API.
+    cl_platform_id CLPlatform::getPlatform(const std::string strPlatformName, unsigned int uiVersion, bool bInitExtensions)
     {
         ////////////////////////////////////////////////////////////////////
         // Get Platform IDs, and search for AMD platform.
@@ -174,6 +193,11 @@ private:
             return NULL;
         }
 
+        if (!bInitExtensions)
+        {
+            return pSelectedPlatform;
+        }
+
         // Init extension function pointers
         INIT_CL_EXT_FCN_PTR(pSelectedPlatform, clCreateFromD3D11BufferKHR);
         INIT_CL_EXT_FCN_PTR(pSelectedPlatform, clGetDeviceIDsFromD3D11KHR);
@@ -240,10 +264,6 @@ cl_event* RFEventCL::operator&()
 }
 
 
-uint64_t RFProgramCL::s_uiModuleVer = UINT64_MAX;
-uint64_t RFProgramCL::s_uiOpenCLVer = UINT64_MAX;
-std::mutex RFProgramCL::s_lock;
-
 bool RFProgramCL::Create(cl_context context, cl_device_id device, const char* kernelFileName, const char* kernelSourceCode, const char* options)
 {
     if (m_built || !context || !device || (!kernelFileName && !kernelSourceCode))
@@ -253,105 +273,93 @@ bool RFProgramCL::Create(cl_context context, cl_device_id device, const char* ke
 
     m_device = device;
 
+    std::string sourceCode;
+
 #ifdef _DEBUG
-    bool bUseKernelCache = false;
-#else
-    bool bUseKernelCache = (kernelFileName != nullptr);
+    // Kernels are loaded from the .cl file if it exists to allow changes without rebuilding the library.
+    sourceCode = ReadSourceFile(kernelFileName);
 #endif
 
-    s_lock.lock();
-    if (bUseKernelCache && s_uiModuleVer == UINT64_MAX)
-    {
-#ifdef _WIN64
-        s_uiModuleVer = GetModuleVer("RapidFire64.dll");
-#else
-        s_uiModuleVer = GetModuleVer("RapidFire.dll");
-#endif
-    }
+    // The offline compiled SPIR-V modules match the built-in source code only.
+    const bool bUseBuiltInSource = sourceCode.empty();
 
-    if (s_uiModuleVer == 0)
+    if (bUseBuiltInSource)
     {
-        bUseKernelCache = false;
+        if (!kernelSourceCode)
+        {
+            return false;
+        }
+
+        sourceCode = kernelSourceCode;
     }
 
-    if (bUseKernelCache && s_uiOpenCLVer == UINT64_MAX)
+    // The key covers the source code, a changed .cl file in debug builds results in a new program.
+    const bool     bUseKernelCache = RFKernelCache::isEnabled();
+    const uint64_t cacheKey = GetCacheKey(sourceCode.c_str(), options);
+
+    // try to use a program that was built for the same context by another session
+    m_program = RFProgramRegistry::acquire(context, m_device, cacheKey);
+    if (m_program)
     {
-#ifdef _WIN64
-        s_uiOpenCLVer = GetModuleVer("amdocl64.dll");
-#else
-        s_uiOpenCLVer = GetModuleVer("amdocl.dll");
-#endif
+        m_built = true;
+        return true;
     }
-    s_lock.unlock();
 
-    if (s_uiOpenCLVer == 0)
+    bool bBuilt = false;
+    bool bStoreBinary = false;
+
+    // try to create from a binary that was built by another session of this process
+    std::vector<unsigned char> binary;
+
+    if (RFProgramRegistry::getBinary(cacheKey, binary))
     {
-        bUseKernelCache = false;
+        bBuilt = BuildFromBinary(context, binary, options);
     }
 
-    std::string deviceName;
-    if (bUseKernelCache)
+    // try to create from the kernel cache
+    if (!bBuilt && bUseKernelCache && RFKernelCache::load(cacheKey, binary))
     {
-        deviceName = GetDeviceName();
-        if (deviceName.length() == 0)
+        bBuilt = BuildFromBinary(context, binary, options);
+
+        if (bBuilt)
         {
-            bUseKernelCache = false;
+            RFProgramRegistry::addBinary(cacheKey, binary);
         }
     }
 
-    std::string binFileName = kernelFileName;
-    binFileName += "bin";
-#ifdef _WIN64
-    binFileName += "64";
-#endif
+    // try to create from the embedded SPIR-V module
+    cl_uint addressBits = 0;
+    const unsigned char* il = nullptr;
+    size_t ilSize = 0;
 
-    // try to create from binary
-    if (bUseKernelCache)
+    if (!bBuilt && bUseBuiltInSource && clGetDeviceInfo(m_device, CL_DEVICE_ADDRESS_BITS, sizeof(cl_uint), &addressBits, nullptr) == CL_SUCCESS &&
+        getKernelIL(kernelFileName, sourceCode.c_str(), addressBits, &il, &ilSize))
     {
-        BinFileData binData = LoadBinaryFile(binFileName.c_str());
-
-        if (binData.moduleVer == s_uiModuleVer && binData.openCLVer == s_uiOpenCLVer && binData.deviceName.compare(deviceName) == 0)
-        {
-            const size_t dataSize = binData.data.size();
-            const unsigned char* binary = binData.data.data();
-
-            cl_int nStatus;
-            m_program = clCreateProgramWithBinary(context, 1, &device, &dataSize, &binary, nullptr, &nStatus);
-            if (nStatus == CL_SUCCESS)
-            {
-                nStatus = clBuildProgram(m_program, 1, &device, options, nullptr, nullptr);
-                if (nStatus == CL_SUCCESS)
-                {
-                    m_built = true;
-                    return true;
-                }
-            }
-        }
+        bBuilt = BuildFromIL(context, il, ilSize, options);
+        bStoreBinary = bBuilt;
     }
 
-#ifdef _DEBUG
-    // try to create from .cl file
-    if (BuildFromSourceFile(context, kernelFileName, options))
+    // create from source code
+    if (!bBuilt)
     {
-        m_built = true;
-        return true;
+        bBuilt = BuildFromSourceCode(context, sourceCode.c_str(), options);
+        bStoreBinary = bBuilt;
     }
-#endif
 
-    // create from built-in source code
-    if (BuildFromSourceCode(context, kernelSourceCode, options))
+    if (!bBuilt)
     {
-        m_built = true;
-
-        if (bUseKernelCache)
-        {
-            StoreBinaryFile(binFileName.c_str(), deviceName.c_str());
-        }
+        return false;
+    }
 
-        return true;
+    if (bStoreBinary)
+    {
+        StoreBinary(cacheKey, bUseKernelCache);
     }
 
-    return false;
+    m_program = RFProgramRegistry::add(context, m_device, cacheKey, m_program);
+    m_built = true;
+
+    return true;
 }
 
 std::string RFProgramCL::GetBuildLog() const
@@ -388,38 +396,22 @@ void RFProgramCL::Release()
 
     if (m_program)
     {
-        clReleaseProgram(m_program);
+        // Programs that failed to build are not registered.
+        if (!RFProgramRegistry::release(m_program))
+        {
+            clReleaseProgram(m_program);
+        }
+
         m_program = NULL;
     }
 }
 
-uint64_t RFProgramCL::GetModuleVer(const char* moduleName) const
+std::string RFProgramCL::GetCacheFilePath(const std::string& fileName)
 {
-    if (!moduleName)
-    {
-        return 0;
-    }
-
-    DWORD infoSize = GetFileVersionInfoSize(moduleName, NULL);
-
-    if (infoSize > 0 && infoSize < 4096)
-    {
-        void* pData = alloca(infoSize);
-        if (GetFileVersionInfo(moduleName, NULL, infoSize, pData))
-        {
-            VS_FIXEDFILEINFO* pFileInfo;
-            unsigned int uiInfoSize;
-            if (VerQueryValue(pData, TEXT("\\"), reinterpret_cast<LPVOID*>(&pFileInfo), &uiInfoSize) && uiInfoSize == sizeof(VS_FIXEDFILEINFO))
-            {
-                return (static_cast<uint64_t>(pFileInfo->dwFileVersionMS) << 32) | pFileInfo->dwFileVersionLS;
-            }
-        }
-    }
-
-    return 0;
+    return RFKernelCache::getFilePath(fileName);
 }
 
-std::string RFProgramCL::GetDeviceName() const
+std::string RFProgramCL::GetDeviceInfoString(cl_device_info param) const
 {
     if (!m_device)
     {
@@ -427,127 +419,162 @@ std::string RFProgramCL::GetDeviceName() const
     }
 
     cl_int nStatus;
-    size_t deviceNameLength;
+    size_t infoLength;
 
-    nStatus = clGetDeviceInfo(m_device, CL_DEVICE_NAME, 0, nullptr, &deviceNameLength);
-    if (nStatus == CL_SUCCESS && deviceNameLength < 512)
+    nStatus = clGetDeviceInfo(m_device, param, 0, nullptr, &infoLength);
+    if (nStatus == CL_SUCCESS && infoLength > 0 && infoLength < 4096)
     {
-        char* deviceName = static_cast<char*>(alloca(deviceNameLength));
-        nStatus = clGetDeviceInfo(m_device, CL_DEVICE_NAME, deviceNameLength, deviceName, nullptr);
+        std::vector<char> info(infoLength);
+        nStatus = clGetDeviceInfo(m_device, param, infoLength, info.data(), nullptr);
         if (nStatus == CL_SUCCESS)
         {
-            return deviceName;
+            return std::string(info.data());
         }
     }
 
     return std::string();
 }
 
-RFProgramCL::BinFileData RFProgramCL::LoadBinaryFile(const char* binaryFileName) const
+uint64_t RFProgramCL::GetCacheKey(const char* sourceCode, const char* options) const
 {
-    if (!binaryFileName)
-    {
-        return BinFileData();
-    }
+    std::string key = sourceCode;
+    key += '\0';
 
-    std::ifstream file(binaryFileName, std::ios::in | std::ios::binary);
-    if (!file)
+    if (options)
     {
-        return BinFileData();
+        key += options;
     }
+    key += '\0';
 
-    file.seekg(0, file.end);
-    size_t fileSize = static_cast<size_t>(file.tellg());
-    file.seekg(0, file.beg);
+    // The device and driver versions identify the compiler that created the binary. No ICD specific
+    // information like module versions is used to make the cache work with any OpenCL implementation.
+    const cl_device_info deviceInfo[] = { CL_DEVICE_NAME, CL_DEVICE_VENDOR, CL_DEVICE_VERSION, CL_DRIVER_VERSION };
 
-    if (fileSize > 1e8)
+    for (cl_device_info param : deviceInfo)
     {
-        file.close();
-        return BinFileData();
+        key += GetDeviceInfoString(param);
+        key += '\0';
     }
 
-    BinFileData binData;
-    file.read(reinterpret_cast<char*>(&binData.moduleVer), sizeof(binData.moduleVer));
-    if (!file)
+    cl_platform_id platform = NULL;
+    if (clGetDeviceInfo(m_device, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platform, nullptr) == CL_SUCCESS && platform)
     {
-        file.close();
-        return BinFileData();
+        char platformVersion[256] = {};
+        if (clGetPlatformInfo(platform, CL_PLATFORM_VERSION, sizeof(platformVersion) - 1, platformVersion, nullptr) == CL_SUCCESS)
+        {
+            key += platformVersion;
+        }
     }
+    key += '\0';
 
-    if (binData.moduleVer != s_uiModuleVer)
-    {
-        file.close();
-        return BinFileData();
-    }
+    // 32 and 64 bit builds of the library may get different binaries for the same device.
+    key += static_cast<char>(sizeof(void*));
 
-    file.read(reinterpret_cast<char*>(&binData.openCLVer), sizeof(binData.openCLVer));
-    if (!file)
+    return utilHash64(key.data(), key.size());
+}
+
+bool RFProgramCL::BuildFromBinary(cl_context context, const std::vector<unsigned char>& binary, const char* options)
+{
+    if (!context || binary.empty())
     {
-        file.close();
-        return BinFileData();
+        return false;
     }
 
-    if (binData.openCLVer != s_uiOpenCLVer)
+    const size_t dataSize = binary.size();
+    const unsigned char* data = binary.data();
+
+    cl_int nStatus;
+    cl_int nBinaryStatus;
+    m_program = clCreateProgramWithBinary(context, 1, &m_device, &dataSize, &data, &nBinaryStatus, &nStatus);
+    if (nStatus != CL_SUCCESS || nBinaryStatus != CL_SUCCESS)
     {
-        file.close();
-        return BinFileData();
+        if (m_program)
+        {
+            clReleaseProgram(m_program);
+            m_program = NULL;
+        }
+
+        return false;
     }
 
-    uint16_t deviceNameLength;
-    file.read(reinterpret_cast<char*>(&deviceNameLength), sizeof(deviceNameLength));
-    if (!file || deviceNameLength >= 512)
+    // A program created from an executable binary still needs to be built, but no compilation takes place.
+    nStatus = clBuildProgram(m_program, 1, &m_device, options, nullptr, nullptr);
+    if (nStatus != CL_SUCCESS)
     {
-        file.close();
-        return BinFileData();
+        clReleaseProgram(m_program);
+        m_program = NULL;
+
+        return false;
     }
 
-    char* deviceName = static_cast<char*>(alloca(deviceNameLength));
-    file.read(deviceName, deviceNameLength);
-    if (!file)
+    return true;
+}
+
+bool RFProgramCL::BuildFromIL(cl_context context, const unsigned char* il, size_t ilSize, const char* options)
+{
+    if (!context || !il || ilSize == 0)
     {
-        file.close();
-        return BinFileData();
+        return false;
     }
 
-    binData.deviceName = std::string(deviceName, deviceNameLength);
+    const std::string extensions = GetDeviceInfoString(CL_DEVICE_EXTENSIONS);
 
-    uint32_t dataSize;
-    file.read(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
-    if (!file)
+    cl_int nStatus = CL_INVALID_OPERATION;
+
+    if (extensions.find("cl_khr_il_program") != std::string::npos && GetDeviceInfoString(CL_DEVICE_IL_VERSION_KHR).find("SPIR-V") != std::string::npos)
     {
-        file.close();
-        return BinFileData();
+        cl_platform_id platform = NULL;
+        clGetDeviceInfo(m_device, CL_DEVICE_PLATFORM, sizeof(cl_platform_id), &platform, nullptr);
+
+        clCreateProgramWithILKHR_pfn pfn_clCreateProgramWithILKHR = reinterpret_cast<clCreateProgramWithILKHR_pfn>(clGetExtensionFunctionAddressForPlatform(platform, "clCreateProgramWithILKHR"));
+        if (pfn_clCreateProgramWithILKHR)
+        {
+            m_program = pfn_clCreateProgramWithILKHR(context, il, ilSize, &nStatus);
+        }
     }
+#ifdef CL_VERSION_2_1
+    else
+    {
+        // OpenCL 2.1 devices support IL programs without the extension. The device version has the
+        // format "OpenCL <major>.<minor> <vendor info>".
+        const std::string deviceVersion = GetDeviceInfoString(CL_DEVICE_VERSION);
 
-    size_t fileDataSize = fileSize - static_cast<size_t>(file.tellg());
-    if (dataSize != fileDataSize)
+        if (deviceVersion.compare(0, 7, "OpenCL ") == 0 && deviceVersion.compare(7, 3, "2.1") >= 0 &&
+            GetDeviceInfoString(CL_DEVICE_IL_VERSION).find("SPIR-V") != std::string::npos)
+        {
+            m_program = clCreateProgramWithIL(context, il, ilSize, &nStatus);
+        }
+    }
+#endif
+
+    if (nStatus != CL_SUCCESS)
     {
-        file.close();
-        return BinFileData();
+        m_program = NULL;
+        return false;
     }
 
-    binData.data.resize(dataSize);
-    file.read(reinterpret_cast<char*>(binData.data.data()), dataSize);
-    if (!file)
+    nStatus = clBuildProgram(m_program, 1, &m_device, options, nullptr, nullptr);
+    if (nStatus != CL_SUCCESS)
     {
-        file.close();
-        return BinFileData();
+        clReleaseProgram(m_program);
+        m_program = NULL;
+
+        return false;
     }
 
-    file.close();
-    return binData;
+    return true;
 }
 
-void RFProgramCL::StoreBinaryFile(const char* binaryFileName, const char* deviceName) const
+void RFProgramCL::StoreBinary(uint64_t cacheKey, bool bStoreInKernelCache) const
 {
-    if (!m_built || !binaryFileName || !deviceName || !s_uiModuleVer || !s_uiOpenCLVer || !m_program)
+    if (!m_program)
     {
         return;
     }
 
     size_t binSize;
     cl_int nStatus = clGetProgramInfo(m_program, CL_PROGRAM_BINARY_SIZES, sizeof(binSize), &binSize, nullptr);
-    if (nStatus != CL_SUCCESS || binSize >= 1e8)
+    if (nStatus != CL_SUCCESS || binSize == 0)
     {
         return;
     }
@@ -560,92 +587,31 @@ void RFProgramCL::StoreBinaryFile(const char* binaryFileName, const char* device
         return;
     }
 
-    std::ofstream file(binaryFileName, std::ios::out | std::ios::binary | std::ios::trunc);
-    if (!file)
-    {
-        return;
-    }
-
-    file.write(reinterpret_cast<char*>(&s_uiModuleVer), sizeof(s_uiModuleVer));
-    if (!file)
-    {
-        file.close();
-        return;
-    }
-
-    file.write(reinterpret_cast<char*>(&s_uiOpenCLVer), sizeof(s_uiOpenCLVer));
-    if (!file)
-    {
-        file.close();
-        return;
-    }
-
-    uint16_t deviceNameLength = static_cast<uint16_t>(strlen(deviceName));
-    file.write(reinterpret_cast<char*>(&deviceNameLength), sizeof(deviceNameLength));
-    if (!file)
-    {
-        file.close();
-        return;
-    }
-
-    file.write(deviceName, deviceNameLength);
-    if (!file)
-    {
-        file.close();
-        return;
-    }
-
-    uint32_t dataSize = static_cast<uint32_t>(binSize);
-    file.write(reinterpret_cast<char*>(&dataSize), sizeof(dataSize));
-    if (!file)
-    {
-        file.close();
-        return;
-    }
+    RFProgramRegistry::addBinary(cacheKey, binary);
 
-    file.write(reinterpret_cast<char*>(binary.data()), binSize);
-    if (!file)
+    if (bStoreInKernelCache)
     {
-        file.close();
-        return;
+        RFKernelCache::store(cacheKey, binary);
     }
-
-    file.close();
 }
 
-bool RFProgramCL::BuildFromSourceFile(cl_context context, const char* sourceFile, const char* options)
+std::string RFProgramCL::ReadSourceFile(const char* sourceFile) const
 {
-    if (!context || !sourceFile)
+    if (!sourceFile)
     {
-        return false;
+        return std::string();
     }
 
     std::ifstream srcFile(sourceFile, std::ios::in | std::ios::binary);
     if (!srcFile)
     {
-        return false;
-    }
-
-    srcFile.seekg(0, srcFile.end);
-    size_t size = static_cast<size_t>(srcFile.tellg());
-    srcFile.seekg(0, srcFile.beg);
-
-    if (size > 1e8)
-    {
-        return false;
-    }
-
-    std::vector<char> sourceCode(size);
-    srcFile.read(sourceCode.data(), size);
-    if (!srcFile)
-    {
-        srcFile.close();
-        return false;
+        return std::string();
     }
 
-    srcFile.close();
+    std::ostringstream sourceCode;
+    sourceCode << srcFile.rdbuf();
 
-    return BuildFromSourceCode(context, sourceCode.data(), options);
+    return sourceCode.str();
 }
 
 bool RFProgramCL::BuildFromSourceCode(cl_context context, const char* sourceCode, const char* options)
@@ -675,8 +641,9 @@ bool RFProgramCL::BuildFromSourceCode(cl_context context, const char* sourceCode
 //////////////////////////////////////////////////////////
 // Native CL context for CSC
 //////////////////////////////////////////////////////////
-RFContextCL::RFContextCL()
-    : m_uiNumResultBuffers(NUM_RESULT_BUFFERS)
+RFContextCL::RFContextCL(unsigned int uiNumResultBuffers, unsigned int uiMaxNumRenderTargets)
+    : m_uiNumResultBuffers(uiNumResultBuffers)
+    , m_uiMaxNumRenderTargets(uiMaxNumRenderTargets)
     , m_bValid(false)
     , m_bUseAsyncCopy(false)
     , m_uiOutputWidth(0)
@@ -696,30 +663,65 @@ RFContextCL::RFContextCL()
     , m_CtxType(RF_CTX_UNKNOWN)
     , m_TargetFormat(RF_FORMAT_UNKNOWN)
     , m_uiCSCKernelIdx(RF_KERNEL_UNKNOWN)
+    , m_uiCSCKernelVariant(RF_KERNEL_UNKNOWN)
     , m_fnAcquireInputMemObj(NULL)
     , m_fnReleaseInputMemObj(NULL)
     , m_fnAcquireDX9Obj(NULL)
     , m_fnReleaseDX9Obj(NULL)
     , m_fnAcquireDX11Obj(NULL)
     , m_fnReleaseDX11Obj(NULL)
+    , m_pHostCSC(nullptr)
+    , m_uiDiffMapSize(0)
+    , m_clDiffSignatures(NULL)
+    , m_bDiffSignaturesValid(false)
 {
     memset(m_CSCKernels, 0, RF_KERNEL_NUMBER * sizeof(CSC_KERNEL));
 
-    memset(m_clInputImage, 0, MAX_NUM_RENDER_TARGETS * sizeof(cl_mem));
+    if (m_uiNumResultBuffers < MIN_NUM_RESULT_BUFFERS || m_uiNumResultBuffers > MAX_NUM_RESULT_BUFFERS ||
+        m_uiMaxNumRenderTargets == 0 || m_uiMaxNumRenderTargets > MAX_NUM_RENDER_TARGETS)
+    {
+        throw std::runtime_error("Invalid number of result buffers or render targets");
+    }
+
+    m_clInputImage       = std::unique_ptr<cl_mem[]>(new cl_mem[m_uiMaxNumRenderTargets]);
+    m_rtState            = std::unique_ptr<RFRenderTargetState[]>(new RFRenderTargetState[m_uiMaxNumRenderTargets]);
+    m_pHostInput         = std::unique_ptr<const unsigned char*[]>(new const unsigned char*[m_uiMaxNumRenderTargets]);
 
-    for (int i = 0; i < NUM_RESULT_BUFFERS; ++i)
+    m_clResultBuffer     = std::unique_ptr<cl_mem[]>(new cl_mem[m_uiNumResultBuffers]);
+    m_clDMAFinished      = std::unique_ptr<RFEventCL[]>(new RFEventCL[m_uiNumResultBuffers]);
+    m_clCSCFinished      = std::unique_ptr<RFEventCL[]>(new RFEventCL[m_uiNumResultBuffers]);
+    m_clPageLockedBuffer = std::unique_ptr<cl_mem[]>(new cl_mem[m_uiNumResultBuffers]);
+    m_pSysmemBuffer      = std::unique_ptr<char*[]>(new char*[m_uiNumResultBuffers]);
+    m_clDiffMapBuffer    = std::unique_ptr<cl_mem[]>(new cl_mem[m_uiNumResultBuffers]);
+    m_bDiffMapValid      = std::unique_ptr<bool[]>(new bool[m_uiNumResultBuffers]);
+    m_bHostResultPending = std::unique_ptr<bool[]>(new bool[m_uiNumResultBuffers]);
+
+    for (unsigned int i = 0; i < m_uiMaxNumRenderTargets; ++i)
     {
+        m_clInputImage[i] = NULL;
         m_rtState[i] = RF_STATE_INVALID;
+        m_pHostInput[i] = nullptr;
+    }
+
+    for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
+    {
         m_clResultBuffer[i] = NULL;
         m_clPageLockedBuffer[i] = NULL;
         m_pSysmemBuffer[i] = nullptr;
+        m_bHostResultPending[i] = false;
+        m_clDiffMapBuffer[i] = NULL;
+        m_bDiffMapValid[i] = false;
     }
 
+    m_uiDiffBlockSize[0] = 0;
+    m_uiDiffBlockSize[1] = 0;
+
+    // Contexts created from a graphics API require the AMD platform. createContext() selects the host platform.
     m_clPlatformId = CLPlatform::getInstance().id;
 
-    if (m_clPlatformId == NULL)
+    if (CLPlatform::getInstance().hostId == NULL)
     {
-        throw std::runtime_error("No AMD platform");
+        throw std::runtime_error("No OpenCL platform");
     }
 
     // get version info of RapidFire.dll
@@ -817,12 +819,24 @@ RFContextCL::~RFContextCL()
 ////////////////////////////////////////////////////////////////////
 RFStatus RFContextCL::createContext()
 {
-    unsigned int uiNumDevices = 0;
+    // System memory input does not need interop with a graphics API and can run on any OpenCL platform.
+    m_clPlatformId = CLPlatform::getInstance().hostId;
+
+    unsigned int   uiNumDevices = 0;
+    cl_device_type DeviceType = CL_DEVICE_TYPE_GPU;
+
+    // Host memory input does not require a GPU. If no GPU is available, e.g. on a server, a CPU device is used.
+    if (clGetDeviceIDs(m_clPlatformId, DeviceType, 0, nullptr, &uiNumDevices) != CL_SUCCESS || uiNumDevices == 0)
+    {
+        DeviceType = CL_DEVICE_TYPE_CPU;
+        uiNumDevices = 0;
+
+        clGetDeviceIDs(m_clPlatformId, DeviceType, 0, nullptr, &uiNumDevices);
+    }
 
-    SAFE_CALL_CL(clGetDeviceIDs(m_clPlatformId, CL_DEVICE_TYPE_GPU, 0, nullptr, &uiNumDevices));
     if (uiNumDevices == 0)
     {
-        RF_Error(RF_STATUS_OPENCL_FAIL, "OpenCL GPU device is not found");
+        RF_Error(RF_STATUS_OPENCL_FAIL, "OpenCL device is not found");
         return RF_STATUS_OPENCL_FAIL;
     }
 
@@ -832,7 +846,7 @@ RFStatus RFContextCL::createContext()
         return RF_STATUS_MEMORY_FAIL;
     }
 
-    SAFE_CALL_CL(clGetDeviceIDs(m_clPlatformId, CL_DEVICE_TYPE_GPU, uiNumDevices, pDevices, nullptr));
+    SAFE_CALL_CL(clGetDeviceIDs(m_clPlatformId, DeviceType, uiNumDevices, pDevices, nullptr));
 
     // Simply take first matching device.
     m_clDevId = pDevices[0];
@@ -842,6 +856,16 @@ RFStatus RFContextCL::createContext()
     cl_context_properties pProperties[] = {CL_CONTEXT_PLATFORM, reinterpret_cast<cl_context_properties>(m_clPlatformId),
         0};
 
+    // Without a graphics context the input is stored in system memory. The CSC is done on the CPU
+    // since uploading the source, running the kernel and reading back the result is slower.
+    m_pHostCSC = std::unique_ptr<RFCSCHost>(new (nothrow) RFCSCHost);
+    if (!m_pHostCSC)
+    {
+        return RF_STATUS_MEMORY_FAIL;
+    }
+
+    m_CtxType = RF_CTX_CL;
+
     return finalizeContext(pProperties);
 }
 
@@ -905,6 +929,11 @@ RFStatus RFContextCL::createContext(DeviceCtx hDC, GraphicsCtx hGLRC)
 ////////////////////////////////////////////////////////////////////
 RFStatus RFContextCL::createContext(ID3D11Device* pD3D11Device)
 {
+    if (!m_clPlatformId)
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
     if (m_bValid || !pD3D11Device)
     {
         return RF_STATUS_FAIL;
@@ -952,6 +981,11 @@ RFStatus RFContextCL::createContext(ID3D11Device* pD3D11Device)
 ////////////////////////////////////////////////////////////////////
 RFStatus RFContextCL::createContext(IDirect3DDevice9* pD3D9Device)
 {
+    if (!m_clPlatformId)
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
     if (m_bValid || !pD3D9Device)
     {
         return RF_STATUS_FAIL;
@@ -1000,6 +1034,11 @@ RFStatus RFContextCL::createContext(IDirect3DDevice9* pD3D9Device)
 ////////////////////////////////////////////////////////////////////
 RFStatus RFContextCL::createContext(IDirect3DDevice9Ex* pD3D9ExDevice)
 {
+    if (!m_clPlatformId)
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
     if (m_bValid || !pD3D9ExDevice)
     {
         return RF_STATUS_FAIL;
@@ -1324,6 +1363,46 @@ RFStatus RFContextCL::setInputTexture(IDirect3DSurface9* pD3D9Texture, const uns
 }
 
 
+////////////////////////////////////////////////////////////////////
+// Set system memory input buffer.
+////////////////////////////////////////////////////////////////////
+RFStatus RFContextCL::setInputBuffer(const void* pHostBuffer, const unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx)
+{
+    unsigned int index;
+
+    idx = 0xFF;
+
+    if (m_CtxType != RF_CTX_CL || !pHostBuffer)
+    {
+        return RF_STATUS_INVALID_TEXTURE;
+    }
+
+    if (!validateDimensions(uiWidth, uiHeight))
+    {
+        return RF_STATUS_INVALID_DIMENSION;
+    }
+
+    // Get index of a free slot.
+    if (!getFreeRenderTargetIndex(index))
+    {
+        return RF_STATUS_RENDER_TARGET_FAIL;
+    }
+
+    m_pHostInput[index] = static_cast<const unsigned char*>(pHostBuffer);
+
+    m_rtState[index] = RF_STATE_FREE;
+
+    idx = index;
+
+    ++m_uiNumRegisteredRT;
+
+    m_uiInputWidth = uiWidth;
+    m_uiInputHeight = uiHeight;
+
+    return RF_STATUS_OK;
+}
+
+
 RFStatus RFContextCL::createBuffers(RFFormat format, unsigned int uiWidth, unsigned int uiHeight, unsigned int uiAlignedWidth, unsigned int uiAlignedHeight, bool bUseAsyncCopy)
 {
     cl_int nStatus;
@@ -1368,9 +1447,9 @@ RFStatus RFContextCL::createBuffers(RFFormat format, unsigned int uiWidth, unsig
     // Store target format. The CSC Context will convert the registered texture into this format.
     m_TargetFormat = format;
 
-    // Create NUM_RESULT_BUFFERS OpenCL buffers that will contain the YUV coded colors.
+    // Create m_uiNumResultBuffers OpenCL buffers that will contain the YUV coded colors.
     // An OpenCL kernel will convert color values from m_clImageBufferRGBA to YUV buffers.
-    for (int i = 0; i < NUM_RESULT_BUFFERS; ++i)
+    for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
     {
         // Create a pinned OpenCL buffer which is used to copy data back from the GPU to sys mem.
         m_clPageLockedBuffer[i] = clCreateBuffer(m_clCtx, CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, m_nOutputBufferSize, nullptr, &nStatus);
@@ -1406,18 +1485,48 @@ RFStatus RFContextCL::createBuffers(RFFormat format, unsigned int uiWidth, unsig
 
     SAFE_CALL_CL(nStatus);
 
+    // Create the buffers for the diff map that is computed while copying RGBA input. The CPU CSC of RF_CTX_CL
+    // contexts does not compute a diff map.
+    if (m_uiDiffBlockSize[0] > 0 && m_uiDiffBlockSize[1] > 0 && m_uiCSCKernelIdx == RF_KERNEL_RGBA_COPY && m_CtxType != RF_CTX_CL)
+    {
+        m_uiDiffMapSize = ((m_uiOutputWidth + m_uiDiffBlockSize[0] - 1) / m_uiDiffBlockSize[0]) * ((m_uiOutputHeight + m_uiDiffBlockSize[1] - 1) / m_uiDiffBlockSize[1]);
+
+        // The signatures don't need to be initialized. The first frame will mark all blocks as changed.
+        m_clDiffSignatures = clCreateBuffer(m_clCtx, CL_MEM_READ_WRITE, m_uiDiffMapSize * sizeof(cl_uint2), nullptr, &nStatus);
+        SAFE_CALL_CL(nStatus);
+
+        for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
+        {
+            m_clDiffMapBuffer[i] = clCreateBuffer(m_clCtx, CL_MEM_READ_WRITE, m_uiDiffMapSize, nullptr, &nStatus);
+            SAFE_CALL_CL(nStatus);
+        }
+
+        m_bDiffSignaturesValid = false;
+    }
+
     if (!configureKernels())
     {
         return RF_STATUS_OPENCL_FAIL;
     }
 
+    // The CPU CSC of RF_CTX_CL contexts does not use the kernels.
+    if (m_CtxType != RF_CTX_CL)
+    {
+        tuneKernels();
+    }
+
+    if (m_pHostCSC)
+    {
+        m_pHostCSC->setDimension(m_uiOutputWidth, m_uiOutputHeight, m_uiAlignedOutputWidth, m_uiAlignedOutputHeight);
+    }
+
     return RF_STATUS_OK;
 }
 
 
 RFStatus RFContextCL::deleteBuffers()
 {
-    for (int i = 0; i < NUM_RESULT_BUFFERS; ++i)
+    for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
     {
         m_clCSCFinished[i].release();
         m_clDMAFinished[i].release();
@@ -1435,7 +1544,7 @@ RFStatus RFContextCL::deleteBuffers()
 
     cl_int nStatus = CL_SUCCESS;
 
-    for (int i = 0; i < NUM_RESULT_BUFFERS; ++i)
+    for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
     {
         if (m_clPageLockedBuffer[i])
         {
@@ -1454,17 +1563,38 @@ RFStatus RFContextCL::deleteBuffers()
             m_clResultBuffer[i] = NULL;
         }
 
-        m_rtState[i] = RF_STATE_INVALID;
+        m_bHostResultPending[i] = false;
+
+        if (m_clDiffMapBuffer[i])
+        {
+            nStatus |= clReleaseMemObject(m_clDiffMapBuffer[i]);
+            m_clDiffMapBuffer[i] = NULL;
+        }
+
+        m_bDiffMapValid[i] = false;
+    }
+
+    if (m_clDiffSignatures)
+    {
+        nStatus |= clReleaseMemObject(m_clDiffSignatures);
+        m_clDiffSignatures = NULL;
     }
 
+    m_uiDiffMapSize = 0;
+    m_bDiffSignaturesValid = false;
 
-    for (unsigned int i = 0; i < MAX_NUM_RENDER_TARGETS; ++i)
+
+    for (unsigned int i = 0; i < m_uiMaxNumRenderTargets; ++i)
     {
         if (m_clInputImage[i])
         {
             nStatus |= clReleaseMemObject(m_clInputImage[i]);
             m_clInputImage[i] = NULL;
         }
+
+        m_pHostInput[i] = nullptr;
+
+        m_rtState[i] = RF_STATE_INVALID;
     }
 
     if (nStatus != CL_SUCCESS)
@@ -1526,6 +1656,18 @@ bool RFContextCL::configureKernels()
     m_CSCKernels[RF_KERNEL_RGBA_TO_NV12].uiLocalWorkSize[0] = 16;
     m_CSCKernels[RF_KERNEL_RGBA_TO_NV12].uiLocalWorkSize[1] = 16;
 
+    // Each work item converts 8 x 2 pixels.
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_VEC8].uiGlobalWorkSize[0] = m_uiOutputWidth / 8;
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_VEC8].uiGlobalWorkSize[1] = m_uiOutputHeight / 2;
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_VEC8].uiLocalWorkSize[0] = 16;
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_VEC8].uiLocalWorkSize[1] = 16;
+
+    // Each work item converts 1 x 2 pixels. The local size has to match the tile size of the kernel.
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_TILED].uiGlobalWorkSize[0] = m_uiOutputWidth;
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_TILED].uiGlobalWorkSize[1] = m_uiOutputHeight / 2;
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_TILED].uiLocalWorkSize[0] = 32;
+    m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_TILED].uiLocalWorkSize[1] = 8;
+
     m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_PLANES].uiGlobalWorkSize[0] = m_uiOutputWidth / 2;
     m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_PLANES].uiGlobalWorkSize[1] = m_uiOutputHeight / 2;
     m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_PLANES].uiLocalWorkSize[0] = 16;
@@ -1541,6 +1683,16 @@ bool RFContextCL::configureKernels()
     m_CSCKernels[RF_KERNEL_RGBA_COPY].uiLocalWorkSize[0] = 16;
     m_CSCKernels[RF_KERNEL_RGBA_COPY].uiLocalWorkSize[1] = 16;
 
+    // The diff kernel uses one work group per block. If no diff map is requested use the default
+    // block size, the kernel will not be used in this case.
+    cl_uint2 vBlockDim = {m_uiDiffBlockSize[0] > 0 ? m_uiDiffBlockSize[0] : 16,
+        m_uiDiffBlockSize[1] > 0 ? m_uiDiffBlockSize[1] : 16};
+
+    m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].uiGlobalWorkSize[0] = ((m_uiOutputWidth + vBlockDim.s[0] - 1) / vBlockDim.s[0]) * 8;
+    m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].uiGlobalWorkSize[1] = ((m_uiOutputHeight + vBlockDim.s[1] - 1) / vBlockDim.s[1]) * 8;
+    m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].uiLocalWorkSize[0] = 8;
+    m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].uiLocalWorkSize[1] = 8;
+
     cl_int4 vDim = {static_cast<int>(m_uiOutputWidth),
         static_cast<int>(m_uiOutputHeight),
         static_cast<int>(m_uiAlignedOutputWidth),
@@ -1566,6 +1718,23 @@ bool RFContextCL::configureKernels()
         }
     }
 
+    m_uiCSCKernelVariant = m_uiCSCKernelIdx;
+
+    if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_TO_NV12)
+    {
+        // The vec8 kernel writes the Y and UV values of 8 pixels per row with a single store but can only
+        // be used if the width is a multiple of 8. Otherwise use the tiled kernel which writes coalesced Y
+        // and UV values as well.
+        if ((m_uiOutputWidth % 8) == 0)
+        {
+            m_uiCSCKernelVariant = RF_KERNEL_RGBA_TO_NV12_VEC8;
+        }
+        else
+        {
+            m_uiCSCKernelVariant = RF_KERNEL_RGBA_TO_NV12_TILED;
+        }
+    }
+
     if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_COPY)
     {
         // The RGBA copy kernel converts RGBA input to one of the following outputs:
@@ -1580,12 +1749,190 @@ bool RFContextCL::configureKernels()
         {
             return false;
         }
+
+        if (clSetKernelArg(m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].kernel, 4, sizeof(cl_int), &m_TargetFormat) != CL_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    if (m_clDiffSignatures)
+    {
+        // Set Argument 7: Block signatures of the previous frame
+        if (clSetKernelArg(m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].kernel, 6, sizeof(cl_mem), &m_clDiffSignatures) != CL_SUCCESS)
+        {
+            return false;
+        }
+
+        // Set Argument 8: Block size
+        if (clSetKernelArg(m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].kernel, 7, sizeof(cl_uint2), &vBlockDim) != CL_SUCCESS)
+        {
+            return false;
+        }
     }
 
     return true;
 }
 
 
+// Local work sizes that are timed for kernels that compute a fixed number of pixels per work item.
+static const size_t s_TuningLocalSizes[][2] = { { 16, 16 }, { 32, 8 }, { 64, 4 }, { 8, 8 } };
+
+
+static void addTuningCandidate(std::vector<RFKernelTuner::Candidate>& Candidates, cl_kernel kernel, unsigned int uiVariant,
+                               size_t uiItemsX, size_t uiItemsY, size_t uiLocalX, size_t uiLocalY)
+{
+    RFKernelTuner::Candidate c;
+
+    c.kernel              = kernel;
+    c.uiVariant           = uiVariant;
+    c.uiLocalWorkSize[0]  = uiLocalX;
+    c.uiLocalWorkSize[1]  = uiLocalY;
+    c.uiGlobalWorkSize[0] = ((uiItemsX + uiLocalX - 1) / uiLocalX) * uiLocalX;
+    c.uiGlobalWorkSize[1] = ((uiItemsY + uiLocalY - 1) / uiLocalY) * uiLocalY;
+
+    Candidates.push_back(c);
+}
+
+
+void RFContextCL::tuneKernels()
+{
+    if (m_uiCSCKernelVariant <= RF_KERNEL_UNKNOWN || m_uiCSCKernelVariant >= RF_KERNEL_NUMBER)
+    {
+        return;
+    }
+
+    // If a diff map is computed, the RF_KERNEL_RGBA_COPY_DIFF kernel is used instead of m_uiCSCKernelVariant.
+    const csc_kernel uiDefaultKernel = (m_uiCSCKernelIdx == RF_KERNEL_RGBA_COPY && m_clDiffSignatures) ? RF_KERNEL_RGBA_COPY_DIFF : m_uiCSCKernelVariant;
+
+    std::vector<RFKernelTuner::Candidate> Candidates;
+    std::ostringstream                    oss;
+    std::string                           strKernel;
+
+    oss << m_uiOutputWidth << "x" << m_uiOutputHeight;
+
+    // The first candidate is the configuration selected by configureKernels.
+    RFKernelTuner::Candidate Default;
+
+    Default.kernel              = m_CSCKernels[uiDefaultKernel].kernel;
+    Default.uiVariant           = uiDefaultKernel;
+    Default.uiGlobalWorkSize[0] = m_CSCKernels[uiDefaultKernel].uiGlobalWorkSize[0];
+    Default.uiGlobalWorkSize[1] = m_CSCKernels[uiDefaultKernel].uiGlobalWorkSize[1];
+    Default.uiLocalWorkSize[0]  = m_CSCKernels[uiDefaultKernel].uiLocalWorkSize[0];
+    Default.uiLocalWorkSize[1]  = m_CSCKernels[uiDefaultKernel].uiLocalWorkSize[1];
+
+    Candidates.push_back(Default);
+
+    if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_TO_NV12)
+    {
+        strKernel = "rgbaTonv12";
+
+        for (const auto& l : s_TuningLocalSizes)
+        {
+            // 2x2 pixels per work item
+            addTuningCandidate(Candidates, m_CSCKernels[RF_KERNEL_RGBA_TO_NV12].kernel, RF_KERNEL_RGBA_TO_NV12, m_uiOutputWidth / 2, m_uiOutputHeight / 2, l[0], l[1]);
+
+            // 8x2 pixels per work item
+            if ((m_uiOutputWidth % 8) == 0)
+            {
+                addTuningCandidate(Candidates, m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_VEC8].kernel, RF_KERNEL_RGBA_TO_NV12_VEC8, m_uiOutputWidth / 8, m_uiOutputHeight / 2, l[0], l[1]);
+            }
+        }
+
+        // The tiled kernel requires a local size of 32x8 and computes 1x2 pixels per work item.
+        addTuningCandidate(Candidates, m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_TILED].kernel, RF_KERNEL_RGBA_TO_NV12_TILED, m_uiOutputWidth, m_uiOutputHeight / 2, 32, 8);
+    }
+    else if (uiDefaultKernel == RF_KERNEL_RGBA_COPY_DIFF)
+    {
+        strKernel = "copy_rgba_diff";
+
+        oss << " " << m_uiDiffBlockSize[0] << "x" << m_uiDiffBlockSize[1];
+
+        // One work group per block. The number of pixels per work item is defined by the local size.
+        const size_t uiNumBlocksX = (m_uiOutputWidth + m_uiDiffBlockSize[0] - 1) / m_uiDiffBlockSize[0];
+        const size_t uiNumBlocksY = (m_uiOutputHeight + m_uiDiffBlockSize[1] - 1) / m_uiDiffBlockSize[1];
+
+        static const size_t BlockLocalSizes[][2] = { { 8, 8 }, { 16, 8 }, { 16, 16 }, { 32, 8 } };
+
+        for (const auto& l : BlockLocalSizes)
+        {
+            if (l[0] <= m_uiDiffBlockSize[0] && l[1] <= m_uiDiffBlockSize[1])
+            {
+                addTuningCandidate(Candidates, m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].kernel, RF_KERNEL_RGBA_COPY_DIFF, uiNumBlocksX * l[0], uiNumBlocksY * l[1], l[0], l[1]);
+            }
+        }
+    }
+    else if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_COPY)
+    {
+        strKernel = "copy_rgba";
+
+        for (const auto& l : s_TuningLocalSizes)
+        {
+            addTuningCandidate(Candidates, m_CSCKernels[RF_KERNEL_RGBA_COPY].kernel, RF_KERNEL_RGBA_COPY, m_uiOutputWidth, m_uiOutputHeight, l[0], l[1]);
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    // The candidates are timed with a scratch input image and write into the first result buffer.
+    cl_int          nStatus;
+    cl_image_format ImageFormat = { CL_RGBA, CL_UNORM_INT8 };
+    cl_image_desc   ImageDesc;
+
+    memset(&ImageDesc, 0, sizeof(ImageDesc));
+
+    ImageDesc.image_type   = CL_MEM_OBJECT_IMAGE2D;
+    ImageDesc.image_width  = m_uiOutputWidth;
+    ImageDesc.image_height = m_uiOutputHeight;
+
+    cl_mem clScratchImage = clCreateImage(m_clCtx, CL_MEM_READ_ONLY, &ImageFormat, &ImageDesc, nullptr, &nStatus);
+
+    if (nStatus != CL_SUCCESS)
+    {
+        return;
+    }
+
+    bool bArgsSet = true;
+
+    for (const auto& c : Candidates)
+    {
+        bArgsSet &= (clSetKernelArg(c.kernel, 0, sizeof(cl_mem), &clScratchImage) == CL_SUCCESS);
+        bArgsSet &= (clSetKernelArg(c.kernel, 1, sizeof(cl_mem), &m_clResultBuffer[0]) == CL_SUCCESS);
+
+        if (c.uiVariant == RF_KERNEL_RGBA_COPY_DIFF)
+        {
+            cl_int nForceDiff = 1;
+
+            bArgsSet &= (clSetKernelArg(c.kernel, 5, sizeof(cl_mem), &m_clDiffMapBuffer[0]) == CL_SUCCESS);
+            bArgsSet &= (clSetKernelArg(c.kernel, 8, sizeof(cl_int), &nForceDiff) == CL_SUCCESS);
+        }
+    }
+
+    if (bArgsSet)
+    {
+        RFKernelTuner Tuner(m_clCtx, m_clDevId);
+
+        const RFKernelTuner::Candidate& Best = Candidates[Tuner.selectCandidate(strKernel, str_cl_kernels, oss.str(), Candidates)];
+
+        const csc_kernel uiBestKernel = static_cast<csc_kernel>(Best.uiVariant);
+
+        m_CSCKernels[uiBestKernel].uiGlobalWorkSize[0] = Best.uiGlobalWorkSize[0];
+        m_CSCKernels[uiBestKernel].uiGlobalWorkSize[1] = Best.uiGlobalWorkSize[1];
+        m_CSCKernels[uiBestKernel].uiLocalWorkSize[0]  = Best.uiLocalWorkSize[0];
+        m_CSCKernels[uiBestKernel].uiLocalWorkSize[1]  = Best.uiLocalWorkSize[1];
+
+        if (uiBestKernel != RF_KERNEL_RGBA_COPY_DIFF)
+        {
+            m_uiCSCKernelVariant = uiBestKernel;
+        }
+    }
+
+    clReleaseMemObject(clScratchImage);
+}
+
+
 RFStatus RFContextCL::acquireCLMemObj(cl_command_queue clQueue, unsigned int idx, unsigned int numEvents, cl_event* eventsWait, cl_event* eventReturned)
 {
     if (m_fnAcquireInputMemObj)
@@ -1622,7 +1969,7 @@ RFStatus RFContextCL::releaseCLMemObj(cl_command_queue clQueue, unsigned int idx
 
 RFStatus RFContextCL::removeCLInputMemObj(unsigned int idx)
 {
-    if (idx >= MAX_NUM_RENDER_TARGETS)
+    if (idx >= m_uiMaxNumRenderTargets)
     {
         return RF_STATUS_INVALID_INDEX;
     }
@@ -1638,6 +1985,7 @@ RFStatus RFContextCL::removeCLInputMemObj(unsigned int idx)
 
     m_rtState[idx] = RF_STATE_INVALID;
     m_clInputImage[idx] = NULL;
+    m_pHostInput[idx] = nullptr;
 
     --m_uiNumRegisteredRT;
 
@@ -1647,7 +1995,7 @@ RFStatus RFContextCL::removeCLInputMemObj(unsigned int idx)
 
 RFStatus RFContextCL::getInputMemObjState(RFRenderTargetState* state, unsigned int idx) const
 {
-    if (idx >= MAX_NUM_RENDER_TARGETS)
+    if (idx >= m_uiMaxNumRenderTargets)
     {
         *state = RF_STATE_INVALID;
         return RF_STATUS_INVALID_INDEX;
@@ -1662,6 +2010,18 @@ RFStatus RFContextCL::getInputMemObjState(RFRenderTargetState* state, unsigned i
 // The correctness of idx is verfied in RFSession::encodeFrame.
 void RFContextCL::getResultBuffer(unsigned int idx, cl_mem* pBuffer) const
 {
+    if (m_bHostResultPending[idx])
+    {
+        // The CSC was done on the CPU. Upload the result only if it is used on the GPU, e.g. by the
+        // diff encoder. The CSC event signals the completion of the upload.
+        m_clCSCFinished[idx].release();
+
+        clEnqueueWriteBuffer(m_clCmdQueue, m_clResultBuffer[idx], CL_FALSE, 0, m_nOutputBufferSize, m_pSysmemBuffer[idx], 0, nullptr, &m_clCSCFinished[idx]);
+        clFlush(m_clCmdQueue);
+
+        m_bHostResultPending[idx] = false;
+    }
+
     *pBuffer = m_clResultBuffer[idx];
 }
 
@@ -1670,7 +2030,8 @@ void RFContextCL::getResultBuffer(unsigned int idx, void* &pBuffer) const
 {
     pBuffer = nullptr;
 
-    if (!m_bUseAsyncCopy)
+    // Results of the CPU CSC are already in sys mem.
+    if (!m_bUseAsyncCopy && m_CtxType != RF_CTX_CL)
     {
         clEnqueueCopyBuffer(m_clCmdQueue, m_clResultBuffer[idx], m_clPageLockedBuffer[idx], 0, 0, m_nOutputBufferSize, 0, nullptr, nullptr);
         clFinish(m_clCmdQueue);
@@ -1694,6 +2055,27 @@ void RFContextCL::getInputImage(unsigned int idx, cl_mem* pBuffer) const
 }
 
 
+bool RFContextCL::getDiffMapBuffer(unsigned int idx, cl_mem* pBuffer) const
+{
+    if (idx >= m_uiNumResultBuffers || !m_bDiffMapValid[idx])
+    {
+        *pBuffer = NULL;
+        return false;
+    }
+
+    *pBuffer = m_clDiffMapBuffer[idx];
+
+    return true;
+}
+
+
+void RFContextCL::enableDiffMap(unsigned int uiBlockWidth, unsigned int uiBlockHeight)
+{
+    m_uiDiffBlockSize[0] = uiBlockWidth;
+    m_uiDiffBlockSize[1] = uiBlockHeight;
+}
+
+
 RFStatus RFContextCL::processBuffer(bool bRunCSC, bool bInvert, unsigned int uiSrcIdx, unsigned int uiDestIdx)
 {
     if (!m_bValid)
@@ -1719,6 +2101,22 @@ RFStatus RFContextCL::processBuffer(bool bRunCSC, bool bInvert, unsigned int uiS
         return RF_STATUS_INVALID_OPENCL_MEMOBJ;
     }
 
+    // The diff map of the destination buffer is only valid if it gets computed by the RF_KERNEL_RGBA_COPY_DIFF kernel.
+    // If a frame is processed without computing the signatures, the signatures of the next frame cannot be compared.
+    const bool bComputeDiffMap = (m_clDiffSignatures && bRunCSC && m_uiCSCKernelIdx == RF_KERNEL_RGBA_COPY);
+
+    m_bDiffMapValid[uiDestIdx] = false;
+
+    if (!bComputeDiffMap)
+    {
+        m_bDiffSignaturesValid = false;
+    }
+
+    if (m_CtxType == RF_CTX_CL)
+    {
+        return processHostBuffer(bRunCSC, bInvert, uiSrcIdx, uiDestIdx);
+    }
+
     // Acquire OpenCL object from OpenGl/D3D object.
     RFEventCL clAcquireImageEvent;
     RFStatus rfStatus = acquireCLMemObj(m_clCmdQueue, uiSrcIdx, 0, nullptr, &clAcquireImageEvent);
@@ -1730,21 +2128,36 @@ RFStatus RFContextCL::processBuffer(bool bRunCSC, bool bInvert, unsigned int uiS
 
     if (bRunCSC || m_uiCSCKernelIdx != RF_KERNEL_RGBA_COPY)
     {
+        const csc_kernel uiKernelIdx = (bComputeDiffMap) ? RF_KERNEL_RGBA_COPY_DIFF : m_uiCSCKernelVariant;
+
         // RGBA input buffer (src)
-        SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[m_uiCSCKernelIdx].kernel, 0, sizeof(cl_mem), static_cast<void*>(&(m_clInputImage[uiSrcIdx]))));
+        SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[uiKernelIdx].kernel, 0, sizeof(cl_mem), static_cast<void*>(&(m_clInputImage[uiSrcIdx]))));
 
         // output buffer (dst)
-        SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[m_uiCSCKernelIdx].kernel, 1, sizeof(cl_mem), static_cast<void*>(&(m_clResultBuffer[uiDestIdx]))));
+        SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[uiKernelIdx].kernel, 1, sizeof(cl_mem), static_cast<void*>(&(m_clResultBuffer[uiDestIdx]))));
 
         int nInvert = (bInvert) ? 1 : 0;
-        SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[m_uiCSCKernelIdx].kernel, 3, sizeof(cl_int), static_cast<void*>(&nInvert)));
+        SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[uiKernelIdx].kernel, 3, sizeof(cl_int), static_cast<void*>(&nInvert)));
 
-        SAFE_CALL_CL(clEnqueueNDRangeKernel(m_clCmdQueue, m_CSCKernels[m_uiCSCKernelIdx].kernel, 2, nullptr,
-                                            m_CSCKernels[m_uiCSCKernelIdx].uiGlobalWorkSize, m_CSCKernels[m_uiCSCKernelIdx].uiLocalWorkSize, 0,
+        if (bComputeDiffMap)
+        {
+            // diff map (dst)
+            SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[uiKernelIdx].kernel, 5, sizeof(cl_mem), static_cast<void*>(&(m_clDiffMapBuffer[uiDestIdx]))));
+
+            // Mark all blocks as changed if the signatures do not belong to the previous frame.
+            int nForceDiff = (m_bDiffSignaturesValid) ? 0 : 1;
+            SAFE_CALL_CL(clSetKernelArg(m_CSCKernels[uiKernelIdx].kernel, 8, sizeof(cl_int), static_cast<void*>(&nForceDiff)));
+        }
+
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(m_clCmdQueue, m_CSCKernels[uiKernelIdx].kernel, 2, nullptr,
+                                            m_CSCKernels[uiKernelIdx].uiGlobalWorkSize, m_CSCKernels[uiKernelIdx].uiLocalWorkSize, 0,
                                             nullptr, &m_clCSCFinished[uiDestIdx]));
 
         clFlush(m_clCmdQueue);
 
+        m_bDiffMapValid[uiDestIdx] = bComputeDiffMap;
+        m_bDiffSignaturesValid = bComputeDiffMap;
+
         if (m_bUseAsyncCopy)
         {
             clEnqueueCopyBuffer(m_clDMAQueue, m_clResultBuffer[uiDestIdx], m_clPageLockedBuffer[uiDestIdx], 0, 0, m_nOutputBufferSize, 1, &m_clCSCFinished[uiDestIdx], &m_clDMAFinished[uiDestIdx]);
@@ -1781,12 +2194,65 @@ RFStatus RFContextCL::processBuffer(bool bRunCSC, bool bInvert, unsigned int uiS
 }
 
 
+RFStatus RFContextCL::processHostBuffer(bool bRunCSC, bool bInvert, unsigned int uiSrcIdx, unsigned int uiDestIdx)
+{
+    if (uiSrcIdx >= m_uiMaxNumRenderTargets || !m_pHostInput[uiSrcIdx] || !m_pHostCSC)
+    {
+        return RF_STATUS_INVALID_RENDER_TARGET;
+    }
+
+    if (!m_pSysmemBuffer[uiDestIdx])
+    {
+        return RF_STATUS_INVALID_OPENCL_MEMOBJ;
+    }
+
+    m_rtState[uiSrcIdx] = RF_STATE_BLOCKED;
+
+    bool bResult = false;
+
+    unsigned char* pDest = reinterpret_cast<unsigned char*>(m_pSysmemBuffer[uiDestIdx]);
+
+    if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_TO_NV12)
+    {
+        bResult = m_pHostCSC->convertToNV12(m_pHostInput[uiSrcIdx], pDest, bInvert);
+    }
+    else if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_TO_I420)
+    {
+        bResult = m_pHostCSC->convertToI420(m_pHostInput[uiSrcIdx], pDest, bInvert);
+    }
+    else if (m_uiCSCKernelIdx == RF_KERNEL_RGBA_COPY)
+    {
+        // Without CSC the input is copied without any reordering like clEnqueueCopyImageToBuffer.
+        if (bRunCSC)
+        {
+            bResult = m_pHostCSC->copyRGBA(m_pHostInput[uiSrcIdx], pDest, m_TargetFormat, bInvert);
+        }
+        else
+        {
+            bResult = m_pHostCSC->copyRGBA(m_pHostInput[uiSrcIdx], pDest, RF_RGBA8, false);
+        }
+    }
+
+    m_rtState[uiSrcIdx] = RF_STATE_FREE;
+
+    if (!bResult)
+    {
+        return RF_STATUS_FAIL;
+    }
+
+    // The result buffer on the GPU gets updated once it is requested.
+    m_bHostResultPending[uiDestIdx] = true;
+
+    return RF_STATUS_OK;
+}
+
+
 bool RFContextCL::getFreeRenderTargetIndex(unsigned int& uiIndex)
 {
-    if (m_uiNumRegisteredRT >= MAX_NUM_RENDER_TARGETS)
+    if (m_uiNumRegisteredRT >= m_uiMaxNumRenderTargets)
     {
         char buf[256];
-        sprintf_s(buf, 256, "Exceed the maximum number of render targets: %d", MAX_NUM_RENDER_TARGETS);
+        sprintf_s(buf, 256, "Exceed the maximum number of render targets: %u", m_uiMaxNumRenderTargets);
         RF_Error(RF_STATUS_RENDER_TARGET_FAIL, buf);
 
         return false;
@@ -1794,7 +2260,7 @@ bool RFContextCL::getFreeRenderTargetIndex(unsigned int& uiIndex)
 
     // Find a render target index whose state is invalid.
     bool found = false;
-    for (int i = 0; i < MAX_NUM_RENDER_TARGETS; ++i)
+    for (unsigned int i = 0; i < m_uiMaxNumRenderTargets; ++i)
     {
         if (m_rtState[i] == RF_STATE_INVALID)
         {
@@ -1819,12 +2285,18 @@ RFStatus RFContextCL::setupKernel()
         // Create color space conversion kernels.
         m_CSCKernels[RF_KERNEL_RGBA_TO_NV12].kernel = clCreateKernel(m_clCscProgram, "rgbaTonv12_image2d", &nStatus);
         SAFE_CALL_CL(nStatus);
+        m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_VEC8].kernel = clCreateKernel(m_clCscProgram, "rgbaTonv12_image2d_vec8", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_TILED].kernel = clCreateKernel(m_clCscProgram, "rgbaTonv12_image2d_tiled", &nStatus);
+        SAFE_CALL_CL(nStatus);
         m_CSCKernels[RF_KERNEL_RGBA_TO_NV12_PLANES].kernel = clCreateKernel(m_clCscProgram, "rgbaToNV12_Planes", &nStatus);
         SAFE_CALL_CL(nStatus);
         m_CSCKernels[RF_KERNEL_RGBA_TO_I420].kernel = clCreateKernel(m_clCscProgram, "rgbaToI420_image2d", &nStatus);
         SAFE_CALL_CL(nStatus);
         m_CSCKernels[RF_KERNEL_RGBA_COPY].kernel = clCreateKernel(m_clCscProgram, "copy_rgba_image2d", &nStatus);
         SAFE_CALL_CL(nStatus);
+        m_CSCKernels[RF_KERNEL_RGBA_COPY_DIFF].kernel = clCreateKernel(m_clCscProgram, "copy_rgba_diff_image2d", &nStatus);
+        SAFE_CALL_CL(nStatus);
 
         return RF_STATUS_OK;
     }
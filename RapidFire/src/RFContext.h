@@ -22,6 +22,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -29,6 +30,7 @@
 #include <CL/cl.h>
 
 #include "RapidFire.h"
+#include "RFCSCHost.h"
 #include "RFPlatform.h"
 #include "RFTypes.h"
 
@@ -69,6 +71,9 @@ public:
 
     void Release();
 
+    // Returns the path of a file in the kernel cache.
+    static std::string GetCacheFilePath(const std::string& fileName);
+
     operator cl_program() const { return m_program; }
 
     operator bool() const
@@ -83,32 +88,28 @@ private:
     // Disable assignment
     RFProgramCL& operator=(const RFProgramCL& rhs);
 
-    uint64_t GetModuleVer(const char* moduleName) const;
-    std::string GetDeviceName() const;
+    std::string GetDeviceInfoString(cl_device_info param) const;
 
-    struct BinFileData
-    {
-        BinFileData() : moduleVer(0), openCLVer(0) {}
+    // Computes the key of the program in the program registry and the kernel cache. The key is a hash of
+    // the source code, the build options and the device, driver and platform versions.
+    uint64_t GetCacheKey(const char* sourceCode, const char* options) const;
+
+    bool BuildFromBinary(cl_context context, const std::vector<unsigned char>& binary, const char* options);
+
+    // Creates the program from a SPIR-V module. Returns false if the device does not accept SPIR-V.
+    bool BuildFromIL(cl_context context, const unsigned char* il, size_t ilSize, const char* options);
 
-        uint64_t moduleVer;
-        uint64_t openCLVer;
-        std::string deviceName;
-        std::vector<unsigned char> data;
-    };
-    BinFileData LoadBinaryFile(const char* binaryFileName) const;
-    void StoreBinaryFile(const char* binaryFileName, const char* deviceName) const;
+    // Keeps the binary of the built program in memory for other sessions and stores it in the kernel cache.
+    void StoreBinary(uint64_t cacheKey, bool bStoreInKernelCache) const;
+
+    std::string ReadSourceFile(const char* sourceFile) const;
 
     bool BuildFromSourceCode(cl_context context, const char* sourceCode, const char* options);
-    bool BuildFromSourceFile(cl_context context, const char* sourceFile, const char* options);
 
     cl_device_id		m_device;
     cl_program			m_program;
     bool				m_built;
 
-    static uint64_t		s_uiModuleVer;
-    static uint64_t		s_uiOpenCLVer;
-    static std::mutex	s_lock;
-
 
 };
 
@@ -117,10 +118,11 @@ class RFContextCL
 {
 public:
 
-    explicit RFContextCL();
+    // uiNumResultBuffers is the pipeline depth of the session, uiMaxNumRenderTargets the number of render targets that can be registered.
+    RFContextCL(unsigned int uiNumResultBuffers, unsigned int uiMaxNumRenderTargets);
     virtual ~RFContextCL();
 
-    // Creates OpenCL context.
+    // Creates OpenCL context. Input is read from system memory and the CSC runs on the CPU.
     virtual RFStatus    createContext();
     // Creates OpenCL context based on an existing OpenGL context.
     virtual RFStatus    createContext(DeviceCtx hDC, GraphicsCtx hGLRC);
@@ -143,6 +145,12 @@ public:
     virtual RFStatus    setInputTexture(ID3D11Texture2D* pD3D11Texture, const unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx);
     // registers DX 9 texture.
     virtual RFStatus    setInputTexture(IDirect3DSurface9* pD3D9Texture, const unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx);
+    // Registers a RGBA8 buffer in system memory. Only supported by contexts created with createContext().
+    RFStatus            setInputBuffer(const void* pHostBuffer, const unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx);
+
+    // Enables the computation of a diff map with a block size of uiBlockWidth x uiBlockHeight while the RGBA input is copied.
+    // Needs to be called before createBuffers.
+    void                enableDiffMap(unsigned int uiBlockWidth, unsigned int uiBlockHeight);
 
     // Converts color space. The input buffer is m_clBuffer[uiSorceIdx], the output is stored in m_clResultBuffer[uiDestIdx].
     virtual RFStatus    processBuffer(bool bRunCSC, bool bInvert, unsigned int uiSorceIdx, unsigned int uiDestIdx);
@@ -153,7 +161,7 @@ public:
     // Gets the state of a GL/D3D object.
     RFStatus            getInputMemObjState(RFRenderTargetState* state, unsigned int idx) const;
 
-    // Copys CSC results to the GPU or sys memory.
+    // Copys CSC results to the GPU or sys memory. If the result was computed on the host it gets uploaded.
     void                getResultBuffer(unsigned int idx, cl_mem* pBuffer) const;
     // Blocks until all results are written into the m_clResultBuffer[idx] and returns the pointer to the buffer in sys mem.
     void                getResultBuffer(unsigned int idx, void* &pBuffer) const;
@@ -166,6 +174,13 @@ public:
 
     void                getInputImage(unsigned int idx, cl_mem* pBuffer) const;
 
+    // Returns true and the diff map of m_clResultBuffer[idx] if it was computed by processBuffer.
+    bool                getDiffMapBuffer(unsigned int idx, cl_mem* pBuffer) const;
+
+    // Has to be called if the last processed frame was not encoded. The signatures belong to the dropped frame,
+    // so the next diff map marks all blocks as changed.
+    void                invalidateDiffSignatures() { m_bDiffSignaturesValid = false; }
+
     bool                isValid()       const { return m_bValid; }
 
     cl_context          getContext()    const { return m_clCtx; }
@@ -180,6 +195,8 @@ public:
 
     unsigned int        getNumRegisteredRT()  const { return m_uiNumRegisteredRT; }
 
+    unsigned int        getMaxNumRenderTargets() const { return m_uiMaxNumRenderTargets; }
+
     unsigned int        getResultBufferSize() const { return static_cast<unsigned int>(m_nOutputBufferSize); }
 
     RFFormat            getTargetFormat()     const { return m_TargetFormat; }
@@ -190,13 +207,17 @@ public:
 
     bool                getAsyncCopy()        const { return m_bUseAsyncCopy; }
 
+    // Returns the instruction set used by the CPU CSC or nullptr if the CSC runs on the GPU.
+    const char*         getHostCSCInstructionSet() const { return m_pHostCSC ? m_pHostCSC->getInstructionSet() : nullptr; }
+
     enum ctx_type { RF_CTX_UNKNOWN = -1, RF_CTX_CL = 0, RF_CTX_FROM_GL = 1, RF_CTX_FROM_DX9EX = 2, RF_CTX_FROM_DX9 = 3, RF_CTX_FROM_DX11 = 4 };
 
     ctx_type            getCtxType()          const { return m_CtxType; }
 
 protected:
 
-    enum csc_kernel { RF_KERNEL_UNKNOWN = -1, RF_KERNEL_RGBA_TO_NV12 = 0, RF_KERNEL_RGBA_TO_NV12_PLANES = 1, RF_KERNEL_RGBA_TO_I420 = 2, RF_KERNEL_RGBA_COPY = 3, RF_KERNEL_NUMBER = 4 };
+    enum csc_kernel { RF_KERNEL_UNKNOWN = -1, RF_KERNEL_RGBA_TO_NV12 = 0, RF_KERNEL_RGBA_TO_NV12_PLANES = 1, RF_KERNEL_RGBA_TO_I420 = 2, RF_KERNEL_RGBA_COPY = 3, RF_KERNEL_RGBA_COPY_DIFF = 4,
+                      RF_KERNEL_RGBA_TO_NV12_VEC8 = 5, RF_KERNEL_RGBA_TO_NV12_TILED = 6, RF_KERNEL_NUMBER = 7 };
 
     typedef struct
     {
@@ -217,10 +238,17 @@ protected:
     void                setMemAccessFunction();
 
     bool                configureKernels();
+
+    // Selects the fastest variant and local work size of the CSC kernel that is used for the current format and
+    // dimension. The configuration selected by configureKernels is kept if tuning fails.
+    void                tuneKernels();
     bool                getFreeRenderTargetIndex(unsigned int& uiIndex);
 
     RFStatus            setupKernel();
 
+    // Runs the CSC of a host memory input on the CPU. The result is written into m_pSysmemBuffer[uiDestIdx].
+    RFStatus            processHostBuffer(bool bRunCSC, bool bInvert, unsigned int uiSrcIdx, unsigned int uiDestIdx);
+
     // Checks if the texture and the buffer dimension match.
     bool                validateDimensions(unsigned int uiWidth, unsigned int uiHeight);
 
@@ -239,6 +267,8 @@ protected:
 
     // The amount of result and page locked buffers
     const unsigned int          m_uiNumResultBuffers;
+    // The number of render targets that can be registered.
+    const unsigned int          m_uiMaxNumRenderTargets;
     // The number of registered render targets.
     unsigned int                m_uiNumRegisteredRT;
 
@@ -254,27 +284,47 @@ protected:
 
     RFFormat                    m_TargetFormat;
     csc_kernel                  m_uiCSCKernelIdx;
+    // The kernel that is run to compute m_uiCSCKernelIdx. configureKernels might select an optimized variant.
+    csc_kernel                  m_uiCSCKernelVariant;
 
     CSC_KERNEL                  m_CSCKernels[RF_KERNEL_NUMBER];
 
     // m_clInputBuffer is set by the application when calling setInputTexture.
-    // m_clInputBuffer is used as input for the CSC.
-    cl_mem                      m_clInputImage[MAX_NUM_RENDER_TARGETS];
-    // m_clResultBuffer stores the results of the CSC.
-    cl_mem                      m_clResultBuffer[NUM_RESULT_BUFFERS];
+    // m_clInputBuffer is used as input for the CSC. Arrays indexed by render target have m_uiMaxNumRenderTargets entries.
+    std::unique_ptr<cl_mem[]>               m_clInputImage;
+    // m_clResultBuffer stores the results of the CSC. Arrays indexed by result buffer have m_uiNumResultBuffers entries.
+    std::unique_ptr<cl_mem[]>               m_clResultBuffer;
 
-    mutable RFEventCL           m_clDMAFinished[NUM_RESULT_BUFFERS];
-    mutable RFEventCL           m_clCSCFinished[NUM_RESULT_BUFFERS];
+    std::unique_ptr<RFEventCL[]>            m_clDMAFinished;
+    std::unique_ptr<RFEventCL[]>            m_clCSCFinished;
 
-    RFRenderTargetState         m_rtState[MAX_NUM_RENDER_TARGETS];
+    std::unique_ptr<RFRenderTargetState[]>  m_rtState;
 
     // Pinned buffer used for data transfer between GPU and host.
-    cl_mem                      m_clPageLockedBuffer[NUM_RESULT_BUFFERS];
-    char*                       m_pSysmemBuffer[NUM_RESULT_BUFFERS];
+    std::unique_ptr<cl_mem[]>               m_clPageLockedBuffer;
+    std::unique_ptr<char*[]>                m_pSysmemBuffer;
 
     // Indicates if an asynchronous copy of the result buffer to sys mem should be used.
     bool                        m_bUseAsyncCopy;
 
+    // Block size of the diff map computed by the RGBA copy. 0 if no diff map is computed.
+    unsigned int                m_uiDiffBlockSize[2];
+    unsigned int                m_uiDiffMapSize;
+    // Block signatures of the last frame processed by the RF_KERNEL_RGBA_COPY_DIFF kernel.
+    cl_mem                      m_clDiffSignatures;
+    // m_clDiffMapBuffer[i] stores the diff map between m_clResultBuffer[i] and the previously processed frame.
+    std::unique_ptr<cl_mem[]>               m_clDiffMapBuffer;
+    std::unique_ptr<bool[]>                 m_bDiffMapValid;
+    // Indicates that m_clDiffSignatures contains the signatures of the previous frame.
+    bool                        m_bDiffSignaturesValid;
+
+    // Input buffers in system memory. Only used by RF_CTX_CL contexts.
+    std::unique_ptr<const unsigned char*[]> m_pHostInput;
+    // CPU color space converter used for host memory input.
+    std::unique_ptr<RFCSCHost>  m_pHostCSC;
+    // Indicates that m_pSysmemBuffer[i] was computed on the host and m_clResultBuffer[i] was not yet updated.
+    std::unique_ptr<bool[]>                 m_bHostResultPending;
+
     ctx_type                    m_CtxType;
 
     CL_MEM_ACCESS_FUNCTION      m_fnAcquireInputMemObj;
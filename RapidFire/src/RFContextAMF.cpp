@@ -31,22 +31,31 @@ using namespace amf;
 
 #define CHECK_AMF_ERROR(a) if (a != AMF_OK) return RF_STATUS_AMF_FAIL;
 
-RFContextAMF::RFContextAMF()
-    : RFContextCL()
+RFContextAMF::RFContextAMF(unsigned int uiNumResultBuffers, unsigned int uiMaxNumRenderTargets)
+    : RFContextCL(uiNumResultBuffers, uiMaxNumRenderTargets)
     , m_uiPlaneCount(0)
     , m_amfContext(NULL)
     , m_amfFormat(AMF_SURFACE_UNKNOWN)
     , m_amfMemory(AMF_MEMORY_UNKNOWN)
 {
-    m_pSurfaceList = new AMFSurfacePtr[NUM_RESULT_BUFFERS];
+    m_pSurfaceList  = new AMFSurfacePtr[m_uiNumResultBuffers];
 
-    for (int i = 0; i < MAX_NUM_RENDER_TARGETS; ++i)
+    // The NV12 interop planes belong to the surfaces in m_pSurfaceList, the D3D9 surfaces are the registered render targets.
+    m_clNV12Planes  = std::unique_ptr<cl_mem[]>(new cl_mem[m_uiNumResultBuffers * 2]);
+    m_clNV12Memory  = std::unique_ptr<AMF_MEMORY_TYPE[]>(new AMF_MEMORY_TYPE[m_uiNumResultBuffers]);
+    m_pD3D9Surfaces = std::unique_ptr<IDirect3DSurface9*[]>(new IDirect3DSurface9*[m_uiMaxNumRenderTargets]);
+
+    for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
     {
-        m_pD3D9Surfaces[i] = NULL;
         m_clNV12Planes[i * 2] = NULL;
         m_clNV12Planes[i * 2 + 1] = NULL;
         m_clNV12Memory[i] = AMF_MEMORY_UNKNOWN;
     }
+
+    for (unsigned int i = 0; i < m_uiMaxNumRenderTargets; ++i)
+    {
+        m_pD3D9Surfaces[i] = NULL;
+    }
 }
 
 
@@ -63,12 +72,15 @@ RFContextAMF::~RFContextAMF()
         delete[] m_pSurfaceList;
     }
 
-    for (int i = 0; i < MAX_NUM_RENDER_TARGETS; ++i)
+    for (unsigned int i = 0; i < m_uiMaxNumRenderTargets; ++i)
     {
         // Surfaces are created by the application, so no need to delete them here.
         m_pD3D9Surfaces[i] = NULL;
+    }
 
-        if (m_CtxType != RF_CTX_FROM_DX9)
+    if (m_CtxType != RF_CTX_FROM_DX9)
+    {
+        for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
         {
             releaseNV12Interop(i);
         }
@@ -291,7 +303,7 @@ RFStatus RFContextAMF::createBuffers(RFFormat format, unsigned int uiWidth, unsi
     }
 
     // Create surdfaces that are used as target for the CSC and as input for the VCE.
-    for (unsigned int i = 0; i < NUM_RESULT_BUFFERS; ++i)
+    for (unsigned int i = 0; i < m_uiNumResultBuffers; ++i)
     {
         amfErr = m_amfContext->AllocSurface(m_amfMemory, m_amfFormat, m_uiAlignedOutputWidth, m_uiAlignedOutputHeight, &(m_pSurfaceList[i]));
         if ((amfErr == AMF_DIRECTX_FAILED || amfErr == AMF_NO_DEVICE) && m_amfMemory == AMF_MEMORY_DX11)
@@ -426,7 +438,7 @@ AMFSurfacePtr RFContextAMF::getAMFSurface(unsigned int uiIdx) const
         return m_pSurfaceList[uiIdx];
     }
 
-    if (uiIdx < NUM_RESULT_BUFFERS)
+    if (uiIdx < m_uiNumResultBuffers)
     {
         // We need to wait until CSC kernel finished.
         m_clCSCFinished[uiIdx].wait();
@@ -440,7 +452,7 @@ AMFSurfacePtr RFContextAMF::getAMFSurface(unsigned int uiIdx) const
 
 cl_mem RFContextAMF::getImageBuffer(unsigned int uiBuffer, unsigned int uiPlaneId)
 {
-    if (uiBuffer >= MAX_NUM_RENDER_TARGETS || uiPlaneId >= m_uiPlaneCount)
+    if (uiBuffer >= m_uiNumResultBuffers || uiPlaneId >= m_uiPlaneCount)
     {
         return NULL;
     }
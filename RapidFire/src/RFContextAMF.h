@@ -31,7 +31,7 @@ class RFContextAMF : public RFContextCL
 {
 public:
 
-    RFContextAMF();
+    RFContextAMF(unsigned int uiNumResultBuffers, unsigned int uiMaxNumRenderTargets);
     ~RFContextAMF();
 
     // Creates OpenCL context.
@@ -78,8 +78,8 @@ private:
     amf::AMF_SURFACE_FORMAT         m_amfFormat;
     amf::AMFSurfacePtr*             m_pSurfaceList;
     amf::AMF_MEMORY_TYPE            m_amfMemory;
-    cl_mem                          m_clNV12Planes[MAX_NUM_RENDER_TARGETS * 2];
-    amf::AMF_MEMORY_TYPE            m_clNV12Memory[MAX_NUM_RENDER_TARGETS];
+    std::unique_ptr<cl_mem[]>                   m_clNV12Planes;
+    std::unique_ptr<amf::AMF_MEMORY_TYPE[]>     m_clNV12Memory;
 
-    IDirect3DSurface9*              m_pD3D9Surfaces[MAX_NUM_RENDER_TARGETS];
+    std::unique_ptr<IDirect3DSurface9*[]>       m_pD3D9Surfaces;
 };
\ No newline at end of file
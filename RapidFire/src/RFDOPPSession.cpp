@@ -199,7 +199,15 @@ RFStatus RFDOPPSession::createContextFromGfx()
     {
         std::unique_ptr<DOPPDrvInterface> pDoppDrv = std::unique_ptr<DOPPDrvInterface>(new DOPPDrvInterface(m_strDisplayName, uiBusNumber));
 
-        std::unique_ptr<GLDOPPCapture>    pDoppCapture = std::unique_ptr<GLDOPPCapture>(new GLDOPPCapture(dpManager.getDesktopId(m_uiDisplayId), m_pContextCL->getNumResultBuffers(), pDoppDrv.get()));
+        // Each desktop texture is registered as render target of the context.
+        unsigned int uiNumDesktopTextures = m_pContextCL->getNumResultBuffers();
+
+        if (uiNumDesktopTextures > m_pContextCL->getMaxNumRenderTargets())
+        {
+            uiNumDesktopTextures = m_pContextCL->getMaxNumRenderTargets();
+        }
+
+        std::unique_ptr<GLDOPPCapture>    pDoppCapture = std::unique_ptr<GLDOPPCapture>(new GLDOPPCapture(dpManager.getDesktopId(m_uiDisplayId), uiNumDesktopTextures, pDoppDrv.get()));
 
         if (m_bMouseShapeData)
         {
@@ -357,6 +365,9 @@ RFStatus RFDOPPSession::registerTexture(RFTexture rt, unsigned int uiWidth, unsi
 
 RFStatus RFDOPPSession::getMouseData(int iWaitForShapeChange, RFMouseData& md) const
 {
+    // Teardown waits for calls holding the lock and releases the ones waiting for a shape change.
+    RFSharedAccess StateAccess(&m_StateLock);
+
     if (!m_pMouseGrab)
     {
         return RF_STATUS_FAIL;
@@ -373,6 +384,8 @@ RFStatus RFDOPPSession::getMouseData(int iWaitForShapeChange, RFMouseData& md) c
 
 RFStatus RFDOPPSession::getMouseData2(int iWaitForShapeChange, RFMouseData2& md) const
 {
+    RFSharedAccess StateAccess(&m_StateLock);
+
     if (!m_pMouseGrab)
     {
         return RF_STATUS_FAIL;
@@ -389,7 +402,7 @@ RFStatus RFDOPPSession::getMouseData2(int iWaitForShapeChange, RFMouseData2& md)
 
 RFStatus RFDOPPSession::releaseSessionEvents(const RFNotification rfEvent)
 {
-    if (rfEvent == RFDesktopNotification)
+    if (rfEvent == RFDesktopNotification && m_pDeskotpCapture)
     {
         if (m_pDeskotpCapture->releaseEvent())
         {
@@ -26,8 +26,6 @@
 #include "RFSession.h"
 #include "RFUtils.h"
 
-#define DOPP_NUM_RT     3
-
 class GLDOPPCapture;
 class DOPPDrvInterface;
 class RFMouseGrab;
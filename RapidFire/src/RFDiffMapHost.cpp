@@ -0,0 +1,920 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFDiffMapHost.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "RFUtils.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RF_DIFF_X86
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM) || defined(_M_ARM64)
+#define RF_DIFF_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#define RF_TARGET_SSE41
+#define RF_TARGET_AVX2
+#else
+#define RF_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define RF_TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+
+// Minimum number of block rows a thread processes.
+#define RF_DIFF_MIN_BLOCK_ROWS_PER_THREAD  2
+
+
+static bool compareRowScalar(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    for (; i + 8 <= uiBytes; i += 8)
+    {
+        uint64_t a;
+        uint64_t b;
+
+        memcpy(&a, pRow0 + i, sizeof(a));
+        memcpy(&b, pRow1 + i, sizeof(b));
+
+        if (a != b)
+        {
+            return true;
+        }
+    }
+
+    for (; i < uiBytes; ++i)
+    {
+        if (pRow0[i] != pRow1[i])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+#ifdef RF_DIFF_X86
+
+RF_TARGET_SSE41
+static bool compareRowSSE41(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    for (; i + 16 <= uiBytes; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + i));
+
+        if (!_mm_testz_si128(_mm_xor_si128(a, b), _mm_xor_si128(a, b)))
+        {
+            return true;
+        }
+    }
+
+    return compareRowScalar(pRow0 + i, pRow1 + i, uiBytes - i);
+}
+
+
+RF_TARGET_AVX2
+static bool compareRowAVX2(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    for (; i + 32 <= uiBytes; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + i));
+        __m256i d = _mm256_xor_si256(a, b);
+
+        if (!_mm256_testz_si256(d, d))
+        {
+            return true;
+        }
+    }
+
+    return compareRowScalar(pRow0 + i, pRow1 + i, uiBytes - i);
+}
+
+#endif // RF_DIFF_X86
+
+
+#ifdef RF_DIFF_NEON
+
+static bool compareRowNEON(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    for (; i + 16 <= uiBytes; i += 16)
+    {
+        uint8x16_t d = veorq_u8(vld1q_u8(pRow0 + i), vld1q_u8(pRow1 + i));
+        uint64x2_t q = vreinterpretq_u64_u8(d);
+
+        if ((vgetq_lane_u64(q, 0) | vgetq_lane_u64(q, 1)) != 0)
+        {
+            return true;
+        }
+    }
+
+    return compareRowScalar(pRow0 + i, pRow1 + i, uiBytes - i);
+}
+
+#endif // RF_DIFF_NEON
+
+
+static uint32_t sadRowScalar(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    uint32_t uiSAD = 0;
+
+    for (unsigned int i = 0; i < uiBytes; ++i)
+    {
+        uiSAD += (pRow0[i] > pRow1[i]) ? pRow0[i] - pRow1[i] : pRow1[i] - pRow0[i];
+    }
+
+    return uiSAD;
+}
+
+
+#ifdef RF_DIFF_X86
+
+RF_TARGET_SSE41
+static uint32_t sadRowSSE41(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    __m128i sum = _mm_setzero_si128();
+
+    for (; i + 16 <= uiBytes; i += 16)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow0 + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pRow1 + i));
+
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(a, b));
+    }
+
+    // _mm_sad_epu8 stores one 16 bit sum in each 64 bit lane.
+    uint32_t uiSAD = _mm_cvtsi128_si32(sum) + _mm_extract_epi32(sum, 2);
+
+    return uiSAD + sadRowScalar(pRow0 + i, pRow1 + i, uiBytes - i);
+}
+
+
+RF_TARGET_AVX2
+static uint32_t sadRowAVX2(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    __m256i sum = _mm256_setzero_si256();
+
+    for (; i + 32 <= uiBytes; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow0 + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pRow1 + i));
+
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(a, b));
+    }
+
+    __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+
+    uint32_t uiSAD = _mm_cvtsi128_si32(sum128) + _mm_extract_epi32(sum128, 2);
+
+    return uiSAD + sadRowScalar(pRow0 + i, pRow1 + i, uiBytes - i);
+}
+
+#endif // RF_DIFF_X86
+
+
+#ifdef RF_DIFF_NEON
+
+static uint32_t sadRowNEON(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes)
+{
+    unsigned int i = 0;
+
+    uint32x4_t sum = vdupq_n_u32(0);
+
+    for (; i + 16 <= uiBytes; i += 16)
+    {
+        uint8x16_t d = vabdq_u8(vld1q_u8(pRow0 + i), vld1q_u8(pRow1 + i));
+
+        sum = vpadalq_u16(sum, vpaddlq_u8(d));
+    }
+
+    uint32_t uiSAD = vgetq_lane_u32(sum, 0) + vgetq_lane_u32(sum, 1) + vgetq_lane_u32(sum, 2) + vgetq_lane_u32(sum, 3);
+
+    return uiSAD + sadRowScalar(pRow0 + i, pRow1 + i, uiBytes - i);
+}
+
+#endif // RF_DIFF_NEON
+
+
+// Counts the lines in [iLow, iHigh) of pCur that are equal to the line shifted by s in pPrev and that changed,
+// i.e. differ from the same line of pPrev. With s = 0 the number of changed lines is returned.
+static unsigned int countLineMatches(const uint32_t* pCur, const uint32_t* pPrev, int iLow, int iHigh, int s)
+{
+    unsigned int uiCount = 0;
+
+    for (int j = std::max(iLow, iLow + s); j < std::min(iHigh, iHigh + s); ++j)
+    {
+        if ((s == 0 || pCur[j] == pPrev[j - s]) && pCur[j] != pPrev[j])
+        {
+            ++uiCount;
+        }
+    }
+
+    return uiCount;
+}
+
+
+RFDiffMapHost::RFDiffMapHost()
+    : m_uiWidth(0)
+    , m_uiHeight(0)
+    , m_uiBlockWidth(0)
+    , m_uiBlockHeight(0)
+    , m_uiMapWidth(0)
+    , m_uiMapHeight(0)
+    , m_uiThreshold(0)
+    , m_bMagnitude(false)
+    , m_pfnRowCompare(compareRowScalar)
+    , m_pfnRowSAD(sadRowScalar)
+    , m_uiPeriodicHistory(0)
+    , m_strInstructionSet("Scalar")
+    , m_ThreadPool()
+{
+#if defined(RF_DIFF_X86)
+    if (utilCpuSupportsAVX2())
+    {
+        m_pfnRowCompare     = compareRowAVX2;
+        m_pfnRowSAD         = sadRowAVX2;
+        m_strInstructionSet = "AVX2";
+    }
+    else if (utilCpuSupportsSSE41())
+    {
+        m_pfnRowCompare     = compareRowSSE41;
+        m_pfnRowSAD         = sadRowSSE41;
+        m_strInstructionSet = "SSE4.1";
+    }
+#elif defined(RF_DIFF_NEON)
+    m_pfnRowCompare     = compareRowNEON;
+    m_pfnRowSAD         = sadRowNEON;
+    m_strInstructionSet = "NEON";
+#endif
+}
+
+
+void RFDiffMapHost::setDimension(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiBlockWidth, unsigned int uiBlockHeight)
+{
+    m_uiWidth       = uiWidth;
+    m_uiHeight      = uiHeight;
+    m_uiBlockWidth  = uiBlockWidth;
+    m_uiBlockHeight = uiBlockHeight;
+
+    m_uiMapWidth  = (uiBlockWidth > 0)  ? (uiWidth + uiBlockWidth - 1) / uiBlockWidth    : 0;
+    m_uiMapHeight = (uiBlockHeight > 0) ? (uiHeight + uiBlockHeight - 1) / uiBlockHeight : 0;
+}
+
+
+void RFDiffMapHost::setThreshold(unsigned int uiThreshold, bool bMagnitude)
+{
+    m_uiThreshold = uiThreshold;
+    m_bMagnitude  = bMagnitude;
+}
+
+
+bool RFDiffMapHost::computeDiffMap(const unsigned char* pCurrent, const unsigned char* pPrevious, unsigned char* pDiffMap)
+{
+    if (!pCurrent || !pPrevious || !pDiffMap || m_uiMapWidth == 0 || m_uiMapHeight == 0)
+    {
+        return false;
+    }
+
+    const unsigned int  uiWidth       = m_uiWidth;
+    const unsigned int  uiHeight      = m_uiHeight;
+    const unsigned int  uiBlockWidth  = m_uiBlockWidth;
+    const unsigned int  uiBlockHeight = m_uiBlockHeight;
+    const unsigned int  uiMapWidth    = m_uiMapWidth;
+    const unsigned int  uiPitch       = m_uiWidth * 4;
+    RowCompareFunction  pfnRowCompare = m_pfnRowCompare;
+
+    if (m_uiThreshold > 0 || m_bMagnitude)
+    {
+        return computeSADMap(pCurrent, pPrevious, pDiffMap);
+    }
+
+    m_ThreadPool.run(m_uiMapHeight, RF_DIFF_MIN_BLOCK_ROWS_PER_THREAD, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int by = uiBegin; by < uiEnd; ++by)
+        {
+            const unsigned int y0 = by * uiBlockHeight;
+            const unsigned int y1 = (y0 + uiBlockHeight < uiHeight) ? y0 + uiBlockHeight : uiHeight;
+
+            for (unsigned int bx = 0; bx < uiMapWidth; ++bx)
+            {
+                const unsigned int x0      = bx * uiBlockWidth;
+                const unsigned int uiBytes = ((x0 + uiBlockWidth < uiWidth) ? uiBlockWidth : uiWidth - x0) * 4;
+
+                unsigned char cDiff = 0;
+
+                // Pixels outside of the image are treated as equal like in the DiffMap_Buffer kernel.
+                for (unsigned int y = y0; y < y1; ++y)
+                {
+                    const size_t uiOffset = static_cast<size_t>(y) * uiPitch + x0 * 4;
+
+                    if (pfnRowCompare(pCurrent + uiOffset, pPrevious + uiOffset, uiBytes))
+                    {
+                        cDiff = 1;
+                        break;
+                    }
+                }
+
+                pDiffMap[by * uiMapWidth + bx] = cDiff;
+            }
+        }
+    });
+
+    return true;
+}
+
+
+bool RFDiffMapHost::computeSADMap(const unsigned char* pCurrent, const unsigned char* pPrevious, unsigned char* pDiffMap)
+{
+    const unsigned int  uiWidth       = m_uiWidth;
+    const unsigned int  uiHeight      = m_uiHeight;
+    const unsigned int  uiBlockWidth  = m_uiBlockWidth;
+    const unsigned int  uiBlockHeight = m_uiBlockHeight;
+    const unsigned int  uiMapWidth    = m_uiMapWidth;
+    const unsigned int  uiPitch       = m_uiWidth * 4;
+    const unsigned int  uiThreshold   = m_uiThreshold;
+    const bool          bMagnitude    = m_bMagnitude;
+    RowSADFunction      pfnRowSAD     = m_pfnRowSAD;
+
+    // The magnitude is the mean absolute difference of the channels of a block rounded up like in the DiffMap_SAD kernels.
+    const uint32_t      uiNumChannels = uiBlockWidth * uiBlockHeight * 4;
+
+    m_ThreadPool.run(m_uiMapHeight, RF_DIFF_MIN_BLOCK_ROWS_PER_THREAD, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int by = uiBegin; by < uiEnd; ++by)
+        {
+            const unsigned int y0 = by * uiBlockHeight;
+            const unsigned int y1 = (y0 + uiBlockHeight < uiHeight) ? y0 + uiBlockHeight : uiHeight;
+
+            for (unsigned int bx = 0; bx < uiMapWidth; ++bx)
+            {
+                const unsigned int x0      = bx * uiBlockWidth;
+                const unsigned int uiBytes = ((x0 + uiBlockWidth < uiWidth) ? uiBlockWidth : uiWidth - x0) * 4;
+
+                uint32_t uiSAD = 0;
+
+                for (unsigned int y = y0; y < y1; ++y)
+                {
+                    const size_t uiOffset = static_cast<size_t>(y) * uiPitch + x0 * 4;
+
+                    uiSAD += pfnRowSAD(pCurrent + uiOffset, pPrevious + uiOffset, uiBytes);
+                }
+
+                unsigned char cDiff = 0;
+
+                if (uiSAD > uiThreshold)
+                {
+                    cDiff = (bMagnitude) ? static_cast<unsigned char>(std::min<uint32_t>((uiSAD + uiNumChannels - 1) / uiNumChannels, 255)) : 1;
+                }
+
+                pDiffMap[by * uiMapWidth + bx] = cDiff;
+            }
+        }
+    });
+
+    return true;
+}
+
+
+bool RFDiffMapHost::detectScroll(const unsigned char* pCurrent, const unsigned char* pPrevious, unsigned char* pDiffMap, int iRange, unsigned int uiMinLines,
+                                 RFDiffCopyRect& CopyRect)
+{
+    memset(&CopyRect, 0, sizeof(CopyRect));
+
+    if (!pCurrent || !pPrevious || !pDiffMap || m_uiMapWidth == 0 || m_uiMapHeight == 0)
+    {
+        return false;
+    }
+
+    // Bounding box of the changed blocks.
+    int iBox[4] = { static_cast<int>(m_uiMapWidth), static_cast<int>(m_uiMapHeight), 0, 0 };
+
+    for (unsigned int by = 0; by < m_uiMapHeight; ++by)
+    {
+        for (unsigned int bx = 0; bx < m_uiMapWidth; ++bx)
+        {
+            if (pDiffMap[by * m_uiMapWidth + bx])
+            {
+                iBox[0] = std::min<int>(iBox[0], bx);
+                iBox[1] = std::min<int>(iBox[1], by);
+                iBox[2] = std::max<int>(iBox[2], bx + 1);
+                iBox[3] = std::max<int>(iBox[3], by + 1);
+            }
+        }
+    }
+
+    if (iBox[2] == 0)
+    {
+        return true;
+    }
+
+    const unsigned int uiWidth       = m_uiWidth;
+    const unsigned int uiHeight      = m_uiHeight;
+    const unsigned int uiBlockWidth  = m_uiBlockWidth;
+    const unsigned int uiBlockHeight = m_uiBlockHeight;
+
+    // Box in pixels.
+    const int iPx0 = iBox[0] * uiBlockWidth;
+    const int iPy0 = iBox[1] * uiBlockHeight;
+    const int iPx1 = std::min<int>(iBox[2] * uiBlockWidth, uiWidth);
+    const int iPy1 = std::min<int>(iBox[3] * uiBlockHeight, uiHeight);
+
+    // A line is a row of a block column or a column of a block row. Hashing the lines per block column
+    // allows to find a shift of a region that only covers a part of the box. The rows of all block columns
+    // are followed by the columns of all block rows.
+    const unsigned int uiNumRowLines = m_uiMapWidth * uiHeight;
+    const unsigned int uiNumLines    = uiNumRowLines + m_uiMapHeight * uiWidth;
+
+    m_LineHashes.resize(2 * uiNumLines);
+
+    uint32_t* pCurHashes  = m_LineHashes.data();
+    uint32_t* pPrevHashes = pCurHashes + uiNumLines;
+
+    m_ThreadPool.run(uiNumLines, 1024, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int i = uiBegin; i < uiEnd; ++i)
+        {
+            const bool         bRow  = (i < uiNumRowLines);
+            const unsigned int k     = (bRow) ? i / uiHeight : (i - uiNumRowLines) / uiWidth;
+            const int          j     = (bRow) ? i % uiHeight : (i - uiNumRowLines) % uiWidth;
+
+            // Only lines inside of the box are compared.
+            if ((bRow  && (static_cast<int>(k) < iBox[0] || static_cast<int>(k) >= iBox[2] || j < iPy0 || j >= iPy1)) ||
+                (!bRow && (static_cast<int>(k) < iBox[1] || static_cast<int>(k) >= iBox[3] || j < iPx0 || j >= iPx1)))
+            {
+                continue;
+            }
+
+            const unsigned int uiStart = k * ((bRow) ? uiBlockWidth : uiBlockHeight);
+            const unsigned int uiEnd   = std::min(uiStart + ((bRow) ? uiBlockWidth : uiBlockHeight), (bRow) ? uiWidth : uiHeight);
+
+            uint32_t uiHash1 = 2166136261u;
+            uint32_t uiHash2 = 2166136261u;
+
+            for (unsigned int t = uiStart; t < uiEnd; ++t)
+            {
+                const size_t uiOffset = ((bRow) ? static_cast<size_t>(j) * uiWidth + t : static_cast<size_t>(t) * uiWidth + j) * 4;
+
+                uint32_t uiPixel1;
+                uint32_t uiPixel2;
+
+                memcpy(&uiPixel1, pCurrent  + uiOffset, sizeof(uiPixel1));
+                memcpy(&uiPixel2, pPrevious + uiOffset, sizeof(uiPixel2));
+
+                uiHash1 = (uiHash1 ^ uiPixel1) * 16777619u;
+                uiHash2 = (uiHash2 ^ uiPixel2) * 16777619u;
+            }
+
+            pCurHashes[i]  = uiHash1;
+            pPrevHashes[i] = uiHash2;
+        }
+    });
+
+    // Shifts [0, 2 * iRange] are vertical shifts from -iRange to iRange, the following ones horizontal shifts.
+    const unsigned int uiNumShifts = 2 * (2 * iRange + 1);
+
+    m_ScrollScores.resize(uiNumShifts);
+
+    uint32_t* pScores = m_ScrollScores.data();
+
+    m_ThreadPool.run(uiNumShifts, 16, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int i = uiBegin; i < uiEnd; ++i)
+        {
+            const bool bVertical = (static_cast<int>(i) <= 2 * iRange);
+            const int  s         = ((bVertical) ? static_cast<int>(i) : static_cast<int>(i) - 2 * iRange - 1) - iRange;
+
+            uint32_t uiScore = 0;
+
+            // A shift of 0 would count the changed lines.
+            if (s != 0 && bVertical)
+            {
+                for (int k = iBox[0]; k < iBox[2]; ++k)
+                {
+                    uiScore += countLineMatches(pCurHashes + k * uiHeight, pPrevHashes + k * uiHeight, iPy0, iPy1, s);
+                }
+            }
+            else if (s != 0)
+            {
+                for (int k = iBox[1]; k < iBox[3]; ++k)
+                {
+                    uiScore += countLineMatches(pCurHashes + uiNumRowLines + k * uiWidth, pPrevHashes + uiNumRowLines + k * uiWidth, iPx0, iPx1, s);
+                }
+            }
+
+            pScores[i] = uiScore;
+        }
+    });
+
+    // A shift is accepted if it explains at least half of the changed lines.
+    unsigned int uiChangedRows = 0;
+    unsigned int uiChangedCols = 0;
+
+    for (int k = iBox[0]; k < iBox[2]; ++k)
+    {
+        uiChangedRows += countLineMatches(pCurHashes + k * uiHeight, pPrevHashes + k * uiHeight, iPy0, iPy1, 0);
+    }
+
+    for (int k = iBox[1]; k < iBox[3]; ++k)
+    {
+        uiChangedCols += countLineMatches(pCurHashes + uiNumRowLines + k * uiWidth, pPrevHashes + uiNumRowLines + k * uiWidth, iPx0, iPx1, 0);
+    }
+
+    unsigned int uiBest   = 0;
+    int          iBestIdx = -1;
+
+    for (unsigned int i = 0; i < uiNumShifts; ++i)
+    {
+        const unsigned int uiChanged = (static_cast<int>(i) <= 2 * iRange) ? uiChangedRows : uiChangedCols;
+
+        if (pScores[i] > uiBest && pScores[i] >= uiMinLines && 2 * pScores[i] >= uiChanged)
+        {
+            uiBest   = pScores[i];
+            iBestIdx = i;
+        }
+    }
+
+    if (iBestIdx < 0)
+    {
+        return true;
+    }
+
+    const bool bVertical = (iBestIdx <= 2 * iRange);
+    const int  s         = ((bVertical) ? iBestIdx : iBestIdx - 2 * iRange - 1) - iRange;
+    const int  iShift    = (s > 0) ? s : -s;
+
+    // The copy covers the block columns (rows) in which the shift explains half of the changed lines.
+    int iFirst = -1;
+    int iLast  = -1;
+
+    for (int k = (bVertical) ? iBox[0] : iBox[1]; k < ((bVertical) ? iBox[2] : iBox[3]); ++k)
+    {
+        const uint32_t* pCur  = (bVertical) ? pCurHashes  + k * uiHeight : pCurHashes  + uiNumRowLines + k * uiWidth;
+        const uint32_t* pPrev = (bVertical) ? pPrevHashes + k * uiHeight : pPrevHashes + uiNumRowLines + k * uiWidth;
+
+        const unsigned int uiMatches = countLineMatches(pCur, pPrev, (bVertical) ? iPy0 : iPx0, (bVertical) ? iPy1 : iPx1, s);
+        const unsigned int uiChanged = countLineMatches(pCur, pPrev, (bVertical) ? iPy0 : iPx0, (bVertical) ? iPy1 : iPx1, 0);
+
+        if (uiMatches > 0 && 2 * uiMatches >= uiChanged)
+        {
+            iFirst = (iFirst < 0) ? k : iFirst;
+            iLast  = k;
+        }
+    }
+
+    if (bVertical)
+    {
+        CopyRect.uiSrcX   = iFirst * uiBlockWidth;
+        CopyRect.uiSrcY   = (s > 0) ? iPy0 : iPy0 - s;
+        CopyRect.uiWidth  = std::min<int>((iLast + 1) * uiBlockWidth, uiWidth) - CopyRect.uiSrcX;
+        CopyRect.uiHeight = iPy1 - iPy0 - iShift;
+        CopyRect.iDy      = s;
+    }
+    else
+    {
+        CopyRect.uiSrcX   = (s > 0) ? iPx0 : iPx0 - s;
+        CopyRect.uiSrcY   = iFirst * uiBlockHeight;
+        CopyRect.uiWidth  = iPx1 - iPx0 - iShift;
+        CopyRect.uiHeight = std::min<int>((iLast + 1) * uiBlockHeight, uiHeight) - CopyRect.uiSrcY;
+        CopyRect.iDx      = s;
+    }
+
+    // Recompute the blocks that overlap the destination of the copy.
+    const int iDstX0 = CopyRect.uiSrcX + CopyRect.iDx;
+    const int iDstY0 = CopyRect.uiSrcY + CopyRect.iDy;
+    const int iDstX1 = iDstX0 + CopyRect.uiWidth;
+    const int iDstY1 = iDstY0 + CopyRect.uiHeight;
+
+    for (int by = iDstY0 / uiBlockHeight; by * static_cast<int>(uiBlockHeight) < iDstY1; ++by)
+    {
+        for (int bx = iDstX0 / uiBlockWidth; bx * static_cast<int>(uiBlockWidth) < iDstX1; ++bx)
+        {
+            const int x0 = bx * uiBlockWidth;
+            const int y0 = by * uiBlockHeight;
+            const int x1 = std::min<int>(x0 + uiBlockWidth, uiWidth);
+            const int y1 = std::min<int>(y0 + uiBlockHeight, uiHeight);
+
+            unsigned char cDiff = 0;
+
+            for (int y = y0; y < y1 && !cDiff; ++y)
+            {
+                for (int x = x0; x < x1; ++x)
+                {
+                    const bool bInside = (x >= iDstX0 && x < iDstX1 && y >= iDstY0 && y < iDstY1);
+                    const int  px      = (bInside) ? x - CopyRect.iDx : x;
+                    const int  py      = (bInside) ? y - CopyRect.iDy : y;
+
+                    if (memcmp(pCurrent + (static_cast<size_t>(y) * uiWidth + x) * 4, pPrevious + (static_cast<size_t>(py) * uiWidth + px) * 4, 4) != 0)
+                    {
+                        cDiff = 1;
+                        break;
+                    }
+                }
+            }
+
+            pDiffMap[by * m_uiMapWidth + bx] = cDiff;
+        }
+    }
+
+    return true;
+}
+
+
+void RFDiffMapHost::setPeriodicHistory(unsigned int uiHistory)
+{
+    m_uiPeriodicHistory = uiHistory;
+
+    m_PeriodicHistory.assign(static_cast<size_t>(m_uiMapWidth) * m_uiMapHeight * uiHistory, 0);
+    m_PeriodicState.assign((uiHistory > 0) ? static_cast<size_t>(m_uiMapWidth) * m_uiMapHeight : 0, 0);
+}
+
+
+bool RFDiffMapHost::detectPeriodic(const unsigned char* pImage, unsigned char* pDiffMap, unsigned char* pPeriodicMap)
+{
+    if (!pImage || !pDiffMap || !pPeriodicMap || m_uiPeriodicHistory == 0 || m_PeriodicState.empty())
+    {
+        return false;
+    }
+
+    const uint32_t* pPixels    = reinterpret_cast<const uint32_t*>(pImage);
+    uint64_t*       pHistory   = m_PeriodicHistory.data();
+    uint32_t*       pState     = m_PeriodicState.data();
+    const unsigned int uiWidth       = m_uiWidth;
+    const unsigned int uiHeight      = m_uiHeight;
+    const unsigned int uiBlockWidth  = m_uiBlockWidth;
+    const unsigned int uiBlockHeight = m_uiBlockHeight;
+    const unsigned int uiMapWidth    = m_uiMapWidth;
+    const unsigned int uiHistory     = m_uiPeriodicHistory;
+
+    m_ThreadPool.run(m_uiMapHeight, RF_DIFF_MIN_BLOCK_ROWS_PER_THREAD, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int by = uiBegin; by < uiEnd; ++by)
+        {
+            for (unsigned int bx = 0; bx < uiMapWidth; ++bx)
+            {
+                const unsigned int uiBlock = by * uiMapWidth + bx;
+
+                pPeriodicMap[uiBlock] = 0;
+
+                if (pDiffMap[uiBlock] == 0)
+                {
+                    continue;
+                }
+
+                const unsigned int x0 = bx * uiBlockWidth;
+                const unsigned int y0 = by * uiBlockHeight;
+                const unsigned int x1 = std::min(x0 + uiBlockWidth, uiWidth);
+                const unsigned int y1 = std::min(y0 + uiBlockHeight, uiHeight);
+
+                // FNV-1a over the pixels of the block.
+                uint64_t uiHash = 14695981039346656037ULL;
+
+                for (unsigned int y = y0; y < y1; ++y)
+                {
+                    for (unsigned int x = x0; x < x1; ++x)
+                    {
+                        uiHash = (uiHash ^ pPixels[static_cast<size_t>(y) * uiWidth + x]) * 1099511628211ULL;
+                    }
+                }
+
+                uint64_t* pSignatures = pHistory + static_cast<size_t>(uiBlock) * uiHistory;
+
+                unsigned int uiStored   = pState[uiBlock] & 0xFF;
+                unsigned int uiNext     = (pState[uiBlock] >> 8) & 0xFF;
+                unsigned int uiRevisits = pState[uiBlock] >> 16;
+                bool         bKnown     = false;
+
+                for (unsigned int i = 0; i < uiStored; ++i)
+                {
+                    bKnown |= (pSignatures[i] == uiHash);
+                }
+
+                if (bKnown)
+                {
+                    uiRevisits = std::min(uiRevisits + 1, 0xFFFFU);
+                }
+                else
+                {
+                    pSignatures[uiNext] = uiHash;
+
+                    uiNext     = (uiNext + 1) % uiHistory;
+                    uiStored   = std::min(uiStored + 1, uiHistory);
+                    uiRevisits = 0;
+                }
+
+                pState[uiBlock] = uiStored | (uiNext << 8) | (uiRevisits << 16);
+
+                if (uiRevisits >= uiHistory)
+                {
+                    pDiffMap[uiBlock]     = 0;
+                    pPeriodicMap[uiBlock] = 1;
+                }
+            }
+        }
+    });
+
+    return true;
+}
+
+
+void RFDiffMapHost::reduceDiffMap(const unsigned char* pSrc, unsigned int uiSrcWidth, unsigned int uiSrcHeight, unsigned int uiFactor, unsigned char* pDst)
+{
+    const unsigned int uiDstWidth  = (uiSrcWidth + uiFactor - 1) / uiFactor;
+    const unsigned int uiDstHeight = (uiSrcHeight + uiFactor - 1) / uiFactor;
+
+    memset(pDst, 0, uiDstWidth * uiDstHeight);
+
+    for (unsigned int y = 0; y < uiSrcHeight; ++y)
+    {
+        const unsigned char* pSrcRow = pSrc + y * uiSrcWidth;
+        unsigned char*       pDstRow = pDst + (y / uiFactor) * uiDstWidth;
+
+        for (unsigned int x = 0; x < uiSrcWidth; ++x)
+        {
+            if (pSrcRow[x] > pDstRow[x / uiFactor])
+            {
+                pDstRow[x / uiFactor] = pSrcRow[x];
+            }
+        }
+    }
+}
+
+
+void RFDiffMapHost::packDiffMap(const unsigned char* pSrc, unsigned int uiWidth, unsigned int uiHeight, unsigned char* pDst)
+{
+    const unsigned int uiPitch = (uiWidth + 7) / 8;
+
+    memset(pDst, 0, uiPitch * uiHeight);
+
+    for (unsigned int y = 0; y < uiHeight; ++y)
+    {
+        const unsigned char* pSrcRow = pSrc + y * uiWidth;
+        unsigned char*       pDstRow = pDst + y * uiPitch;
+
+        for (unsigned int x = 0; x < uiWidth; ++x)
+        {
+            if (pSrcRow[x])
+            {
+                pDstRow[x / 8] |= static_cast<unsigned char>(1 << (x % 8));
+            }
+        }
+    }
+}
+
+
+unsigned int RFDiffMapHost::buildRects(const unsigned char* pSrc, unsigned int uiWidth, unsigned int uiHeight, unsigned int* pRects)
+{
+    // Runs of the previous and the current row stored as {start, end, rect index}.
+    std::vector<unsigned int> PrevRuns;
+    std::vector<unsigned int> CurRuns;
+
+    unsigned int  uiNumRects = 0;
+    unsigned int* pRect      = pRects + 1;
+
+    for (unsigned int y = 0; y < uiHeight; ++y)
+    {
+        const unsigned char* pRow = pSrc + y * uiWidth;
+
+        unsigned int uiPrev = 0;
+        unsigned int x      = 0;
+
+        CurRuns.clear();
+
+        while (x < uiWidth)
+        {
+            if (!pRow[x])
+            {
+                ++x;
+                continue;
+            }
+
+            const unsigned int x0 = x;
+
+            while (x < uiWidth && pRow[x])
+            {
+                ++x;
+            }
+
+            // Runs of both rows are sorted, skip the runs of the previous row that start left of this one.
+            while (uiPrev < PrevRuns.size() && PrevRuns[uiPrev] < x0)
+            {
+                uiPrev += 3;
+            }
+
+            unsigned int uiRect;
+
+            if (uiPrev < PrevRuns.size() && PrevRuns[uiPrev] == x0 && PrevRuns[uiPrev + 1] == x)
+            {
+                // Extend the rectangle of the run above.
+                uiRect = PrevRuns[uiPrev + 2];
+                ++pRect[4 * uiRect + 3];
+                uiPrev += 3;
+            }
+            else
+            {
+                uiRect = uiNumRects++;
+
+                pRect[4 * uiRect + 0] = x0;
+                pRect[4 * uiRect + 1] = y;
+                pRect[4 * uiRect + 2] = x - x0;
+                pRect[4 * uiRect + 3] = 1;
+            }
+
+            CurRuns.push_back(x0);
+            CurRuns.push_back(x);
+            CurRuns.push_back(uiRect);
+        }
+
+        PrevRuns.swap(CurRuns);
+    }
+
+    pRects[0] = uiNumRects;
+
+    return uiNumRects;
+}
+
+
+unsigned int RFDiffMapHost::packTiles(const unsigned char* pSrc, unsigned int uiMapWidth, unsigned int uiMapHeight, const unsigned char* pImage,
+                                      unsigned int uiWidth, unsigned int uiHeight, unsigned int uiBlockWidth, unsigned int uiBlockHeight, unsigned int* pTiles)
+{
+    const unsigned int uiNumBlocks = uiMapWidth * uiMapHeight;
+    const uint32_t*    pPixels     = reinterpret_cast<const uint32_t*>(pImage);
+
+    unsigned int uiNumTiles = 0;
+
+    for (unsigned int i = 0; i < uiNumBlocks; ++i)
+    {
+        if (pSrc[i])
+        {
+            pTiles[1 + uiNumTiles++] = i;
+        }
+    }
+
+    unsigned int* pTile = pTiles + 1 + uiNumTiles;
+
+    for (unsigned int t = 0; t < uiNumTiles; ++t)
+    {
+        const unsigned int x0 = (pTiles[1 + t] % uiMapWidth) * uiBlockWidth;
+        const unsigned int y0 = (pTiles[1 + t] / uiMapWidth) * uiBlockHeight;
+
+        // Part of the block that is inside the image.
+        const unsigned int uiCopyWidth  = std::min(uiBlockWidth, uiWidth - x0);
+        const unsigned int uiCopyHeight = std::min(uiBlockHeight, uiHeight - y0);
+
+        for (unsigned int y = 0; y < uiBlockHeight; ++y)
+        {
+            unsigned int* pDst = pTile + y * uiBlockWidth;
+
+            if (y < uiCopyHeight)
+            {
+                memcpy(pDst, pPixels + (y0 + y) * uiWidth + x0, uiCopyWidth * sizeof(uint32_t));
+                memset(pDst + uiCopyWidth, 0, (uiBlockWidth - uiCopyWidth) * sizeof(uint32_t));
+            }
+            else
+            {
+                memset(pDst, 0, uiBlockWidth * sizeof(uint32_t));
+            }
+        }
+
+        pTile += uiBlockWidth * uiBlockHeight;
+    }
+
+    pTiles[0] = uiNumTiles;
+
+    return uiNumTiles;
+}
@@ -0,0 +1,137 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "RapidFire.h"
+#include "RFThreadPool.h"
+
+// RFDiffMapHost computes the difference map of two 32 bpp images in system memory on the CPU. It produces
+// the same map as the DiffMap_Buffer kernel of RFEncoderDM: one byte per block of uiBlockWidth x uiBlockHeight
+// pixels that is 1 if any pixel of the block differs and 0 otherwise. If a threshold or the magnitude output is
+// set, the map matches the DiffMap_SADBuffer kernel instead.
+// Block rows are distributed across a thread pool. Each block is compared with the widest instruction set
+// supported by the CPU (AVX2, SSE4.1 or NEON) and the comparison stops at the first differing vector.
+class RFDiffMapHost
+{
+public:
+
+    RFDiffMapHost();
+
+    // Sets the dimension of the images and the block size. The diff map has ceil(uiWidth / uiBlockWidth) x
+    // ceil(uiHeight / uiBlockHeight) entries.
+    void            setDimension(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiBlockWidth, unsigned int uiBlockHeight);
+
+    // A block is only marked as changed if the sum of absolute differences of its channels is larger than
+    // uiThreshold. If bMagnitude is true changed blocks store the mean absolute difference of their channels
+    // rounded up instead of 1.
+    void            setThreshold(unsigned int uiThreshold, bool bMagnitude);
+
+    // Compares two tightly packed images and writes the diff map into pDiffMap.
+    bool            computeDiffMap(const unsigned char* pCurrent, const unsigned char* pPrevious, unsigned char* pDiffMap);
+
+    // Detects a vertical or horizontal shift of the content inside the bounding box of the changed blocks. The
+    // shift is searched in [-iRange, iRange] by matching hashes of the rows of each block column and of the columns
+    // of each block row. If at least uiMinLines lines and half of the changed lines match, CopyRect describes the
+    // pixels of the previous image that are moved and the entries of pDiffMap that cover the destination are
+    // recomputed with the moved pixels as reference. Otherwise uiWidth of CopyRect is 0.
+    bool            detectScroll(const unsigned char* pCurrent, const unsigned char* pPrevious, unsigned char* pDiffMap, int iRange, unsigned int uiMinLines,
+                                 RFDiffCopyRect& CopyRect);
+
+    // Sets the number of states per block that are stored by detectPeriodic and clears the stored states. Needs
+    // to be called after setDimension.
+    void            setPeriodicHistory(unsigned int uiHistory);
+
+    // Computes a signature of each changed block of pImage. If the signature matches one of the last uiHistory
+    // signatures of the block for uiHistory consecutive changes, the block alternates between known states and its
+    // entry of pDiffMap is cleared and the entry of pPeriodicMap is set to 1. All other entries of pPeriodicMap are 0.
+    // Produces the same result as the DiffMap_Periodic kernel.
+    bool            detectPeriodic(const unsigned char* pImage, unsigned char* pDiffMap, unsigned char* pPeriodicMap);
+
+    // Computes a coarser level of a diff map. Each entry of pDst is the maximum of uiFactor x uiFactor entries
+    // of pSrc. pDst has ceil(uiSrcWidth / uiFactor) x ceil(uiSrcHeight / uiFactor) entries.
+    static void     reduceDiffMap(const unsigned char* pSrc, unsigned int uiSrcWidth, unsigned int uiSrcHeight, unsigned int uiFactor, unsigned char* pDst);
+
+    // Packs a diff map into one bit per entry. Each row starts at a new byte and the first entry of a byte is
+    // stored in the least significant bit. pDst has ceil(uiWidth / 8) x uiHeight bytes.
+    static void     packDiffMap(const unsigned char* pSrc, unsigned int uiWidth, unsigned int uiHeight, unsigned char* pDst);
+
+    // Writes the number of rectangles followed by the rectangles {x, y, width, height} that cover all non zero
+    // entries of the diff map to pRects. Maximal horizontal runs are merged with runs of the same extent in the
+    // next row. pRects needs to store 1 + 4 * uiHeight * ceil(uiWidth / 2) values. Returns the number of rectangles.
+    static unsigned int buildRects(const unsigned char* pSrc, unsigned int uiWidth, unsigned int uiHeight, unsigned int* pRects);
+
+    // Writes the number of non zero entries of the diff map followed by their indices and the pixels of the
+    // corresponding blocks of the 32 bpp image pImage to pTiles. The pixels of a block are stored row by row, pixels
+    // outside the image are 0. Returns the number of blocks.
+    static unsigned int packTiles(const unsigned char* pSrc, unsigned int uiMapWidth, unsigned int uiMapHeight, const unsigned char* pImage,
+                                  unsigned int uiWidth, unsigned int uiHeight, unsigned int uiBlockWidth, unsigned int uiBlockHeight, unsigned int* pTiles);
+
+    // Returns the name of the instruction set that is used for the comparison.
+    const char*     getInstructionSet() const { return m_strInstructionSet; }
+
+    // Returns true if the first uiBytes of the two rows differ.
+    typedef bool (*RowCompareFunction)(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes);
+
+    // Returns the sum of absolute differences of the first uiBytes of the two rows.
+    typedef uint32_t (*RowSADFunction)(const uint8_t* pRow0, const uint8_t* pRow1, unsigned int uiBytes);
+
+private:
+
+    // Disable copy constructor.
+    RFDiffMapHost(const RFDiffMapHost& other);
+    // Disable assignment operator.
+    RFDiffMapHost& operator=(const RFDiffMapHost& rhs);
+
+    // Computes the diff map from the sum of absolute differences of each block.
+    bool                computeSADMap(const unsigned char* pCurrent, const unsigned char* pPrevious, unsigned char* pDiffMap);
+
+    unsigned int        m_uiWidth;
+    unsigned int        m_uiHeight;
+    unsigned int        m_uiBlockWidth;
+    unsigned int        m_uiBlockHeight;
+    unsigned int        m_uiMapWidth;
+    unsigned int        m_uiMapHeight;
+
+    unsigned int        m_uiThreshold;
+    bool                m_bMagnitude;
+
+    RowCompareFunction  m_pfnRowCompare;
+    RowSADFunction      m_pfnRowSAD;
+
+    // Line hashes of the current and of the previous image and the score of each shift used by detectScroll.
+    std::vector<uint32_t>   m_LineHashes;
+    std::vector<uint32_t>   m_ScrollScores;
+
+    // Block signatures and packed state of each block used by detectPeriodic.
+    unsigned int            m_uiPeriodicHistory;
+    std::vector<uint64_t>   m_PeriodicHistory;
+    std::vector<uint32_t>   m_PeriodicState;
+
+    const char*         m_strInstructionSet;
+
+    RFThreadPool        m_ThreadPool;
+};
@@ -57,6 +57,20 @@ public:
 
     virtual RFStatus            getEncodedFrame(unsigned int& uiSize, void* &pBitStream)  { return RF_STATUS_FAIL; }
 
+    // Returns the GPU buffers of an encoded frame without a transfer to system memory. The buffers are owned by the
+    // encoder until releaseEncodedFrameCL is called. Only supported by encoders that keep their output on the GPU.
+    virtual RFStatus            getEncodedFrameCL(RFEncodedFrameCL& Frame)                                          { return RF_STATUS_INVALID_ENCODER; }
+
+    virtual RFStatus            releaseEncodedFrameCL()                                                             { return RF_STATUS_INVALID_ENCODER; }
+
+    // A consumer accumulates the changes of all encoded frames until it retrieves them with getConsumerFrame.
+    // Only supported by encoders that return a diff map.
+    virtual RFStatus            createConsumer(unsigned int& uiConsumer)                                            { return RF_STATUS_INVALID_ENCODER; }
+
+    virtual RFStatus            deleteConsumer(unsigned int uiConsumer)                                             { return RF_STATUS_INVALID_ENCODER; }
+
+    virtual RFStatus            getConsumerFrame(unsigned int uiConsumer, unsigned int& uiSize, void* &pBitStream)  { return RF_STATUS_INVALID_ENCODER; }
+
     // Returns true if the format is supporetd as input by the encoder.
     virtual bool                isFormatSupported(RFFormat format)  const { return false; };
 
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <vector>
 
 #include <CL/cl.h>
@@ -84,8 +85,10 @@ private:
     // Updates the AMF context with the property specified by uiParameterIndex.
     RFStatus					setAMFProperty(unsigned int uiParameterIndex, RFParameterType rfType, RFProperties value);
 
-    bool                            m_bBlock;
-    unsigned int                    m_uiPendingFrames;
+    // encode and getEncodedFrame may be called by different threads. m_uiPendingFrames is incremented by encode
+    // and decremented by getEncodedFrame, m_bBlock is set by setParameter and read by getEncodedFrame.
+    std::atomic_bool                m_bBlock;
+    std::atomic<unsigned int>       m_uiPendingFrames;
 
     const RFContextAMF*             m_pContext;
 
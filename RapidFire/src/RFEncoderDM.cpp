@@ -24,14 +24,18 @@
 
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <string>
 
 #include "RFContext.h"
+#include "RFDiffMapHost.h"
 #include "RFEncoderSettings.h"
 #include "RFError.h"
+#include "RFKernelTuner.h"
 #include "RFUtils.h"
 
 using namespace std;
@@ -42,481 +46,2456 @@ using namespace std;
 
 const char* str_cl_DiffMapkernels = MULTI_LINE_STR(     __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
 
+                                                        // Returns c plus the sum of absolute differences of the bytes of a and b.
+                                                        unsigned int DiffMap_SAD4(uint4 a, uint4 b, unsigned int c)
+                                                        {
+                                                            uchar16 d = abs_diff(as_uchar16(a), as_uchar16(b));
+                                                            ushort8 s8 = convert_ushort8(d.s02468ace) + convert_ushort8(d.s13579bdf);
+                                                            uint4 s4 = convert_uint4(s8.s0246) + convert_uint4(s8.s1357);
+
+                                                            return c + s4.x + s4.y + s4.z + s4.w;
+                                                        }
+
+
+                                                        // The rows of a block are compared in passes of get_local_size(1) rows. The work group stops after the first pass
+                                                        // that found a difference. The second barrier guarantees that all work items read the flag before the next pass.
                                                         __kernel void DiffMap_Image(__read_only image2d_t Image1, __read_only image2d_t Image2, __global unsigned char* DiffMap,
                                                                                     unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY)
                                                         {
                                                             __local unsigned int result;
-                                                            result = 0;
+
+                                                            unsigned int localX = get_local_id(0);
+                                                            unsigned int localY = get_local_id(1);
+
+                                                            if (localX == 0 && localY == 0)
+                                                            {
+                                                                result = 0;
+                                                            }
+
                                                             barrier(CLK_LOCAL_MEM_FENCE);
-                                                            short groupX = get_group_id(0);
-                                                            short groupY = get_group_id(1);
-                                                            short groupIndex = groupX + get_num_groups(0) * groupY;
-                                                            short groupSize = get_local_size(0) * get_local_size(1);
-                                                            short localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
 
                                                             // Offset into the image
-                                                            unsigned int x_offset = groupX * uiLocalPxX;
-                                                            unsigned int y_offset = groupY * uiLocalPxY;
+                                                            unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+                                                            unsigned int y_offset = get_group_id(1) * uiLocalPxY;
 
-                                                            // Limit size to xDimension
-                                                            unsigned int localBlockSize = uiLocalPxX * uiLocalPxY;
+                                                            // Part of the block that is inside the image
+                                                            unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+                                                            unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
 
-                                                            float4 pixels1;
-                                                            float4 pixels2;
+                                                            for (unsigned int y0 = 0; y0 < blockHeight; y0 += get_local_size(1))
+                                                            {
+                                                                unsigned int changed = 0;
+                                                                unsigned int y = y0 + localY;
 
-                                                            int2 pos = (int2)(x_offset, y_offset);
+                                                                if (y < blockHeight)
+                                                                {
+                                                                    for (unsigned int x = localX; x < blockWidth; x += get_local_size(0))
+                                                                    {
+                                                                        int2 pos = (int2)(x_offset + x, y_offset + y);
 
-                                                            for (; localIndex < localBlockSize; localIndex += groupSize)
-                                                            {
-                                                                if (result != 0)
+                                                                        changed |= any(read_imagef(Image1, sampler, pos) != read_imagef(Image2, sampler, pos));
+                                                                    }
+                                                                }
+
+                                                                if (changed != 0)
                                                                 {
-                                                                    return;
+                                                                    result = 1;
                                                                 }
 
-                                                                unsigned int x = localIndex % uiLocalPxX;
-                                                                unsigned int y = localIndex / uiLocalPxX;
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
 
-                                                                pixels1 = read_imagef(Image1, sampler, pos + (int2)(x, y));
-                                                                pixels2 = read_imagef(Image2, sampler, pos + (int2)(x, y));
+                                                                changed = result;
 
-                                                                if (amd_sad4(as_uint4(pixels1), as_uint4(pixels2), 0) != 0)
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                if (changed != 0)
                                                                 {
-                                                                    result = 1;
-                                                                    DiffMap[groupIndex] = 1;
-                                                                    return;
+                                                                    break;
                                                                 }
                                                             }
+
+                                                            if (localX == 0 && localY == 0 && result != 0)
+                                                            {
+                                                                DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = 1;
+                                                            }
                                                         };
 
 
+                                                        // Each work item compares four neighbouring pixels of a row with one vector load and neighbouring work items load
+                                                        // neighbouring vectors. The position of a work item advances by the work group size in each pass. It is updated
+                                                        // incrementally to avoid an integer division in the loop.
                                                         __kernel void DiffMap_Buffer(__global unsigned int* Image1, __global unsigned int* Image2, __global unsigned char* DiffMap,
                                                                                      unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY)
                                                         {
                                                             __local unsigned int result;
-                                                            result = 0;
+
+                                                            unsigned int groupSize = get_local_size(0) * get_local_size(1);
+                                                            unsigned int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+
+                                                            if (localIndex == 0)
+                                                            {
+                                                                result = 0;
+                                                            }
+
                                                             barrier(CLK_LOCAL_MEM_FENCE);
-                                                            short groupX = get_group_id(0);
-                                                            short groupY = get_group_id(1);
-                                                            short groupIndex = groupX + get_num_groups(0) * groupY;
-                                                            short groupSize = get_local_size(0) * get_local_size(1);
-                                                            short localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
 
                                                             // Offset into the image
-                                                            unsigned int x_offset = groupX * uiLocalPxX;
-                                                            unsigned int y_offset = groupY * uiLocalPxY;
+                                                            unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+                                                            unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+
+                                                            // Part of the block that is inside the image
+                                                            unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+                                                            unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
+
+                                                            // Number of vectors per row. The last vector of a row is partial if the width is not a multiple of 4.
+                                                            unsigned int rowVectors = (blockWidth + 3) / 4;
+                                                            unsigned int stepY = groupSize / rowVectors;
+                                                            unsigned int stepX = groupSize - stepY * rowVectors;
+
+                                                            unsigned int vx = localIndex % rowVectors;
+                                                            unsigned int y = localIndex / rowVectors;
+
+                                                            for (unsigned int i = 0; i < rowVectors * blockHeight; i += groupSize)
+                                                            {
+                                                                unsigned int changed = 0;
+
+                                                                if (y < blockHeight)
+                                                                {
+                                                                    unsigned int x = 4 * vx;
+                                                                    unsigned int idx = x_offset + x + (y_offset + y) * DomainSizeX;
+
+                                                                    if (x + 4 <= blockWidth)
+                                                                    {
+                                                                        changed = any(vload4(0, Image1 + idx) != vload4(0, Image2 + idx));
+                                                                    }
+                                                                    else
+                                                                    {
+                                                                        for (; x < blockWidth; ++x)
+                                                                        {
+                                                                            changed |= (Image1[idx] != Image2[idx]);
+                                                                            ++idx;
+                                                                        }
+                                                                    }
+                                                                }
+
+                                                                if (changed != 0)
+                                                                {
+                                                                    result = 1;
+                                                                }
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                changed = result;
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                if (changed != 0)
+                                                                {
+                                                                    break;
+                                                                }
+
+                                                                vx += stepX;
+                                                                y += stepY;
+
+                                                                if (vx >= rowVectors)
+                                                                {
+                                                                    vx -= rowVectors;
+                                                                    ++y;
+                                                                }
+                                                            }
+
+                                                            if (localIndex == 0 && result != 0)
+                                                            {
+                                                                DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = 1;
+                                                            }
+                                                        };
+
+
+                                                        // Computes the sum of absolute differences of the channels of each block. A block is changed if the sum is larger than
+                                                        // uiThreshold. DiffMap stores 1 for changed blocks or, if uiMagnitude is set, the mean absolute difference of the
+                                                        // channels of the block rounded up. Each work group processes one block.
+                                                        __kernel void DiffMap_SADImage(__read_only image2d_t Image1, __read_only image2d_t Image2, __global unsigned char* DiffMap,
+                                                                                       unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY,
+                                                                                       const unsigned int uiThreshold, const unsigned int uiMagnitude)
+                                                        {
+                                                            __local unsigned int sad;
 
-                                                            // Offset into linear buffer
-                                                            unsigned int idx = x_offset + (DomainSizeX * y_offset);
+                                                            unsigned int localX = get_local_id(0);
+                                                            unsigned int localY = get_local_id(1);
 
-                                                            // Limit size to xDimension
+                                                            if (localX == 0 && localY == 0)
+                                                            {
+                                                                sad = 0;
+                                                            }
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+                                                            unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+                                                            unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+                                                            unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
+                                                            unsigned int localBlockSize = uiLocalPxX * uiLocalPxY;
+                                                            unsigned int localSad = 0;
+
+                                                            for (unsigned int y = localY; y < blockHeight; y += get_local_size(1))
+                                                            {
+                                                                for (unsigned int x = localX; x < blockWidth; x += get_local_size(0))
+                                                                {
+                                                                    int2 pos = (int2)(x_offset + x, y_offset + y);
+                                                                    uint4 pixels1 = convert_uint4_sat_rte(read_imagef(Image1, sampler, pos) * 255.0f);
+                                                                    uint4 pixels2 = convert_uint4_sat_rte(read_imagef(Image2, sampler, pos) * 255.0f);
+                                                                    uint4 d = abs_diff(pixels1, pixels2);
+
+                                                                    localSad += d.x + d.y + d.z + d.w;
+                                                                }
+                                                            }
+
+                                                            atomic_add(&sad, localSad);
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            if (localX == 0 && localY == 0)
+                                                            {
+                                                                unsigned char result = 0;
+
+                                                                if (sad > uiThreshold)
+                                                                {
+                                                                    result = (uiMagnitude != 0) ? (unsigned char)min((sad + 4 * localBlockSize - 1) / (4 * localBlockSize), 255u) : 1;
+                                                                }
+
+                                                                DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = result;
+                                                            }
+                                                        };
+
+
+                                                        __kernel void DiffMap_SADBuffer(__global unsigned int* Image1, __global unsigned int* Image2, __global unsigned char* DiffMap,
+                                                                                        unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY,
+                                                                                        const unsigned int uiThreshold, const unsigned int uiMagnitude)
+                                                        {
+                                                            __local unsigned int sad;
+
+                                                            unsigned int groupSize = get_local_size(0) * get_local_size(1);
+                                                            unsigned int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+
+                                                            if (localIndex == 0)
+                                                            {
+                                                                sad = 0;
+                                                            }
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+                                                            unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+                                                            unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+                                                            unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
                                                             unsigned int localBlockSize = uiLocalPxX * uiLocalPxY;
+                                                            unsigned int localSad = 0;
+
+                                                            // The vectors are distributed as in DiffMap_Buffer.
+                                                            unsigned int rowVectors = (blockWidth + 3) / 4;
+                                                            unsigned int stepY = groupSize / rowVectors;
+                                                            unsigned int stepX = groupSize - stepY * rowVectors;
 
-                                                            uint4 pixels1;
-                                                            uint4 pixels2;
+                                                            unsigned int vx = localIndex % rowVectors;
+                                                            unsigned int y = localIndex / rowVectors;
 
-                                                            for (; localIndex < localBlockSize; localIndex += 4 * groupSize)
+                                                            for (unsigned int i = localIndex; i < rowVectors * blockHeight; i += groupSize)
                                                             {
-                                                                if(result != 0)
+                                                                unsigned int x = 4 * vx;
+                                                                unsigned int idx = x_offset + x + (y_offset + y) * DomainSizeX;
+
+                                                                if (x + 4 <= blockWidth)
+                                                                {
+                                                                    localSad = DIFF_MAP_SAD4(vload4(0, Image1 + idx), vload4(0, Image2 + idx), localSad);
+                                                                }
+                                                                else
                                                                 {
-                                                                    return;
+                                                                    for (; x < blockWidth; ++x)
+                                                                    {
+                                                                        localSad = DIFF_MAP_SAD4((uint4)(Image1[idx], 0, 0, 0), (uint4)(Image2[idx], 0, 0, 0), localSad);
+                                                                        ++idx;
+                                                                    }
                                                                 }
 
-                                                                for (unsigned int i = 0; i < 4; ++i)
+                                                                vx += stepX;
+                                                                y += stepY;
+
+                                                                if (vx >= rowVectors)
                                                                 {
-                                                                    unsigned int localIndex_ = localIndex + i * groupSize;
-                                                                    unsigned int x = localIndex_ % uiLocalPxX;
-                                                                    unsigned int y = localIndex_ / uiLocalPxX;
-                                                                    if (x_offset + x < DomainSizeX && y_offset + y < DomainSizeY)
+                                                                    vx -= rowVectors;
+                                                                    ++y;
+                                                                }
+                                                            }
+
+                                                            atomic_add(&sad, localSad);
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            if (localIndex == 0)
+                                                            {
+                                                                unsigned char result = 0;
+
+                                                                if (sad > uiThreshold)
+                                                                {
+                                                                    result = (uiMagnitude != 0) ? (unsigned char)min((sad + 4 * localBlockSize - 1) / (4 * localBlockSize), 255u) : 1;
+                                                                }
+
+                                                                DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = result;
+                                                            }
+                                                        };
+
+
+                                                        // Compares the NV12 images of two result buffers byte by byte. The luma plane has DomainSizeX x DomainSizeY bytes and is
+                                                        // followed by the interleaved chroma plane with DomainSizeX x DomainSizeY / 2 bytes. If uiChroma is set the chroma rows
+                                                        // that belong to a block are compared after its luma rows. The rows are distributed as the vectors in DiffMap_Buffer,
+                                                        // each work item compares 8 bytes.
+                                                        __kernel void DiffMap_NV12Buffer(__global unsigned char* Image1, __global unsigned char* Image2, __global unsigned char* DiffMap,
+                                                                                         unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY,
+                                                                                         const unsigned int uiChroma)
+                                                        {
+                                                            __local unsigned int result;
+
+                                                            unsigned int groupSize = get_local_size(0) * get_local_size(1);
+                                                            unsigned int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+
+                                                            if (localIndex == 0)
+                                                            {
+                                                                result = 0;
+                                                            }
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+                                                            unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+                                                            unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+                                                            unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
+
+                                                            // Each UV pair covers 2x2 luma samples, hence the chroma rows of a block have the same width in bytes.
+                                                            // The chroma plane has DomainSizeY / 2 rows, the last block of an image with an odd height gets one row less.
+                                                            unsigned int chromaHeight = (uiChroma != 0) ? min((blockHeight + 1) / 2, DomainSizeY / 2 - y_offset / 2) : 0;
+                                                            unsigned int chromaOffset = DomainSizeX * DomainSizeY + x_offset + (y_offset / 2) * DomainSizeX;
+                                                            unsigned int numRows = blockHeight + chromaHeight;
+
+                                                            unsigned int rowVectors = (blockWidth + 7) / 8;
+                                                            unsigned int stepY = groupSize / rowVectors;
+                                                            unsigned int stepX = groupSize - stepY * rowVectors;
+
+                                                            unsigned int vx = localIndex % rowVectors;
+                                                            unsigned int y = localIndex / rowVectors;
+
+                                                            for (unsigned int i = 0; i < rowVectors * numRows; i += groupSize)
+                                                            {
+                                                                unsigned int changed = 0;
+
+                                                                if (y < numRows)
+                                                                {
+                                                                    unsigned int x = 8 * vx;
+                                                                    unsigned int idx = (y < blockHeight) ? x_offset + x + (y_offset + y) * DomainSizeX : chromaOffset + x + (y - blockHeight) * DomainSizeX;
+
+                                                                    if (x + 8 <= blockWidth)
                                                                     {
-                                                                        ((unsigned int*)&(pixels1))[i] = Image1[idx + x + y * DomainSizeX];
-                                                                        ((unsigned int*)&(pixels2))[i] = Image2[idx + x + y * DomainSizeX];
+                                                                        changed = any(vload8(0, Image1 + idx) != vload8(0, Image2 + idx));
                                                                     }
                                                                     else
                                                                     {
-                                                                        ((unsigned int*)&(pixels1))[i] = 0;
-                                                                        ((unsigned int*)&(pixels2))[i] = 0;
+                                                                        for (; x < blockWidth; ++x)
+                                                                        {
+                                                                            changed |= (Image1[idx] != Image2[idx]);
+                                                                            ++idx;
+                                                                        }
                                                                     }
                                                                 }
-                                                                if (amd_sad4(pixels1, pixels2, 0) != 0)
+
+                                                                if (changed != 0)
                                                                 {
                                                                     result = 1;
-                                                                    DiffMap[groupIndex] = 1;
-                                                                    return;
+                                                                }
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                changed = result;
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                if (changed != 0)
+                                                                {
+                                                                    break;
+                                                                }
+
+                                                                vx += stepX;
+                                                                y += stepY;
+
+                                                                if (vx >= rowVectors)
+                                                                {
+                                                                    vx -= rowVectors;
+                                                                    ++y;
                                                                 }
                                                             }
+
+                                                            if (localIndex == 0 && result != 0)
+                                                            {
+                                                                DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = 1;
+                                                            }
                                                         };
-                                                    );
 
 
-// ATTENTION: The difference encoder needs two frames (ResultBuffers) to create a difference map. In order not to override
-// the result buffer of the previous frame, the RFEncoderDM::encode function needs to fail before the result buffer gets written.
-// Therefor the diff encoder can only store NUM_RESULT_BUFFERS - 1 frames. This way the RFEncoderDM::m_ResultQueue is full
-// but the RFContext::m_clResultBuffer has still one slot left which contains the previous frame.
-RFEncoderDM::RFEncoderDM()
-    : RFEncoder()
-    , m_uiNumTargetBuffers(NUM_RESULT_BUFFERS - 1)
-    , m_bLockMappedBuffer(false)
-    , m_uiPreviousBuffer(0)
-    , m_uiCurrentTargetBuffer(0)
-    , m_pClearData(nullptr)
-    , m_uiDiffMapSize(0)
-    , m_DiffMapImagekernel(NULL)
-    , m_DiffMapBufferkernel(NULL)
-    , m_pContext(nullptr)
-    , m_pMappedBuffer(nullptr)
-{
-    m_uiTotalBlockSize[0] = 16;
-    m_uiTotalBlockSize[1] = 16;
+                                                        // Computes a coarser level of the diff map pyramid. Each entry is the maximum of uiFactor x uiFactor entries of the
+                                                        // finer level. Both levels are stored in DiffMap at the given offsets.
+                                                        __kernel void DiffMap_Reduce(__global unsigned char* DiffMap, const unsigned int uiSrcOffset, const unsigned int uiSrcWidth, const unsigned int uiSrcHeight,
+                                                                                     const unsigned int uiDstOffset, const unsigned int uiDstWidth, const unsigned int uiFactor)
+                                                        {
+                                                            unsigned int x = get_global_id(0);
+                                                            unsigned int y = get_global_id(1);
+
+                                                            unsigned int x0 = x * uiFactor;
+                                                            unsigned int y0 = y * uiFactor;
+                                                            unsigned int x1 = min(x0 + uiFactor, uiSrcWidth);
+                                                            unsigned int y1 = min(y0 + uiFactor, uiSrcHeight);
+
+                                                            unsigned char result = 0;
+
+                                                            for (unsigned int j = y0; j < y1; ++j)
+                                                            {
+                                                                for (unsigned int i = x0; i < x1; ++i)
+                                                                {
+                                                                    result = max(result, DiffMap[uiSrcOffset + j * uiSrcWidth + i]);
+                                                                }
+                                                            }
+
+                                                            DiffMap[uiDstOffset + y * uiDstWidth + x] = result;
+                                                        };
+
+
+                                                        // Adds the diff map of the current frame to the map accumulated for a consumer. Entries keep the maximum to preserve the
+                                                        // magnitude of changed blocks.
+                                                        __kernel void DiffMap_Accumulate(__global unsigned char* DiffMap, __global unsigned char* Accumulated)
+                                                        {
+                                                            unsigned int i = get_global_id(0);
+
+                                                            Accumulated[i] = max(Accumulated[i], DiffMap[i]);
+                                                        };
+
+
+                                                        // Detects blocks that alternate between a few states like a blinking caret. Each work item processes one block of the
+                                                        // first level. History stores the signatures of the last uiHistory distinct states of each block and State the number of
+                                                        // stored signatures, the index of the next signature that is replaced and the number of consecutive changes to a stored
+                                                        // state. A changed block whose last uiHistory changes returned to a stored state is removed from the diff map and marked
+                                                        // in PeriodicMap.
+                                                        __kernel void DiffMap_Periodic(__global unsigned int* Image, __global unsigned char* DiffMap, __global ulong* History, __global unsigned int* State,
+                                                                                       __global unsigned char* PeriodicMap, const unsigned int uiHistory, const unsigned int uiWidth, const unsigned int uiHeight,
+                                                                                       const unsigned int uiBlockWidth, const unsigned int uiBlockHeight)
+                                                        {
+                                                            unsigned int bx = get_global_id(0);
+                                                            unsigned int by = get_global_id(1);
+                                                            unsigned int block = by * get_global_size(0) + bx;
+
+                                                            PeriodicMap[block] = 0;
+
+                                                            if (DiffMap[block] == 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int x0 = bx * uiBlockWidth;
+                                                            unsigned int y0 = by * uiBlockHeight;
+                                                            unsigned int x1 = min(x0 + uiBlockWidth, uiWidth);
+                                                            unsigned int y1 = min(y0 + uiBlockHeight, uiHeight);
+
+                                                            ulong hash = 14695981039346656037UL;
+
+                                                            for (unsigned int y = y0; y < y1; ++y)
+                                                            {
+                                                                for (unsigned int x = x0; x < x1; ++x)
+                                                                {
+                                                                    hash = (hash ^ Image[y * uiWidth + x]) * 1099511628211UL;
+                                                                }
+                                                            }
+
+                                                            __global ulong* Signatures = History + block * uiHistory;
+
+                                                            unsigned int state    = State[block];
+                                                            unsigned int stored   = state & 0xFF;
+                                                            unsigned int next     = (state >> 8) & 0xFF;
+                                                            unsigned int revisits = state >> 16;
+                                                            unsigned int known    = 0;
+
+                                                            for (unsigned int i = 0; i < stored; ++i)
+                                                            {
+                                                                known |= (Signatures[i] == hash) ? 1 : 0;
+                                                            }
+
+                                                            if (known)
+                                                            {
+                                                                revisits = min(revisits + 1, 0xFFFFu);
+                                                            }
+                                                            else
+                                                            {
+                                                                Signatures[next] = hash;
+
+                                                                next     = (next + 1) % uiHistory;
+                                                                stored   = min(stored + 1, uiHistory);
+                                                                revisits = 0;
+                                                            }
+
+                                                            State[block] = stored | (next << 8) | (revisits << 16);
+
+                                                            if (revisits >= uiHistory)
+                                                            {
+                                                                DiffMap[block]     = 0;
+                                                                PeriodicMap[block] = 1;
+                                                            }
+                                                        };
+
+
+                                                        // Packs the entries of one level of the diff map into one bit per entry. Each work item writes one byte, rows of the
+                                                        // packed map have uiPitch bytes. The first entry of a byte is stored in the least significant bit.
+                                                        __kernel void DiffMap_Pack(__global unsigned char* DiffMap, const unsigned int uiSrcOffset, const unsigned int uiSrcWidth,
+                                                                                   __global unsigned char* Bits, const unsigned int uiDstOffset, const unsigned int uiPitch)
+                                                        {
+                                                            unsigned int x = get_global_id(0);
+                                                            unsigned int y = get_global_id(1);
+
+                                                            unsigned int x0 = x * 8;
+                                                            unsigned int x1 = min(x0 + 8, uiSrcWidth);
+
+                                                            unsigned char bits = 0;
+
+                                                            for (unsigned int i = x0; i < x1; ++i)
+                                                            {
+                                                                if (DiffMap[uiSrcOffset + y * uiSrcWidth + i] != 0)
+                                                                {
+                                                                    bits |= (unsigned char)(1 << (i - x0));
+                                                                }
+                                                            }
+
+                                                            Bits[uiDstOffset + y * uiPitch + x] = bits;
+                                                        };
+
+
+                                                        // Finds the maximal horizontal runs of changed blocks. Each work item processes one row and stores up to uiMaxRuns
+                                                        // runs as {start, end} in Runs.
+                                                        __kernel void DiffMap_Runs(__global unsigned char* DiffMap, const unsigned int uiWidth, const unsigned int uiMaxRuns,
+                                                                                   __global uint2* Runs, __global unsigned int* RunCount)
+                                                        {
+                                                            unsigned int y = get_global_id(0);
+
+                                                            __global unsigned char* Row = DiffMap + y * uiWidth;
+                                                            __global uint2* RowRuns = Runs + y * uiMaxRuns;
+
+                                                            unsigned int n = 0;
+                                                            unsigned int x = 0;
+
+                                                            while (x < uiWidth)
+                                                            {
+                                                                if (Row[x] == 0)
+                                                                {
+                                                                    ++x;
+                                                                    continue;
+                                                                }
+
+                                                                unsigned int x0 = x;
+
+                                                                while (x < uiWidth && Row[x] != 0)
+                                                                {
+                                                                    ++x;
+                                                                }
+
+                                                                RowRuns[n] = (uint2)(x0, x);
+                                                                ++n;
+                                                            }
+
+                                                            RunCount[y] = n;
+                                                        };
+
+
+                                                        // Merges the runs found by DiffMap_Runs into rectangles. A run is appended to the rectangle of the run in the row above
+                                                        // if both have the same extent. Runs with no match start a new rectangle. Executed by a single work item since each
+                                                        // row depends on the previous one. Rects contains the number of rectangles followed by {x, y, width, height}.
+                                                        __kernel void DiffMap_Rects(__global uint2* Runs, __global unsigned int* RunCount, __global unsigned int* RunRect,
+                                                                                    const unsigned int uiHeight, const unsigned int uiMaxRuns, __global unsigned int* Rects)
+                                                        {
+                                                            unsigned int uiNumRects = 0;
+                                                            unsigned int uiPrevCount = 0;
+
+                                                            for (unsigned int y = 0; y < uiHeight; ++y)
+                                                            {
+                                                                unsigned int uiCount = RunCount[y];
+                                                                unsigned int uiPrev = 0;
+
+                                                                for (unsigned int i = 0; i < uiCount; ++i)
+                                                                {
+                                                                    uint2 run = Runs[y * uiMaxRuns + i];
+
+                                                                    // Runs of both rows are sorted, skip the runs of the previous row that start left of this one.
+                                                                    while (uiPrev < uiPrevCount && Runs[(y - 1) * uiMaxRuns + uiPrev].x < run.x)
+                                                                    {
+                                                                        ++uiPrev;
+                                                                    }
+
+                                                                    unsigned int uiRect;
+
+                                                                    if (uiPrev < uiPrevCount && Runs[(y - 1) * uiMaxRuns + uiPrev].x == run.x && Runs[(y - 1) * uiMaxRuns + uiPrev].y == run.y)
+                                                                    {
+                                                                        uiRect = RunRect[(y - 1) * uiMaxRuns + uiPrev];
+                                                                        Rects[1 + 4 * uiRect + 3] += 1;
+                                                                        ++uiPrev;
+                                                                    }
+                                                                    else
+                                                                    {
+                                                                        uiRect = uiNumRects;
+                                                                        ++uiNumRects;
+
+                                                                        Rects[1 + 4 * uiRect + 0] = run.x;
+                                                                        Rects[1 + 4 * uiRect + 1] = y;
+                                                                        Rects[1 + 4 * uiRect + 2] = run.y - run.x;
+                                                                        Rects[1 + 4 * uiRect + 3] = 1;
+                                                                    }
+
+                                                                    RunRect[y * uiMaxRuns + i] = uiRect;
+                                                                }
+
+                                                                uiPrevCount = uiCount;
+                                                            }
+
+                                                            Rects[0] = uiNumRects;
+                                                        };
+
+
+                                                        // Computes the exclusive prefix sum of the changed blocks inside each work group. TileOffsets receives the position of
+                                                        // each changed block among the changed blocks of its group and GroupSums the number of changed blocks of each group.
+                                                        // Scan needs one entry per work item.
+                                                        __kernel void DiffMap_TileScan(__global unsigned char* DiffMap, const unsigned int uiNumBlocks, __global unsigned int* TileOffsets,
+                                                                                       __global unsigned int* GroupSums, __local unsigned int* Scan)
+                                                        {
+                                                            unsigned int gid = get_global_id(0);
+                                                            unsigned int lid = get_local_id(0);
+                                                            unsigned int groupSize = get_local_size(0);
+
+                                                            unsigned int changed = (gid < uiNumBlocks && DiffMap[gid] != 0) ? 1 : 0;
+
+                                                            Scan[lid] = changed;
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            // Inclusive scan in log2(groupSize) steps.
+                                                            for (unsigned int offset = 1; offset < groupSize; offset *= 2)
+                                                            {
+                                                                unsigned int value = (lid >= offset) ? Scan[lid - offset] : 0;
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                Scan[lid] += value;
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+                                                            }
+
+                                                            if (gid < uiNumBlocks)
+                                                            {
+                                                                TileOffsets[gid] = Scan[lid] - changed;
+                                                            }
+
+                                                            if (lid == groupSize - 1)
+                                                            {
+                                                                GroupSums[get_group_id(0)] = Scan[lid];
+                                                            }
+                                                        };
+
+
+                                                        // Replaces the number of changed blocks of each group of DiffMap_TileScan with the number of changed blocks of all
+                                                        // previous groups and stores the total as the first value of Tiles. Executed by a single work item.
+                                                        __kernel void DiffMap_TileGroups(__global unsigned int* GroupSums, const unsigned int uiNumGroups, __global unsigned int* Tiles)
+                                                        {
+                                                            unsigned int uiSum = 0;
+
+                                                            for (unsigned int i = 0; i < uiNumGroups; ++i)
+                                                            {
+                                                                unsigned int uiCount = GroupSums[i];
+
+                                                                GroupSums[i] = uiSum;
+                                                                uiSum += uiCount;
+                                                            }
+
+                                                            Tiles[0] = uiSum;
+                                                        };
+
+
+                                                        // Copies the pixels of each changed block to its position in the compacted list. Tiles contains the number of
+                                                        // blocks n followed by n block indices and the pixels of the n blocks. Each work group processes one block.
+                                                        __kernel void DiffMap_TileGather(__global unsigned int* Image, __global unsigned char* DiffMap, __global unsigned int* TileOffsets,
+                                                                                         __global unsigned int* GroupSums, const unsigned int uiScanGroupSize, __global unsigned int* Tiles,
+                                                                                         unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY)
+                                                        {
+                                                            unsigned int block = get_group_id(0) + get_num_groups(0) * get_group_id(1);
+
+                                                            if (DiffMap[block] == 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int localX = get_local_id(0);
+                                                            unsigned int localY = get_local_id(1);
+                                                            unsigned int tile = GroupSums[block / uiScanGroupSize] + TileOffsets[block];
+
+                                                            if (localX == 0 && localY == 0)
+                                                            {
+                                                                Tiles[1 + tile] = block;
+                                                            }
+
+                                                            __global unsigned int* Tile = Tiles + 1 + Tiles[0] + tile * uiLocalPxX * uiLocalPxY;
+
+                                                            unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+                                                            unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+
+                                                            for (unsigned int y = localY; y < uiLocalPxY; y += get_local_size(1))
+                                                            {
+                                                                for (unsigned int x = localX; x < uiLocalPxX; x += get_local_size(0))
+                                                                {
+                                                                    unsigned int pixel = 0;
+
+                                                                    if (x_offset + x < DomainSizeX && y_offset + y < DomainSizeY)
+                                                                    {
+                                                                        pixel = Image[x_offset + x + (y_offset + y) * DomainSizeX];
+                                                                    }
+
+                                                                    Tile[x + y * uiLocalPxX] = pixel;
+                                                                }
+                                                            }
+                                                        };
+
+
+                                                        // Computes the bounding box of the changed blocks for the scroll detection and clears the scores. Executed by a single
+                                                        // work item. Scroll contains the box {x0, y0, x1, y1} in blocks followed by the RFDiffCopyRect.
+                                                        __kernel void DiffMap_Bounds(__global unsigned char* DiffMap, const unsigned int uiMapWidth, const unsigned int uiMapHeight,
+                                                                                     __global int* Scroll, __global unsigned int* Scores, const unsigned int uiNumScores)
+                                                        {
+                                                            int4 box = (int4)(uiMapWidth, uiMapHeight, 0, 0);
+
+                                                            for (unsigned int y = 0; y < uiMapHeight; ++y)
+                                                            {
+                                                                for (unsigned int x = 0; x < uiMapWidth; ++x)
+                                                                {
+                                                                    if (DiffMap[y * uiMapWidth + x] != 0)
+                                                                    {
+                                                                        box = (int4)(min(box.x, (int)x), min(box.y, (int)y), max(box.z, (int)x + 1), max(box.w, (int)y + 1));
+                                                                    }
+                                                                }
+                                                            }
+
+                                                            vstore4(box, 0, Scroll);
+
+                                                            for (unsigned int i = 4; i < 10; ++i)
+                                                            {
+                                                                Scroll[i] = 0;
+                                                            }
+
+                                                            for (unsigned int i = 0; i < uiNumScores; ++i)
+                                                            {
+                                                                Scores[i] = 0;
+                                                            }
+                                                        };
+
+
+                                                        // Maps work item i to a line of the scroll detection. Rows of the block columns are followed by columns of the block rows.
+                                                        // Returns false if the line is outside of the box found by DiffMap_Bounds, otherwise the line contains the pixels
+                                                        // [uiStart, uiEnd) of row or column uiLine.
+                                                        bool DiffMap_ScrollLine(unsigned int i, __global int* Scroll, const unsigned int uiWidth, const unsigned int uiHeight,
+                                                                                const unsigned int uiBlockWidth, const unsigned int uiBlockHeight, const unsigned int uiMapWidth,
+                                                                                bool* pRow, unsigned int* pLine, unsigned int* pStart, unsigned int* pEnd)
+                                                        {
+                                                            unsigned int uiNumRowLines = uiMapWidth * uiHeight;
+
+                                                            bool bRow = (i < uiNumRowLines);
+                                                            int  k    = (bRow) ? i / uiHeight : (i - uiNumRowLines) / uiWidth;
+                                                            int  j    = (bRow) ? i % uiHeight : (i - uiNumRowLines) % uiWidth;
+
+                                                            if (bRow && (k < Scroll[0] || k >= Scroll[2] || j < Scroll[1] * (int)uiBlockHeight || j >= min(Scroll[3] * (int)uiBlockHeight, (int)uiHeight)))
+                                                            {
+                                                                return false;
+                                                            }
+
+                                                            if (!bRow && (k < Scroll[1] || k >= Scroll[3] || j < Scroll[0] * (int)uiBlockWidth || j >= min(Scroll[2] * (int)uiBlockWidth, (int)uiWidth)))
+                                                            {
+                                                                return false;
+                                                            }
+
+                                                            *pRow   = bRow;
+                                                            *pLine  = j;
+                                                            *pStart = k * ((bRow) ? uiBlockWidth : uiBlockHeight);
+                                                            *pEnd   = min(*pStart + ((bRow) ? uiBlockWidth : uiBlockHeight), (bRow) ? uiWidth : uiHeight);
+
+                                                            return true;
+                                                        };
+
+
+                                                        // Computes the FNV-1a hashes of the lines of both images. The hashes of Image1 are followed by the ones of Image2.
+                                                        // Each work item processes one line.
+                                                        __kernel void DiffMap_LineHashBuffer(__global unsigned int* Image1, __global unsigned int* Image2, __global int* Scroll, __global unsigned int* LineHashes,
+                                                                                             const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                                                                             const unsigned int uiMapWidth, const unsigned int uiNumLines)
+                                                        {
+                                                            unsigned int i = get_global_id(0);
+
+                                                            bool bRow;
+                                                            unsigned int uiLine;
+                                                            unsigned int uiStart;
+                                                            unsigned int uiEnd;
+
+                                                            if (!DiffMap_ScrollLine(i, Scroll, uiWidth, uiHeight, uiBlockWidth, uiBlockHeight, uiMapWidth, &bRow, &uiLine, &uiStart, &uiEnd))
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int uiHash1 = 2166136261u;
+                                                            unsigned int uiHash2 = 2166136261u;
+
+                                                            for (unsigned int t = uiStart; t < uiEnd; ++t)
+                                                            {
+                                                                unsigned int idx = (bRow) ? uiLine * uiWidth + t : t * uiWidth + uiLine;
+
+                                                                uiHash1 = (uiHash1 ^ Image1[idx]) * 16777619u;
+                                                                uiHash2 = (uiHash2 ^ Image2[idx]) * 16777619u;
+                                                            }
+
+                                                            LineHashes[i] = uiHash1;
+                                                            LineHashes[uiNumLines + i] = uiHash2;
+                                                        };
+
+
+                                                        __kernel void DiffMap_LineHashImage(__read_only image2d_t Image1, __read_only image2d_t Image2, __global int* Scroll, __global unsigned int* LineHashes,
+                                                                                            const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                                                                            const unsigned int uiMapWidth, const unsigned int uiNumLines)
+                                                        {
+                                                            unsigned int i = get_global_id(0);
+
+                                                            bool bRow;
+                                                            unsigned int uiLine;
+                                                            unsigned int uiStart;
+                                                            unsigned int uiEnd;
+
+                                                            if (!DiffMap_ScrollLine(i, Scroll, uiWidth, uiHeight, uiBlockWidth, uiBlockHeight, uiMapWidth, &bRow, &uiLine, &uiStart, &uiEnd))
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int uiHash1 = 2166136261u;
+                                                            unsigned int uiHash2 = 2166136261u;
+
+                                                            for (unsigned int t = uiStart; t < uiEnd; ++t)
+                                                            {
+                                                                int2 pos = (bRow) ? (int2)(t, uiLine) : (int2)(uiLine, t);
+
+                                                                uint4 pixels1 = as_uint4(read_imagef(Image1, sampler, pos));
+                                                                uint4 pixels2 = as_uint4(read_imagef(Image2, sampler, pos));
+
+                                                                for (unsigned int c = 0; c < 4; ++c)
+                                                                {
+                                                                    uiHash1 = (uiHash1 ^ ((unsigned int*)&pixels1)[c]) * 16777619u;
+                                                                    uiHash2 = (uiHash2 ^ ((unsigned int*)&pixels2)[c]) * 16777619u;
+                                                                }
+                                                            }
+
+                                                            LineHashes[i] = uiHash1;
+                                                            LineHashes[uiNumLines + i] = uiHash2;
+                                                        };
+
+
+                                                        // Counts the lines in [iLow, iHigh) of Cur that are equal to the line shifted by s in Prev and that changed. With s = 0
+                                                        // the number of changed lines is returned.
+                                                        unsigned int DiffMap_CountLineMatches(__global unsigned int* Cur, __global unsigned int* Prev, int iLow, int iHigh, int s)
+                                                        {
+                                                            unsigned int n = 0;
+
+                                                            for (int j = max(iLow, iLow + s); j < min(iHigh, iHigh + s); ++j)
+                                                            {
+                                                                if ((s == 0 || Cur[j] == Prev[j - s]) && Cur[j] != Prev[j])
+                                                                {
+                                                                    ++n;
+                                                                }
+                                                            }
+
+                                                            return n;
+                                                        };
+
+
+                                                        // Scores the shifts of the scroll detection. Work item (i, k) counts the lines of strip k that match with a shift of
+                                                        // i - iRange. The block columns [0, uiMapWidth) are scored as vertical shifts in Scores[0, 2 * iRange], the following
+                                                        // block rows as horizontal shifts. The score of a shift of 0 is the number of changed lines.
+                                                        __kernel void DiffMap_ScrollSearch(__global unsigned int* LineHashes, __global int* Scroll, __global unsigned int* Scores,
+                                                                                           const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                                                                           const unsigned int uiMapWidth, const unsigned int uiNumLines, const int iRange)
+                                                        {
+                                                            int  s         = (int)get_global_id(0) - iRange;
+                                                            int  k         = get_global_id(1);
+                                                            bool bVertical = (k < (int)uiMapWidth);
+
+                                                            k = (bVertical) ? k : k - (int)uiMapWidth;
+
+                                                            if ((bVertical && (k < Scroll[0] || k >= Scroll[2])) || (!bVertical && (k < Scroll[1] || k >= Scroll[3])))
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            int iLow  = (bVertical) ? Scroll[1] * (int)uiBlockHeight : Scroll[0] * (int)uiBlockWidth;
+                                                            int iHigh = (bVertical) ? min(Scroll[3] * (int)uiBlockHeight, (int)uiHeight) : min(Scroll[2] * (int)uiBlockWidth, (int)uiWidth);
+
+                                                            unsigned int uiOffset = (bVertical) ? k * uiHeight : uiMapWidth * uiHeight + k * uiWidth;
+
+                                                            unsigned int n = DiffMap_CountLineMatches(LineHashes + uiOffset, LineHashes + uiNumLines + uiOffset, iLow, iHigh, s);
+
+                                                            if (n > 0)
+                                                            {
+                                                                atomic_add(&Scores[((bVertical) ? 0 : 2 * iRange + 1) + get_global_id(0)], n);
+                                                            }
+                                                        };
+
+
+                                                        // Selects the best shift scored by DiffMap_ScrollSearch and stores the RFDiffCopyRect in Scroll. A shift is accepted if
+                                                        // it matches at least uiMinLines lines and half of the changed lines. The copy covers the strips in which the shift
+                                                        // matches half of the changed lines. Executed by a single work item.
+                                                        __kernel void DiffMap_ScrollSelect(__global unsigned int* LineHashes, __global int* Scroll, __global unsigned int* Scores,
+                                                                                           const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                                                                           const unsigned int uiMapWidth, const unsigned int uiNumLines, const int iRange, const unsigned int uiMinLines)
+                                                        {
+                                                            if (Scroll[2] == 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int uiBest = 0;
+                                                            int iBestIdx = -1;
+
+                                                            for (int i = 0; i < 2 * (2 * iRange + 1); ++i)
+                                                            {
+                                                                bool bVertical = (i <= 2 * iRange);
+                                                                unsigned int uiChanged = Scores[(bVertical) ? iRange : 3 * iRange + 1];
+
+                                                                if (i != iRange && i != 3 * iRange + 1 && Scores[i] > uiBest && Scores[i] >= uiMinLines && 2 * Scores[i] >= uiChanged)
+                                                                {
+                                                                    uiBest = Scores[i];
+                                                                    iBestIdx = i;
+                                                                }
+                                                            }
+
+                                                            if (iBestIdx < 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            bool bVertical = (iBestIdx <= 2 * iRange);
+                                                            int  s         = ((bVertical) ? iBestIdx : iBestIdx - 2 * iRange - 1) - iRange;
+
+                                                            int iPx0 = Scroll[0] * (int)uiBlockWidth;
+                                                            int iPy0 = Scroll[1] * (int)uiBlockHeight;
+                                                            int iPx1 = min(Scroll[2] * (int)uiBlockWidth, (int)uiWidth);
+                                                            int iPy1 = min(Scroll[3] * (int)uiBlockHeight, (int)uiHeight);
+
+                                                            int iFirst = -1;
+                                                            int iLast = -1;
+
+                                                            for (int k = (bVertical) ? Scroll[0] : Scroll[1]; k < ((bVertical) ? Scroll[2] : Scroll[3]); ++k)
+                                                            {
+                                                                unsigned int uiOffset = (bVertical) ? k * uiHeight : uiMapWidth * uiHeight + k * uiWidth;
+
+                                                                unsigned int uiMatches = DiffMap_CountLineMatches(LineHashes + uiOffset, LineHashes + uiNumLines + uiOffset, (bVertical) ? iPy0 : iPx0, (bVertical) ? iPy1 : iPx1, s);
+                                                                unsigned int uiChanged = DiffMap_CountLineMatches(LineHashes + uiOffset, LineHashes + uiNumLines + uiOffset, (bVertical) ? iPy0 : iPx0, (bVertical) ? iPy1 : iPx1, 0);
+
+                                                                if (uiMatches > 0 && 2 * uiMatches >= uiChanged)
+                                                                {
+                                                                    iFirst = (iFirst < 0) ? k : iFirst;
+                                                                    iLast = k;
+                                                                }
+                                                            }
+
+                                                            if (bVertical)
+                                                            {
+                                                                Scroll[4] = iFirst * uiBlockWidth;
+                                                                Scroll[5] = (s > 0) ? iPy0 : iPy0 - s;
+                                                                Scroll[6] = min((iLast + 1) * (int)uiBlockWidth, (int)uiWidth) - Scroll[4];
+                                                                Scroll[7] = iPy1 - iPy0 - abs(s);
+                                                                Scroll[9] = s;
+                                                            }
+                                                            else
+                                                            {
+                                                                Scroll[4] = (s > 0) ? iPx0 : iPx0 - s;
+                                                                Scroll[5] = iFirst * uiBlockHeight;
+                                                                Scroll[6] = iPx1 - iPx0 - abs(s);
+                                                                Scroll[7] = min((iLast + 1) * (int)uiBlockHeight, (int)uiHeight) - Scroll[5];
+                                                                Scroll[8] = s;
+                                                            }
+                                                        };
+
+
+                                                        // Recomputes the entries of the diff map that overlap the destination of the copy selected by DiffMap_ScrollSelect.
+                                                        // Pixels inside of the destination are compared with the moved pixels of Image2. Each work item processes one block.
+                                                        __kernel void DiffMap_ResidualBuffer(__global unsigned int* Image1, __global unsigned int* Image2, __global unsigned char* DiffMap, __global int* Scroll,
+                                                                                             const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                                                                             const unsigned int uiMapWidth)
+                                                        {
+                                                            if (Scroll[6] == 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            int4 dst = (int4)(Scroll[4] + Scroll[8], Scroll[5] + Scroll[9], Scroll[4] + Scroll[8] + Scroll[6], Scroll[5] + Scroll[9] + Scroll[7]);
+
+                                                            int x0 = get_global_id(0) * uiBlockWidth;
+                                                            int y0 = get_global_id(1) * uiBlockHeight;
+                                                            int x1 = min(x0 + (int)uiBlockWidth, (int)uiWidth);
+                                                            int y1 = min(y0 + (int)uiBlockHeight, (int)uiHeight);
+
+                                                            if (x1 <= dst.x || x0 >= dst.z || y1 <= dst.y || y0 >= dst.w)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned char result = 0;
+
+                                                            for (int y = y0; y < y1 && result == 0; ++y)
+                                                            {
+                                                                for (int x = x0; x < x1; ++x)
+                                                                {
+                                                                    bool bInside = (x >= dst.x && x < dst.z && y >= dst.y && y < dst.w);
+
+                                                                    int px = (bInside) ? x - Scroll[8] : x;
+                                                                    int py = (bInside) ? y - Scroll[9] : y;
+
+                                                                    if (Image1[y * uiWidth + x] != Image2[py * uiWidth + px])
+                                                                    {
+                                                                        result = 1;
+                                                                        break;
+                                                                    }
+                                                                }
+                                                            }
+
+                                                            DiffMap[get_global_id(1) * uiMapWidth + get_global_id(0)] = result;
+                                                        };
+
+
+                                                        __kernel void DiffMap_ResidualImage(__read_only image2d_t Image1, __read_only image2d_t Image2, __global unsigned char* DiffMap, __global int* Scroll,
+                                                                                            const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                                                                            const unsigned int uiMapWidth)
+                                                        {
+                                                            if (Scroll[6] == 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            int4 dst = (int4)(Scroll[4] + Scroll[8], Scroll[5] + Scroll[9], Scroll[4] + Scroll[8] + Scroll[6], Scroll[5] + Scroll[9] + Scroll[7]);
+
+                                                            int x0 = get_global_id(0) * uiBlockWidth;
+                                                            int y0 = get_global_id(1) * uiBlockHeight;
+                                                            int x1 = min(x0 + (int)uiBlockWidth, (int)uiWidth);
+                                                            int y1 = min(y0 + (int)uiBlockHeight, (int)uiHeight);
+
+                                                            if (x1 <= dst.x || x0 >= dst.z || y1 <= dst.y || y0 >= dst.w)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned char result = 0;
+
+                                                            for (int y = y0; y < y1 && result == 0; ++y)
+                                                            {
+                                                                for (int x = x0; x < x1; ++x)
+                                                                {
+                                                                    bool bInside = (x >= dst.x && x < dst.z && y >= dst.y && y < dst.w);
+
+                                                                    int2 pos = (bInside) ? (int2)(x - Scroll[8], y - Scroll[9]) : (int2)(x, y);
+
+                                                                    if (any(as_uint4(read_imagef(Image1, sampler, (int2)(x, y))) != as_uint4(read_imagef(Image2, sampler, pos))))
+                                                                    {
+                                                                        result = 1;
+                                                                        break;
+                                                                    }
+                                                                }
+                                                            }
+
+                                                            DiffMap[get_global_id(1) * uiMapWidth + get_global_id(0)] = result;
+                                                        };
+                                                    );
+
+
+// ATTENTION: The difference encoder needs two frames (ResultBuffers) to create a difference map. In order not to override
+// the result buffer of the previous frame, the RFEncoderDM::encode function needs to fail before the result buffer gets written.
+// Therefor the diff encoder can only store RFContextCL::getNumResultBuffers() - 1 frames. This way the RFEncoderDM::m_ResultQueue is full
+// but the RFContext::m_clResultBuffer has still one slot left which contains the previous frame.
+RFEncoderDM::RFEncoderDM()
+    : RFEncoder()
+    , m_uiNumTargetBuffers(0)
+    , m_uiQueueTimeout(DEFAULT_DIFF_MAP_QUEUE_TIMEOUT)
+    , m_bLockMappedBuffer(false)
+    , m_bGPUOutput(false)
+    , m_bFusedCSC(false)
+    , m_bHostDiffMap(false)
+    , m_uiPreviousBuffer(0)
+    , m_uiCurrentTargetBuffer(0)
+    , m_pClearData(nullptr)
+    , m_uiDiffMapSize(0)
+    , m_bPyramid(false)
+    , m_uiNumLevels(1)
+    , m_uiOutputMode(RF_DIFF_MAP_BYTES)
+    , m_uiOutputSize(0)
+    , m_uiReadbackSize(0)
+    , m_uiMaxRuns(0)
+    , m_clRuns(NULL)
+    , m_clRunCount(NULL)
+    , m_clRunRect(NULL)
+    , m_uiTileSize(0)
+    , m_uiNumScanGroups(0)
+    , m_clTileOffsets(NULL)
+    , m_clTileGroupSums(NULL)
+    , m_uiThreshold(0)
+    , m_bMagnitude(false)
+    , m_bScrollDetect(false)
+    , m_uiHeaderSize(0)
+    , m_uiNumLines(0)
+    , m_clLineHashes(NULL)
+    , m_clScrollScores(NULL)
+    , m_clScroll(NULL)
+    , m_uiPeriodicHistory(0)
+    , m_uiPeriodicOffset(0)
+    , m_clPeriodicHistory(NULL)
+    , m_clPeriodicState(NULL)
+    , m_clPeriodicMap(NULL)
+    , m_DiffMapImagekernel(NULL)
+    , m_DiffMapBufferkernel(NULL)
+    , m_DiffMapSADImagekernel(NULL)
+    , m_DiffMapSADBufferkernel(NULL)
+    , m_DiffMapReducekernel(NULL)
+    , m_DiffMapPackkernel(NULL)
+    , m_DiffMapRunskernel(NULL)
+    , m_DiffMapRectskernel(NULL)
+    , m_DiffMapTileScankernel(NULL)
+    , m_DiffMapTileGroupskernel(NULL)
+    , m_DiffMapTileGatherkernel(NULL)
+    , m_DiffMapBoundskernel(NULL)
+    , m_DiffMapLineHashBufferkernel(NULL)
+    , m_DiffMapLineHashImagekernel(NULL)
+    , m_DiffMapScrollSearchkernel(NULL)
+    , m_DiffMapScrollSelectkernel(NULL)
+    , m_DiffMapResidualBufferkernel(NULL)
+    , m_DiffMapResidualImagekernel(NULL)
+    , m_DiffMapAccumulatekernel(NULL)
+    , m_DiffMapPeriodickernel(NULL)
+    , m_DiffMapNV12kernel(NULL)
+    , m_pContext(nullptr)
+    , m_pMappedBuffer(nullptr)
+    , m_bKernelTuned(false)
+{
+    m_uiTotalBlockSize[0] = 16;
+    m_uiTotalBlockSize[1] = 16;
+
+    m_globalDim[0] = 0;
+    m_globalDim[1] = 0;
+
+    m_localDim[0] = m_uiTotalBlockSize[0];
+    m_localDim[1] = m_uiTotalBlockSize[1];
+
+    for (DMConsumer& Consumer : m_Consumers)
+    {
+        Consumer.bActive            = false;
+        Consumer.clAccumulatedMap   = NULL;
+        Consumer.clPageLockedBuffer = NULL;
+        Consumer.pSysmemBuffer      = nullptr;
+    }
+
+    m_strEncoderName = "RF_ENCODER_DIFFERENCE";
+}
+
+
+RFEncoderDM::~RFEncoderDM()
+{
+    if (m_DiffMapImagekernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapImagekernel);
+    }
+
+    if (m_DiffMapBufferkernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapBufferkernel);
+    }
+
+    if (m_DiffMapSADImagekernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapSADImagekernel);
+    }
+
+    if (m_DiffMapSADBufferkernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapSADBufferkernel);
+    }
+
+    if (m_DiffMapReducekernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapReducekernel);
+    }
+
+    if (m_DiffMapPackkernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapPackkernel);
+    }
+
+    if (m_DiffMapRunskernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapRunskernel);
+    }
+
+    if (m_DiffMapRectskernel != NULL)
+    {
+        clReleaseKernel(m_DiffMapRectskernel);
+    }
+
+    cl_kernel Kernels[] = { m_DiffMapTileScankernel, m_DiffMapTileGroupskernel, m_DiffMapTileGatherkernel, m_DiffMapBoundskernel,
+                            m_DiffMapLineHashBufferkernel, m_DiffMapLineHashImagekernel, m_DiffMapScrollSearchkernel, m_DiffMapScrollSelectkernel,
+                            m_DiffMapResidualBufferkernel, m_DiffMapResidualImagekernel, m_DiffMapAccumulatekernel, m_DiffMapPeriodickernel,
+                            m_DiffMapNV12kernel };
+
+    for (cl_kernel kernel : Kernels)
+    {
+        if (kernel != NULL)
+        {
+            clReleaseKernel(kernel);
+        }
+    }
+
+	m_DiffMapProgram.Release();
+
+    deleteBuffers();
+
+    for (DMConsumer& Consumer : m_Consumers)
+    {
+        deleteConsumerBuffers(Consumer);
+    }
+}
+
+
+bool RFEncoderDM::isFormatSupported(RFFormat format) const
+{
+    return (format == RF_RGBA8 || format == RF_ARGB8 || format == RF_BGRA8 || format == RF_NV12);
+}
+
+
+RFStatus RFEncoderDM::init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig)
+{
+    if (!pConfig)
+    {
+        return RF_STATUS_INVALID_CONFIG;
+    }
+
+    if (!pContextCL)
+    {
+        return RF_STATUS_INVALID_OPENCL_CONTEXT;
+    }
+
+    m_pContext = pContextCL;
+
+    m_format = pConfig->getInputFormat();
+
+    if (!isFormatSupported(m_format))
+    {
+        return RF_STATUS_INVALID_FORMAT;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_BLOCK_S, m_uiTotalBlockSize[0]))
+    {
+        m_uiTotalBlockSize[0] = 16;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_BLOCK_T, m_uiTotalBlockSize[1]))
+    {
+        m_uiTotalBlockSize[1] = 16;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_LOCK_BUFFER, m_bLockMappedBuffer))
+    {
+        m_bLockMappedBuffer = false;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_FUSED_CSC, m_bFusedCSC))
+    {
+        m_bFusedCSC = false;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_PYRAMID, m_bPyramid))
+    {
+        m_bPyramid = false;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_OUTPUT_MODE, m_uiOutputMode))
+    {
+        m_uiOutputMode = RF_DIFF_MAP_BYTES;
+    }
+
+    if (m_uiOutputMode > RF_DIFF_MAP_TILES)
+    {
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_SCROLL_DETECT, m_bScrollDetect))
+    {
+        m_bScrollDetect = false;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_THRESHOLD, m_uiThreshold))
+    {
+        m_uiThreshold = 0;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_MAGNITUDE, m_bMagnitude))
+    {
+        m_bMagnitude = false;
+    }
+
+    if (m_uiThreshold > 0 || m_bMagnitude)
+    {
+        // The diff map computed by the CSC kernel only flags any difference.
+        m_bFusedCSC = false;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_PERIODIC_HISTORY, m_uiPeriodicHistory))
+    {
+        m_uiPeriodicHistory = 0;
+    }
+
+    // A periodic block alternates between at least two states.
+    if (m_uiPeriodicHistory == 1 || m_uiPeriodicHistory > DIFF_MAP_MAX_PERIODIC_HISTORY)
+    {
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_NV12_CHROMA, m_bChroma))
+    {
+        m_bChroma = false;
+    }
+
+    if (m_format == RF_NV12)
+    {
+        // NV12 result buffers are compared byte by byte. Thresholds and the stages that read 32 bpp pixels are not
+        // supported. The diff map of the CSC kernel is only computed for RGBA.
+        if (m_uiThreshold > 0 || m_bMagnitude || m_bScrollDetect || m_uiPeriodicHistory > 0 || m_uiOutputMode == RF_DIFF_MAP_TILES)
+        {
+            return RF_STATUS_INVALID_ENCODER_PARAMETER;
+        }
+
+        m_bFusedCSC = false;
+    }
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_GPU_OUTPUT, m_bGPUOutput))
+    {
+        m_bGPUOutput = false;
+    }
+
+    // The RFDiffCopyRect and the periodic map are stored in scratch buffers that are overwritten by the next frame.
+    if (m_bGPUOutput && (m_bScrollDetect || m_uiPeriodicHistory > 0))
+    {
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_QUEUE_TIMEOUT, m_uiQueueTimeout))
+    {
+        m_uiQueueTimeout = DEFAULT_DIFF_MAP_QUEUE_TIMEOUT;
+    }
+
+    // 0 selects the maximum that the pipeline depth of the session allows.
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_NUM_BUFFERS, m_uiNumTargetBuffers) || m_uiNumTargetBuffers == 0)
+    {
+        m_uiNumTargetBuffers = m_pContext->getNumResultBuffers() - 1;
+    }
+
+    // One result buffer of the context has to hold the previous frame.
+    if (m_uiNumTargetBuffers == 0 || m_uiNumTargetBuffers >= m_pContext->getNumResultBuffers())
+    {
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    bool bHostDiffMap = true;
+
+    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_HOST_DIFF, bHostDiffMap))
+    {
+        bHostDiffMap = true;
+    }
+
+    // Frames of RF_CTX_CL contexts are converted on the CPU and are available in system memory. The GPU output
+    // requires the diff map to be computed by the kernels.
+    m_bHostDiffMap = (bHostDiffMap && !m_bGPUOutput && m_format != RF_NV12 && m_pContext->getCtxType() == RFContextCL::RF_CTX_CL);
+
+    // For now only a block size of 64 is supported.
+    if ((m_uiTotalBlockSize[0] % 8) || (m_uiTotalBlockSize[1] % 8) || (m_uiTotalBlockSize[0] * m_uiTotalBlockSize[1] == 0))
+    {
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    m_uiWidth = pConfig->getEncoderWidth();
+    m_uiHeight = pConfig->getEncoderHeight();
+
+    m_uiAlignedWidth = m_uiWidth;
+    m_uiAlignedHeight = m_uiHeight;
+
+    if (m_bHostDiffMap)
+    {
+        m_pHostDiffMap = std::unique_ptr<RFDiffMapHost>(new (nothrow) RFDiffMapHost);
+        if (!m_pHostDiffMap)
+        {
+            return RF_STATUS_MEMORY_FAIL;
+        }
+    }
+
+    if (!createBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    // m_uiPreviousBuffer will strore the index of the previously encoded buffer. For the first frame we set it to the maximum.
+    // RFSession will use as first buffer the ResultBuffer with index 0. It is expected that the first encoded frame shows a
+    // difference on all blocks.
+    m_uiPreviousBuffer = m_pContext->getNumResultBuffers() - 1;
+
+    if (m_bHostDiffMap)
+    {
+        // The OpenCL kernels are not needed. This allows to run the encoder on devices that cannot build them.
+        return RF_STATUS_OK;
+    }
+
+    if (m_bFusedCSC)
+    {
+        // The context will create the diff map buffers when createBuffers is called.
+        const_cast<RFContextCL*>(m_pContext)->enableDiffMap(m_uiTotalBlockSize[0], m_uiTotalBlockSize[1]);
+    }
+
+    return GenerateCLProgramAndKernel();
+}
+
+
+RFStatus RFEncoderDM::resize(unsigned int uiWidth, unsigned int uiHeight)
+{
+    if (!deleteBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    m_uiWidth = uiWidth;
+    m_uiHeight = uiHeight;
+
+    m_uiAlignedWidth = m_uiWidth;
+    m_uiAlignedHeight = m_uiHeight;
+
+    if (!createBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    // The accumulated maps of the consumers are recreated with the new dimension and all blocks marked as changed.
+    RFReadWriteAccess ConsumerAccess(&m_ConsumerLock);
+
+    for (DMConsumer& Consumer : m_Consumers)
+    {
+        if (Consumer.bActive)
+        {
+            deleteConsumerBuffers(Consumer);
+
+            if (!createConsumerBuffers(Consumer))
+            {
+                return RF_STATUS_OPENCL_FAIL;
+            }
+        }
+    }
+
+    return RF_STATUS_OK;
+}
+
+
+bool RFEncoderDM::createBuffers()
+{
+    cl_int nStatus;
+
+    // Each target buffer can be pending once.
+    if (!m_ResultQueue.init(m_uiNumTargetBuffers))
+    {
+        return false;
+    }
+
+    // One work group compares one block. The local size can be changed by tuneDiffMapKernel once the
+    // kernel is used.
+    m_localDim[0] = std::min<size_t>(16, m_uiTotalBlockSize[0]);
+    m_localDim[1] = std::min<size_t>(16, m_uiTotalBlockSize[1]);
+
+    m_bKernelTuned = false;
+
+    unsigned int uiAlignedWidth = static_cast<unsigned int>(ceil(static_cast<float>(m_uiWidth) / static_cast<float>(m_uiTotalBlockSize[0]))) * m_uiTotalBlockSize[0];
+    unsigned int uiAlignedHeight = static_cast<unsigned int>(ceil(static_cast<float>(m_uiHeight) / static_cast<float>(m_uiTotalBlockSize[1]))) * m_uiTotalBlockSize[1];
+
+    // Define the dimension of the diff map output buffer.
+    m_uiOutputWidth = uiAlignedWidth / m_uiTotalBlockSize[0];
+    m_uiOutputHeight = uiAlignedHeight / m_uiTotalBlockSize[1];
+
+    // Create buffers to store diff map. The levels of the pyramid are stored one after another.
+    // The rectangle list and the tiles are built from the first level only.
+    m_uiNumLevels = (m_bPyramid && (m_uiOutputMode == RF_DIFF_MAP_BYTES || m_uiOutputMode == RF_DIFF_MAP_BITS)) ? DIFF_MAP_PYRAMID_LEVELS : 1;
+
+    m_uiLevelDim[0][0] = m_uiOutputWidth;
+    m_uiLevelDim[0][1] = m_uiOutputHeight;
+    m_uiLevelOffset[0] = 0;
+
+    for (unsigned int l = 1; l < m_uiNumLevels; ++l)
+    {
+        m_uiLevelDim[l][0] = (m_uiLevelDim[l - 1][0] + DIFF_MAP_PYRAMID_FACTOR - 1) / DIFF_MAP_PYRAMID_FACTOR;
+        m_uiLevelDim[l][1] = (m_uiLevelDim[l - 1][1] + DIFF_MAP_PYRAMID_FACTOR - 1) / DIFF_MAP_PYRAMID_FACTOR;
+        m_uiLevelOffset[l] = m_uiLevelOffset[l - 1] + m_uiLevelDim[l - 1][0] * m_uiLevelDim[l - 1][1];
+    }
+
+    m_uiDiffMapSize = m_uiLevelOffset[m_uiNumLevels - 1] + m_uiLevelDim[m_uiNumLevels - 1][0] * m_uiLevelDim[m_uiNumLevels - 1][1];
+
+    // A row of n blocks contains at most ceil(n / 2) runs of changed blocks.
+    m_uiMaxRuns = (m_uiOutputWidth + 1) / 2;
+
+    if (m_uiOutputMode == RF_DIFF_MAP_BITS)
+    {
+        // Each row of a level starts at a new byte.
+        m_uiOutputSize = 0;
+
+        for (unsigned int l = 0; l < m_uiNumLevels; ++l)
+        {
+            m_uiPackedOffset[l] = m_uiOutputSize;
+            m_uiOutputSize += ((m_uiLevelDim[l][0] + 7) / 8) * m_uiLevelDim[l][1];
+        }
+
+        m_uiReadbackSize = m_uiOutputSize;
+    }
+    else if (m_uiOutputMode == RF_DIFF_MAP_RECTS)
+    {
+        // The rectangle count followed by one rectangle per run in the worst case.
+        m_uiOutputSize   = sizeof(unsigned int) + m_uiOutputHeight * m_uiMaxRuns * sizeof(RFDiffRect);
+        m_uiReadbackSize = std::min<unsigned int>(m_uiOutputSize, sizeof(unsigned int) + DIFF_MAP_RECTS_READBACK * sizeof(RFDiffRect));
+    }
+    else if (m_uiOutputMode == RF_DIFF_MAP_TILES)
+    {
+        // The tile count followed by the index and the pixels of each block in the worst case.
+        m_uiTileSize     = m_uiTotalBlockSize[0] * m_uiTotalBlockSize[1] * 4;
+        m_uiOutputSize   = sizeof(unsigned int) + m_uiOutputWidth * m_uiOutputHeight * (sizeof(unsigned int) + m_uiTileSize);
+        m_uiReadbackSize = std::min<unsigned int>(m_uiOutputSize, sizeof(unsigned int) + DIFF_MAP_TILES_READBACK * (sizeof(unsigned int) + m_uiTileSize));
+    }
+    else
+    {
+        m_uiOutputSize   = m_uiDiffMapSize;
+        m_uiReadbackSize = m_uiDiffMapSize;
+    }
+
+    // The output is preceded by the RFDiffCopyRect and the periodic map. The periodic map is padded to keep the
+    // output aligned.
+    m_uiPeriodicOffset = (m_bScrollDetect) ? sizeof(RFDiffCopyRect) : 0;
+    m_uiHeaderSize     = m_uiPeriodicOffset + ((m_uiPeriodicHistory > 0) ? ((m_uiOutputWidth * m_uiOutputHeight + 3) & ~3U) : 0);
+
+    m_globalDim[0] = m_uiOutputWidth * m_localDim[0];
+    m_globalDim[1] = m_uiOutputHeight * m_localDim[1];
+
+    if (m_pHostDiffMap)
+    {
+        m_pHostDiffMap->setDimension(m_uiWidth, m_uiHeight, m_uiTotalBlockSize[0], m_uiTotalBlockSize[1]);
+        m_pHostDiffMap->setThreshold(m_uiThreshold, m_bMagnitude);
+        m_pHostDiffMap->setPeriodicHistory(m_uiPeriodicHistory);
+
+        if (m_uiOutputMode != RF_DIFF_MAP_BYTES)
+        {
+            m_HostDiffMap.resize(m_uiDiffMapSize);
+        }
+
+        // The diff map is written by the CPU, no OpenCL buffers are required.
+        for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+        {
+            DMDiffMapBuffer  TargetBuffer;
+
+            TargetBuffer.clGPUBuffer        = NULL;
+            TargetBuffer.clPageLockedBuffer = NULL;
+            TargetBuffer.clOutputBuffer     = NULL;
+            TargetBuffer.clDiffFinished     = NULL;
+            TargetBuffer.clDMAFinished      = NULL;
+            TargetBuffer.uiSourceBuffer     = 0;
+            TargetBuffer.pSysmemBuffer      = new (nothrow) char[m_uiHeaderSize + m_uiOutputSize];
+
+            if (!TargetBuffer.pSysmemBuffer)
+            {
+                return false;
+            }
+
+            memset(TargetBuffer.pSysmemBuffer, 0, m_uiHeaderSize + m_uiOutputSize);
+
+            m_TargetBuffers.push_back(TargetBuffer);
+        }
+
+        return true;
+    }
+
+    nStatus = CL_SUCCESS;
+
+    if (m_uiOutputMode == RF_DIFF_MAP_RECTS)
+    {
+        // Scratch buffers of DiffMap_Runs and DiffMap_Rects. They can be shared by all target buffers since the kernels
+        // are executed in order.
+        const size_t uiNumRuns = m_uiOutputHeight * m_uiMaxRuns;
+
+        m_clRuns = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiNumRuns * 2 * sizeof(cl_uint), nullptr, &nStatus);
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clRunCount = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiOutputHeight * sizeof(cl_uint), nullptr, &nStatus);
+        }
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clRunRect = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiNumRuns * sizeof(cl_uint), nullptr, &nStatus);
+        }
+
+        if (nStatus != CL_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    if (m_uiOutputMode == RF_DIFF_MAP_TILES)
+    {
+        m_uiNumScanGroups = (m_uiOutputWidth * m_uiOutputHeight + DIFF_MAP_SCAN_GROUP_SIZE - 1) / DIFF_MAP_SCAN_GROUP_SIZE;
+
+        m_clTileOffsets = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiNumScanGroups * DIFF_MAP_SCAN_GROUP_SIZE * sizeof(cl_uint), nullptr, &nStatus);
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clTileGroupSums = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiNumScanGroups * sizeof(cl_uint), nullptr, &nStatus);
+        }
+
+        if (nStatus != CL_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    if (m_bScrollDetect)
+    {
+        // The hashes of the rows of each block column and of the columns of each block row of both images, one score per
+        // vertical and horizontal shift and the bounding box followed by the RFDiffCopyRect.
+        m_uiNumLines = m_uiOutputWidth * m_uiHeight + m_uiOutputHeight * m_uiWidth;
+
+        m_clLineHashes = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, 2 * m_uiNumLines * sizeof(cl_uint), nullptr, &nStatus);
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clScrollScores = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, 2 * (2 * DIFF_MAP_SCROLL_RANGE + 1) * sizeof(cl_uint), nullptr, &nStatus);
+        }
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clScroll = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, 4 * sizeof(cl_int) + sizeof(RFDiffCopyRect), nullptr, &nStatus);
+        }
+
+        if (nStatus != CL_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    if (m_uiPeriodicHistory > 0)
+    {
+        // The signatures of each block, the state of each block and the periodic map of the current frame.
+        const size_t uiNumBlocks = m_uiOutputWidth * m_uiOutputHeight;
+
+        m_clPeriodicHistory = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiNumBlocks * m_uiPeriodicHistory * sizeof(cl_ulong), nullptr, &nStatus);
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clPeriodicState = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiNumBlocks * sizeof(cl_uint), nullptr, &nStatus);
+        }
+
+        if (nStatus == CL_SUCCESS)
+        {
+            m_clPeriodicMap = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiNumBlocks, nullptr, &nStatus);
+        }
+
+        if (nStatus == CL_SUCCESS)
+        {
+            cl_uint uiPattern = 0;
+            nStatus = clEnqueueFillBuffer(m_pContext->getCmdQueue(), m_clPeriodicState, &uiPattern, sizeof(uiPattern), 0, uiNumBlocks * sizeof(cl_uint), 0, nullptr, nullptr);
+        }
+
+        if (nStatus != CL_SUCCESS)
+        {
+            return false;
+        }
+    }
+
+    for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+    {
+        DMDiffMapBuffer  TargetBuffer;
+
+        TargetBuffer.clOutputBuffer     = NULL;
+        TargetBuffer.clPageLockedBuffer = NULL;
+        TargetBuffer.pSysmemBuffer      = nullptr;
+        TargetBuffer.uiSourceBuffer     = 0;
+
+        if (!m_bGPUOutput)
+        {
+            // Create pinned OpenCL buffers that can be accessed by the application to retreive the diff map.
+            TargetBuffer.clPageLockedBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, m_uiHeaderSize + m_uiOutputSize, nullptr, &nStatus);
+            if (nStatus != CL_SUCCESS)
+            {
+                break;
+            }
+
+            // Get address of pinned OpenCL buffers.
+            TargetBuffer.pSysmemBuffer = static_cast<char*>(clEnqueueMapBuffer(m_pContext->getCmdQueue(), TargetBuffer.clPageLockedBuffer, CL_TRUE, CL_MAP_READ, 0, m_uiHeaderSize + m_uiOutputSize,
+                                                            0, nullptr, nullptr, &nStatus));
+            if (nStatus != CL_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        // Create buffer in GPU mem that will store the diff map computed by the kernel.
+        TargetBuffer.clGPUBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiDiffMapSize, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        char cPattern = 0;
+        nStatus = clEnqueueFillBuffer(m_pContext->getCmdQueue(), TargetBuffer.clGPUBuffer, &cPattern, sizeof(cPattern), 0, m_uiDiffMapSize, 0, nullptr, nullptr);
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        if (m_uiOutputMode != RF_DIFF_MAP_BYTES)
+        {
+            // Create buffer in GPU mem that will store the packed map or the rectangle list.
+            TargetBuffer.clOutputBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiOutputSize, nullptr, &nStatus);
+            if (nStatus != CL_SUCCESS)
+            {
+                break;
+            }
+        }
+
+        m_TargetBuffers.push_back(TargetBuffer);
+    }
+
+    if (nStatus != CL_SUCCESS)
+    {
+        return false;
+    }
+
+    clFinish(m_pContext->getCmdQueue());
+
+    return true;
+}
+
+
+bool RFEncoderDM::deleteBuffers()
+{
+    // Release events that are still in use.
+    while (m_ResultQueue.size() > 0)
+    {
+        const DMDiffMapBuffer* pElem = m_ResultQueue.pop();
+
+        if (pElem->clDiffFinished)
+        {
+            clReleaseEvent(pElem->clDiffFinished);
+        }
+
+        if (pElem->clDMAFinished)
+        {
+            clReleaseEvent(pElem->clDMAFinished);
+        }
+    }
+
+    if (m_bGPUOutput)
+    {
+        // Release the events of a frame the application did not return with releaseEncodedFrameCL.
+        releaseEncodedFrameCL();
+    }
+
+    if (!m_pContext)
+    {
+        return false;
+    }
+
+    if (m_pContext->getCmdQueue())
+    {
+        clFinish(m_pContext->getCmdQueue());
+    }
+
+    if (m_pContext->getDMAQueue())
+    {
+        clFinish(m_pContext->getDMAQueue());
+    }
+
+    cl_int nStatus = CL_SUCCESS;
+
+    for (auto& tb : m_TargetBuffers)
+    {
+        if (!tb.clPageLockedBuffer)
+        {
+            // Buffer of the host diff map.
+            delete[] tb.pSysmemBuffer;
+            tb.pSysmemBuffer = nullptr;
+        }
+
+        if (tb.pSysmemBuffer)
+        {
+            nStatus |= clEnqueueUnmapMemObject(m_pContext->getCmdQueue(), tb.clPageLockedBuffer, tb.pSysmemBuffer, 0, nullptr, nullptr);
+            clFinish(m_pContext->getCmdQueue());
+
+            tb.pSysmemBuffer = nullptr;
+        }
+
+        if (tb.clPageLockedBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clPageLockedBuffer);
+            tb.clPageLockedBuffer = NULL;
+        }
+
+        if (tb.clGPUBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clGPUBuffer);
+            tb.clGPUBuffer = NULL;
+        }
+
+        if (tb.clOutputBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clOutputBuffer);
+            tb.clOutputBuffer = NULL;
+        }
+    }
+
+    m_TargetBuffers.clear();
+
+    cl_mem* pScratchBuffers[] = { &m_clRuns, &m_clRunCount, &m_clRunRect, &m_clTileOffsets, &m_clTileGroupSums, &m_clLineHashes, &m_clScrollScores, &m_clScroll,
+                                  &m_clPeriodicHistory, &m_clPeriodicState, &m_clPeriodicMap };
+
+    for (cl_mem* pBuffer : pScratchBuffers)
+    {
+        if (*pBuffer)
+        {
+            nStatus |= clReleaseMemObject(*pBuffer);
+            *pBuffer = NULL;
+        }
+    }
+
+    clFinish(m_pContext->getCmdQueue());
+
+    return (nStatus == CL_SUCCESS);
+}
+
+
+RFStatus RFEncoderDM::encode(unsigned int uiBufferIdx, bool bUseInputImages)
+{
+    cl_mem          clCurrentImage;
+    cl_mem          clPrevImage;
+
+    DMDiffMapBuffer* pCurrentBuffer = &m_TargetBuffers[m_uiCurrentTargetBuffer];
+
+    // m_bLockMappedBuffer should only be set if a separate reader thread is used. In this case a call to RFEncoderDM::encode
+    // is possible while the reader thread is still working on the buffer returned by RFEncoderDM::getEncodedFrame.
+    // In the single threading case RFEncoderDM::encode is only called after the procession on the buffer returned by RFEncoderDM::getEncodedFrame
+    // has finished.
+    // This differentiation needs to be done to allow the single threading case to submit 2 frames before calling RFEncoderDM::getEncodedFrame.
+    // This enables RFEncoderDM::getEncodedFrame to return without waiting for the current encode task since it can return the
+    // result of the previously submitted task.
+    {
+        RFReadWriteAccess BufferAccess(&m_BufferLock);
+
+        // GetTickCount64 has a resolution of about 15 ms which is longer than the default timeout.
+        Timer WaitTimer;
+
+        while (((m_bLockMappedBuffer || m_bGPUOutput) && (pCurrentBuffer == m_pMappedBuffer)) || m_ResultQueue.size() >= m_uiNumTargetBuffers)
+        {
+            const float fRemainingMs = m_uiQueueTimeout - WaitTimer.getTime() * 1000.0f;
+
+            if (fRemainingMs <= 0.0f)
+            {
+                return RF_STATUS_QUEUE_FULL;
+            }
+
+            // Wait until getEncodedFrame releases a buffer. Round up, a timeout of 0 would not wait at all.
+            m_BufferReleased.wait(&m_BufferLock, static_cast<unsigned int>(ceilf(fRemainingMs)));
+        }
+    }
+
+    pCurrentBuffer->uiSourceBuffer = uiBufferIdx;
+
+    if (m_pHostDiffMap)
+    {
+        void* pCurrentImage  = nullptr;
+        void* pPreviousImage = nullptr;
+
+        m_pContext->getResultBuffer(uiBufferIdx, pCurrentImage);
+        m_pContext->getResultBuffer(m_uiPreviousBuffer, pPreviousImage);
+
+        unsigned char* pOutput  = reinterpret_cast<unsigned char*>(pCurrentBuffer->pSysmemBuffer) + m_uiHeaderSize;
+        unsigned char* pDiffMap = (m_uiOutputMode == RF_DIFF_MAP_BYTES) ? pOutput : m_HostDiffMap.data();
+
+        if (!m_pHostDiffMap->computeDiffMap(static_cast<const unsigned char*>(pCurrentImage), static_cast<const unsigned char*>(pPreviousImage), pDiffMap))
+        {
+            return RF_STATUS_FAIL;
+        }
+
+        SAFE_CALL_RF(accumulateDiffMap(nullptr, pDiffMap));
+
+        if (m_uiPeriodicHistory > 0)
+        {
+            unsigned char* pPeriodicMap = reinterpret_cast<unsigned char*>(pCurrentBuffer->pSysmemBuffer) + m_uiPeriodicOffset;
+
+            if (!m_pHostDiffMap->detectPeriodic(static_cast<const unsigned char*>(pCurrentImage), pDiffMap, pPeriodicMap))
+            {
+                return RF_STATUS_FAIL;
+            }
+        }
+
+        if (m_bScrollDetect)
+        {
+            RFDiffCopyRect* pCopyRect = reinterpret_cast<RFDiffCopyRect*>(pCurrentBuffer->pSysmemBuffer);
 
-    m_uiNumLocalPixels[0] = 1;
-    m_uiNumLocalPixels[1] = 1;
+            if (!m_pHostDiffMap->detectScroll(static_cast<const unsigned char*>(pCurrentImage), static_cast<const unsigned char*>(pPreviousImage), pDiffMap,
+                                              DIFF_MAP_SCROLL_RANGE, DIFF_MAP_SCROLL_MIN_LINES, *pCopyRect))
+            {
+                return RF_STATUS_FAIL;
+            }
+        }
 
-    m_globalDim[0] = 0;
-    m_globalDim[1] = 0;
+        for (unsigned int l = 1; l < m_uiNumLevels; ++l)
+        {
+            RFDiffMapHost::reduceDiffMap(pDiffMap + m_uiLevelOffset[l - 1], m_uiLevelDim[l - 1][0], m_uiLevelDim[l - 1][1], DIFF_MAP_PYRAMID_FACTOR, pDiffMap + m_uiLevelOffset[l]);
+        }
 
-    m_localDim[0] = m_uiTotalBlockSize[0];
-    m_localDim[1] = m_uiTotalBlockSize[1];
+        if (m_uiOutputMode == RF_DIFF_MAP_BITS)
+        {
+            for (unsigned int l = 0; l < m_uiNumLevels; ++l)
+            {
+                RFDiffMapHost::packDiffMap(pDiffMap + m_uiLevelOffset[l], m_uiLevelDim[l][0], m_uiLevelDim[l][1], pOutput + m_uiPackedOffset[l]);
+            }
+        }
+        else if (m_uiOutputMode == RF_DIFF_MAP_RECTS)
+        {
+            RFDiffMapHost::buildRects(pDiffMap, m_uiOutputWidth, m_uiOutputHeight, reinterpret_cast<unsigned int*>(pOutput));
+        }
+        else if (m_uiOutputMode == RF_DIFF_MAP_TILES)
+        {
+            RFDiffMapHost::packTiles(pDiffMap, m_uiOutputWidth, m_uiOutputHeight, static_cast<const unsigned char*>(pCurrentImage), m_uiWidth, m_uiHeight,
+                                     m_uiTotalBlockSize[0], m_uiTotalBlockSize[1], reinterpret_cast<unsigned int*>(pOutput));
+        }
 
-    m_strEncoderName = "RF_ENCODER_DIFFERENCE";
-}
+        // The diff map is complete, getEncodedFrame does not need to wait.
+        pCurrentBuffer->clDiffFinished = NULL;
+        pCurrentBuffer->clDMAFinished  = NULL;
 
+        m_ResultQueue.push(pCurrentBuffer);
 
-RFEncoderDM::~RFEncoderDM()
-{
-    if (m_DiffMapImagekernel != NULL)
-    {
-        clReleaseKernel(m_DiffMapImagekernel);
+        m_uiPreviousBuffer = uiBufferIdx;
+
+        m_uiCurrentTargetBuffer = (m_uiCurrentTargetBuffer + 1) % m_uiNumTargetBuffers;
+
+        return RF_STATUS_OK;
     }
 
-    if (m_DiffMapBufferkernel != NULL)
+    cl_mem clFusedDiffMap = NULL;
+
+    if (!bUseInputImages && m_bFusedCSC && m_pContext->getDiffMapBuffer(uiBufferIdx, &clFusedDiffMap))
     {
-        clReleaseKernel(m_DiffMapBufferkernel);
-    }
+        // The diff map was already computed by the context while processing the result buffer. Only the transfer
+        // to the pinned buffer is required. The copy waits for the CSC since both run on the same queue.
+        SAFE_CALL_RF(accumulateDiffMap(clFusedDiffMap, nullptr));
 
-	m_DiffMapProgram.Release();
+        if (m_uiNumLevels > 1 || m_uiOutputMode != RF_DIFF_MAP_BYTES || m_bScrollDetect || m_uiPeriodicHistory > 0 || m_bGPUOutput)
+        {
+            // The context only computes the first level as byte map. The pyramid and the output format are built in the
+            // GPU buffer of the encoder. The GPU output is returned in the buffer of the encoder since the map of the
+            // context is overwritten when its result buffer is reused.
+            SAFE_CALL_CL(clEnqueueCopyBuffer(m_pContext->getCmdQueue(), clFusedDiffMap, pCurrentBuffer->clGPUBuffer, 0, 0, m_uiOutputWidth * m_uiOutputHeight, 0, nullptr, nullptr));
 
-    deleteBuffers();
-}
+            cl_mem clCurrent;
 
+            m_pContext->getResultBuffer(uiBufferIdx, &clCurrent);
 
-bool RFEncoderDM::isFormatSupported(RFFormat format) const
-{
-    return (format == RF_RGBA8 || format == RF_ARGB8 || format == RF_BGRA8);
-}
+            if (m_uiPeriodicHistory > 0)
+            {
+                SAFE_CALL_RF(detectPeriodic(pCurrentBuffer->clGPUBuffer, clCurrent));
+            }
 
+            if (m_bScrollDetect)
+            {
+                cl_mem clPrevious;
 
-RFStatus RFEncoderDM::init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig)
-{
-    if (!pConfig)
-    {
-        return RF_STATUS_INVALID_CONFIG;
+                m_pContext->getResultBuffer(m_uiPreviousBuffer, &clPrevious);
+
+                SAFE_CALL_RF(detectScroll(pCurrentBuffer, clCurrent, clPrevious, false));
+            }
+
+            SAFE_CALL_RF(finalizeDiffMap(pCurrentBuffer, clCurrent));
+        }
+        else
+        {
+            SAFE_CALL_CL(clEnqueueCopyBuffer(m_pContext->getCmdQueue(), clFusedDiffMap, pCurrentBuffer->clPageLockedBuffer, 0, 0, m_uiDiffMapSize, 0, nullptr, &pCurrentBuffer->clDMAFinished));
+        }
+
+        // getEncodedFrame will release both events.
+        clRetainEvent(pCurrentBuffer->clDMAFinished);
+        pCurrentBuffer->clDiffFinished = pCurrentBuffer->clDMAFinished;
+
+        m_ResultQueue.push(pCurrentBuffer);
+
+        clFlush(m_pContext->getCmdQueue());
+
+        m_uiPreviousBuffer = uiBufferIdx;
+
+        m_uiCurrentTargetBuffer = (m_uiCurrentTargetBuffer + 1) % m_uiNumTargetBuffers;
+
+        return RF_STATUS_OK;
     }
 
-    if (!pContextCL)
+    // The SAD kernels process all pixels of a block while the other kernels stop at the first difference.
+    const bool      bSAD = (m_uiThreshold > 0 || m_bMagnitude);
+
+    cl_kernel       diffMapKernel;
+    const char*     strKernelName;
+
+    if (bUseInputImages)
     {
-        return RF_STATUS_INVALID_OPENCL_CONTEXT;
+        m_pContext->getInputImage(uiBufferIdx, &clCurrentImage);
+        m_pContext->getInputImage(m_uiPreviousBuffer, &clPrevImage);
+        diffMapKernel = (bSAD) ? m_DiffMapSADImagekernel : m_DiffMapImagekernel;
+        strKernelName = (bSAD) ? "DiffMap_SADImage" : "DiffMap_Image";
     }
+    else
+    {
+        m_pContext->getResultBuffer(uiBufferIdx, &clCurrentImage);
+        m_pContext->getResultBuffer(m_uiPreviousBuffer, &clPrevImage);
+        diffMapKernel = (bSAD) ? m_DiffMapSADBufferkernel : m_DiffMapBufferkernel;
+        strKernelName = (bSAD) ? "DiffMap_SADBuffer" : "DiffMap_Buffer";
 
-    m_pContext = pContextCL;
+        if (m_format == RF_NV12)
+        {
+            const unsigned int uiChroma = (m_bChroma) ? 1 : 0;
 
-    m_format = pConfig->getInputFormat();
+            diffMapKernel = m_DiffMapNV12kernel;
+            strKernelName = "DiffMap_NV12Buffer";
 
-    if (!isFormatSupported(m_format))
-    {
-        return RF_STATUS_INVALID_FORMAT;
+            SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 7, sizeof(unsigned int), &uiChroma));
+        }
     }
 
-    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_BLOCK_S, m_uiTotalBlockSize[0]))
+    if (bSAD)
     {
-        m_uiTotalBlockSize[0] = 16;
+        const unsigned int uiMagnitude = (m_bMagnitude) ? 1 : 0;
+
+        SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 7, sizeof(unsigned int), &m_uiThreshold));
+        SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 8, sizeof(unsigned int), &uiMagnitude));
     }
 
-    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_BLOCK_T, m_uiTotalBlockSize[1]))
+    if (!m_bKernelTuned)
     {
-        m_uiTotalBlockSize[1] = 16;
+        tuneDiffMapKernel(diffMapKernel, strKernelName, bUseInputImages);
     }
 
-    if (!pConfig->getParameterValue<bool>(RF_DIFF_ENCODER_LOCK_BUFFER, m_bLockMappedBuffer))
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 0, sizeof(cl_mem),       &clCurrentImage));
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 1, sizeof(cl_mem),       &clPrevImage));
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 2, sizeof(cl_mem),       &(pCurrentBuffer->clGPUBuffer)));
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 3, sizeof(unsigned int), &m_uiWidth));
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 4, sizeof(unsigned int), &m_uiHeight));
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 5, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 6, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+
+    char cPattern = 0;
+    SAFE_CALL_CL(clEnqueueFillBuffer(m_pContext->getCmdQueue(), pCurrentBuffer->clGPUBuffer, &cPattern, sizeof(cPattern), 0, m_uiDiffMapSize, 0, nullptr, nullptr));
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), diffMapKernel, 2, nullptr, m_globalDim, m_localDim, 0, nullptr, &(pCurrentBuffer->clDiffFinished)));
+
+    // The consumers accumulate the map before the periodic blocks and the moved blocks are removed.
+    SAFE_CALL_RF(accumulateDiffMap(pCurrentBuffer->clGPUBuffer, nullptr));
+
+    // The tiles and the block signatures are read from the result buffer which is also used if the diff map is computed
+    // from the input images.
+    cl_mem clSource;
+
+    m_pContext->getResultBuffer(uiBufferIdx, &clSource);
+
+    if (m_uiPeriodicHistory > 0)
     {
-        m_bLockMappedBuffer = false;
+        SAFE_CALL_RF(detectPeriodic(pCurrentBuffer->clGPUBuffer, clSource));
     }
 
-    // For now only a block size of 64 is supported.
-    if ((m_uiTotalBlockSize[0] % 8) || (m_uiTotalBlockSize[1] % 8) || (m_uiTotalBlockSize[0] * m_uiTotalBlockSize[1] == 0))
+    if (m_bScrollDetect)
     {
-        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+        SAFE_CALL_RF(detectScroll(pCurrentBuffer, clCurrentImage, clPrevImage, bUseInputImages));
     }
 
-    m_uiWidth = pConfig->getEncoderWidth();
-    m_uiHeight = pConfig->getEncoderHeight();
+    SAFE_CALL_RF(finalizeDiffMap(pCurrentBuffer, clSource));
 
-    m_uiAlignedWidth = m_uiWidth;
-    m_uiAlignedHeight = m_uiHeight;
+    // Now we can be sure to get a Diff Map -> Store buffer in queue to be retrieved by getEncodedFrame.
+    m_ResultQueue.push(pCurrentBuffer);
 
-    if (!createBuffers())
+    clFlush(m_pContext->getCmdQueue());
+
+    if (bUseInputImages)
     {
-        return RF_STATUS_OPENCL_FAIL;
+        // The scroll detection reads the images until the diff map is final.
+        cl_event* pImagesReleased = (m_bScrollDetect) ? &(pCurrentBuffer->clDMAFinished) : &(pCurrentBuffer->clDiffFinished);
+
+        const_cast<RFContextCL*>(m_pContext)->releaseCLMemObj(m_pContext->getDMAQueue(), m_uiPreviousBuffer, 1, pImagesReleased);
     }
 
-    // m_uiPreviousBuffer will strore the index of the previously encoded buffer. For the first frame we set it to the maximum.
-    // RFSession will use as first buffer the ResultBuffer with index 0. It is expected that the first encoded frame shows a
-    // difference on all blocks.
-    m_uiPreviousBuffer = m_pContext->getNumResultBuffers() - 1;
+    m_uiPreviousBuffer = uiBufferIdx;
 
-    return GenerateCLProgramAndKernel();
+    m_uiCurrentTargetBuffer = (m_uiCurrentTargetBuffer + 1) % m_uiNumTargetBuffers;
+
+    return RF_STATUS_OK;
 }
 
 
-RFStatus RFEncoderDM::resize(unsigned int uiWidth, unsigned int uiHeight)
+RFStatus RFEncoderDM::getEncodedFrame(unsigned int& uiSize, void* &pBitStream)
 {
-    if (!deleteBuffers())
+    if (m_bGPUOutput)
     {
-        return RF_STATUS_OPENCL_FAIL;
+        // The frames have to be retrieved with getEncodedFrameCL.
+        return RF_STATUS_INVALID_ENCODER;
     }
 
-    m_uiWidth = uiWidth;
-    m_uiHeight = uiHeight;
+    if (m_ResultQueue.size() == 0)
+    {
+        return RF_STATUS_NO_ENCODED_FRAME;
+    }
 
-    m_uiAlignedWidth = m_uiWidth;
-    m_uiAlignedHeight = m_uiHeight;
+    const DMDiffMapBuffer* pEncodedBuffer = nullptr;
 
-    if (!createBuffers())
     {
-        return RF_STATUS_OPENCL_FAIL;
+        RFReadWriteAccess BufferAccess(&m_BufferLock);
+
+        pEncodedBuffer  = m_ResultQueue.pop();
+        m_pMappedBuffer = pEncodedBuffer;
+
+        // Wake up encode if it is waiting for a buffer.
+        m_BufferReleased.notifyAll();
     }
 
-    return RF_STATUS_OK;
-}
+    // Wait until transfer has completed. Diff maps computed on the host have no events.
+    if (pEncodedBuffer->clDMAFinished)
+    {
+        clWaitForEvents(1, &pEncodedBuffer->clDMAFinished);
+        clReleaseEvent(pEncodedBuffer->clDMAFinished);
+    }
 
+    // Just release event, no sync is required sine m_clDMAFinished can only finish if m_clDiffFinished is finished.
+    if (pEncodedBuffer->clDiffFinished)
+    {
+        clReleaseEvent(pEncodedBuffer->clDiffFinished);
+    }
 
-bool RFEncoderDM::createBuffers()
-{
-    cl_int nStatus;
+    if (pEncodedBuffer->pSysmemBuffer)
+    {
+        pBitStream = pEncodedBuffer->pSysmemBuffer;
+        uiSize = m_uiHeaderSize + m_uiOutputSize;
 
-    m_uiNumLocalPixels[0] = m_uiTotalBlockSize[0] / static_cast<unsigned int>(m_localDim[0]);
-    m_uiNumLocalPixels[1] = m_uiTotalBlockSize[1] / static_cast<unsigned int>(m_localDim[1]);
+        if (m_uiOutputMode == RF_DIFF_MAP_RECTS || m_uiOutputMode == RF_DIFF_MAP_TILES)
+        {
+            const unsigned int uiCount     = *reinterpret_cast<const unsigned int*>(pEncodedBuffer->pSysmemBuffer + m_uiHeaderSize);
+            const unsigned int uiEntrySize = (m_uiOutputMode == RF_DIFF_MAP_RECTS) ? sizeof(RFDiffRect) : sizeof(unsigned int) + m_uiTileSize;
+            const unsigned int uiListSize  = sizeof(unsigned int) + uiCount * uiEntrySize;
 
-    unsigned int uiAlignedWidth = static_cast<unsigned int>(ceil(static_cast<float>(m_uiWidth) / static_cast<float>(m_uiTotalBlockSize[0]))) * m_uiTotalBlockSize[0];
-    unsigned int uiAlignedHeight = static_cast<unsigned int>(ceil(static_cast<float>(m_uiHeight) / static_cast<float>(m_uiTotalBlockSize[1]))) * m_uiTotalBlockSize[1];
+            uiSize = m_uiHeaderSize + uiListSize;
 
-    // Define the dimension of the diff map output buffer.
-    m_uiOutputWidth = uiAlignedWidth / m_uiTotalBlockSize[0];
-    m_uiOutputHeight = uiAlignedHeight / m_uiTotalBlockSize[1];
+            if (uiListSize > m_uiReadbackSize && pEncodedBuffer->clOutputBuffer)
+            {
+                // Only the first DIFF_MAP_RECTS_READBACK rectangles or DIFF_MAP_TILES_READBACK tiles were transferred by encode.
+                // Use the DMA queue if available since the command queue might already contain work of the next frames.
+                cl_command_queue clQueue = (m_pContext->getDMAQueue()) ? m_pContext->getDMAQueue() : m_pContext->getCmdQueue();
+                cl_event         clCopyFinished;
+
+                SAFE_CALL_CL(clEnqueueCopyBuffer(clQueue, pEncodedBuffer->clOutputBuffer, pEncodedBuffer->clPageLockedBuffer, m_uiReadbackSize, m_uiHeaderSize + m_uiReadbackSize,
+                                                 uiListSize - m_uiReadbackSize, 0, nullptr, &clCopyFinished));
 
-    // Create buffers to store diff map.
-    m_uiDiffMapSize = (m_uiOutputWidth * m_uiOutputHeight);
+                clWaitForEvents(1, &clCopyFinished);
+                clReleaseEvent(clCopyFinished);
+            }
+        }
+
+        return RF_STATUS_OK;
+    }
 
-    m_globalDim[0] = uiAlignedWidth / m_uiNumLocalPixels[0];
-    m_globalDim[1] = uiAlignedHeight / m_uiNumLocalPixels[1];
+    return RF_STATUS_NO_ENCODED_FRAME;
+}
 
-    m_localDim[0] = m_localDim[0];
-    m_localDim[1] = m_localDim[1];
 
-    for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+RFStatus RFEncoderDM::getEncodedFrameCL(RFEncodedFrameCL& Frame)
+{
+    if (!m_bGPUOutput)
     {
-        DMDiffMapBuffer  TargetBuffer;
+        return RF_STATUS_INVALID_ENCODER;
+    }
 
-        // Create pinned OpenCL buffers that can be accessed by the application to retreive the diff map.
-        TargetBuffer.clPageLockedBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, m_uiDiffMapSize, nullptr, &nStatus);
-        if (nStatus != CL_SUCCESS)
-        {
-            break;
-        }
+    const DMDiffMapBuffer* pEncodedBuffer = nullptr;
 
-        // Get address of pinned OpenCL buffers.
-        TargetBuffer.pSysmemBuffer = static_cast<char*>(clEnqueueMapBuffer(m_pContext->getCmdQueue(), TargetBuffer.clPageLockedBuffer, CL_TRUE, CL_MAP_READ, 0, m_uiDiffMapSize,
-                                                        0, nullptr, nullptr, &nStatus));
-        if (nStatus != CL_SUCCESS)
-        {
-            break;
-        }
+    {
+        RFReadWriteAccess BufferAccess(&m_BufferLock);
 
-        // Create buffer in GPU mem that will store the diff map computed by the kernel.
-        TargetBuffer.clGPUBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiDiffMapSize, nullptr, &nStatus);
-        if (nStatus != CL_SUCCESS)
+        // The previous frame has to be released first since encode could otherwise overwrite it.
+        if (m_pMappedBuffer)
         {
-            break;
+            return RF_STATUS_FAIL;
         }
 
-        char cPattern = 0;
-        nStatus = clEnqueueFillBuffer(m_pContext->getCmdQueue(), TargetBuffer.clGPUBuffer, &cPattern, sizeof(cPattern), 0, m_uiDiffMapSize, 0, nullptr, nullptr);
-        if (nStatus != CL_SUCCESS)
+        if (m_ResultQueue.size() == 0)
         {
-            break;
+            return RF_STATUS_NO_ENCODED_FRAME;
         }
 
-        m_TargetBuffers.push_back(TargetBuffer);
+        pEncodedBuffer  = m_ResultQueue.pop();
+        m_pMappedBuffer = pEncodedBuffer;
     }
 
-    if (nStatus != CL_SUCCESS)
-    {
-        return false;
-    }
+    cl_mem clSource = NULL;
 
-    clFinish(m_pContext->getCmdQueue());
+    m_pContext->getResultBuffer(pEncodedBuffer->uiSourceBuffer, &clSource);
 
-    return true;
+    Frame.clOutput     = (m_uiOutputMode == RF_DIFF_MAP_BYTES) ? pEncodedBuffer->clGPUBuffer : pEncodedBuffer->clOutputBuffer;
+    Frame.clSource     = clSource;
+    Frame.clEvent      = pEncodedBuffer->clDMAFinished;
+    Frame.uiOutputSize = m_uiOutputSize;
+    Frame.uiSourceSize = m_pContext->getResultBufferSize();
+
+    return RF_STATUS_OK;
 }
 
 
-bool RFEncoderDM::deleteBuffers()
+RFStatus RFEncoderDM::releaseEncodedFrameCL()
 {
-    // Release events that are still in use.
-    while (m_ResultQueue.size() > 0)
+    if (!m_bGPUOutput)
     {
-        const DMDiffMapBuffer* pElem = m_ResultQueue.pop();
-
-        clReleaseEvent(pElem->clDiffFinished);
-        clReleaseEvent(pElem->clDMAFinished);
+        return RF_STATUS_INVALID_ENCODER;
     }
 
-    if (!m_pContext)
+    RFReadWriteAccess BufferAccess(&m_BufferLock);
+
+    if (!m_pMappedBuffer)
     {
-        return false;
+        return RF_STATUS_NO_ENCODED_FRAME;
     }
 
-    if (m_pContext->getCmdQueue())
+    // The events are owned by the encoder while the application holds the frame.
+    if (m_pMappedBuffer->clDMAFinished)
     {
-        clFinish(m_pContext->getCmdQueue());
+        clReleaseEvent(m_pMappedBuffer->clDMAFinished);
     }
 
-    if (m_pContext->getDMAQueue())
+    if (m_pMappedBuffer->clDiffFinished)
     {
-        clFinish(m_pContext->getDMAQueue());
+        clReleaseEvent(m_pMappedBuffer->clDiffFinished);
     }
 
-    cl_int nStatus = CL_SUCCESS;
+    m_pMappedBuffer = nullptr;
 
-    for (auto& tb : m_TargetBuffers)
+    // Wake up encode if it is waiting for the buffer.
+    m_BufferReleased.notifyAll();
+
+    return RF_STATUS_OK;
+}
+
+
+RFStatus RFEncoderDM::createConsumer(unsigned int& uiConsumer)
+{
+    RFReadWriteAccess ConsumerAccess(&m_ConsumerLock);
+
+    for (unsigned int i = 0; i < DIFF_MAP_MAX_CONSUMERS; ++i)
     {
-        if (tb.pSysmemBuffer)
+        if (!m_Consumers[i].bActive)
         {
-            nStatus |= clEnqueueUnmapMemObject(m_pContext->getCmdQueue(), tb.clPageLockedBuffer, tb.pSysmemBuffer, 0, nullptr, nullptr);
-            clFinish(m_pContext->getCmdQueue());
+            if (!createConsumerBuffers(m_Consumers[i]))
+            {
+                deleteConsumerBuffers(m_Consumers[i]);
 
-            tb.pSysmemBuffer = nullptr;
+                return RF_STATUS_OPENCL_FAIL;
+            }
+
+            m_Consumers[i].bActive = true;
+
+            uiConsumer = i;
+
+            return RF_STATUS_OK;
         }
+    }
 
-        if (tb.clPageLockedBuffer)
+    return RF_STATUS_FAIL;
+}
+
+
+RFStatus RFEncoderDM::deleteConsumer(unsigned int uiConsumer)
+{
+    RFReadWriteAccess ConsumerAccess(&m_ConsumerLock);
+
+    if (uiConsumer >= DIFF_MAP_MAX_CONSUMERS || !m_Consumers[uiConsumer].bActive)
+    {
+        return RF_STATUS_INVALID_INDEX;
+    }
+
+    deleteConsumerBuffers(m_Consumers[uiConsumer]);
+
+    m_Consumers[uiConsumer].bActive = false;
+
+    return RF_STATUS_OK;
+}
+
+
+RFStatus RFEncoderDM::getConsumerFrame(unsigned int uiConsumer, unsigned int& uiSize, void* &pBitStream)
+{
+    const unsigned int uiMapSize = m_uiOutputWidth * m_uiOutputHeight;
+
+    cl_event clCopyFinished = NULL;
+
+    {
+        RFReadWriteAccess ConsumerAccess(&m_ConsumerLock);
+
+        if (uiConsumer >= DIFF_MAP_MAX_CONSUMERS || !m_Consumers[uiConsumer].bActive)
         {
-            nStatus |= clReleaseMemObject(tb.clPageLockedBuffer);
-            tb.clPageLockedBuffer = NULL;
+            return RF_STATUS_INVALID_INDEX;
         }
 
-        if (tb.clGPUBuffer)
+        DMConsumer& Consumer = m_Consumers[uiConsumer];
+
+        if (m_pHostDiffMap)
         {
-            nStatus |= clReleaseMemObject(tb.clGPUBuffer);
-            tb.clGPUBuffer = NULL;
+            memcpy(Consumer.pSysmemBuffer, Consumer.HostMap.data(), uiMapSize);
+            std::fill(Consumer.HostMap.begin(), Consumer.HostMap.end(), 0);
         }
-    }
+        else
+        {
+            // The copy includes the maps of all frames that were submitted to the command queue so far.
+            char cPattern = 0;
 
-    m_TargetBuffers.clear();
+            SAFE_CALL_CL(clEnqueueCopyBuffer(m_pContext->getCmdQueue(), Consumer.clAccumulatedMap, Consumer.clPageLockedBuffer, 0, 0, uiMapSize, 0, nullptr, &clCopyFinished));
+            SAFE_CALL_CL(clEnqueueFillBuffer(m_pContext->getCmdQueue(), Consumer.clAccumulatedMap, &cPattern, sizeof(cPattern), 0, uiMapSize, 0, nullptr, nullptr));
 
-    clFinish(m_pContext->getCmdQueue());
+            clFlush(m_pContext->getCmdQueue());
+        }
 
-    return (nStatus == CL_SUCCESS);
+        pBitStream = Consumer.pSysmemBuffer;
+        uiSize     = uiMapSize;
+    }
+
+    if (clCopyFinished)
+    {
+        clWaitForEvents(1, &clCopyFinished);
+        clReleaseEvent(clCopyFinished);
+    }
+
+    return RF_STATUS_OK;
 }
 
 
-RFStatus RFEncoderDM::encode(unsigned int uiBufferIdx, bool bUseInputImages)
+bool RFEncoderDM::createConsumerBuffers(DMConsumer& Consumer)
 {
-    cl_mem          clCurrentImage;
-    cl_mem          clPrevImage;
-    unsigned int    uiFailCount = 0;
+    const unsigned int uiMapSize = m_uiOutputWidth * m_uiOutputHeight;
 
-    DMDiffMapBuffer* pCurrentBuffer = &m_TargetBuffers[m_uiCurrentTargetBuffer];
-
-    // m_bLockMappedBuffer should only be set if a separate reader thread is used. In this case a call to RFEncoderDM::encode
-    // is possible while the reader thread is still working on the buffer returned by RFEncoderDM::getEncodedFrame.
-    // In the single threading case RFEncoderDM::encode is only called after the procession on the buffer returned by RFEncoderDM::getEncodedFrame
-    // has finished.
-    // This differentiation needs to be done to allow the single threading case to submit 2 frames before calling RFEncoderDM::getEncodedFrame.
-    // This enables RFEncoderDM::getEncodedFrame to return without waiting for the current encode task since it can return the
-    // result of the previously submitted task.
-    while ((m_bLockMappedBuffer && (pCurrentBuffer == m_pMappedBuffer)) || m_ResultQueue.size() >= m_uiNumTargetBuffers)
+    if (m_pHostDiffMap)
     {
-        // Give other threads the chance to run.
-        Sleep(0);
-        ++uiFailCount;
+        // A new consumer has not received any frame, all blocks are marked as changed.
+        Consumer.HostMap.assign(uiMapSize, 1);
+        Consumer.pSysmemBuffer = new (nothrow) char[uiMapSize];
 
-        if (uiFailCount > 100)
-        {
-            return RF_STATUS_QUEUE_FULL;
-        }
+        return (Consumer.pSysmemBuffer != nullptr);
     }
 
-    cl_kernel diffMapKernel;
-    if (bUseInputImages)
+    cl_int nStatus;
+
+    Consumer.clAccumulatedMap = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiMapSize, nullptr, &nStatus);
+    if (nStatus != CL_SUCCESS)
     {
-        m_pContext->getInputImage(uiBufferIdx, &clCurrentImage);
-        m_pContext->getInputImage(m_uiPreviousBuffer, &clPrevImage);
-        diffMapKernel = m_DiffMapImagekernel;
+        return false;
     }
-    else
+
+    Consumer.clPageLockedBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, uiMapSize, nullptr, &nStatus);
+    if (nStatus != CL_SUCCESS)
     {
-        m_pContext->getResultBuffer(uiBufferIdx, &clCurrentImage);
-        m_pContext->getResultBuffer(m_uiPreviousBuffer, &clPrevImage);
-        diffMapKernel = m_DiffMapBufferkernel;
+        return false;
     }
 
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 0, sizeof(cl_mem),       &clCurrentImage));
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 1, sizeof(cl_mem),       &clPrevImage));
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 2, sizeof(cl_mem),       &(pCurrentBuffer->clGPUBuffer)));
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 3, sizeof(unsigned int), &m_uiWidth));
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 4, sizeof(unsigned int), &m_uiHeight));
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 5, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
-    SAFE_CALL_CL(clSetKernelArg(diffMapKernel, 6, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+    Consumer.pSysmemBuffer = static_cast<char*>(clEnqueueMapBuffer(m_pContext->getCmdQueue(), Consumer.clPageLockedBuffer, CL_TRUE, CL_MAP_READ, 0, uiMapSize,
+                                                                   0, nullptr, nullptr, &nStatus));
+    if (nStatus != CL_SUCCESS)
+    {
+        return false;
+    }
 
-    char cPattern = 0;
-    SAFE_CALL_CL(clEnqueueFillBuffer(m_pContext->getCmdQueue(), pCurrentBuffer->clGPUBuffer, &cPattern, sizeof(cPattern), 0, m_uiDiffMapSize, 0, nullptr, nullptr));
-    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), diffMapKernel, 2, nullptr, m_globalDim, m_localDim, 0, nullptr, &(pCurrentBuffer->clDiffFinished)));
-    SAFE_CALL_CL(clEnqueueCopyBuffer(m_pContext->getCmdQueue(), pCurrentBuffer->clGPUBuffer, pCurrentBuffer->clPageLockedBuffer, 0, 0, m_uiDiffMapSize, 0, nullptr, &pCurrentBuffer->clDMAFinished));
+    // A new consumer has not received any frame, all blocks are marked as changed.
+    char cPattern = 1;
 
-    // Now we can be sure to get a Diff Map -> Store buffer in queue to be retrieved by getEncodedFrame.
-    m_ResultQueue.push(pCurrentBuffer);
+    nStatus = clEnqueueFillBuffer(m_pContext->getCmdQueue(), Consumer.clAccumulatedMap, &cPattern, sizeof(cPattern), 0, uiMapSize, 0, nullptr, nullptr);
 
-    clFlush(m_pContext->getCmdQueue());
+    return (nStatus == CL_SUCCESS);
+}
 
-    if (bUseInputImages)
+
+void RFEncoderDM::deleteConsumerBuffers(DMConsumer& Consumer)
+{
+    if (!Consumer.clPageLockedBuffer)
     {
-        const_cast<RFContextCL*>(m_pContext)->releaseCLMemObj(m_pContext->getDMAQueue(), m_uiPreviousBuffer, 1, &(pCurrentBuffer->clDiffFinished));
+        // Buffer of the host diff map.
+        delete[] Consumer.pSysmemBuffer;
+        Consumer.pSysmemBuffer = nullptr;
     }
 
-    m_uiPreviousBuffer = uiBufferIdx;
+    if (Consumer.clAccumulatedMap || Consumer.clPageLockedBuffer)
+    {
+        clFinish(m_pContext->getCmdQueue());
+    }
 
-    m_uiCurrentTargetBuffer = (m_uiCurrentTargetBuffer + 1) % m_uiNumTargetBuffers;
+    if (Consumer.pSysmemBuffer)
+    {
+        clEnqueueUnmapMemObject(m_pContext->getCmdQueue(), Consumer.clPageLockedBuffer, Consumer.pSysmemBuffer, 0, nullptr, nullptr);
+        clFinish(m_pContext->getCmdQueue());
 
-    return RF_STATUS_OK;
-}
+        Consumer.pSysmemBuffer = nullptr;
+    }
 
+    if (Consumer.clPageLockedBuffer)
+    {
+        clReleaseMemObject(Consumer.clPageLockedBuffer);
+        Consumer.clPageLockedBuffer = NULL;
+    }
 
-RFStatus RFEncoderDM::getEncodedFrame(unsigned int& uiSize, void* &pBitStream)
-{
-    if (m_ResultQueue.size() == 0)
+    if (Consumer.clAccumulatedMap)
     {
-        return RF_STATUS_NO_ENCODED_FRAME;
+        clReleaseMemObject(Consumer.clAccumulatedMap);
+        Consumer.clAccumulatedMap = NULL;
     }
 
-    const DMDiffMapBuffer* pEncodedBuffer = m_ResultQueue.pop();
+    Consumer.HostMap.clear();
+}
 
-    m_pMappedBuffer = pEncodedBuffer;
 
-    // Wait until transfer has completed.
-    clWaitForEvents(1, &pEncodedBuffer->clDMAFinished);
-    clReleaseEvent(pEncodedBuffer->clDMAFinished);
+RFStatus RFEncoderDM::accumulateDiffMap(cl_mem clDiffMap, const unsigned char* pHostDiffMap)
+{
+    RFReadWriteAccess ConsumerAccess(&m_ConsumerLock);
 
-    // Just release event, no sync is required sine m_clDMAFinished can only finish if m_clDiffFinished is finished.
-    clReleaseEvent(pEncodedBuffer->clDiffFinished);
+    const unsigned int uiMapSize = m_uiOutputWidth * m_uiOutputHeight;
+    size_t             globalDim = uiMapSize;
 
-    if (pEncodedBuffer->pSysmemBuffer)
+    for (DMConsumer& Consumer : m_Consumers)
     {
-        pBitStream = pEncodedBuffer->pSysmemBuffer;
-        uiSize = m_uiDiffMapSize;
+        if (!Consumer.bActive)
+        {
+            continue;
+        }
 
-        return RF_STATUS_OK;
+        if (pHostDiffMap)
+        {
+            for (unsigned int i = 0; i < uiMapSize; ++i)
+            {
+                Consumer.HostMap[i] = std::max(Consumer.HostMap[i], pHostDiffMap[i]);
+            }
+        }
+        else
+        {
+            SAFE_CALL_CL(clSetKernelArg(m_DiffMapAccumulatekernel, 0, sizeof(cl_mem), &clDiffMap));
+            SAFE_CALL_CL(clSetKernelArg(m_DiffMapAccumulatekernel, 1, sizeof(cl_mem), &Consumer.clAccumulatedMap));
+
+            SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_DiffMapAccumulatekernel, 1, nullptr, &globalDim, nullptr, 0, nullptr, nullptr));
+        }
     }
 
-    return RF_STATUS_NO_ENCODED_FRAME;
+    return RF_STATUS_OK;
 }
 
 
@@ -526,6 +2505,12 @@ RFStatus RFEncoderDM::setParameter(const unsigned int uiParameterName, RFParamet
     {
         m_bLockMappedBuffer = (value != 0);
     }
+    else if (uiParameterName == RF_DIFF_ENCODER_QUEUE_TIMEOUT)
+    {
+        m_uiQueueTimeout = static_cast<unsigned int>(value);
+
+        return RF_STATUS_OK;
+    }
 
     return RF_STATUS_FAIL;
 }
@@ -558,6 +2543,78 @@ RFParameterState RFEncoderDM::getParameter(const unsigned int uiParameterName, R
 
         return RF_PARAMETER_STATE_READY;
     }
+    else if (uiParameterName == RF_DIFF_ENCODER_FUSED_CSC)
+    {
+        value = m_bFusedCSC;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_HOST_DIFF)
+    {
+        value = m_bHostDiffMap;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_PYRAMID)
+    {
+        value = m_bPyramid;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_OUTPUT_MODE)
+    {
+        value = m_uiOutputMode;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_SCROLL_DETECT)
+    {
+        value = m_bScrollDetect;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_THRESHOLD)
+    {
+        value = m_uiThreshold;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_MAGNITUDE)
+    {
+        value = m_bMagnitude;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_QUEUE_TIMEOUT)
+    {
+        value = m_uiQueueTimeout;
+
+        return RF_PARAMETER_STATE_READY;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_NUM_BUFFERS)
+    {
+        value = m_uiNumTargetBuffers;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_PERIODIC_HISTORY)
+    {
+        value = m_uiPeriodicHistory;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_GPU_OUTPUT)
+    {
+        value = m_bGPUOutput;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_NV12_CHROMA)
+    {
+        value = m_bChroma;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
 
     return RF_PARAMETER_STATE_INVALID;
 }
@@ -566,7 +2623,21 @@ RFStatus RFEncoderDM::GenerateCLProgramAndKernel()
 {
     assert(m_pContext);
 
-	m_DiffMapProgram.Create(m_pContext->getContext(), m_pContext->getDeviceId(), DIFF_KERNEL_NAME, str_cl_DiffMapkernels);
+    // The SAD kernels use amd_sad4 if the device supports cl_amd_media_ops. All other kernels and devices only use
+    // core OpenCL functions, which allows to run the encoder on any OpenCL 1.2 device.
+    std::string strExtensions;
+    size_t      uiExtensionsSize = 0;
+
+    if (clGetDeviceInfo(m_pContext->getDeviceId(), CL_DEVICE_EXTENSIONS, 0, nullptr, &uiExtensionsSize) == CL_SUCCESS && uiExtensionsSize > 0)
+    {
+        strExtensions.resize(uiExtensionsSize);
+
+        clGetDeviceInfo(m_pContext->getDeviceId(), CL_DEVICE_EXTENSIONS, uiExtensionsSize, &strExtensions[0], nullptr);
+    }
+
+    const char* strOptions = (strExtensions.find("cl_amd_media_ops") != std::string::npos) ? "-D DIFF_MAP_SAD4=amd_sad4" : "-D DIFF_MAP_SAD4=DiffMap_SAD4";
+
+	m_DiffMapProgram.Create(m_pContext->getContext(), m_pContext->getDeviceId(), DIFF_KERNEL_NAME, str_cl_DiffMapkernels, strOptions);
 
     if (m_DiffMapProgram)
     {
@@ -575,6 +2646,44 @@ RFStatus RFEncoderDM::GenerateCLProgramAndKernel()
 		SAFE_CALL_CL(nStatus);
         m_DiffMapBufferkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Buffer", &nStatus);
         SAFE_CALL_CL(nStatus);
+        m_DiffMapSADImagekernel = clCreateKernel(m_DiffMapProgram, "DiffMap_SADImage", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapSADBufferkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_SADBuffer", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapNV12kernel = clCreateKernel(m_DiffMapProgram, "DiffMap_NV12Buffer", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapReducekernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Reduce", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapPackkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Pack", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapRunskernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Runs", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapRectskernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Rects", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapTileScankernel = clCreateKernel(m_DiffMapProgram, "DiffMap_TileScan", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapTileGroupskernel = clCreateKernel(m_DiffMapProgram, "DiffMap_TileGroups", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapTileGatherkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_TileGather", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapBoundskernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Bounds", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapLineHashBufferkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_LineHashBuffer", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapLineHashImagekernel = clCreateKernel(m_DiffMapProgram, "DiffMap_LineHashImage", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapScrollSearchkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_ScrollSearch", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapScrollSelectkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_ScrollSelect", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapResidualBufferkernel = clCreateKernel(m_DiffMapProgram, "DiffMap_ResidualBuffer", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapResidualImagekernel = clCreateKernel(m_DiffMapProgram, "DiffMap_ResidualImage", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapAccumulatekernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Accumulate", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_DiffMapPeriodickernel = clCreateKernel(m_DiffMapProgram, "DiffMap_Periodic", &nStatus);
+        SAFE_CALL_CL(nStatus);
 
         return RF_STATUS_OK;
     }
@@ -584,4 +2693,341 @@ RFStatus RFEncoderDM::GenerateCLProgramAndKernel()
 	}
 
     return RF_STATUS_OPENCL_FAIL;
-}
\ No newline at end of file
+}
+
+
+RFStatus RFEncoderDM::reduceDiffMap(cl_mem clDiffMap)
+{
+    const unsigned int uiFactor = DIFF_MAP_PYRAMID_FACTOR;
+
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 0, sizeof(cl_mem), &clDiffMap));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 6, sizeof(unsigned int), &uiFactor));
+
+    // Each level is computed from the previous one. The in-order queue serializes the kernels.
+    for (unsigned int l = 1; l < m_uiNumLevels; ++l)
+    {
+        size_t globalDim[2] = { m_uiLevelDim[l][0], m_uiLevelDim[l][1] };
+
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 1, sizeof(unsigned int), &m_uiLevelOffset[l - 1]));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 2, sizeof(unsigned int), &m_uiLevelDim[l - 1][0]));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 3, sizeof(unsigned int), &m_uiLevelDim[l - 1][1]));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 4, sizeof(unsigned int), &m_uiLevelOffset[l]));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapReducekernel, 5, sizeof(unsigned int), &m_uiLevelDim[l][0]));
+
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_DiffMapReducekernel, 2, nullptr, globalDim, nullptr, 0, nullptr, nullptr));
+    }
+
+    return RF_STATUS_OK;
+}
+
+
+RFStatus RFEncoderDM::finalizeDiffMap(DMDiffMapBuffer* pBuffer, cl_mem clSource)
+{
+    cl_command_queue clQueue = m_pContext->getCmdQueue();
+
+    if (m_uiNumLevels > 1)
+    {
+        SAFE_CALL_RF(reduceDiffMap(pBuffer->clGPUBuffer));
+    }
+
+    if (m_uiOutputMode == RF_DIFF_MAP_BITS)
+    {
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapPackkernel, 0, sizeof(cl_mem), &pBuffer->clGPUBuffer));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapPackkernel, 3, sizeof(cl_mem), &pBuffer->clOutputBuffer));
+
+        for (unsigned int l = 0; l < m_uiNumLevels; ++l)
+        {
+            unsigned int uiPitch = (m_uiLevelDim[l][0] + 7) / 8;
+            size_t       globalDim[2] = { uiPitch, m_uiLevelDim[l][1] };
+
+            SAFE_CALL_CL(clSetKernelArg(m_DiffMapPackkernel, 1, sizeof(unsigned int), &m_uiLevelOffset[l]));
+            SAFE_CALL_CL(clSetKernelArg(m_DiffMapPackkernel, 2, sizeof(unsigned int), &m_uiLevelDim[l][0]));
+            SAFE_CALL_CL(clSetKernelArg(m_DiffMapPackkernel, 4, sizeof(unsigned int), &m_uiPackedOffset[l]));
+            SAFE_CALL_CL(clSetKernelArg(m_DiffMapPackkernel, 5, sizeof(unsigned int), &uiPitch));
+
+            SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapPackkernel, 2, nullptr, globalDim, nullptr, 0, nullptr, nullptr));
+        }
+    }
+    else if (m_uiOutputMode == RF_DIFF_MAP_RECTS)
+    {
+        size_t uiRows = m_uiOutputHeight;
+        size_t uiOne  = 1;
+
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRunskernel, 0, sizeof(cl_mem),       &pBuffer->clGPUBuffer));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRunskernel, 1, sizeof(unsigned int), &m_uiOutputWidth));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRunskernel, 2, sizeof(unsigned int), &m_uiMaxRuns));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRunskernel, 3, sizeof(cl_mem),       &m_clRuns));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRunskernel, 4, sizeof(cl_mem),       &m_clRunCount));
+
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapRunskernel, 1, nullptr, &uiRows, nullptr, 0, nullptr, nullptr));
+
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRectskernel, 0, sizeof(cl_mem),       &m_clRuns));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRectskernel, 1, sizeof(cl_mem),       &m_clRunCount));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRectskernel, 2, sizeof(cl_mem),       &m_clRunRect));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRectskernel, 3, sizeof(unsigned int), &m_uiOutputHeight));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRectskernel, 4, sizeof(unsigned int), &m_uiMaxRuns));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapRectskernel, 5, sizeof(cl_mem),       &pBuffer->clOutputBuffer));
+
+        // The rows depend on each other, a single work item merges the runs.
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapRectskernel, 1, nullptr, &uiOne, &uiOne, 0, nullptr, nullptr));
+    }
+    else if (m_uiOutputMode == RF_DIFF_MAP_TILES)
+    {
+        const unsigned int uiNumBlocks     = m_uiOutputWidth * m_uiOutputHeight;
+        const unsigned int uiScanGroupSize = DIFF_MAP_SCAN_GROUP_SIZE;
+
+        size_t uiScanGlobal = m_uiNumScanGroups * uiScanGroupSize;
+        size_t uiScanLocal  = uiScanGroupSize;
+        size_t uiOne        = 1;
+
+        // The position of each changed block in the compacted list is the prefix sum of the changed blocks.
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileScankernel, 0, sizeof(cl_mem),       &pBuffer->clGPUBuffer));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileScankernel, 1, sizeof(unsigned int), &uiNumBlocks));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileScankernel, 2, sizeof(cl_mem),       &m_clTileOffsets));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileScankernel, 3, sizeof(cl_mem),       &m_clTileGroupSums));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileScankernel, 4, uiScanGroupSize * sizeof(cl_uint), nullptr));
+
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapTileScankernel, 1, nullptr, &uiScanGlobal, &uiScanLocal, 0, nullptr, nullptr));
+
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGroupskernel, 0, sizeof(cl_mem),       &m_clTileGroupSums));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGroupskernel, 1, sizeof(unsigned int), &m_uiNumScanGroups));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGroupskernel, 2, sizeof(cl_mem),       &pBuffer->clOutputBuffer));
+
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapTileGroupskernel, 1, nullptr, &uiOne, &uiOne, 0, nullptr, nullptr));
+
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 0, sizeof(cl_mem),       &clSource));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 1, sizeof(cl_mem),       &pBuffer->clGPUBuffer));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 2, sizeof(cl_mem),       &m_clTileOffsets));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 3, sizeof(cl_mem),       &m_clTileGroupSums));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 4, sizeof(unsigned int), &uiScanGroupSize));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 5, sizeof(cl_mem),       &pBuffer->clOutputBuffer));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 6, sizeof(unsigned int), &m_uiWidth));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 7, sizeof(unsigned int), &m_uiHeight));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 8, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+        SAFE_CALL_CL(clSetKernelArg(m_DiffMapTileGatherkernel, 9, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+
+        // One work group per block as for the diff map kernels. Unchanged blocks return immediately.
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapTileGatherkernel, 2, nullptr, m_globalDim, m_localDim, 0, nullptr, nullptr));
+    }
+
+    if (m_bScrollDetect)
+    {
+        // The RFDiffCopyRect follows the bounding box in m_clScroll.
+        SAFE_CALL_CL(clEnqueueCopyBuffer(clQueue, m_clScroll, pBuffer->clPageLockedBuffer, 4 * sizeof(cl_int), 0, sizeof(RFDiffCopyRect), 0, nullptr, nullptr));
+    }
+
+    if (m_uiPeriodicHistory > 0)
+    {
+        SAFE_CALL_CL(clEnqueueCopyBuffer(clQueue, m_clPeriodicMap, pBuffer->clPageLockedBuffer, 0, m_uiPeriodicOffset, m_uiOutputWidth * m_uiOutputHeight, 0, nullptr, nullptr));
+    }
+
+    if (m_bGPUOutput)
+    {
+        // The output stays on the GPU. The marker completes once all commands of the diff map have finished.
+        SAFE_CALL_CL(clEnqueueMarkerWithWaitList(clQueue, 0, nullptr, &pBuffer->clDMAFinished));
+
+        return RF_STATUS_OK;
+    }
+
+    cl_mem clOutput = (m_uiOutputMode == RF_DIFF_MAP_BYTES) ? pBuffer->clGPUBuffer : pBuffer->clOutputBuffer;
+
+    SAFE_CALL_CL(clEnqueueCopyBuffer(clQueue, clOutput, pBuffer->clPageLockedBuffer, 0, m_uiHeaderSize, m_uiReadbackSize, 0, nullptr, &pBuffer->clDMAFinished));
+
+    return RF_STATUS_OK;
+}
+
+
+RFStatus RFEncoderDM::detectPeriodic(cl_mem clDiffMap, cl_mem clSource)
+{
+    size_t globalDim[2] = { m_uiOutputWidth, m_uiOutputHeight };
+
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 0, sizeof(cl_mem),       &clSource));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 1, sizeof(cl_mem),       &clDiffMap));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 2, sizeof(cl_mem),       &m_clPeriodicHistory));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 3, sizeof(cl_mem),       &m_clPeriodicState));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 4, sizeof(cl_mem),       &m_clPeriodicMap));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 5, sizeof(unsigned int), &m_uiPeriodicHistory));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 6, sizeof(unsigned int), &m_uiWidth));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 7, sizeof(unsigned int), &m_uiHeight));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 8, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapPeriodickernel, 9, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_DiffMapPeriodickernel, 2, nullptr, globalDim, nullptr, 0, nullptr, nullptr));
+
+    return RF_STATUS_OK;
+}
+
+
+RFStatus RFEncoderDM::detectScroll(DMDiffMapBuffer* pBuffer, cl_mem clCurrent, cl_mem clPrevious, bool bUseInputImages)
+{
+    cl_command_queue clQueue = m_pContext->getCmdQueue();
+
+    const int          iRange       = DIFF_MAP_SCROLL_RANGE;
+    const unsigned int uiMinLines   = DIFF_MAP_SCROLL_MIN_LINES;
+    const unsigned int uiNumScores  = 2 * (2 * iRange + 1);
+
+    size_t uiOne = 1;
+
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapBoundskernel, 0, sizeof(cl_mem),       &pBuffer->clGPUBuffer));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapBoundskernel, 1, sizeof(unsigned int), &m_uiOutputWidth));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapBoundskernel, 2, sizeof(unsigned int), &m_uiOutputHeight));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapBoundskernel, 3, sizeof(cl_mem),       &m_clScroll));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapBoundskernel, 4, sizeof(cl_mem),       &m_clScrollScores));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapBoundskernel, 5, sizeof(unsigned int), &uiNumScores));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapBoundskernel, 1, nullptr, &uiOne, &uiOne, 0, nullptr, nullptr));
+
+    // Hash the lines of both images inside of the bounding box.
+    cl_kernel LineHashKernel = (bUseInputImages) ? m_DiffMapLineHashImagekernel : m_DiffMapLineHashBufferkernel;
+    size_t    uiNumLines     = m_uiNumLines;
+
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 0, sizeof(cl_mem),       &clCurrent));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 1, sizeof(cl_mem),       &clPrevious));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 2, sizeof(cl_mem),       &m_clScroll));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 3, sizeof(cl_mem),       &m_clLineHashes));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 4, sizeof(unsigned int), &m_uiWidth));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 5, sizeof(unsigned int), &m_uiHeight));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 6, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 7, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 8, sizeof(unsigned int), &m_uiOutputWidth));
+    SAFE_CALL_CL(clSetKernelArg(LineHashKernel, 9, sizeof(unsigned int), &m_uiNumLines));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, LineHashKernel, 1, nullptr, &uiNumLines, nullptr, 0, nullptr, nullptr));
+
+    // Score each shift per block column and block row.
+    size_t globalDim[2] = { 2 * iRange + 1, m_uiOutputWidth + m_uiOutputHeight };
+
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 0, sizeof(cl_mem),       &m_clLineHashes));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 1, sizeof(cl_mem),       &m_clScroll));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 2, sizeof(cl_mem),       &m_clScrollScores));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 3, sizeof(unsigned int), &m_uiWidth));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 4, sizeof(unsigned int), &m_uiHeight));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 5, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 6, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 7, sizeof(unsigned int), &m_uiOutputWidth));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 8, sizeof(unsigned int), &m_uiNumLines));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSearchkernel, 9, sizeof(int),          &iRange));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapScrollSearchkernel, 2, nullptr, globalDim, nullptr, 0, nullptr, nullptr));
+
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 0,  sizeof(cl_mem),       &m_clLineHashes));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 1,  sizeof(cl_mem),       &m_clScroll));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 2,  sizeof(cl_mem),       &m_clScrollScores));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 3,  sizeof(unsigned int), &m_uiWidth));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 4,  sizeof(unsigned int), &m_uiHeight));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 5,  sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 6,  sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 7,  sizeof(unsigned int), &m_uiOutputWidth));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 8,  sizeof(unsigned int), &m_uiNumLines));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 9,  sizeof(int),          &iRange));
+    SAFE_CALL_CL(clSetKernelArg(m_DiffMapScrollSelectkernel, 10, sizeof(unsigned int), &uiMinLines));
+
+    // The selection depends on all scores, a single work item evaluates them.
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, m_DiffMapScrollSelectkernel, 1, nullptr, &uiOne, &uiOne, 0, nullptr, nullptr));
+
+    // Compare the blocks that overlap the destination of the copy with the moved pixels.
+    cl_kernel ResidualKernel = (bUseInputImages) ? m_DiffMapResidualImagekernel : m_DiffMapResidualBufferkernel;
+    size_t    mapDim[2]      = { m_uiOutputWidth, m_uiOutputHeight };
+
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 0, sizeof(cl_mem),       &clCurrent));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 1, sizeof(cl_mem),       &clPrevious));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 2, sizeof(cl_mem),       &pBuffer->clGPUBuffer));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 3, sizeof(cl_mem),       &m_clScroll));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 4, sizeof(unsigned int), &m_uiWidth));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 5, sizeof(unsigned int), &m_uiHeight));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 6, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 7, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+    SAFE_CALL_CL(clSetKernelArg(ResidualKernel, 8, sizeof(unsigned int), &m_uiOutputWidth));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(clQueue, ResidualKernel, 2, nullptr, mapDim, nullptr, 0, nullptr, nullptr));
+
+    return RF_STATUS_OK;
+}
+
+
+void RFEncoderDM::tuneDiffMapKernel(cl_kernel diffMapKernel, const char* strKernelName, bool bUseInputImages)
+{
+    m_bKernelTuned = true;
+
+    // The candidates compare a scratch image with itself. This is the worst case since no work group can exit early.
+    cl_int nStatus;
+    cl_mem clScratch;
+
+    if (bUseInputImages)
+    {
+        cl_image_format ImageFormat = { CL_RGBA, CL_UNORM_INT8 };
+        cl_image_desc   ImageDesc;
+
+        memset(&ImageDesc, 0, sizeof(ImageDesc));
+
+        ImageDesc.image_type   = CL_MEM_OBJECT_IMAGE2D;
+        ImageDesc.image_width  = m_uiWidth;
+        ImageDesc.image_height = m_uiHeight;
+
+        clScratch = clCreateImage(m_pContext->getContext(), CL_MEM_READ_ONLY, &ImageFormat, &ImageDesc, nullptr, &nStatus);
+    }
+    else
+    {
+        clScratch = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_ONLY, m_uiWidth * m_uiHeight * 4, nullptr, &nStatus);
+    }
+
+    if (nStatus != CL_SUCCESS)
+    {
+        return;
+    }
+
+    nStatus  = clSetKernelArg(diffMapKernel, 0, sizeof(cl_mem),       &clScratch);
+    nStatus |= clSetKernelArg(diffMapKernel, 1, sizeof(cl_mem),       &clScratch);
+    nStatus |= clSetKernelArg(diffMapKernel, 2, sizeof(cl_mem),       &(m_TargetBuffers[0].clGPUBuffer));
+    nStatus |= clSetKernelArg(diffMapKernel, 3, sizeof(unsigned int), &m_uiWidth);
+    nStatus |= clSetKernelArg(diffMapKernel, 4, sizeof(unsigned int), &m_uiHeight);
+    nStatus |= clSetKernelArg(diffMapKernel, 5, sizeof(unsigned int), &m_uiTotalBlockSize[0]);
+    nStatus |= clSetKernelArg(diffMapKernel, 6, sizeof(unsigned int), &m_uiTotalBlockSize[1]);
+
+    if (nStatus == CL_SUCCESS)
+    {
+        static const size_t LocalSizes[][2] = { { 8, 8 }, { 16, 8 }, { 16, 16 }, { 32, 8 }, { 32, 16 }, { 64, 4 } };
+
+        std::vector<RFKernelTuner::Candidate> Candidates;
+
+        // The first candidate is the default configuration.
+        RFKernelTuner::Candidate c;
+
+        c.kernel              = diffMapKernel;
+        c.uiVariant           = 0;
+        c.uiLocalWorkSize[0]  = m_localDim[0];
+        c.uiLocalWorkSize[1]  = m_localDim[1];
+        c.uiGlobalWorkSize[0] = m_uiOutputWidth * m_localDim[0];
+        c.uiGlobalWorkSize[1] = m_uiOutputHeight * m_localDim[1];
+
+        Candidates.push_back(c);
+
+        for (const auto& l : LocalSizes)
+        {
+            if (l[0] <= m_uiTotalBlockSize[0] && l[1] <= m_uiTotalBlockSize[1])
+            {
+                c.uiLocalWorkSize[0]  = l[0];
+                c.uiLocalWorkSize[1]  = l[1];
+                c.uiGlobalWorkSize[0] = m_uiOutputWidth * l[0];
+                c.uiGlobalWorkSize[1] = m_uiOutputHeight * l[1];
+
+                Candidates.push_back(c);
+            }
+        }
+
+        std::ostringstream oss;
+
+        oss << m_uiWidth << "x" << m_uiHeight << " " << m_uiTotalBlockSize[0] << "x" << m_uiTotalBlockSize[1];
+
+        RFKernelTuner Tuner(m_pContext->getContext(), m_pContext->getDeviceId());
+
+        const RFKernelTuner::Candidate& Best = Candidates[Tuner.selectCandidate(strKernelName, str_cl_DiffMapkernels, oss.str(), Candidates)];
+
+        m_localDim[0]  = Best.uiLocalWorkSize[0];
+        m_localDim[1]  = Best.uiLocalWorkSize[1];
+        m_globalDim[0] = Best.uiGlobalWorkSize[0];
+        m_globalDim[1] = Best.uiGlobalWorkSize[1];
+    }
+
+    clReleaseMemObject(clScratch);
+}
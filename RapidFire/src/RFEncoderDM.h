@@ -22,7 +22,8 @@
 
 #pragma once
 
-#include <queue>
+#include <memory>
+#include <vector>
 
 #include <CL/opencl.h>
 #include <components/Component.h>
@@ -31,8 +32,34 @@
 
 #include "RFEncoder.h"
 #include "RFLock.h"
+#include "RFSpscQueue.h"
 
 class RFContextCL;
+class RFDiffMapHost;
+
+// Number of levels of the diff map pyramid and the number of blocks of a level that are combined
+// into one block of the next level.
+#define DIFF_MAP_PYRAMID_LEVELS     3
+#define DIFF_MAP_PYRAMID_FACTOR     4
+
+// Number of rectangles that are transferred together with the rectangle count. Larger lists are completed
+// by getEncodedFrame.
+#define DIFF_MAP_RECTS_READBACK     256
+
+// Number of tiles that are transferred together with the tile count and the number of blocks processed by a work
+// group of the prefix sum that compacts the tiles.
+#define DIFF_MAP_TILES_READBACK     1024
+#define DIFF_MAP_SCAN_GROUP_SIZE    256
+
+// Largest shift in pixels searched by the scroll detection and the number of lines a shift has to match.
+#define DIFF_MAP_SCROLL_RANGE       128
+#define DIFF_MAP_SCROLL_MIN_LINES   8
+
+// Maximum number of consumers that accumulate the diff maps of the encoder.
+#define DIFF_MAP_MAX_CONSUMERS      16
+
+// Maximum number of states per block that are stored by the periodic change detection.
+#define DIFF_MAP_MAX_PERIODIC_HISTORY   16
 
 class RFEncoderDM : public RFEncoder
 {
@@ -49,6 +76,16 @@ public:
 
     virtual RFStatus            getEncodedFrame(unsigned int& uiSize, void* &pBitStream)                                        override;
 
+    virtual RFStatus            getEncodedFrameCL(RFEncodedFrameCL& Frame)                                                      override;
+
+    virtual RFStatus            releaseEncodedFrameCL()                                                                         override;
+
+    virtual RFStatus            createConsumer(unsigned int& uiConsumer)                                                        override;
+
+    virtual RFStatus            deleteConsumer(unsigned int uiConsumer)                                                         override;
+
+    virtual RFStatus            getConsumerFrame(unsigned int uiConsumer, unsigned int& uiSize, void* &pBitStream)              override;
+
     virtual bool                isFormatSupported(RFFormat format) const                                                        override;
 
     virtual RFStatus            setParameter(unsigned int const uiParameterName, RFParameterType rfType, RFProperties value)    override;
@@ -64,29 +101,145 @@ public:
 
 private:
 
-    bool                      deleteBuffers();
-    bool                      createBuffers();
-    RFStatus                  GenerateCLProgramAndKernel();
-
     struct DMDiffMapBuffer
     {
         cl_mem              clGPUBuffer;
         cl_mem              clPageLockedBuffer;
         char*               pSysmemBuffer;
 
+        // Stores the packed map or the rectangle list if the output mode is not RF_DIFF_MAP_BYTES.
+        cl_mem              clOutputBuffer;
+
         cl_event            clDiffFinished;
         cl_event            clDMAFinished;
+
+        // Index of the result buffer of the context the diff map was computed from.
+        unsigned int        uiSourceBuffer;
+    };
+
+    struct DMConsumer
+    {
+        bool                        bActive;
+
+        // Diff map accumulated since the last call to getConsumerFrame and the pinned buffer it is returned in.
+        cl_mem                      clAccumulatedMap;
+        cl_mem                      clPageLockedBuffer;
+        char*                       pSysmemBuffer;
+
+        // Accumulated map if the diff map is computed on the host.
+        std::vector<unsigned char>  HostMap;
     };
 
+    bool                      deleteBuffers();
+    bool                      createBuffers();
+    RFStatus                  GenerateCLProgramAndKernel();
+
+    // Computes the coarser levels of the diff map pyramid from the first level stored in clDiffMap.
+    RFStatus                  reduceDiffMap(cl_mem clDiffMap);
+
+    // Converts the diff map stored in clGPUBuffer of pBuffer into the output format and enqueues the transfer
+    // to the pinned buffer. The tiles are copied from clSource.
+    RFStatus                  finalizeDiffMap(DMDiffMapBuffer* pBuffer, cl_mem clSource);
+
+    // Searches a vertical or horizontal shift of the changed region of clCurrent and updates the diff map stored
+    // in clGPUBuffer of pBuffer. The RFDiffCopyRect is stored in m_clScroll.
+    RFStatus                  detectScroll(DMDiffMapBuffer* pBuffer, cl_mem clCurrent, cl_mem clPrevious, bool bUseInputImages);
+
+    // Removes blocks of clDiffMap that alternate between the states stored in m_clPeriodicHistory and marks them in
+    // m_clPeriodicMap. The block signatures are computed from clSource.
+    RFStatus                  detectPeriodic(cl_mem clDiffMap, cl_mem clSource);
+
+    // Creates the buffers of a consumer for the current dimension. All blocks of the accumulated map are marked as changed.
+    bool                      createConsumerBuffers(DMConsumer& Consumer);
+    void                      deleteConsumerBuffers(DMConsumer& Consumer);
+
+    // Adds the first level of the diff map to the accumulated maps of all consumers. pHostDiffMap is used if the
+    // diff map is computed on the host, clDiffMap otherwise.
+    RFStatus                  accumulateDiffMap(cl_mem clDiffMap, const unsigned char* pHostDiffMap);
+
+    // Selects the local work size of diffMapKernel. Each work group compares one block, hence the local
+    // size defines the number of pixels compared by a work item.
+    void                      tuneDiffMapKernel(cl_kernel diffMapKernel, const char* strKernelName, bool bUseInputImages);
+
     bool                                        m_bLockMappedBuffer;
 
+    // If true the output stays in GPU memory and is retrieved by getEncodedFrameCL. No pinned buffers are created
+    // and clDMAFinished marks the completion of the diff map.
+    bool                                        m_bGPUOutput;
+
+    // If true the diff map is computed by the context while copying the RGBA input.
+    bool                                        m_bFusedCSC;
+
+    // If true the diff map of host memory frames is computed by m_pHostDiffMap on the CPU.
+    bool                                        m_bHostDiffMap;
+    std::unique_ptr<RFDiffMapHost>              m_pHostDiffMap;
+
     unsigned int                                m_uiPreviousBuffer;
     unsigned int                                m_uiDiffMapSize;
 
-    unsigned int                                m_uiNumLocalPixels[2];
+    // If true the output contains the diff map followed by DIFF_MAP_PYRAMID_LEVELS - 1 coarser levels.
+    bool                                        m_bPyramid;
+    unsigned int                                m_uiNumLevels;
+    unsigned int                                m_uiLevelDim[DIFF_MAP_PYRAMID_LEVELS][2];
+    unsigned int                                m_uiLevelOffset[DIFF_MAP_PYRAMID_LEVELS];
+
+    // Format of the diff map returned by getEncodedFrame (RFDiffMapOutput).
+    unsigned int                                m_uiOutputMode;
+    unsigned int                                m_uiOutputSize;
+
+    // Number of bytes transferred to the pinned buffer by encode. Is smaller than m_uiOutputSize for rectangle lists and tiles.
+    unsigned int                                m_uiReadbackSize;
+
+    // Offsets of the levels in the bit packed map.
+    unsigned int                                m_uiPackedOffset[DIFF_MAP_PYRAMID_LEVELS];
+
+    // Maximum number of runs in a row of the diff map and the scratch buffers used to build the rectangle list.
+    unsigned int                                m_uiMaxRuns;
+    cl_mem                                      m_clRuns;
+    cl_mem                                      m_clRunCount;
+    cl_mem                                      m_clRunRect;
+
+    // Size of a tile in bytes and the scratch buffers of the prefix sum that compacts the tiles.
+    unsigned int                                m_uiTileSize;
+    unsigned int                                m_uiNumScanGroups;
+    cl_mem                                      m_clTileOffsets;
+    cl_mem                                      m_clTileGroupSums;
+
+    // Blocks are compared by their sum of absolute differences if a threshold is set or the magnitude is returned.
+    unsigned int                                m_uiThreshold;
+    bool                                        m_bMagnitude;
+
+    // If true the chroma plane of NV12 result buffers is compared in addition to the luma plane.
+    bool                                        m_bChroma;
+
+    // If true the output is preceded by an RFDiffCopyRect.
+    bool                                        m_bScrollDetect;
+
+    // Size of the data that precedes the output, the RFDiffCopyRect followed by the periodic map.
+    unsigned int                                m_uiHeaderSize;
+
+    // Scratch buffers of the scroll detection. m_clScroll stores the bounding box of the changed blocks followed by
+    // the RFDiffCopyRect.
+    unsigned int                                m_uiNumLines;
+    cl_mem                                      m_clLineHashes;
+    cl_mem                                      m_clScrollScores;
+    cl_mem                                      m_clScroll;
+
+    // Number of states per block stored by the periodic change detection, 0 if it is disabled. The periodic map
+    // starts at m_uiPeriodicOffset of the output buffer. m_clPeriodicHistory stores the block signatures and
+    // m_clPeriodicState the number of stored signatures, the next signature and the number of repeated states per block.
+    unsigned int                                m_uiPeriodicHistory;
+    unsigned int                                m_uiPeriodicOffset;
+    cl_mem                                      m_clPeriodicHistory;
+    cl_mem                                      m_clPeriodicState;
+    cl_mem                                      m_clPeriodicMap;
+
+    // Byte map of host diff maps that are converted into a different output format.
+    std::vector<unsigned char>                  m_HostDiffMap;
+
     unsigned int                                m_uiTotalBlockSize[2];
 
-    const unsigned int                          m_uiNumTargetBuffers;
+    unsigned int                                m_uiNumTargetBuffers;
     unsigned int                                m_uiCurrentTargetBuffer;
 
     char*                                       m_pClearData;
@@ -94,8 +247,30 @@ private:
     size_t                                      m_globalDim[2];
     size_t                                      m_localDim[2];
 
+    // Indicates that m_localDim was selected by tuneDiffMapKernel for the current dimension.
+    bool                                        m_bKernelTuned;
+
     cl_kernel                                   m_DiffMapImagekernel;
     cl_kernel                                   m_DiffMapBufferkernel;
+    cl_kernel                                   m_DiffMapSADImagekernel;
+    cl_kernel                                   m_DiffMapSADBufferkernel;
+    cl_kernel                                   m_DiffMapReducekernel;
+    cl_kernel                                   m_DiffMapPackkernel;
+    cl_kernel                                   m_DiffMapRunskernel;
+    cl_kernel                                   m_DiffMapRectskernel;
+    cl_kernel                                   m_DiffMapTileScankernel;
+    cl_kernel                                   m_DiffMapTileGroupskernel;
+    cl_kernel                                   m_DiffMapTileGatherkernel;
+    cl_kernel                                   m_DiffMapBoundskernel;
+    cl_kernel                                   m_DiffMapLineHashBufferkernel;
+    cl_kernel                                   m_DiffMapLineHashImagekernel;
+    cl_kernel                                   m_DiffMapScrollSearchkernel;
+    cl_kernel                                   m_DiffMapScrollSelectkernel;
+    cl_kernel                                   m_DiffMapResidualBufferkernel;
+    cl_kernel                                   m_DiffMapResidualImagekernel;
+    cl_kernel                                   m_DiffMapAccumulatekernel;
+    cl_kernel                                   m_DiffMapPeriodickernel;
+    cl_kernel                                   m_DiffMapNV12kernel;
     RFProgramCL                                 m_DiffMapProgram;
 
     const RFContextCL*                          m_pContext;
@@ -105,8 +280,20 @@ private:
 
     // Queue that contains references to buffers that store a diff map which were not yet
     // read by calling getEncodedFrame
-    RFLockedQueue<const DMDiffMapBuffer*>       m_ResultQueue;
+    RFSpscQueue<const DMDiffMapBuffer*>         m_ResultQueue;
 
-    // Pointer to the buffer that was retrieved by calling getEncodedFrame
+    // Pointer to the buffer that was retrieved by calling getEncodedFrame. With m_bGPUOutput it is reset by
+    // releaseEncodedFrameCL and the buffer is not reused before.
     const DMDiffMapBuffer*                      m_pMappedBuffer;
+
+    // Protects m_pMappedBuffer. m_BufferReleased is signalled by getEncodedFrame and encode waits up to
+    // m_uiQueueTimeout ms for it if no target buffer is available.
+    RFLock                                      m_BufferLock;
+    RFCondition                                 m_BufferReleased;
+    unsigned int                                m_uiQueueTimeout;
+
+    // Consumers are identified by their index. m_ConsumerLock protects the consumers since they can be accessed by
+    // other threads than the one that encodes.
+    DMConsumer                                  m_Consumers[DIFF_MAP_MAX_CONSUMERS];
+    RFLock                                      m_ConsumerLock;
 };
\ No newline at end of file
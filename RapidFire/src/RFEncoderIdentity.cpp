@@ -23,22 +23,226 @@
 #include "RFEncoderIdentity.h"
 
 #include <assert.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include "RFEncoderSettings.h"
 #include "RFError.h"
 #include "RFUtils.h"
 
+using namespace std;
+
+#define IDENTITY_KERNEL_NAME "rfIdentityKernel.cl"
+
+#define MULTI_LINE_STR(a) #a
+
+const char* str_cl_Identitykernels = MULTI_LINE_STR(    // Computes the mask of changed pixels of each chunk and the number of words the chunk occupies in the output,
+                                                        // 1 + number of changed pixels for changed chunks and 0 otherwise. LocalMasks stores one mask per chunk of the work group.
+                                                        __kernel void Compact_Masks(__global unsigned int* Current, __global unsigned int* Previous, const unsigned int uiKeyFrame, const unsigned int uiNumPixels,
+                                                                                    __global unsigned int* Masks, __global unsigned int* ChunkSizes, __local unsigned int* LocalMasks)
+                                                        {
+                                                            unsigned int gid = get_global_id(0);
+                                                            unsigned int lid = get_local_id(0);
+
+                                                            if (lid < get_local_size(0) / 32)
+                                                            {
+                                                                LocalMasks[lid] = 0;
+                                                            }
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            if (gid < uiNumPixels)
+                                                            {
+                                                                unsigned int value = (uiKeyFrame) ? Current[gid] : Current[gid] ^ Previous[gid];
+
+                                                                if (value != 0)
+                                                                {
+                                                                    atomic_or(&LocalMasks[lid / 32], 1u << (lid % 32));
+                                                                }
+                                                            }
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            unsigned int chunk = gid / 32;
+
+                                                            if (lid % 32 == 0 && gid < uiNumPixels)
+                                                            {
+                                                                unsigned int mask = LocalMasks[lid / 32];
+
+                                                                Masks[chunk]      = mask;
+                                                                ChunkSizes[chunk] = (mask != 0) ? 1 + popcount(mask) : 0;
+                                                            }
+                                                        };
+
+
+                                                        // Computes the exclusive prefix sum of the chunk sizes within each work group and stores the sum of each group in GroupSums.
+                                                        __kernel void Compact_Scan(__global unsigned int* ChunkSizes, const unsigned int uiNumChunks, __global unsigned int* ChunkOffsets,
+                                                                                   __global unsigned int* GroupSums, __local unsigned int* Scan)
+                                                        {
+                                                            unsigned int gid = get_global_id(0);
+                                                            unsigned int lid = get_local_id(0);
+                                                            unsigned int groupSize = get_local_size(0);
+
+                                                            unsigned int size = (gid < uiNumChunks) ? ChunkSizes[gid] : 0;
+
+                                                            Scan[lid] = size;
+
+                                                            barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                            // Inclusive scan in log2(groupSize) steps.
+                                                            for (unsigned int offset = 1; offset < groupSize; offset *= 2)
+                                                            {
+                                                                unsigned int value = (lid >= offset) ? Scan[lid - offset] : 0;
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+
+                                                                Scan[lid] += value;
+
+                                                                barrier(CLK_LOCAL_MEM_FENCE);
+                                                            }
+
+                                                            if (gid < uiNumChunks)
+                                                            {
+                                                                ChunkOffsets[gid] = Scan[lid] - size;
+                                                            }
+
+                                                            if (lid == groupSize - 1)
+                                                            {
+                                                                GroupSums[get_group_id(0)] = Scan[lid];
+                                                            }
+                                                        };
+
+
+                                                        // Replaces the sum of each group of Compact_Scan with the sum of all previous groups and writes the size of the output
+                                                        // in bytes and the key frame flag. uiHeaderSize is the number of words of the header including the bitmap.
+                                                        // Executed by a single work item.
+                                                        __kernel void Compact_Groups(__global unsigned int* GroupSums, const unsigned int uiNumGroups, const unsigned int uiHeaderSize,
+                                                                                     const unsigned int uiKeyFrame, __global unsigned int* Output)
+                                                        {
+                                                            unsigned int uiSum = 0;
+
+                                                            for (unsigned int i = 0; i < uiNumGroups; ++i)
+                                                            {
+                                                                unsigned int uiGroupSum = GroupSums[i];
+
+                                                                GroupSums[i] = uiSum;
+                                                                uiSum += uiGroupSum;
+                                                            }
+
+                                                            Output[0] = (uiHeaderSize + uiSum) * 4;
+                                                            Output[1] = uiKeyFrame;
+                                                        };
+
+
+                                                        // Writes one word of the chunk bitmap. Bit i of word n is set if chunk 32 * n + i changed.
+                                                        __kernel void Compact_Bitmap(__global unsigned int* Masks, const unsigned int uiNumChunks, __global unsigned int* Output)
+                                                        {
+                                                            unsigned int word = get_global_id(0);
+                                                            unsigned int bits = 0;
+
+                                                            for (unsigned int i = 0; i < 32; ++i)
+                                                            {
+                                                                unsigned int chunk = word * 32 + i;
+
+                                                                if (chunk < uiNumChunks && Masks[chunk] != 0)
+                                                                {
+                                                                    bits |= 1u << i;
+                                                                }
+                                                            }
+
+                                                            Output[2 + word] = bits;
+                                                        };
+
+
+                                                        // Writes the mask and the XORed values of the changed pixels of each changed chunk behind the header.
+                                                        __kernel void Compact_Write(__global unsigned int* Current, __global unsigned int* Previous, const unsigned int uiKeyFrame, const unsigned int uiNumPixels,
+                                                                                    __global unsigned int* Masks, __global unsigned int* ChunkOffsets, __global unsigned int* GroupSums, const unsigned int uiScanGroupSize,
+                                                                                    const unsigned int uiHeaderSize, __global unsigned int* Output)
+                                                        {
+                                                            unsigned int gid = get_global_id(0);
+
+                                                            if (gid >= uiNumPixels)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int chunk = gid / 32;
+                                                            unsigned int lane  = gid % 32;
+                                                            unsigned int mask  = Masks[chunk];
+
+                                                            if (mask == 0)
+                                                            {
+                                                                return;
+                                                            }
+
+                                                            unsigned int offset = uiHeaderSize + GroupSums[chunk / uiScanGroupSize] + ChunkOffsets[chunk];
+
+                                                            if (lane == 0)
+                                                            {
+                                                                Output[offset] = mask;
+                                                            }
+
+                                                            if (mask & (1u << lane))
+                                                            {
+                                                                unsigned int value = (uiKeyFrame) ? Current[gid] : Current[gid] ^ Previous[gid];
+
+                                                                Output[offset + 1 + popcount(mask & ((1u << lane) - 1))] = value;
+                                                            }
+                                                        };
+                                                    );
+
 
 RFEncoderIdentity::RFEncoderIdentity()
     : RFEncoder()
     , m_nBufferSize(0)
     , m_pBuffer(nullptr)
+    , m_bCompact(false)
+    , m_bHostCompact(false)
+    , m_bKeyFrame(true)
+    , m_uiPreviousBuffer(0)
+    , m_uiNumPixels(0)
+    , m_uiNumChunks(0)
+    , m_uiHeaderSize(0)
+    , m_uiOutputCapacity(0)
+    , m_uiReadbackSize(0)
+    , m_uiNumScanGroups(0)
+    , m_clMasks(NULL)
+    , m_clChunkSizes(NULL)
+    , m_clChunkOffsets(NULL)
+    , m_clGroupSums(NULL)
+    , m_uiNumTargetBuffers(0)
+    , m_uiCurrentTargetBuffer(0)
+    , m_pMappedBuffer(nullptr)
+    , m_CompactMaskskernel(NULL)
+    , m_CompactScankernel(NULL)
+    , m_CompactGroupskernel(NULL)
+    , m_CompactBitmapkernel(NULL)
+    , m_CompactWritekernel(NULL)
     , m_pContext(nullptr)
 {
     m_strEncoderName = "RF_ENCODER_IDENTITY";
 }
 
 
+RFEncoderIdentity::~RFEncoderIdentity()
+{
+    cl_kernel Kernels[] = { m_CompactMaskskernel, m_CompactScankernel, m_CompactGroupskernel, m_CompactBitmapkernel, m_CompactWritekernel };
+
+    for (cl_kernel clKernel : Kernels)
+    {
+        if (clKernel != NULL)
+        {
+            clReleaseKernel(clKernel);
+        }
+    }
+
+    m_CompactProgram.Release();
+
+    deleteBuffers();
+}
+
+
 RFStatus RFEncoderIdentity::init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig)
 {
     if (!pConfig)
@@ -53,6 +257,10 @@ RFStatus RFEncoderIdentity::init(const RFContextCL* pContextCL, const RFEncoderS
 
     m_pContext = pContextCL;
 
+    // Like RFEncoderDM at most getNumResultBuffers() - 1 compacted frames can be pending. The additional target
+    // buffer holds the frame that was returned by getEncodedFrame while the next frames are compacted.
+    m_uiNumTargetBuffers = m_pContext->getNumResultBuffers();
+
     m_format = pConfig->getInputFormat();
 
     if (!isFormatSupported(m_format))
@@ -83,7 +291,36 @@ RFStatus RFEncoderIdentity::init(const RFContextCL* pContextCL, const RFEncoderS
         return RF_STATUS_INVALID_FORMAT;
     }
 
-    return RF_STATUS_OK;
+    if (!pConfig->getParameterValue(RF_IDENTITY_ENCODER_COMPACT, m_bCompact))
+    {
+        m_bCompact = false;
+    }
+
+    if (!m_bCompact)
+    {
+        return RF_STATUS_OK;
+    }
+
+    // The compaction compares 32 bit pixels.
+    if (m_format == RF_NV12)
+    {
+        return RF_STATUS_INVALID_FORMAT;
+    }
+
+    // Frames of RF_CTX_CL contexts are converted on the CPU and are available in system memory.
+    m_bHostCompact = (m_pContext->getCtxType() == RFContextCL::RF_CTX_CL);
+
+    if (!createBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    if (m_bHostCompact)
+    {
+        return RF_STATUS_OK;
+    }
+
+    return GenerateCLProgramAndKernel();
 }
 
 
@@ -112,10 +349,204 @@ RFStatus RFEncoderIdentity::resize(unsigned int uiWidth, unsigned int uiHeight)
         return RF_STATUS_INVALID_FORMAT;
     }
 
+    if (m_bCompact)
+    {
+        // The first frame with the new dimension is a key frame.
+        if (!deleteBuffers() || !createBuffers())
+        {
+            return RF_STATUS_OPENCL_FAIL;
+        }
+    }
+
     return RF_STATUS_OK;
 }
 
 
+bool RFEncoderIdentity::createBuffers()
+{
+    // One target buffer is not pending since it holds the frame the application reads.
+    if (!m_ResultQueue.init(m_uiNumTargetBuffers - 1))
+    {
+        return false;
+    }
+
+    m_uiNumPixels     = m_uiWidth * m_uiHeight;
+    m_uiNumChunks     = (m_uiNumPixels + IDENTITY_COMPACT_CHUNK_SIZE - 1) / IDENTITY_COMPACT_CHUNK_SIZE;
+    m_uiNumScanGroups = (m_uiNumChunks + IDENTITY_COMPACT_GROUP_SIZE - 1) / IDENTITY_COMPACT_GROUP_SIZE;
+
+    // The header stores the size of the output, the key frame flag and one bit per chunk.
+    m_uiHeaderSize = 2 + (m_uiNumChunks + 31) / 32;
+
+    // In the worst case all pixels changed and each chunk stores its mask.
+    m_uiOutputCapacity = (m_uiHeaderSize + m_uiNumChunks + m_uiNumPixels) * sizeof(unsigned int);
+    m_uiReadbackSize   = min(m_uiOutputCapacity, static_cast<unsigned int>(m_uiHeaderSize * sizeof(unsigned int)) + IDENTITY_COMPACT_READBACK);
+
+    m_bKeyFrame = true;
+
+    if (m_bHostCompact)
+    {
+        for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+        {
+            IdentityCompactBuffer TargetBuffer;
+
+            TargetBuffer.clGPUBuffer        = NULL;
+            TargetBuffer.clPageLockedBuffer = NULL;
+            TargetBuffer.clDMAFinished      = NULL;
+            TargetBuffer.pSysmemBuffer      = new (nothrow) char[m_uiOutputCapacity];
+
+            if (!TargetBuffer.pSysmemBuffer)
+            {
+                return false;
+            }
+
+            m_TargetBuffers.push_back(TargetBuffer);
+        }
+
+        return true;
+    }
+
+    cl_int nStatus = CL_SUCCESS;
+
+    m_clMasks = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiNumChunks * sizeof(unsigned int), nullptr, &nStatus);
+    if (nStatus != CL_SUCCESS)
+    {
+        return false;
+    }
+
+    m_clChunkSizes = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiNumChunks * sizeof(unsigned int), nullptr, &nStatus);
+    if (nStatus != CL_SUCCESS)
+    {
+        return false;
+    }
+
+    m_clChunkOffsets = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiNumChunks * sizeof(unsigned int), nullptr, &nStatus);
+    if (nStatus != CL_SUCCESS)
+    {
+        return false;
+    }
+
+    m_clGroupSums = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiNumScanGroups * sizeof(unsigned int), nullptr, &nStatus);
+    if (nStatus != CL_SUCCESS)
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+    {
+        IdentityCompactBuffer TargetBuffer;
+
+        TargetBuffer.clGPUBuffer   = NULL;
+        TargetBuffer.pSysmemBuffer = nullptr;
+        TargetBuffer.clDMAFinished = NULL;
+
+        // Create pinned OpenCL buffers into which the compacted frames are transferred.
+        TargetBuffer.clPageLockedBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, m_uiOutputCapacity, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        TargetBuffer.pSysmemBuffer = static_cast<char*>(clEnqueueMapBuffer(m_pContext->getCmdQueue(), TargetBuffer.clPageLockedBuffer, CL_TRUE, CL_MAP_READ, 0, m_uiOutputCapacity,
+                                                                          0, nullptr, nullptr, &nStatus));
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        // Create buffer in GPU mem that will store the compacted frame.
+        TargetBuffer.clGPUBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, m_uiOutputCapacity, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        m_TargetBuffers.push_back(TargetBuffer);
+    }
+
+    return (nStatus == CL_SUCCESS);
+}
+
+
+bool RFEncoderIdentity::deleteBuffers()
+{
+    // Release events that are still in use.
+    while (m_ResultQueue.size() > 0)
+    {
+        const IdentityCompactBuffer* pElem = m_ResultQueue.pop();
+
+        if (pElem->clDMAFinished)
+        {
+            clReleaseEvent(pElem->clDMAFinished);
+        }
+    }
+
+    if (!m_pContext)
+    {
+        return false;
+    }
+
+    if (m_pContext->getCmdQueue())
+    {
+        clFinish(m_pContext->getCmdQueue());
+    }
+
+    if (m_pContext->getDMAQueue())
+    {
+        clFinish(m_pContext->getDMAQueue());
+    }
+
+    cl_int nStatus = CL_SUCCESS;
+
+    for (auto& tb : m_TargetBuffers)
+    {
+        if (!tb.clPageLockedBuffer)
+        {
+            // Buffer of a frame compacted on the host.
+            delete[] tb.pSysmemBuffer;
+            tb.pSysmemBuffer = nullptr;
+        }
+
+        if (tb.pSysmemBuffer)
+        {
+            nStatus |= clEnqueueUnmapMemObject(m_pContext->getCmdQueue(), tb.clPageLockedBuffer, tb.pSysmemBuffer, 0, nullptr, nullptr);
+            clFinish(m_pContext->getCmdQueue());
+
+            tb.pSysmemBuffer = nullptr;
+        }
+
+        if (tb.clPageLockedBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clPageLockedBuffer);
+            tb.clPageLockedBuffer = NULL;
+        }
+
+        if (tb.clGPUBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clGPUBuffer);
+            tb.clGPUBuffer = NULL;
+        }
+    }
+
+    m_TargetBuffers.clear();
+
+    m_uiCurrentTargetBuffer = 0;
+    m_pMappedBuffer         = nullptr;
+
+    cl_mem* pScratchBuffers[] = { &m_clMasks, &m_clChunkSizes, &m_clChunkOffsets, &m_clGroupSums };
+
+    for (cl_mem* pBuffer : pScratchBuffers)
+    {
+        if (*pBuffer)
+        {
+            nStatus |= clReleaseMemObject(*pBuffer);
+            *pBuffer = NULL;
+        }
+    }
+
+    return (nStatus == CL_SUCCESS);
+}
+
+
 bool RFEncoderIdentity::isFormatSupported(RFFormat format) const
 {
     if (format == RF_RGBA8 || format == RF_ARGB8 || format == RF_BGRA8 || format == RF_NV12)
@@ -129,11 +560,54 @@ bool RFEncoderIdentity::isFormatSupported(RFFormat format) const
 
 RFStatus RFEncoderIdentity::getEncodedFrame(unsigned int& uiSize, void* &pBitStream)
 {
-    if (m_pBuffer)
+    if (m_bCompact)
+    {
+        if (m_ResultQueue.size() == 0)
+        {
+            return RF_STATUS_NO_ENCODED_FRAME;
+        }
+
+        // The buffer is marked as mapped before it is removed from the queue, otherwise encode could select it
+        // while the application reads it.
+        const IdentityCompactBuffer* pEncodedBuffer = m_ResultQueue.front();
+
+        m_pMappedBuffer = pEncodedBuffer;
+
+        m_ResultQueue.pop();
+
+        // Wait until the header and the first changed chunks were transferred. Frames compacted on the host have no events.
+        if (pEncodedBuffer->clDMAFinished)
+        {
+            clWaitForEvents(1, &pEncodedBuffer->clDMAFinished);
+            clReleaseEvent(pEncodedBuffer->clDMAFinished);
+        }
+
+        uiSize = *reinterpret_cast<const unsigned int*>(pEncodedBuffer->pSysmemBuffer);
+
+        if (uiSize > m_uiReadbackSize && pEncodedBuffer->clGPUBuffer)
+        {
+            // Use the DMA queue if available since the command queue might already contain work of the next frames.
+            cl_command_queue clQueue = (m_pContext->getDMAQueue()) ? m_pContext->getDMAQueue() : m_pContext->getCmdQueue();
+            cl_event         clCopyFinished;
+
+            SAFE_CALL_CL(clEnqueueCopyBuffer(clQueue, pEncodedBuffer->clGPUBuffer, pEncodedBuffer->clPageLockedBuffer, m_uiReadbackSize, m_uiReadbackSize,
+                                             uiSize - m_uiReadbackSize, 0, nullptr, &clCopyFinished));
+
+            clWaitForEvents(1, &clCopyFinished);
+            clReleaseEvent(clCopyFinished);
+        }
+
+        pBitStream = pEncodedBuffer->pSysmemBuffer;
+
+        return RF_STATUS_OK;
+    }
+
+    void* pBuffer = m_pBuffer.exchange(nullptr);
+
+    if (pBuffer)
     {
         uiSize = static_cast<unsigned int>(m_nBufferSize);
-        pBitStream = m_pBuffer;
-        m_pBuffer = nullptr;
+        pBitStream = pBuffer;
     }
     else
     {
@@ -148,13 +622,239 @@ RFStatus RFEncoderIdentity::encode(unsigned int uiBufferIdx, bool bUseInputImage
 {
     assert(m_pContext);
 
-    m_pContext->getResultBuffer(uiBufferIdx, m_pBuffer);
+    if (m_bCompact)
+    {
+        IdentityCompactBuffer* pCurrentBuffer = &m_TargetBuffers[m_uiCurrentTargetBuffer];
+
+        // The frame returned by getEncodedFrame must not be overwritten while the application reads it, which
+        // can happen on another thread.
+        if (m_ResultQueue.size() >= m_ResultQueue.capacity() || pCurrentBuffer == m_pMappedBuffer)
+        {
+            return RF_STATUS_QUEUE_FULL;
+        }
+
+        if (m_bHostCompact)
+        {
+            void* pCurrent  = nullptr;
+            void* pPrevious = nullptr;
+
+            m_pContext->getResultBuffer(uiBufferIdx, pCurrent);
+
+            if (!m_bKeyFrame)
+            {
+                m_pContext->getResultBuffer(m_uiPreviousBuffer, pPrevious);
+            }
+
+            if (!pCurrent || (!m_bKeyFrame && !pPrevious))
+            {
+                RF_Error(RF_STATUS_INVALID_OPENCL_MEMOBJ, "Input pBuffer is invalid");
+                return RF_STATUS_INVALID_OPENCL_MEMOBJ;
+            }
+
+            compactFrame(static_cast<const unsigned int*>(pCurrent), static_cast<const unsigned int*>(pPrevious), reinterpret_cast<unsigned int*>(pCurrentBuffer->pSysmemBuffer));
 
-    if (!m_pBuffer)
+            pCurrentBuffer->clDMAFinished = NULL;
+        }
+        else
+        {
+            SAFE_CALL_RF(compactFrame(pCurrentBuffer, uiBufferIdx));
+        }
+
+        m_ResultQueue.push(pCurrentBuffer);
+
+        m_uiCurrentTargetBuffer = (m_uiCurrentTargetBuffer + 1) % m_uiNumTargetBuffers;
+        m_uiPreviousBuffer      = uiBufferIdx;
+        m_bKeyFrame             = false;
+
+        return RF_STATUS_OK;
+    }
+
+    void* pBuffer = nullptr;
+
+    m_pContext->getResultBuffer(uiBufferIdx, pBuffer);
+
+    if (!pBuffer)
     {
         RF_Error(RF_STATUS_INVALID_OPENCL_MEMOBJ, "Input pBuffer is invalid");
         return RF_STATUS_INVALID_OPENCL_MEMOBJ;
     }
 
+    m_pBuffer.store(pBuffer);
+
+    return RF_STATUS_OK;
+}
+
+
+RFParameterState RFEncoderIdentity::getParameter(const unsigned int uiParameterName, RFVideoCodec codec, RFProperties& value) const
+{
+    if (codec != RF_VIDEO_CODEC_NONE)
+    {
+        return RF_PARAMETER_STATE_INVALID;
+    }
+
+    value = 0;
+
+    if (uiParameterName == RF_IDENTITY_ENCODER_COMPACT)
+    {
+        value = m_bCompact;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+
+    return RF_PARAMETER_STATE_INVALID;
+}
+
+
+RFStatus RFEncoderIdentity::compactFrame(IdentityCompactBuffer* pBuffer, unsigned int uiBufferIdx)
+{
+    cl_mem clCurrent;
+    cl_mem clPrevious;
+
+    m_pContext->getResultBuffer(uiBufferIdx, &clCurrent);
+
+    // Key frames are not compared, the current frame is passed as a valid argument.
+    if (m_bKeyFrame)
+    {
+        clPrevious = clCurrent;
+    }
+    else
+    {
+        m_pContext->getResultBuffer(m_uiPreviousBuffer, &clPrevious);
+    }
+
+    const unsigned int uiKeyFrame      = (m_bKeyFrame) ? 1 : 0;
+    const unsigned int uiScanGroupSize = IDENTITY_COMPACT_GROUP_SIZE;
+    const unsigned int uiBitmapSize    = m_uiHeaderSize - 2;
+
+    const size_t localDim          = IDENTITY_COMPACT_GROUP_SIZE;
+    const size_t globalPixelDim    = ((m_uiNumPixels + localDim - 1) / localDim) * localDim;
+    const size_t globalScanDim     = m_uiNumScanGroups * localDim;
+    const size_t globalBitmapDim   = uiBitmapSize;
+    const size_t globalSingleDim   = 1;
+
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 0, sizeof(cl_mem),       &clCurrent));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 1, sizeof(cl_mem),       &clPrevious));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 2, sizeof(unsigned int), &uiKeyFrame));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 3, sizeof(unsigned int), &m_uiNumPixels));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 4, sizeof(cl_mem),       &m_clMasks));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 5, sizeof(cl_mem),       &m_clChunkSizes));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactMaskskernel, 6, (localDim / IDENTITY_COMPACT_CHUNK_SIZE) * sizeof(unsigned int), nullptr));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_CompactMaskskernel, 1, nullptr, &globalPixelDim, &localDim, 0, nullptr, nullptr));
+
+    SAFE_CALL_CL(clSetKernelArg(m_CompactScankernel, 0, sizeof(cl_mem),       &m_clChunkSizes));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactScankernel, 1, sizeof(unsigned int), &m_uiNumChunks));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactScankernel, 2, sizeof(cl_mem),       &m_clChunkOffsets));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactScankernel, 3, sizeof(cl_mem),       &m_clGroupSums));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactScankernel, 4, localDim * sizeof(unsigned int), nullptr));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_CompactScankernel, 1, nullptr, &globalScanDim, &localDim, 0, nullptr, nullptr));
+
+    SAFE_CALL_CL(clSetKernelArg(m_CompactGroupskernel, 0, sizeof(cl_mem),       &m_clGroupSums));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactGroupskernel, 1, sizeof(unsigned int), &m_uiNumScanGroups));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactGroupskernel, 2, sizeof(unsigned int), &m_uiHeaderSize));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactGroupskernel, 3, sizeof(unsigned int), &uiKeyFrame));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactGroupskernel, 4, sizeof(cl_mem),       &(pBuffer->clGPUBuffer)));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_CompactGroupskernel, 1, nullptr, &globalSingleDim, nullptr, 0, nullptr, nullptr));
+
+    SAFE_CALL_CL(clSetKernelArg(m_CompactBitmapkernel, 0, sizeof(cl_mem),       &m_clMasks));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactBitmapkernel, 1, sizeof(unsigned int), &m_uiNumChunks));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactBitmapkernel, 2, sizeof(cl_mem),       &(pBuffer->clGPUBuffer)));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_CompactBitmapkernel, 1, nullptr, &globalBitmapDim, nullptr, 0, nullptr, nullptr));
+
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 0, sizeof(cl_mem),       &clCurrent));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 1, sizeof(cl_mem),       &clPrevious));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 2, sizeof(unsigned int), &uiKeyFrame));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 3, sizeof(unsigned int), &m_uiNumPixels));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 4, sizeof(cl_mem),       &m_clMasks));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 5, sizeof(cl_mem),       &m_clChunkOffsets));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 6, sizeof(cl_mem),       &m_clGroupSums));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 7, sizeof(unsigned int), &uiScanGroupSize));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 8, sizeof(unsigned int), &m_uiHeaderSize));
+    SAFE_CALL_CL(clSetKernelArg(m_CompactWritekernel, 9, sizeof(cl_mem),       &(pBuffer->clGPUBuffer)));
+
+    SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), m_CompactWritekernel, 1, nullptr, &globalPixelDim, &localDim, 0, nullptr, nullptr));
+
+    // Only the header and the first changed chunks are transferred. getEncodedFrame copies the remainder if the output is larger.
+    SAFE_CALL_CL(clEnqueueCopyBuffer(m_pContext->getCmdQueue(), pBuffer->clGPUBuffer, pBuffer->clPageLockedBuffer, 0, 0, m_uiReadbackSize, 0, nullptr, &pBuffer->clDMAFinished));
+
+    clFlush(m_pContext->getCmdQueue());
+
     return RF_STATUS_OK;
-}
\ No newline at end of file
+}
+
+
+unsigned int RFEncoderIdentity::compactFrame(const unsigned int* pCurrent, const unsigned int* pPrevious, unsigned int* pOutput) const
+{
+    unsigned int* pBitmap = pOutput + 2;
+    unsigned int  uiSize  = m_uiHeaderSize;
+
+    memset(pBitmap, 0, (m_uiHeaderSize - 2) * sizeof(unsigned int));
+
+    for (unsigned int uiChunk = 0; uiChunk < m_uiNumChunks; ++uiChunk)
+    {
+        const unsigned int uiFirst = uiChunk * IDENTITY_COMPACT_CHUNK_SIZE;
+        const unsigned int uiLast  = min(uiFirst + IDENTITY_COMPACT_CHUNK_SIZE, m_uiNumPixels);
+
+        unsigned int* pMask = pOutput + uiSize;
+        unsigned int  uiMask = 0;
+        unsigned int  uiNumChanged = 0;
+
+        for (unsigned int i = uiFirst; i < uiLast; ++i)
+        {
+            const unsigned int uiValue = (pPrevious) ? pCurrent[i] ^ pPrevious[i] : pCurrent[i];
+
+            if (uiValue != 0)
+            {
+                uiMask |= 1u << (i - uiFirst);
+                pMask[1 + uiNumChanged++] = uiValue;
+            }
+        }
+
+        if (uiMask)
+        {
+            *pMask = uiMask;
+            pBitmap[uiChunk / 32] |= 1u << (uiChunk % 32);
+
+            uiSize += 1 + uiNumChanged;
+        }
+    }
+
+    pOutput[0] = uiSize * sizeof(unsigned int);
+    pOutput[1] = (pPrevious) ? 0 : 1;
+
+    return pOutput[0];
+}
+
+
+RFStatus RFEncoderIdentity::GenerateCLProgramAndKernel()
+{
+    assert(m_pContext);
+
+    m_CompactProgram.Create(m_pContext->getContext(), m_pContext->getDeviceId(), IDENTITY_KERNEL_NAME, str_cl_Identitykernels);
+
+    if (m_CompactProgram)
+    {
+        cl_int nStatus;
+        m_CompactMaskskernel = clCreateKernel(m_CompactProgram, "Compact_Masks", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_CompactScankernel = clCreateKernel(m_CompactProgram, "Compact_Scan", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_CompactGroupskernel = clCreateKernel(m_CompactProgram, "Compact_Groups", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_CompactBitmapkernel = clCreateKernel(m_CompactProgram, "Compact_Bitmap", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_CompactWritekernel = clCreateKernel(m_CompactProgram, "Compact_Write", &nStatus);
+        SAFE_CALL_CL(nStatus);
+
+        return RF_STATUS_OK;
+    }
+    else
+    {
+        RF_Error(RF_STATUS_OPENCL_FAIL, m_CompactProgram.GetBuildLog().c_str());
+    }
+
+    return RF_STATUS_OPENCL_FAIL;
+}
@@ -22,33 +22,123 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+
+#include <CL/opencl.h>
+
 #include "RFEncoder.h"
+#include "RFLock.h"
+#include "RFSpscQueue.h"
+
+// Number of pixels per chunk of the compacted output. Each changed chunk is stored as a mask of its changed pixels
+// followed by their values.
+#define IDENTITY_COMPACT_CHUNK_SIZE     32
+
+// Local size of the kernels that compact the frame and number of chunks processed by a work group of the prefix sum.
+#define IDENTITY_COMPACT_GROUP_SIZE     256
+
+// Number of bytes of changed chunks that are transferred together with the header. Larger outputs are completed
+// by getEncodedFrame.
+#define IDENTITY_COMPACT_READBACK       (256 * 1024)
 
 class RFEncoderIdentity : public RFEncoder
 {
 public:
 
     RFEncoderIdentity();
+    ~RFEncoderIdentity();
+
+    virtual RFStatus            init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig)                           override;
+
+    virtual RFStatus            resize(unsigned int uiWidth, unsigned int uiHeight)                                             override;
 
-    virtual RFStatus    init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig) override;
-                                                                                              
-    virtual RFStatus    resize(unsigned int uiWidth, unsigned int uiHeight)                   override;
-                                                                                              
-    virtual bool        isFormatSupported(RFFormat format) const                              override;
-                                                                                              
-    virtual RFStatus    encode(unsigned int uiBufferIdx, bool bUseInputImage)                 override;
-                                                                                              
-    virtual RFStatus    getEncodedFrame(unsigned int& uiSize, void* &pBitStream)              override;
+    virtual bool                isFormatSupported(RFFormat format) const                                                        override;
+
+    virtual RFStatus            encode(unsigned int uiBufferIdx, bool bUseInputImage)                                           override;
+
+    virtual RFStatus            getEncodedFrame(unsigned int& uiSize, void* &pBitStream)                                        override;
+
+    virtual RFParameterState    getParameter(unsigned int const uiParameterName, RFVideoCodec codec, RFProperties &value) const override;
 
     // Returns preferred format of the encoder.
-    virtual RFFormat    getPreferredFormat() const override { return RF_RGBA8; }
+    virtual RFFormat            getPreferredFormat() const override { return RF_RGBA8; }
 
-    virtual bool        isResizeSupported()  const override { return true; }
+    virtual bool                isResizeSupported()  const override { return true; }
 
 private:
 
-    size_t              m_nBufferSize;
-    void*               m_pBuffer;
+    struct IdentityCompactBuffer
+    {
+        cl_mem              clGPUBuffer;
+        cl_mem              clPageLockedBuffer;
+        char*               pSysmemBuffer;
+
+        cl_event            clDMAFinished;
+    };
+
+    bool                    deleteBuffers();
+    bool                    createBuffers();
+    RFStatus                GenerateCLProgramAndKernel();
+
+    // Enqueues the kernels that compact the result buffer uiBufferIdx into clGPUBuffer of pBuffer.
+    RFStatus                compactFrame(IdentityCompactBuffer* pBuffer, unsigned int uiBufferIdx);
+
+    // Compacts a frame in system memory on the CPU. pPrevious is nullptr for key frames. Returns the size of the output.
+    unsigned int            compactFrame(const unsigned int* pCurrent, const unsigned int* pPrevious, unsigned int* pOutput) const;
+
+    size_t                  m_nBufferSize;
+
+    // Result buffer of the last frame. Set by encode and taken by getEncodedFrame, which may run on another thread.
+    std::atomic<void*>      m_pBuffer;
+
+    // If true frames are XORed with the previous frame and only changed chunks are returned (RF_IDENTITY_ENCODER_COMPACT).
+    bool                    m_bCompact;
+
+    // If true frames of host memory contexts are compacted on the CPU.
+    bool                    m_bHostCompact;
+
+    // The next frame is XORed with a frame of zeros. Set after init and resize.
+    bool                    m_bKeyFrame;
+    unsigned int            m_uiPreviousBuffer;
+
+    // Number of pixels and chunks of the frame, number of words of the header including the chunk bitmap
+    // and the size of the output in the worst case.
+    unsigned int            m_uiNumPixels;
+    unsigned int            m_uiNumChunks;
+    unsigned int            m_uiHeaderSize;
+    unsigned int            m_uiOutputCapacity;
+
+    // Number of bytes transferred to the pinned buffer by encode.
+    unsigned int            m_uiReadbackSize;
+
+    // Scratch buffers of the compaction. They are shared by all target buffers since the kernels execute in order.
+    unsigned int            m_uiNumScanGroups;
+    cl_mem                  m_clMasks;
+    cl_mem                  m_clChunkSizes;
+    cl_mem                  m_clChunkOffsets;
+    cl_mem                  m_clGroupSums;
+
+    unsigned int            m_uiNumTargetBuffers;
+    unsigned int            m_uiCurrentTargetBuffer;
+
+    // Target buffer that was returned by the last call to getEncodedFrame. It stays valid until the next call
+    // since at most m_uiNumTargetBuffers - 1 frames are pending. Written by the thread that reads the frames.
+    std::atomic<const IdentityCompactBuffer*>   m_pMappedBuffer;
+
+    cl_kernel               m_CompactMaskskernel;
+    cl_kernel               m_CompactScankernel;
+    cl_kernel               m_CompactGroupskernel;
+    cl_kernel               m_CompactBitmapkernel;
+    cl_kernel               m_CompactWritekernel;
+    RFProgramCL             m_CompactProgram;
+
+    const RFContextCL*      m_pContext;
+
+    // vector of buffers into which the compacted frames are written.
+    std::vector<IdentityCompactBuffer>          m_TargetBuffers;
 
-    const RFContextCL*  m_pContext;
-};
\ No newline at end of file
+    // Queue that contains references to buffers that store a compacted frame which was not yet
+    // read by calling getEncodedFrame
+    RFSpscQueue<const IdentityCompactBuffer*>   m_ResultQueue;
+};
@@ -1268,6 +1268,159 @@ bool RFEncoderSettings::createParameterMap()
 
     m_ParameterMap[RF_DIFF_ENCODER_LOCK_BUFFER] = Entry;
 
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Fused CSC Diff Map";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_DIFF_ENCODER_FUSED_CSC] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Host Diff Map";
+    Entry.Value.bValue                            =  true;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  true;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  true;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  true;
+
+    m_ParameterMap[RF_DIFF_ENCODER_HOST_DIFF] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Diff Map Pyramid";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_DIFF_ENCODER_PYRAMID] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Diff Map Output Mode";
+    Entry.Value.uiValue                           =  RF_DIFF_MAP_BYTES;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  RF_DIFF_MAP_BYTES;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  RF_DIFF_MAP_BYTES;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  RF_DIFF_MAP_BYTES;
+
+    m_ParameterMap[RF_DIFF_ENCODER_OUTPUT_MODE] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Tile Cache Slots";
+    Entry.Value.uiValue                           =  4096;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  4096;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  4096;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  4096;
+
+    m_ParameterMap[RF_TILE_CACHE_SLOTS] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Scroll Detection";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_DIFF_ENCODER_SCROLL_DETECT] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Diff Map Threshold";
+    Entry.Value.uiValue                           =  0;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  0;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  0;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  0;
+
+    m_ParameterMap[RF_DIFF_ENCODER_THRESHOLD] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Diff Map Magnitude";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_DIFF_ENCODER_MAGNITUDE] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Diff Map Queue Timeout";
+    Entry.Value.uiValue                           =  DEFAULT_DIFF_MAP_QUEUE_TIMEOUT;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  DEFAULT_DIFF_MAP_QUEUE_TIMEOUT;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  DEFAULT_DIFF_MAP_QUEUE_TIMEOUT;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  DEFAULT_DIFF_MAP_QUEUE_TIMEOUT;
+
+    m_ParameterMap[RF_DIFF_ENCODER_QUEUE_TIMEOUT] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Diff Map Buffers";
+    Entry.Value.uiValue                           =  0;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  0;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  0;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  0;
+
+    m_ParameterMap[RF_DIFF_ENCODER_NUM_BUFFERS] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Identity Compact";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_IDENTITY_ENCODER_COMPACT] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Output Compression";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_OUTPUT_COMPRESSION] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Output Compression Chunk Size";
+    Entry.Value.uiValue                           =  262144;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  262144;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  262144;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  262144;
+
+    m_ParameterMap[RF_OUTPUT_COMPRESSION_CHUNK_SIZE] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Output Compression Threads";
+    Entry.Value.uiValue                           =  0;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  0;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  0;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  0;
+
+    m_ParameterMap[RF_OUTPUT_COMPRESSION_THREADS] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_UINT;
+    Entry.strParameterName                        = "Diff Map Periodic History";
+    Entry.Value.uiValue                           =  0;
+    Entry.PresetValue[RF_PRESET_FAST].uiValue     =  0;
+    Entry.PresetValue[RF_PRESET_BALANCED].uiValue =  0;
+    Entry.PresetValue[RF_PRESET_QUALITY].uiValue  =  0;
+
+    m_ParameterMap[RF_DIFF_ENCODER_PERIODIC_HISTORY] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Diff Map GPU Output";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_DIFF_ENCODER_GPU_OUTPUT] = Entry;
+
+    Entry.EntryType                               = RF_PARAMETER_BOOL;
+    Entry.strParameterName                        = "Diff Map NV12 Chroma";
+    Entry.Value.bValue                            =  false;
+    Entry.PresetValue[RF_PRESET_FAST].bValue      =  false;
+    Entry.PresetValue[RF_PRESET_BALANCED].bValue  =  false;
+    Entry.PresetValue[RF_PRESET_QUALITY].bValue   =  false;
+
+    m_ParameterMap[RF_DIFF_ENCODER_NV12_CHROMA] = Entry;
+
     // Store all names in m_ParameterNames.
     map<unsigned int, MapEntry>::const_iterator itr;
 
@@ -0,0 +1,680 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFEncoderTC.h"
+
+#include <assert.h>
+#include <string.h>
+
+#include "RFContext.h"
+#include "RFEncoderSettings.h"
+#include "RFError.h"
+
+using namespace std;
+
+#define TILE_CACHE_KERNEL_NAME "rfTileCacheKernel.cl"
+
+#define MULTI_LINE_STR(a) #a
+
+const char* str_cl_TileCachekernels = MULTI_LINE_STR(   __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+
+                                                        // Finalizes the hash of a tile. The FNV-1a steps only mix the lower bits into the upper bits.
+                                                        ulong TileCache_Finalize(ulong hash)
+                                                        {
+                                                            hash ^= hash >> 33;
+                                                            hash *= 0xff51afd7ed558ccdUL;
+                                                            hash ^= hash >> 33;
+                                                            hash *= 0xc4ceb9fe1a85ec53UL;
+                                                            hash ^= hash >> 33;
+
+                                                            return hash;
+                                                        }
+
+
+                                                        // Computes a 64 bit hash of each block of uiBlockWidth x uiBlockHeight pixels. Each work item processes one block.
+                                                        // The hash is seeded with the size of the block such that clipped blocks at the borders do not match full blocks.
+                                                        __kernel void TileCache_HashBuffer(__global unsigned int* Image, __global ulong* Hashes, const unsigned int uiWidth, const unsigned int uiHeight,
+                                                                                           const unsigned int uiBlockWidth, const unsigned int uiBlockHeight)
+                                                        {
+                                                            unsigned int bx = get_global_id(0);
+                                                            unsigned int by = get_global_id(1);
+
+                                                            unsigned int x0 = bx * uiBlockWidth;
+                                                            unsigned int y0 = by * uiBlockHeight;
+                                                            unsigned int x1 = min(x0 + uiBlockWidth, uiWidth);
+                                                            unsigned int y1 = min(y0 + uiBlockHeight, uiHeight);
+
+                                                            ulong hash = 14695981039346656037UL ^ (((ulong)(x1 - x0) << 32) | (y1 - y0));
+
+                                                            for (unsigned int y = y0; y < y1; ++y)
+                                                            {
+                                                                for (unsigned int x = x0; x < x1; ++x)
+                                                                {
+                                                                    hash = (hash ^ Image[y * uiWidth + x]) * 1099511628211UL;
+                                                                }
+                                                            }
+
+                                                            Hashes[by * get_global_size(0) + bx] = TileCache_Finalize(hash);
+                                                        };
+
+
+                                                        // Same as TileCache_HashBuffer for an RGBA8 image. The pixels are packed into the byte order of the buffer.
+                                                        __kernel void TileCache_HashImage(__read_only image2d_t Image, __global ulong* Hashes, const unsigned int uiWidth, const unsigned int uiHeight,
+                                                                                          const unsigned int uiBlockWidth, const unsigned int uiBlockHeight)
+                                                        {
+                                                            unsigned int bx = get_global_id(0);
+                                                            unsigned int by = get_global_id(1);
+
+                                                            unsigned int x0 = bx * uiBlockWidth;
+                                                            unsigned int y0 = by * uiBlockHeight;
+                                                            unsigned int x1 = min(x0 + uiBlockWidth, uiWidth);
+                                                            unsigned int y1 = min(y0 + uiBlockHeight, uiHeight);
+
+                                                            ulong hash = 14695981039346656037UL ^ (((ulong)(x1 - x0) << 32) | (y1 - y0));
+
+                                                            for (unsigned int y = y0; y < y1; ++y)
+                                                            {
+                                                                for (unsigned int x = x0; x < x1; ++x)
+                                                                {
+                                                                    uint4 c = convert_uint4(read_imagef(Image, sampler, (int2)(x, y)) * 255.0f + 0.5f);
+
+                                                                    hash = (hash ^ (c.x | (c.y << 8) | (c.z << 16) | (c.w << 24))) * 1099511628211UL;
+                                                                }
+                                                            }
+
+                                                            Hashes[by * get_global_size(0) + bx] = TileCache_Finalize(hash);
+                                                        };
+                                                    );
+
+
+// Host implementation of TileCache_HashBuffer.
+static uint64_t hashTile(const unsigned char* pImage, unsigned int uiPitch, unsigned int uiTileWidth, unsigned int uiTileHeight)
+{
+    uint64_t uiHash = 14695981039346656037ULL ^ ((static_cast<uint64_t>(uiTileWidth) << 32) | uiTileHeight);
+
+    for (unsigned int y = 0; y < uiTileHeight; ++y)
+    {
+        const unsigned char* pRow = pImage + static_cast<size_t>(y) * uiPitch;
+
+        for (unsigned int x = 0; x < uiTileWidth; ++x)
+        {
+            uint32_t uiPixel;
+
+            memcpy(&uiPixel, pRow + x * 4, sizeof(uiPixel));
+
+            uiHash = (uiHash ^ uiPixel) * 1099511628211ULL;
+        }
+    }
+
+    uiHash ^= uiHash >> 33;
+    uiHash *= 0xff51afd7ed558ccdULL;
+    uiHash ^= uiHash >> 33;
+    uiHash *= 0xc4ceb9fe1a85ec53ULL;
+    uiHash ^= uiHash >> 33;
+
+    return uiHash;
+}
+
+
+RFEncoderTC::RFEncoderTC()
+    : RFEncoder()
+    , m_bHostHashes(false)
+    , m_uiNumBlocks(0)
+    , m_uiNumTargetBuffers(0)
+    , m_uiCurrentTargetBuffer(0)
+    , m_bPreviousHashesValid(false)
+    , m_uiNumSlots(0)
+    , m_pOutput(nullptr)
+    , m_uiOutputCapacity(0)
+    , m_HashImagekernel(NULL)
+    , m_HashBufferkernel(NULL)
+    , m_pContext(nullptr)
+{
+    m_uiTotalBlockSize[0] = 16;
+    m_uiTotalBlockSize[1] = 16;
+
+    m_strEncoderName = "RF_ENCODER_TILE_CACHE";
+}
+
+
+RFEncoderTC::~RFEncoderTC()
+{
+    if (m_HashImagekernel != NULL)
+    {
+        clReleaseKernel(m_HashImagekernel);
+    }
+
+    if (m_HashBufferkernel != NULL)
+    {
+        clReleaseKernel(m_HashBufferkernel);
+    }
+
+    m_TileCacheProgram.Release();
+
+    deleteBuffers();
+}
+
+
+bool RFEncoderTC::isFormatSupported(RFFormat format) const
+{
+    return (format == RF_RGBA8 || format == RF_ARGB8 || format == RF_BGRA8);
+}
+
+
+RFStatus RFEncoderTC::init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig)
+{
+    if (!pConfig)
+    {
+        return RF_STATUS_INVALID_CONFIG;
+    }
+
+    if (!pContextCL)
+    {
+        return RF_STATUS_INVALID_OPENCL_CONTEXT;
+    }
+
+    m_pContext = pContextCL;
+
+    // Each result buffer of the session can have one pending target buffer.
+    m_uiNumTargetBuffers = m_pContext->getNumResultBuffers();
+
+    m_format = pConfig->getInputFormat();
+
+    if (!isFormatSupported(m_format))
+    {
+        return RF_STATUS_INVALID_FORMAT;
+    }
+
+    // The tile cache uses the same blocks as the difference encoder.
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_BLOCK_S, m_uiTotalBlockSize[0]))
+    {
+        m_uiTotalBlockSize[0] = 16;
+    }
+
+    if (!pConfig->getParameterValue(RF_DIFF_ENCODER_BLOCK_T, m_uiTotalBlockSize[1]))
+    {
+        m_uiTotalBlockSize[1] = 16;
+    }
+
+    if (!pConfig->getParameterValue(RF_TILE_CACHE_SLOTS, m_uiNumSlots))
+    {
+        m_uiNumSlots = 4096;
+    }
+
+    if ((m_uiTotalBlockSize[0] % 8) || (m_uiTotalBlockSize[1] % 8) || (m_uiTotalBlockSize[0] * m_uiTotalBlockSize[1] == 0) || m_uiNumSlots == 0)
+    {
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    // Frames of RF_CTX_CL contexts are converted on the CPU and are available in system memory.
+    m_bHostHashes = (m_pContext->getCtxType() == RFContextCL::RF_CTX_CL);
+
+    m_uiWidth  = pConfig->getEncoderWidth();
+    m_uiHeight = pConfig->getEncoderHeight();
+
+    m_uiAlignedWidth  = m_uiWidth;
+    m_uiAlignedHeight = m_uiHeight;
+
+    m_TileCache.reset(m_uiNumSlots);
+
+    if (!createBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    if (m_bHostHashes)
+    {
+        return RF_STATUS_OK;
+    }
+
+    return GenerateCLProgramAndKernel();
+}
+
+
+RFStatus RFEncoderTC::resize(unsigned int uiWidth, unsigned int uiHeight)
+{
+    if (!deleteBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    m_uiWidth  = uiWidth;
+    m_uiHeight = uiHeight;
+
+    m_uiAlignedWidth  = m_uiWidth;
+    m_uiAlignedHeight = m_uiHeight;
+
+    // The tiles stored by the client remain valid, only the blocks of the new frame have to be sent.
+    if (!createBuffers())
+    {
+        return RF_STATUS_OPENCL_FAIL;
+    }
+
+    return RF_STATUS_OK;
+}
+
+
+bool RFEncoderTC::createBuffers()
+{
+    // Each target buffer can be pending once.
+    if (!m_ResultQueue.init(m_uiNumTargetBuffers))
+    {
+        return false;
+    }
+
+    m_uiOutputWidth  = (m_uiWidth + m_uiTotalBlockSize[0] - 1) / m_uiTotalBlockSize[0];
+    m_uiOutputHeight = (m_uiHeight + m_uiTotalBlockSize[1] - 1) / m_uiTotalBlockSize[1];
+
+    m_uiNumBlocks = m_uiOutputWidth * m_uiOutputHeight;
+
+    m_PreviousHashes.assign(m_uiNumBlocks, 0);
+    m_bPreviousHashesValid = false;
+
+    // In the worst case all blocks changed and none of them is cached.
+    const size_t uiTileSize = m_uiTotalBlockSize[0] * m_uiTotalBlockSize[1] * 4;
+
+    m_uiOutputCapacity = sizeof(unsigned int) + m_uiNumBlocks * (sizeof(RFTileCacheEntry) + uiTileSize);
+
+    m_pOutput = new (nothrow) char[m_uiOutputCapacity];
+
+    if (!m_pOutput)
+    {
+        return false;
+    }
+
+    const size_t uiHashSize = m_uiNumBlocks * sizeof(uint64_t);
+
+    if (m_bHostHashes)
+    {
+        for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+        {
+            TCHashBuffer TargetBuffer;
+
+            TargetBuffer.clGPUBuffer        = NULL;
+            TargetBuffer.clPageLockedBuffer = NULL;
+            TargetBuffer.clHashFinished     = NULL;
+            TargetBuffer.uiResultBuffer     = 0;
+            TargetBuffer.pHashes            = new (nothrow) uint64_t[m_uiNumBlocks];
+
+            if (!TargetBuffer.pHashes)
+            {
+                return false;
+            }
+
+            m_TargetBuffers.push_back(TargetBuffer);
+        }
+
+        return true;
+    }
+
+    cl_int nStatus = CL_SUCCESS;
+
+    for (unsigned int i = 0; i < m_uiNumTargetBuffers; ++i)
+    {
+        TCHashBuffer TargetBuffer;
+
+        TargetBuffer.clGPUBuffer    = NULL;
+        TargetBuffer.pHashes        = nullptr;
+        TargetBuffer.clHashFinished = NULL;
+        TargetBuffer.uiResultBuffer = 0;
+
+        // Create pinned OpenCL buffers into which the hashes are transferred.
+        TargetBuffer.clPageLockedBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_WRITE_ONLY | CL_MEM_ALLOC_HOST_PTR, uiHashSize, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        TargetBuffer.pHashes = static_cast<uint64_t*>(clEnqueueMapBuffer(m_pContext->getCmdQueue(), TargetBuffer.clPageLockedBuffer, CL_TRUE, CL_MAP_READ, 0, uiHashSize,
+                                                                         0, nullptr, nullptr, &nStatus));
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        // Create buffer in GPU mem that will store the hashes computed by the kernel.
+        TargetBuffer.clGPUBuffer = clCreateBuffer(m_pContext->getContext(), CL_MEM_READ_WRITE, uiHashSize, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            break;
+        }
+
+        m_TargetBuffers.push_back(TargetBuffer);
+    }
+
+    return (nStatus == CL_SUCCESS);
+}
+
+
+bool RFEncoderTC::deleteBuffers()
+{
+    // Release events that are still in use.
+    while (m_ResultQueue.size() > 0)
+    {
+        const TCHashBuffer* pElem = m_ResultQueue.pop();
+
+        if (pElem->clHashFinished)
+        {
+            clReleaseEvent(pElem->clHashFinished);
+        }
+    }
+
+    delete[] m_pOutput;
+    m_pOutput = nullptr;
+
+    if (!m_pContext)
+    {
+        return false;
+    }
+
+    if (m_pContext->getCmdQueue())
+    {
+        clFinish(m_pContext->getCmdQueue());
+    }
+
+    cl_int nStatus = CL_SUCCESS;
+
+    for (auto& tb : m_TargetBuffers)
+    {
+        if (!tb.clPageLockedBuffer)
+        {
+            // Hashes computed on the host.
+            delete[] tb.pHashes;
+            tb.pHashes = nullptr;
+        }
+
+        if (tb.pHashes)
+        {
+            nStatus |= clEnqueueUnmapMemObject(m_pContext->getCmdQueue(), tb.clPageLockedBuffer, tb.pHashes, 0, nullptr, nullptr);
+            clFinish(m_pContext->getCmdQueue());
+
+            tb.pHashes = nullptr;
+        }
+
+        if (tb.clPageLockedBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clPageLockedBuffer);
+            tb.clPageLockedBuffer = NULL;
+        }
+
+        if (tb.clGPUBuffer)
+        {
+            nStatus |= clReleaseMemObject(tb.clGPUBuffer);
+            tb.clGPUBuffer = NULL;
+        }
+    }
+
+    m_TargetBuffers.clear();
+
+    m_uiCurrentTargetBuffer = 0;
+
+    return (nStatus == CL_SUCCESS);
+}
+
+
+RFStatus RFEncoderTC::encode(unsigned int uiBufferIdx, bool bUseInputImages)
+{
+    if (m_ResultQueue.size() >= m_uiNumTargetBuffers)
+    {
+        return RF_STATUS_QUEUE_FULL;
+    }
+
+    TCHashBuffer* pCurrentBuffer = &m_TargetBuffers[m_uiCurrentTargetBuffer];
+
+    pCurrentBuffer->uiResultBuffer = uiBufferIdx;
+
+    if (m_bHostHashes)
+    {
+        void* pImage = nullptr;
+
+        m_pContext->getResultBuffer(uiBufferIdx, pImage);
+
+        if (!pImage)
+        {
+            RF_Error(RF_STATUS_INVALID_OPENCL_MEMOBJ, "Input pBuffer is invalid");
+            return RF_STATUS_INVALID_OPENCL_MEMOBJ;
+        }
+
+        computeHashes(static_cast<const unsigned char*>(pImage), pCurrentBuffer->pHashes);
+
+        pCurrentBuffer->clHashFinished = NULL;
+    }
+    else
+    {
+        cl_mem      clImage;
+        cl_kernel   hashKernel;
+
+        if (bUseInputImages)
+        {
+            m_pContext->getInputImage(uiBufferIdx, &clImage);
+            hashKernel = m_HashImagekernel;
+        }
+        else
+        {
+            m_pContext->getResultBuffer(uiBufferIdx, &clImage);
+            hashKernel = m_HashBufferkernel;
+        }
+
+        size_t globalDim[2] = { m_uiOutputWidth, m_uiOutputHeight };
+
+        SAFE_CALL_CL(clSetKernelArg(hashKernel, 0, sizeof(cl_mem),       &clImage));
+        SAFE_CALL_CL(clSetKernelArg(hashKernel, 1, sizeof(cl_mem),       &(pCurrentBuffer->clGPUBuffer)));
+        SAFE_CALL_CL(clSetKernelArg(hashKernel, 2, sizeof(unsigned int), &m_uiWidth));
+        SAFE_CALL_CL(clSetKernelArg(hashKernel, 3, sizeof(unsigned int), &m_uiHeight));
+        SAFE_CALL_CL(clSetKernelArg(hashKernel, 4, sizeof(unsigned int), &m_uiTotalBlockSize[0]));
+        SAFE_CALL_CL(clSetKernelArg(hashKernel, 5, sizeof(unsigned int), &m_uiTotalBlockSize[1]));
+
+        SAFE_CALL_CL(clEnqueueNDRangeKernel(m_pContext->getCmdQueue(), hashKernel, 2, nullptr, globalDim, nullptr, 0, nullptr, nullptr));
+        SAFE_CALL_CL(clEnqueueCopyBuffer(m_pContext->getCmdQueue(), pCurrentBuffer->clGPUBuffer, pCurrentBuffer->clPageLockedBuffer, 0, 0, m_uiNumBlocks * sizeof(uint64_t),
+                                         0, nullptr, &pCurrentBuffer->clHashFinished));
+
+        clFlush(m_pContext->getCmdQueue());
+
+        if (bUseInputImages)
+        {
+            const_cast<RFContextCL*>(m_pContext)->releaseCLMemObj(m_pContext->getDMAQueue(), uiBufferIdx, 1, &(pCurrentBuffer->clHashFinished));
+        }
+    }
+
+    m_ResultQueue.push(pCurrentBuffer);
+
+    m_uiCurrentTargetBuffer = (m_uiCurrentTargetBuffer + 1) % m_uiNumTargetBuffers;
+
+    return RF_STATUS_OK;
+}
+
+
+RFStatus RFEncoderTC::getEncodedFrame(unsigned int& uiSize, void* &pBitStream)
+{
+    if (m_ResultQueue.size() == 0)
+    {
+        return RF_STATUS_NO_ENCODED_FRAME;
+    }
+
+    const TCHashBuffer* pEncodedBuffer = m_ResultQueue.pop();
+
+    if (pEncodedBuffer->clHashFinished)
+    {
+        clWaitForEvents(1, &pEncodedBuffer->clHashFinished);
+        clReleaseEvent(pEncodedBuffer->clHashFinished);
+    }
+
+    // The pixels of new tiles are taken from the copy of the frame in system memory.
+    void* pImage = nullptr;
+
+    m_pContext->getResultBuffer(pEncodedBuffer->uiResultBuffer, pImage);
+
+    if (!pImage || !m_pOutput)
+    {
+        return RF_STATUS_NO_ENCODED_FRAME;
+    }
+
+    uiSize     = buildOutput(pEncodedBuffer->pHashes, static_cast<const unsigned char*>(pImage));
+    pBitStream = m_pOutput;
+
+    return RF_STATUS_OK;
+}
+
+
+RFParameterState RFEncoderTC::getParameter(const unsigned int uiParameterName, RFVideoCodec codec, RFProperties& value) const
+{
+    if (codec != RF_VIDEO_CODEC_NONE)
+    {
+        return RF_PARAMETER_STATE_INVALID;
+    }
+
+    value = 0;
+
+    if (uiParameterName == RF_DIFF_ENCODER_BLOCK_S)
+    {
+        value = m_uiTotalBlockSize[0];
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_DIFF_ENCODER_BLOCK_T)
+    {
+        value = m_uiTotalBlockSize[1];
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+    else if (uiParameterName == RF_TILE_CACHE_SLOTS)
+    {
+        value = m_uiNumSlots;
+
+        return RF_PARAMETER_STATE_BLOCKED;
+    }
+
+    return RF_PARAMETER_STATE_INVALID;
+}
+
+
+RFStatus RFEncoderTC::GenerateCLProgramAndKernel()
+{
+    assert(m_pContext);
+
+    m_TileCacheProgram.Create(m_pContext->getContext(), m_pContext->getDeviceId(), TILE_CACHE_KERNEL_NAME, str_cl_TileCachekernels);
+
+    if (m_TileCacheProgram)
+    {
+        cl_int nStatus;
+        m_HashImagekernel = clCreateKernel(m_TileCacheProgram, "TileCache_HashImage", &nStatus);
+        SAFE_CALL_CL(nStatus);
+        m_HashBufferkernel = clCreateKernel(m_TileCacheProgram, "TileCache_HashBuffer", &nStatus);
+        SAFE_CALL_CL(nStatus);
+
+        return RF_STATUS_OK;
+    }
+    else
+    {
+        RF_Error(RF_STATUS_OPENCL_FAIL, m_TileCacheProgram.GetBuildLog().c_str());
+    }
+
+    return RF_STATUS_OPENCL_FAIL;
+}
+
+
+void RFEncoderTC::computeHashes(const unsigned char* pImage, uint64_t* pHashes)
+{
+    const unsigned int uiWidth       = m_uiWidth;
+    const unsigned int uiHeight      = m_uiHeight;
+    const unsigned int uiBlockWidth  = m_uiTotalBlockSize[0];
+    const unsigned int uiBlockHeight = m_uiTotalBlockSize[1];
+    const unsigned int uiMapWidth    = m_uiOutputWidth;
+    const unsigned int uiPitch       = m_uiWidth * 4;
+
+    m_ThreadPool.run(m_uiOutputHeight, 1, [=](unsigned int uiBegin, unsigned int uiEnd)
+    {
+        for (unsigned int by = uiBegin; by < uiEnd; ++by)
+        {
+            const unsigned int y0 = by * uiBlockHeight;
+            const unsigned int h  = (y0 + uiBlockHeight < uiHeight) ? uiBlockHeight : uiHeight - y0;
+
+            for (unsigned int bx = 0; bx < uiMapWidth; ++bx)
+            {
+                const unsigned int x0 = bx * uiBlockWidth;
+                const unsigned int w  = (x0 + uiBlockWidth < uiWidth) ? uiBlockWidth : uiWidth - x0;
+
+                pHashes[by * uiMapWidth + bx] = hashTile(pImage + static_cast<size_t>(y0) * uiPitch + x0 * 4, uiPitch, w, h);
+            }
+        }
+    });
+}
+
+
+unsigned int RFEncoderTC::buildOutput(const uint64_t* pHashes, const unsigned char* pImage)
+{
+    const unsigned int uiPitch    = m_uiWidth * 4;
+    const unsigned int uiTileSize = m_uiTotalBlockSize[0] * m_uiTotalBlockSize[1] * 4;
+
+    RFTileCacheEntry* pEntries     = reinterpret_cast<RFTileCacheEntry*>(m_pOutput + sizeof(unsigned int));
+    unsigned int      uiNumEntries = 0;
+
+    for (unsigned int i = 0; i < m_uiNumBlocks; ++i)
+    {
+        if (m_bPreviousHashesValid && pHashes[i] == m_PreviousHashes[i])
+        {
+            continue;
+        }
+
+        RFTileCacheEntry& Entry = pEntries[uiNumEntries++];
+
+        Entry.uiX   = i % m_uiOutputWidth;
+        Entry.uiY   = i / m_uiOutputWidth;
+        Entry.uiHit = (m_TileCache.lookup(pHashes[i], Entry.uiSlot)) ? 1 : 0;
+    }
+
+    memcpy(m_pOutput, &uiNumEntries, sizeof(uiNumEntries));
+
+    // Append the pixels of the tiles that are not stored by the client. Pixels outside of the frame are 0.
+    char* pTile = reinterpret_cast<char*>(pEntries + uiNumEntries);
+
+    for (unsigned int i = 0; i < uiNumEntries; ++i)
+    {
+        if (pEntries[i].uiHit)
+        {
+            continue;
+        }
+
+        const unsigned int x0 = pEntries[i].uiX * m_uiTotalBlockSize[0];
+        const unsigned int y0 = pEntries[i].uiY * m_uiTotalBlockSize[1];
+        const unsigned int w  = (x0 + m_uiTotalBlockSize[0] < m_uiWidth)  ? m_uiTotalBlockSize[0] : m_uiWidth - x0;
+        const unsigned int h  = (y0 + m_uiTotalBlockSize[1] < m_uiHeight) ? m_uiTotalBlockSize[1] : m_uiHeight - y0;
+
+        if (w < m_uiTotalBlockSize[0] || h < m_uiTotalBlockSize[1])
+        {
+            memset(pTile, 0, uiTileSize);
+        }
+
+        for (unsigned int y = 0; y < h; ++y)
+        {
+            memcpy(pTile + y * m_uiTotalBlockSize[0] * 4, pImage + static_cast<size_t>(y0 + y) * uiPitch + x0 * 4, w * 4);
+        }
+
+        pTile += uiTileSize;
+    }
+
+    memcpy(m_PreviousHashes.data(), pHashes, m_uiNumBlocks * sizeof(uint64_t));
+    m_bPreviousHashesValid = true;
+
+    return static_cast<unsigned int>(pTile - m_pOutput);
+}
@@ -0,0 +1,125 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <CL/opencl.h>
+
+#include "RFEncoder.h"
+#include "RFLock.h"
+#include "RFSpscQueue.h"
+#include "RFThreadPool.h"
+#include "RFTileCache.h"
+
+// RFEncoderTC splits the frame into the blocks of the difference encoder and computes a 64 bit content hash per
+// block. Blocks whose hash differs from the previous frame are looked up in a tile cache that mirrors the tiles
+// stored by the client. For each changed block the output contains either the slot of the cached tile or the
+// pixels of the tile together with the slot in which the client has to store it.
+class RFEncoderTC : public RFEncoder
+{
+public:
+
+    RFEncoderTC();
+    ~RFEncoderTC();
+
+    virtual RFStatus            init(const RFContextCL* pContextCL, const RFEncoderSettings* pConfig)                           override;
+
+    virtual RFStatus            resize(unsigned int uiWidth, unsigned int uiHeight)                                             override;
+
+    virtual RFStatus            encode(unsigned int uiBufferIdx, bool bUseInputImages)                                          override;
+
+    virtual RFStatus            getEncodedFrame(unsigned int& uiSize, void* &pBitStream)                                        override;
+
+    virtual bool                isFormatSupported(RFFormat format) const                                                        override;
+
+    virtual RFParameterState    getParameter(unsigned int const uiParameterName, RFVideoCodec codec, RFProperties &value) const override;
+
+    // Returns preferred format of the encoder.
+    virtual RFFormat            getPreferredFormat() const override { return RF_RGBA8; }
+
+    virtual RFVideoCodec        getPreferredVideoCodec() const override { return RF_VIDEO_CODEC_NONE; }
+
+    virtual bool                isResizeSupported()  const override { return true; }
+
+private:
+
+    struct TCHashBuffer
+    {
+        cl_mem              clGPUBuffer;
+        cl_mem              clPageLockedBuffer;
+        uint64_t*           pHashes;
+
+        // Result buffer of the context that contains the pixels of the frame.
+        unsigned int        uiResultBuffer;
+
+        cl_event            clHashFinished;
+    };
+
+    bool                      deleteBuffers();
+    bool                      createBuffers();
+    RFStatus                  GenerateCLProgramAndKernel();
+
+    // Computes the block hashes of a frame in system memory on the CPU.
+    void                      computeHashes(const unsigned char* pImage, uint64_t* pHashes);
+
+    // Writes the entries of all changed blocks and the pixels of the new tiles to m_pOutput. Returns the size of the output.
+    unsigned int              buildOutput(const uint64_t* pHashes, const unsigned char* pImage);
+
+    // If true the hashes of host memory frames are computed on the CPU.
+    bool                                        m_bHostHashes;
+
+    unsigned int                                m_uiTotalBlockSize[2];
+    unsigned int                                m_uiNumBlocks;
+
+    unsigned int                                m_uiNumTargetBuffers;
+    unsigned int                                m_uiCurrentTargetBuffer;
+
+    // Hashes of the previously encoded frame. Only blocks with a different hash are sent.
+    std::vector<uint64_t>                       m_PreviousHashes;
+    bool                                        m_bPreviousHashesValid;
+
+    RFTileCache                                 m_TileCache;
+    unsigned int                                m_uiNumSlots;
+
+    // Output of the last call to getEncodedFrame. It stays valid until the next call.
+    char*                                       m_pOutput;
+    size_t                                      m_uiOutputCapacity;
+
+    cl_kernel                                   m_HashImagekernel;
+    cl_kernel                                   m_HashBufferkernel;
+    RFProgramCL                                 m_TileCacheProgram;
+
+    const RFContextCL*                          m_pContext;
+
+    RFThreadPool                                m_ThreadPool;
+
+    // vector of buffers into which the hash kernel can write.
+    std::vector<TCHashBuffer>                   m_TargetBuffers;
+
+    // Queue that contains references to buffers that store hashes which were not yet
+    // processed by calling getEncodedFrame
+    RFSpscQueue<const TCHashBuffer*>            m_ResultQueue;
+};
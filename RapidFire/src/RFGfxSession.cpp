@@ -255,4 +255,56 @@ RFStatus RFDX11Session::registerTexture(RFTexture rt, unsigned int uiWidth,unsig
     }
 
     return m_pContextCL->setInputTexture(pDX11Tex, uiWidth, uiHeight, idx);
-}
\ No newline at end of file
+}
+
+
+RFHostSession::RFHostSession(RFEncoderID rfEncoder)
+    : RFSession(rfEncoder)
+{
+    // AMF needs a graphics device as input.
+    if (rfEncoder == RF_AMF)
+    {
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[CreateSession] Failed to create host memory session. Encoder not supported");
+
+        throw std::runtime_error("Failed to create host memory session. Encoder not supported");
+    }
+
+    try
+    {
+        // Add all know parameters to map.
+        m_ParameterMap.addParameter(RF_HOST_MEMORY, RFParameterAttr("RF_HOST_MEMORY", RF_PARAMETER_BOOL, 0));
+    }
+    catch(...)
+    {
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[CreateSession] Failed to create host memory Parameters.");
+
+        throw std::runtime_error("Failed to create host memory Parameters.");
+    }
+}
+
+
+RFStatus RFHostSession::createContextFromGfx()
+{
+    if (!m_pContextCL)
+    {
+        return RF_STATUS_INVALID_OPENCL_CONTEXT;
+    }
+
+    return m_pContextCL->createContext();
+}
+
+
+RFStatus RFHostSession::registerTexture(RFTexture rt, unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx)
+{
+    if (rt.rfRT == nullptr)
+    {
+        return RF_STATUS_INVALID_TEXTURE;
+    }
+
+    if (!m_pContextCL)
+    {
+        return RF_STATUS_INVALID_OPENCL_CONTEXT;
+    }
+
+    return m_pContextCL->setInputBuffer(rt.rfRT, uiWidth, uiHeight, idx);
+}
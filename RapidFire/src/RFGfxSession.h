@@ -76,4 +76,18 @@ private:
     virtual RFStatus    registerTexture(RFTexture rt, unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx) override;
 
     ID3D11Device*       m_pDX11Device;
-};
\ No newline at end of file
+};
+
+
+class RFHostSession : public RFSession
+{
+public:
+
+    explicit RFHostSession(RFEncoderID rfEncoder);
+
+private:
+
+    virtual RFStatus    createContextFromGfx()  override;
+
+    virtual RFStatus    registerTexture(RFTexture rt, unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx) override;
+};
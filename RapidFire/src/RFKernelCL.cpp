@@ -124,6 +124,125 @@ const char* str_cl_kernels =
     "\n"
     "\n"
     "\n"
+    "// Reads 8 consecutive pixels starting at pos and returns the R, G and B channels in separate vectors.\n"
+    "void readPixels8(read_only image2d_t pIn, int2 pos, int8* pR, int8* pG, int8* pB)\n"
+    "{\n"
+    "    uchar4 p0 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos));\n"
+    "    uchar4 p1 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(1, 0)));\n"
+    "    uchar4 p2 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(2, 0)));\n"
+    "    uchar4 p3 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(3, 0)));\n"
+    "    uchar4 p4 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(4, 0)));\n"
+    "    uchar4 p5 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(5, 0)));\n"
+    "    uchar4 p6 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(6, 0)));\n"
+    "    uchar4 p7 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(7, 0)));\n"
+    "\n"
+    "    *pR = convert_int8((uchar8)(p0.x, p1.x, p2.x, p3.x, p4.x, p5.x, p6.x, p7.x));\n"
+    "    *pG = convert_int8((uchar8)(p0.y, p1.y, p2.y, p3.y, p4.y, p5.y, p6.y, p7.y));\n"
+    "    *pB = convert_int8((uchar8)(p0.z, p1.z, p2.z, p3.z, p4.z, p5.z, p6.z, p7.z));\n"
+    "}\n"
+    "\n"
+    "\n"
+    "// Same conversion as rgbaTonv12_image2d but each work item computes a strip of 8x2 pixels. The Y values are\n"
+    "// written with one vstore8 per row and the 4 interleaved UV samples with one vstore8.\n"
+    "// The width of the image and the aligned width need to be a multiple of 8.\n"
+    "//\n"
+    "// Global work size is width/8, height/2.\n"
+    "//\n"
+    "__kernel void rgbaTonv12_image2d_vec8(read_only image2d_t pIn, __global uchar * pOut, const int4 vDim, const int mirror)\n"
+    "{\n"
+    "    uint uiGlobalIdX = get_global_id(0);    // 0 - width /8\n"
+    "    uint uiGlobalIdY = get_global_id(1);    // 0 - height/2\n"
+    "\n"
+    "    if (uiGlobalIdX >= vDim.x / 8 || uiGlobalIdY >= vDim.y / 2)\n"
+    "    {\n"
+    "        return;\n"
+    "    }\n"
+    "\n"
+    "    int8 R0, G0, B0, R1, G1, B1;\n"
+    "\n"
+    "    // Read 8 pixels of row y and 8 pixels of row y+1.\n"
+    "    readPixels8(pIn, (int2)(uiGlobalIdX * 8, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 1) : 2 * uiGlobalIdY), &R0, &G0, &B0);\n"
+    "    readPixels8(pIn, (int2)(uiGlobalIdX * 8, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 2) : 2 * uiGlobalIdY + 1), &R1, &G1, &B1);\n"
+    "\n"
+    "    uchar8 Y0 = convert_uchar8(((66 * R0 + 129 * G0 + 25 * B0 + 128) >> 8) + 16);\n"
+    "    uchar8 Y1 = convert_uchar8(((66 * R1 + 129 * G1 + 25 * B1 + 128) >> 8) + 16);\n"
+    "\n"
+    "    uint uiYPlaneOffset = uiGlobalIdX * 8 + uiGlobalIdY * 2 * vDim.z;\n"
+    "\n"
+    "    vstore8(Y0, 0, pOut + uiYPlaneOffset);\n"
+    "    vstore8(Y1, 0, pOut + uiYPlaneOffset + vDim.z);\n"
+    "\n"
+    "    // Take average color of each 2x2 quad.\n"
+    "    int4 R = (R0.even + R0.odd + R1.even + R1.odd) >> 2;\n"
+    "    int4 G = (G0.even + G0.odd + G1.even + G1.odd) >> 2;\n"
+    "    int4 B = (B0.even + B0.odd + B1.even + B1.odd) >> 2;\n"
+    "\n"
+    "    uchar4 U = convert_uchar4(((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128);\n"
+    "    uchar4 V = convert_uchar4(((112 * R - 94 * G - 18  * B + 128) >> 8) + 128);\n"
+    "\n"
+    "    // Write interleaved UV plane.\n"
+    "    uint uiUVPlaneOffset = vDim.z * vDim.y + uiGlobalIdX * 8 + uiGlobalIdY * vDim.z;\n"
+    "\n"
+    "    vstore8((uchar8)(U.x, V.x, U.y, V.y, U.z, V.z, U.w, V.w), 0, pOut + uiUVPlaneOffset);\n"
+    "}\n"
+    "\n"
+    "\n"
+    "// Same conversion as rgbaTonv12_image2d using a tile in local memory. Each work item reads and converts\n"
+    "// 2 pixels of one column, consecutive work items write consecutive Y values. The sums of the vertical\n"
+    "// pixel pairs are stored in local memory and used by the first half of the work items to compute the UV\n"
+    "// samples which are written as uchar2.\n"
+    "//\n"
+    "// Global work size is width, height/2.\n"
+    "// Local  work size is NV12_TILE_WIDTH x NV12_TILE_HEIGHT.\n"
+    "//\n"
+    "#define NV12_TILE_WIDTH  32\n"
+    "#define NV12_TILE_HEIGHT 8\n"
+    "\n"
+    "__kernel __attribute__((reqd_work_group_size(NV12_TILE_WIDTH, NV12_TILE_HEIGHT, 1)))\n"
+    "void rgbaTonv12_image2d_tiled(read_only image2d_t pIn, __global uchar * pOut, const int4 vDim, const int mirror)\n"
+    "{\n"
+    "    __local ushort4 ColumnSum[NV12_TILE_HEIGHT][NV12_TILE_WIDTH];\n"
+    "\n"
+    "    uint uiLocalIdX  = get_local_id(0);\n"
+    "    uint uiLocalIdY  = get_local_id(1);\n"
+    "    uint uiGlobalIdX = get_global_id(0);    // 0 - width\n"
+    "    uint uiGlobalIdY = get_global_id(1);    // 0 - height/2\n"
+    "\n"
+    "    // Work items outside of the image still need to reach the barrier. Like rgbaTonv12_image2d the last column\n"
+    "    // of an image with an odd width is not converted.\n"
+    "    if (uiGlobalIdX < (vDim.x / 2) * 2 && uiGlobalIdY < vDim.y / 2)\n"
+    "    {\n"
+    "        uchar4 RGBA0 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, (int2)(uiGlobalIdX, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 1) : 2 * uiGlobalIdY)));\n"
+    "        uchar4 RGBA1 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, (int2)(uiGlobalIdX, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 2) : 2 * uiGlobalIdY + 1)));\n"
+    "\n"
+    "        uint uiYPlaneOffset = uiGlobalIdX + uiGlobalIdY * 2 * vDim.z;\n"
+    "\n"
+    "        pOut[uiYPlaneOffset]          = ((66 * RGBA0.x + 129 * RGBA0.y + 25 * RGBA0.z + 128) >> 8) + 16;\n"
+    "        pOut[uiYPlaneOffset + vDim.z] = ((66 * RGBA1.x + 129 * RGBA1.y + 25 * RGBA1.z + 128) >> 8) + 16;\n"
+    "\n"
+    "        ColumnSum[uiLocalIdY][uiLocalIdX] = convert_ushort4(RGBA0) + convert_ushort4(RGBA1);\n"
+    "    }\n"
+    "\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "\n"
+    "    // Each of the first NV12_TILE_WIDTH / 2 work items of a row computes one UV sample.\n"
+    "    uint uiChromaX = get_group_id(0) * NV12_TILE_WIDTH / 2 + uiLocalIdX;\n"
+    "\n"
+    "    if (uiLocalIdX >= NV12_TILE_WIDTH / 2 || uiChromaX >= vDim.x / 2 || uiGlobalIdY >= vDim.y / 2)\n"
+    "    {\n"
+    "        return;\n"
+    "    }\n"
+    "\n"
+    "    ushort4 RGBA = (ColumnSum[uiLocalIdY][2 * uiLocalIdX] + ColumnSum[uiLocalIdY][2 * uiLocalIdX + 1]) >> 2;\n"
+    "\n"
+    "    uchar2 UV = (uchar2)(((-38 * RGBA.x - 74 * RGBA.y + 112 * RGBA.z + 128) >> 8) + 128,\n"
+    "                         ((112 * RGBA.x - 94 * RGBA.y - 18  * RGBA.z + 128) >> 8) + 128);\n"
+    "\n"
+    "    vstore2(UV, 0, pOut + vDim.z * vDim.y + 2 * uiChromaX + uiGlobalIdY * vDim.z);\n"
+    "}\n"
+    "\n"
+    "\n"
+    "\n"
     "__kernel void rgbaToNV12_Planes(__read_only image2d_t rgbaIn, __write_only image2d_t yOut, const int4 vDim, const int mirror, __write_only image2d_t uvOut)\n"
     "{\n"
     "   uint uiGlobalId_X = get_global_id(0);\n"
@@ -303,5 +422,93 @@ const char* str_cl_kernels =
     "      rgbaOut[uiBufferOffset + 3] = pixel.w; \n"
     "   }\n"
     "}  \n"
-    "\n";
+    "\n"
+    "\n"
+    "\n"
+    "// Same as copy_rgba_image2d but additionally computes a difference map. Each work group processes one block of\n"
+    "// vBlockDim.x x vBlockDim.y pixels. While the block is copied a 64 bit signature of the output pixels is computed.\n"
+    "// The signature is compared with the signature of the previous frame which is stored in pSignatures. This way the\n"
+    "// previous frame does not need to be read again.\n"
+    "// If a signature differs, or if nForceDiff is set, the value of the block in pDiffMap is set to 1 otherwise to 0.\n"
+    "//\n"
+    "// Global Work Size : (number of blocks in x * 8) x (number of blocks in y * 8)\n"
+    "// Local Work Size  : 8 x 8\n"
+    "//\n"
+    "__kernel void copy_rgba_diff_image2d(__read_only image2d_t rgbaIn, __global uchar *rgbaOut, const int4 vDim, const int mirror, const int nTargetOrdering,\n"
+    "                                     __global uchar *pDiffMap, __global uint2 *pSignatures, const uint2 vBlockDim, const int nForceDiff)\n"
+    "{\n"
+    "    __local uint uiBlockSum;\n"
+    "    __local uint uiBlockXor;\n"
+    "\n"
+    "    uint uiLocalId_X = get_local_id(0);\n"
+    "    uint uiLocalId_Y = get_local_id(1);\n"
+    "\n"
+    "    if (uiLocalId_X == 0 && uiLocalId_Y == 0)\n"
+    "    {\n"
+    "        uiBlockSum = 0;\n"
+    "        uiBlockXor = 0;\n"
+    "    }\n"
+    "\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "\n"
+    "    uint uiBlockOffset_X = get_group_id(0) * vBlockDim.x;\n"
+    "    uint uiBlockOffset_Y = get_group_id(1) * vBlockDim.y;\n"
+    "\n"
+    "    uint uiSum = 0;\n"
+    "    uint uiXor = 0;\n"
+    "\n"
+    "    for (uint by = uiLocalId_Y; by < vBlockDim.y && uiBlockOffset_Y + by < vDim.y; by += get_local_size(1))\n"
+    "    {\n"
+    "        uint y = uiBlockOffset_Y + by;\n"
+    "\n"
+    "        for (uint bx = uiLocalId_X; bx < vBlockDim.x && uiBlockOffset_X + bx < vDim.x; bx += get_local_size(0))\n"
+    "        {\n"
+    "            uint x = uiBlockOffset_X + bx;\n"
+    "\n"
+    "            int2 ImgCoord = (int2)(x, (mirror) ? vDim.y - (y + 1) : y);\n"
+    "\n"
+    "            uchar4 pixel = convert_uchar4_sat(255.0f * read_imagef(rgbaIn, imageSampler, ImgCoord));\n"
+    "\n"
+    "            if (nTargetOrdering == 1)\n"
+    "            {\n"
+    "                // ARGB\n"
+    "                pixel = pixel.wxyz;\n"
+    "            }\n"
+    "            else if (nTargetOrdering == 2)\n"
+    "            {\n"
+    "                // BGRA\n"
+    "                pixel = pixel.zyxw;\n"
+    "            }\n"
+    "\n"
+    "            vstore4(pixel, x + y * vDim.z, rgbaOut);\n"
+    "\n"
+    "            // Mix the pixel value with its position inside the block. This way moved content changes the signature.\n"
+    "            uint uiPixel = as_uint(pixel);\n"
+    "            uint uiPos   = bx + by * vBlockDim.x;\n"
+    "\n"
+    "            uint h = (uiPixel ^ (uiPos * 0x9E3779B1u)) * 0x85EBCA77u;\n"
+    "            h ^= h >> 13;\n"
+    "            h *= 0xC2B2AE3Du;\n"
+    "            h ^= h >> 16;\n"
+    "\n"
+    "            uiSum += h;\n"
+    "            uiXor ^= rotate(uiPixel * 0x27D4EB2Fu + uiPos, uiPos & 31);\n"
+    "        }\n"
+    "    }\n"
+    "\n"
+    "    atomic_add(&uiBlockSum, uiSum);\n"
+    "    atomic_xor(&uiBlockXor, uiXor);\n"
+    "\n"
+    "    barrier(CLK_LOCAL_MEM_FENCE);\n"
+    "\n"
+    "    if (uiLocalId_X == 0 && uiLocalId_Y == 0)\n"
+    "    {\n"
+    "        uint  uiBlockIdx = get_group_id(0) + get_group_id(1) * get_num_groups(0);\n"
+    "        uint2 Signature  = (uint2)(uiBlockSum, uiBlockXor);\n"
+    "\n"
+    "        pDiffMap[uiBlockIdx] = (nForceDiff || any(Signature != pSignatures[uiBlockIdx])) ? 1 : 0;\n"
+    "\n"
+    "        pSignatures[uiBlockIdx] = Signature;\n"
+    "    }\n"
+    "}\n";
     
\ No newline at end of file
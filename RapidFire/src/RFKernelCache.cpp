@@ -0,0 +1,477 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFKernelCache.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined WIN32 || defined _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+#include "RFUtils.h"
+
+#define KERNEL_CACHE_MAGIC          0x434b4652      // 'RFKC'
+#define KERNEL_CACHE_VERSION        1
+#define KERNEL_CACHE_DEFAULT_SIZE   64              // MB
+#define KERNEL_CACHE_FILE_EXT       ".rfbin"
+
+namespace
+{
+    struct EntryHeader
+    {
+        uint32_t    uiMagic;
+        uint32_t    uiVersion;
+        uint64_t    uiKey;
+        uint64_t    uiDataHash;
+        uint64_t    uiDataSize;
+    };
+
+
+    struct EntryInfo
+    {
+        std::string strPath;
+        uint64_t    uiSize;
+        uint64_t    uiLastUse;
+    };
+
+
+    std::string getEnvironmentVariable(const char* pName)
+    {
+#if defined WIN32 || defined _WIN32
+        char*   pEnvVar = nullptr;
+        size_t  len = 0;
+
+        if (_dupenv_s(&pEnvVar, &len, pName) != 0 || !pEnvVar)
+        {
+            return std::string();
+        }
+
+        std::string strValue(pEnvVar);
+
+        free(pEnvVar);
+
+        return strValue;
+#else
+        const char* pEnvVar = getenv(pName);
+
+        return (pEnvVar) ? std::string(pEnvVar) : std::string();
+#endif
+    }
+
+
+    bool directoryExists(const std::string& strPath)
+    {
+#if defined WIN32 || defined _WIN32
+        DWORD dwAttributes = GetFileAttributesA(strPath.c_str());
+
+        return (dwAttributes != INVALID_FILE_ATTRIBUTES && (dwAttributes & FILE_ATTRIBUTE_DIRECTORY));
+#else
+        struct stat st;
+
+        return (stat(strPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode));
+#endif
+    }
+
+
+    // Creates the directory and all missing parent directories. strPath uses '/' as separator.
+    bool createDirectories(const std::string& strPath)
+    {
+        size_t pos = 0;
+
+        do
+        {
+            pos = strPath.find('/', pos + 1);
+
+            std::string strDir = strPath.substr(0, pos);
+
+            // Errors are ignored here since parts of the path may exist or may not be accessible, e.g.
+            // drive letters or network shares. Only the existence of the complete path is checked.
+#if defined WIN32 || defined _WIN32
+            CreateDirectoryA(strDir.c_str(), NULL);
+#else
+            mkdir(strDir.c_str(), 0755);
+#endif
+        } while (pos != std::string::npos);
+
+        return directoryExists(strPath);
+    }
+
+
+    // Sets the modification time of the file to the current time. The modification time is used
+    // to find the least recently used entries.
+    void touchFile(const std::string& strPath)
+    {
+#if defined WIN32 || defined _WIN32
+        HANDLE hFile = CreateFileA(strPath.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (hFile != INVALID_HANDLE_VALUE)
+        {
+            FILETIME ft;
+
+            GetSystemTimeAsFileTime(&ft);
+            SetFileTime(hFile, NULL, NULL, &ft);
+
+            CloseHandle(hFile);
+        }
+#else
+        utimes(strPath.c_str(), nullptr);
+#endif
+    }
+
+
+    // Replaces strPath with strTmpPath. The rename is atomic if both files are on the same volume.
+    bool replaceFile(const std::string& strTmpPath, const std::string& strPath)
+    {
+#if defined WIN32 || defined _WIN32
+        return (MoveFileExA(strTmpPath.c_str(), strPath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0);
+#else
+        return (rename(strTmpPath.c_str(), strPath.c_str()) == 0);
+#endif
+    }
+
+
+    unsigned long getProcessId()
+    {
+#if defined WIN32 || defined _WIN32
+        return GetCurrentProcessId();
+#else
+        return static_cast<unsigned long>(getpid());
+#endif
+    }
+
+
+    std::vector<EntryInfo> listEntries(const std::string& strDirectory)
+    {
+        std::vector<EntryInfo> Entries;
+
+#if defined WIN32 || defined _WIN32
+        WIN32_FIND_DATAA fd;
+
+        HANDLE hFind = FindFirstFileA((strDirectory + "*" KERNEL_CACHE_FILE_EXT).c_str(), &fd);
+
+        if (hFind == INVALID_HANDLE_VALUE)
+        {
+            return Entries;
+        }
+
+        do
+        {
+            if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            {
+                EntryInfo e;
+
+                e.strPath   = strDirectory + fd.cFileName;
+                e.uiSize    = (static_cast<uint64_t>(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow;
+                e.uiLastUse = (static_cast<uint64_t>(fd.ftLastWriteTime.dwHighDateTime) << 32) | fd.ftLastWriteTime.dwLowDateTime;
+
+                Entries.push_back(e);
+            }
+        } while (FindNextFileA(hFind, &fd));
+
+        FindClose(hFind);
+#else
+        DIR* pDir = opendir(strDirectory.empty() ? "." : strDirectory.c_str());
+
+        if (!pDir)
+        {
+            return Entries;
+        }
+
+        const std::string strExt(KERNEL_CACHE_FILE_EXT);
+
+        while (struct dirent* pEntry = readdir(pDir))
+        {
+            std::string strName(pEntry->d_name);
+
+            if (strName.size() <= strExt.size() || strName.compare(strName.size() - strExt.size(), strExt.size(), strExt) != 0)
+            {
+                continue;
+            }
+
+            EntryInfo   e;
+            struct stat st;
+
+            e.strPath = strDirectory + strName;
+
+            if (stat(e.strPath.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            {
+                e.uiSize    = static_cast<uint64_t>(st.st_size);
+#ifdef __APPLE__
+                e.uiLastUse = static_cast<uint64_t>(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+                e.uiLastUse = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+
+                Entries.push_back(e);
+            }
+        }
+
+        closedir(pDir);
+#endif
+
+        return Entries;
+    }
+}
+
+
+std::string     RFKernelCache::s_strDirectory;
+uint64_t        RFKernelCache::s_uiMaxSize = 0;
+bool            RFKernelCache::s_bInitialized = false;
+std::mutex      RFKernelCache::s_lock;
+
+
+bool RFKernelCache::isEnabled()
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    init();
+
+    return (s_uiMaxSize > 0);
+}
+
+
+std::string RFKernelCache::getFilePath(const std::string& strFileName)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    init();
+
+    return s_strDirectory + strFileName;
+}
+
+
+bool RFKernelCache::load(uint64_t uiKey, std::vector<unsigned char>& Binary)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    init();
+
+    if (s_uiMaxSize == 0)
+    {
+        return false;
+    }
+
+    const std::string strPath = getEntryPath(uiKey);
+
+    std::ifstream file(strPath.c_str(), std::ios::in | std::ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    EntryHeader header;
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if (!file || header.uiMagic != KERNEL_CACHE_MAGIC || header.uiVersion != KERNEL_CACHE_VERSION ||
+        header.uiKey != uiKey || header.uiDataSize == 0 || header.uiDataSize > s_uiMaxSize)
+    {
+        return false;
+    }
+
+    Binary.resize(static_cast<size_t>(header.uiDataSize));
+
+    file.read(reinterpret_cast<char*>(Binary.data()), Binary.size());
+
+    if (!file || utilHash64(Binary.data(), Binary.size()) != header.uiDataHash)
+    {
+        Binary.clear();
+        return false;
+    }
+
+    file.close();
+
+    touchFile(strPath);
+
+    return true;
+}
+
+
+bool RFKernelCache::store(uint64_t uiKey, const std::vector<unsigned char>& Binary)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    init();
+
+    if (s_uiMaxSize == 0 || Binary.empty() || Binary.size() + sizeof(EntryHeader) > s_uiMaxSize)
+    {
+        return false;
+    }
+
+    const std::string strPath = getEntryPath(uiKey);
+
+    // The process id makes the name of the temporary file unique among all processes that write to the cache.
+    // Threads of the same process are serialized by s_lock.
+    std::ostringstream oss;
+    oss << strPath << "." << getProcessId() << ".tmp";
+
+    const std::string strTmpPath = oss.str();
+
+    EntryHeader header;
+
+    header.uiMagic    = KERNEL_CACHE_MAGIC;
+    header.uiVersion  = KERNEL_CACHE_VERSION;
+    header.uiKey      = uiKey;
+    header.uiDataHash = utilHash64(Binary.data(), Binary.size());
+    header.uiDataSize = Binary.size();
+
+    std::ofstream file(strTmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(Binary.data()), Binary.size());
+    file.close();
+
+    if (!file || !replaceFile(strTmpPath, strPath))
+    {
+        remove(strTmpPath.c_str());
+        return false;
+    }
+
+    evictEntries();
+
+    return true;
+}
+
+
+void RFKernelCache::init()
+{
+    if (s_bInitialized)
+    {
+        return;
+    }
+
+    s_bInitialized = true;
+
+    const std::string strSize = getEnvironmentVariable("RF_KERNEL_CACHE_SIZE");
+
+    s_uiMaxSize = (strSize.empty()) ? KERNEL_CACHE_DEFAULT_SIZE : strtoull(strSize.c_str(), nullptr, 10);
+    s_uiMaxSize *= 1024 * 1024;
+
+    std::string strDirectory = getEnvironmentVariable("RF_KERNEL_CACHE_PATH");
+
+    if (strDirectory.empty())
+    {
+#if defined WIN32 || defined _WIN32
+        const std::string strBase = getEnvironmentVariable("LOCALAPPDATA");
+
+        if (!strBase.empty())
+        {
+            strDirectory = strBase + "/RapidFire/KernelCache";
+        }
+#else
+        const std::string strXdgBase  = getEnvironmentVariable("XDG_CACHE_HOME");
+        const std::string strHomeBase = getEnvironmentVariable("HOME");
+
+        if (!strXdgBase.empty())
+        {
+            strDirectory = strXdgBase + "/rapidfire";
+        }
+        else if (!strHomeBase.empty())
+        {
+            strDirectory = strHomeBase + "/.cache/rapidfire";
+        }
+#endif
+    }
+
+    std::replace(strDirectory.begin(), strDirectory.end(), '\\', '/');
+
+    if (strDirectory.empty())
+    {
+        // Fall back to the working directory.
+        return;
+    }
+
+    if (!createDirectories(strDirectory))
+    {
+        return;
+    }
+
+    if (strDirectory.back() != '/')
+    {
+        strDirectory += '/';
+    }
+
+    s_strDirectory = strDirectory;
+}
+
+
+std::string RFKernelCache::getEntryPath(uint64_t uiKey)
+{
+    std::ostringstream oss;
+
+    oss << s_strDirectory << std::hex << std::setw(16) << std::setfill('0') << uiKey << KERNEL_CACHE_FILE_EXT;
+
+    return oss.str();
+}
+
+
+void RFKernelCache::evictEntries()
+{
+    std::vector<EntryInfo> Entries = listEntries(s_strDirectory);
+
+    uint64_t uiTotalSize = 0;
+
+    for (const EntryInfo& e : Entries)
+    {
+        uiTotalSize += e.uiSize;
+    }
+
+    if (uiTotalSize <= s_uiMaxSize)
+    {
+        return;
+    }
+
+    std::sort(Entries.begin(), Entries.end(), [](const EntryInfo& a, const EntryInfo& b) { return a.uiLastUse < b.uiLastUse; });
+
+    for (const EntryInfo& e : Entries)
+    {
+        if (uiTotalSize <= s_uiMaxSize)
+        {
+            break;
+        }
+
+        if (remove(e.strPath.c_str()) == 0)
+        {
+            uiTotalSize -= e.uiSize;
+        }
+    }
+}
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+// RFKernelCache stores OpenCL program binaries on disk. Entries are identified by a 64 bit key that the
+// caller computes from everything that affects the binary, e.g. the kernel source, the build options and
+// the device and driver versions. A changed driver or kernel therefore results in a new key and never in
+// a stale binary.
+//
+// The cache directory can be set with the environment variable RF_KERNEL_CACHE_PATH. By default
+// %LOCALAPPDATA%/RapidFire/KernelCache is used on Windows and $XDG_CACHE_HOME/rapidfire or ~/.cache/rapidfire
+// on other platforms. The size of the cache is limited to RF_KERNEL_CACHE_SIZE MB (default 64 MB). If the
+// limit is exceeded the least recently used entries are removed. RF_KERNEL_CACHE_SIZE=0 disables the cache.
+class RFKernelCache
+{
+public:
+
+    // Returns true if binaries can be loaded from and stored in the cache.
+    static bool         isEnabled();
+
+    // Returns the path of a file in the cache directory. If no cache directory is available the
+    // file is located in the working directory.
+    static std::string  getFilePath(const std::string& strFileName);
+
+    // Loads the binary that was stored with uiKey and marks the entry as recently used.
+    static bool         load(uint64_t uiKey, std::vector<unsigned char>& Binary);
+
+    // Stores the binary. The entry is written to a temporary file and renamed afterwards, concurrent
+    // readers either see the complete entry or no entry at all.
+    static bool         store(uint64_t uiKey, const std::vector<unsigned char>& Binary);
+
+private:
+
+    // Disable constructor.
+    RFKernelCache();
+
+    static void         init();
+
+    static std::string  getEntryPath(uint64_t uiKey);
+
+    // Removes the least recently used entries until the cache size is below the limit.
+    static void         evictEntries();
+
+    static std::string  s_strDirectory;
+    static uint64_t     s_uiMaxSize;
+    static bool         s_bInitialized;
+    static std::mutex   s_lock;
+};
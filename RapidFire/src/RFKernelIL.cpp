@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFKernelIL.h"
+
+#include <string.h>
+
+#include "RFUtils.h"
+
+#ifdef RF_USE_OFFLINE_KERNELS
+
+// RFKernelIL.inc is generated by tools/compile_kernels.py. It defines the array s_KernelIL
+// with one entry per kernel file. uiSourceHash is the utilHash64 of the source string the library
+// embeds, an outdated .inc file is detected this way and the kernels are built from source.
+struct RFKernelILEntry
+{
+    const char*             pFileName;
+    uint64_t                uiSourceHash;
+    const unsigned char*    pIL32;
+    size_t                  uiSize32;
+    const unsigned char*    pIL64;
+    size_t                  uiSize64;
+};
+
+#include "RFKernelIL.inc"
+
+bool getKernelIL(const char* kernelFileName, const char* kernelSourceCode, unsigned int uiAddressBits, const unsigned char** ppIL, size_t* pSize)
+{
+    if (!kernelFileName || !kernelSourceCode || !ppIL || !pSize)
+    {
+        return false;
+    }
+
+    for (const RFKernelILEntry& e : s_KernelIL)
+    {
+        if (e.pFileName && strcmp(e.pFileName, kernelFileName) == 0)
+        {
+            if (e.uiSourceHash != utilHash64(kernelSourceCode, strlen(kernelSourceCode)))
+            {
+                return false;
+            }
+
+            *ppIL  = (uiAddressBits == 64) ? e.pIL64 : e.pIL32;
+            *pSize = (uiAddressBits == 64) ? e.uiSize64 : e.uiSize32;
+
+            return (*ppIL != nullptr && *pSize > 0);
+        }
+    }
+
+    return false;
+}
+
+#else
+
+bool getKernelIL(const char* kernelFileName, const char* kernelSourceCode, unsigned int uiAddressBits, const unsigned char** ppIL, size_t* pSize)
+{
+    return false;
+}
+
+#endif
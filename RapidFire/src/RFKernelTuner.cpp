@@ -0,0 +1,311 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFKernelTuner.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+#include <fstream>
+#include <sstream>
+
+#include "RFContext.h"
+#include "RFUtils.h"
+
+#define KERNEL_TUNING_FILE_NAME "rfkerneltuning.txt"
+
+// Number of timed runs per candidate. An additional run is done before to warm up caches.
+#define NUM_TUNING_RUNS         4
+
+std::map<std::string, RFKernelTuner::Configuration> RFKernelTuner::s_Configurations;
+bool RFKernelTuner::s_bLoaded = false;
+std::mutex RFKernelTuner::s_lock;
+
+
+RFKernelTuner::RFKernelTuner(cl_context clCtx, cl_device_id clDevId)
+    : m_clCtx(clCtx)
+    , m_clDevId(clDevId)
+    , m_clProfilingQueue(NULL)
+{
+    size_t uiDeviceNameLength = 0;
+
+    if (clGetDeviceInfo(m_clDevId, CL_DEVICE_NAME, 0, nullptr, &uiDeviceNameLength) == CL_SUCCESS && uiDeviceNameLength > 0)
+    {
+        std::vector<char> deviceName(uiDeviceNameLength);
+
+        if (clGetDeviceInfo(m_clDevId, CL_DEVICE_NAME, uiDeviceNameLength, deviceName.data(), nullptr) == CL_SUCCESS)
+        {
+            m_strDeviceName = deviceName.data();
+        }
+    }
+}
+
+
+RFKernelTuner::~RFKernelTuner()
+{
+    if (m_clProfilingQueue)
+    {
+        clReleaseCommandQueue(m_clProfilingQueue);
+    }
+}
+
+
+unsigned int RFKernelTuner::selectCandidate(const std::string& strKernel, const char* pSourceCode, const std::string& strProblem, const std::vector<Candidate>& Candidates)
+{
+    if (Candidates.size() < 2)
+    {
+        return 0;
+    }
+
+    uint64_t uiSourceHash = (pSourceCode) ? utilHash64(pSourceCode, strlen(pSourceCode)) : 0;
+
+    std::ostringstream oss;
+
+    oss << m_strDeviceName << '\t' << strKernel << '\t' << std::hex << uiSourceHash << std::dec << '\t' << strProblem;
+
+    const std::string strKey = oss.str();
+
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+
+        loadConfigurations();
+
+        std::map<std::string, Configuration>::const_iterator itr = s_Configurations.find(strKey);
+
+        if (itr != s_Configurations.end())
+        {
+            for (unsigned int i = 0; i < Candidates.size(); ++i)
+            {
+                if (Candidates[i].uiVariant == itr->second.uiVariant &&
+                    Candidates[i].uiLocalWorkSize[0] == itr->second.uiLocalWorkSize[0] &&
+                    Candidates[i].uiLocalWorkSize[1] == itr->second.uiLocalWorkSize[1] &&
+                    isValidCandidate(Candidates[i]))
+                {
+                    return i;
+                }
+            }
+        }
+    }
+
+    if (!m_clProfilingQueue)
+    {
+        cl_int nStatus;
+
+        m_clProfilingQueue = clCreateCommandQueue(m_clCtx, m_clDevId, CL_QUEUE_PROFILING_ENABLE, &nStatus);
+
+        if (nStatus != CL_SUCCESS)
+        {
+            m_clProfilingQueue = NULL;
+            return 0;
+        }
+    }
+
+    unsigned int uiBest = 0;
+    cl_ulong     uiBestTime = CL_ULONG_MAX;
+
+    for (unsigned int i = 0; i < Candidates.size(); ++i)
+    {
+        if (!isValidCandidate(Candidates[i]))
+        {
+            continue;
+        }
+
+        cl_ulong uiTime = timeCandidate(Candidates[i]);
+
+        if (uiTime > 0 && uiTime < uiBestTime)
+        {
+            uiBest = i;
+            uiBestTime = uiTime;
+        }
+    }
+
+    if (uiBestTime == CL_ULONG_MAX)
+    {
+        return 0;
+    }
+
+    Configuration cfg;
+
+    cfg.uiVariant = Candidates[uiBest].uiVariant;
+    cfg.uiLocalWorkSize[0] = Candidates[uiBest].uiLocalWorkSize[0];
+    cfg.uiLocalWorkSize[1] = Candidates[uiBest].uiLocalWorkSize[1];
+
+    {
+        std::lock_guard<std::mutex> lock(s_lock);
+
+        storeConfiguration(strKey, cfg);
+    }
+
+    return uiBest;
+}
+
+
+bool RFKernelTuner::isValidCandidate(const Candidate& c) const
+{
+    if (!c.kernel || c.uiLocalWorkSize[0] == 0 || c.uiLocalWorkSize[1] == 0 || c.uiGlobalWorkSize[0] == 0 || c.uiGlobalWorkSize[1] == 0)
+    {
+        return false;
+    }
+
+    if ((c.uiGlobalWorkSize[0] % c.uiLocalWorkSize[0]) || (c.uiGlobalWorkSize[1] % c.uiLocalWorkSize[1]))
+    {
+        return false;
+    }
+
+    size_t uiMaxWorkGroupSize = 0;
+
+    if (clGetKernelWorkGroupInfo(c.kernel, m_clDevId, CL_KERNEL_WORK_GROUP_SIZE, sizeof(size_t), &uiMaxWorkGroupSize, nullptr) != CL_SUCCESS)
+    {
+        return false;
+    }
+
+    if (c.uiLocalWorkSize[0] * c.uiLocalWorkSize[1] > uiMaxWorkGroupSize)
+    {
+        return false;
+    }
+
+    // Kernels that define reqd_work_group_size can only run with this size.
+    size_t uiCompileWorkGroupSize[3] = { 0, 0, 0 };
+
+    if (clGetKernelWorkGroupInfo(c.kernel, m_clDevId, CL_KERNEL_COMPILE_WORK_GROUP_SIZE, sizeof(uiCompileWorkGroupSize), uiCompileWorkGroupSize, nullptr) == CL_SUCCESS &&
+        uiCompileWorkGroupSize[0] > 0)
+    {
+        return (uiCompileWorkGroupSize[0] == c.uiLocalWorkSize[0] && uiCompileWorkGroupSize[1] == c.uiLocalWorkSize[1]);
+    }
+
+    return true;
+}
+
+
+cl_ulong RFKernelTuner::timeCandidate(const Candidate& c)
+{
+    if (clEnqueueNDRangeKernel(m_clProfilingQueue, c.kernel, 2, nullptr, c.uiGlobalWorkSize, c.uiLocalWorkSize, 0, nullptr, nullptr) != CL_SUCCESS)
+    {
+        return 0;
+    }
+
+    cl_event clEvents[NUM_TUNING_RUNS];
+    unsigned int uiNumEvents = 0;
+
+    for (; uiNumEvents < NUM_TUNING_RUNS; ++uiNumEvents)
+    {
+        if (clEnqueueNDRangeKernel(m_clProfilingQueue, c.kernel, 2, nullptr, c.uiGlobalWorkSize, c.uiLocalWorkSize, 0, nullptr, &clEvents[uiNumEvents]) != CL_SUCCESS)
+        {
+            break;
+        }
+    }
+
+    clFinish(m_clProfilingQueue);
+
+    cl_ulong uiTotalTime = 0;
+    bool     bValid = (uiNumEvents == NUM_TUNING_RUNS);
+
+    for (unsigned int i = 0; i < uiNumEvents; ++i)
+    {
+        cl_ulong uiStart = 0;
+        cl_ulong uiEnd = 0;
+
+        if (clGetEventProfilingInfo(clEvents[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &uiStart, nullptr) == CL_SUCCESS &&
+            clGetEventProfilingInfo(clEvents[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &uiEnd, nullptr) == CL_SUCCESS &&
+            uiEnd > uiStart)
+        {
+            uiTotalTime += uiEnd - uiStart;
+        }
+        else
+        {
+            bValid = false;
+        }
+
+        clReleaseEvent(clEvents[i]);
+    }
+
+    if (!bValid)
+    {
+        return 0;
+    }
+
+    return uiTotalTime / NUM_TUNING_RUNS;
+}
+
+
+// Each line of the tuning file contains one configuration:
+// <device name> \t <kernel> \t <source hash> \t <problem> \t <variant> \t <local size x> \t <local size y>
+// If a key exists multiple times the last entry is used.
+void RFKernelTuner::loadConfigurations()
+{
+    if (s_bLoaded)
+    {
+        return;
+    }
+
+    s_bLoaded = true;
+
+    std::ifstream file(RFProgramCL::GetCacheFilePath(KERNEL_TUNING_FILE_NAME).c_str());
+
+    if (!file)
+    {
+        return;
+    }
+
+    std::string strLine;
+
+    while (std::getline(file, strLine))
+    {
+        std::vector<std::string> Fields;
+        std::istringstream       iss(strLine);
+        std::string              strField;
+
+        while (std::getline(iss, strField, '\t'))
+        {
+            Fields.push_back(strField);
+        }
+
+        if (Fields.size() != 7)
+        {
+            continue;
+        }
+
+        Configuration cfg;
+
+        cfg.uiVariant          = strtoul(Fields[4].c_str(), nullptr, 10);
+        cfg.uiLocalWorkSize[0] = strtoul(Fields[5].c_str(), nullptr, 10);
+        cfg.uiLocalWorkSize[1] = strtoul(Fields[6].c_str(), nullptr, 10);
+
+        s_Configurations[Fields[0] + '\t' + Fields[1] + '\t' + Fields[2] + '\t' + Fields[3]] = cfg;
+    }
+}
+
+
+void RFKernelTuner::storeConfiguration(const std::string& strKey, const Configuration& cfg)
+{
+    s_Configurations[strKey] = cfg;
+
+    std::ofstream file(RFProgramCL::GetCacheFilePath(KERNEL_TUNING_FILE_NAME).c_str(), std::ios::out | std::ios::app);
+
+    if (!file)
+    {
+        return;
+    }
+
+    file << strKey << '\t' << cfg.uiVariant << '\t' << cfg.uiLocalWorkSize[0] << '\t' << cfg.uiLocalWorkSize[1] << std::endl;
+}
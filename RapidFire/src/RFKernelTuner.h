@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <CL/cl.h>
+
+// RFKernelTuner selects the fastest work group configuration of a kernel. On first use all candidates
+// are timed on the device. The winner is stored in a file next to the kernel binary cache, keyed by the
+// device name, the kernel and a hash of the kernel source. Later sessions read the stored configuration
+// and don't need to time the candidates again.
+class RFKernelTuner
+{
+public:
+
+    struct Candidate
+    {
+        cl_kernel       kernel;
+        // Identifies the kernel variant, e.g. the number of pixels computed by a work item.
+        unsigned int    uiVariant;
+        size_t          uiGlobalWorkSize[2];
+        size_t          uiLocalWorkSize[2];
+    };
+
+    RFKernelTuner(cl_context clCtx, cl_device_id clDevId);
+    ~RFKernelTuner();
+
+    // Returns the index of the fastest candidate. strKernel identifies the kernel and pSourceCode is the source the
+    // kernels were built from. strProblem describes the input, e.g. the dimension. All kernel arguments of the
+    // candidates need to be set. Candidates that cannot be executed on the device are ignored.
+    // Returns 0 if none of the candidates could be timed.
+    unsigned int    selectCandidate(const std::string& strKernel, const char* pSourceCode, const std::string& strProblem, const std::vector<Candidate>& Candidates);
+
+    // Returns true if the candidate can be launched on the device.
+    bool            isValidCandidate(const Candidate& c) const;
+
+private:
+
+    // Disable copy constructor.
+    RFKernelTuner(const RFKernelTuner& other);
+    // Disable assignment operator.
+    RFKernelTuner& operator=(const RFKernelTuner& rhs);
+
+    struct Configuration
+    {
+        unsigned int    uiVariant;
+        size_t          uiLocalWorkSize[2];
+    };
+
+    // Returns the average execution time of the candidate in ns or 0 if the candidate failed.
+    cl_ulong        timeCandidate(const Candidate& c);
+
+    static void     loadConfigurations();
+    static void     storeConfiguration(const std::string& strKey, const Configuration& cfg);
+
+    cl_context                  m_clCtx;
+    cl_device_id                m_clDevId;
+    cl_command_queue            m_clProfilingQueue;
+    std::string                 m_strDeviceName;
+
+    // Configurations of all kernels that were tuned so far. The key is built from the device name,
+    // the kernel, the source hash and the problem description.
+    static std::map<std::string, Configuration>     s_Configurations;
+    static bool                                     s_bLoaded;
+    static std::mutex                               s_lock;
+};
@@ -76,4 +76,95 @@ RFReadWriteAccess::~RFReadWriteAccess()
     {
         m_pLock->unlock();
     }
+}
+
+
+RFCondition::RFCondition()
+{
+    InitializeConditionVariable(&m_cv);
+}
+
+
+bool RFCondition::wait(RFLock* pLock, unsigned int uiTimeoutMs)
+{
+    if (!pLock)
+    {
+        return false;
+    }
+
+    return (SleepConditionVariableCS(&m_cv, &pLock->m_cs, uiTimeoutMs) != 0);
+}
+
+
+void RFCondition::notifyAll()
+{
+    WakeAllConditionVariable(&m_cv);
+}
+
+
+RFSharedLock::RFSharedLock()
+{
+    InitializeSRWLock(&m_srw);
+}
+
+
+void RFSharedLock::lockShared()
+{
+    AcquireSRWLockShared(&m_srw);
+}
+
+
+void RFSharedLock::unlockShared()
+{
+    ReleaseSRWLockShared(&m_srw);
+}
+
+
+void RFSharedLock::lockExclusive()
+{
+    AcquireSRWLockExclusive(&m_srw);
+}
+
+
+void RFSharedLock::unlockExclusive()
+{
+    ReleaseSRWLockExclusive(&m_srw);
+}
+
+
+RFSharedAccess::RFSharedAccess(RFSharedLock* pLock)
+    : m_pLock(pLock)
+{
+    if (m_pLock)
+    {
+        m_pLock->lockShared();
+    }
+}
+
+
+RFSharedAccess::~RFSharedAccess()
+{
+    if (m_pLock)
+    {
+        m_pLock->unlockShared();
+    }
+}
+
+
+RFExclusiveAccess::RFExclusiveAccess(RFSharedLock* pLock)
+    : m_pLock(pLock)
+{
+    if (m_pLock)
+    {
+        m_pLock->lockExclusive();
+    }
+}
+
+
+RFExclusiveAccess::~RFExclusiveAccess()
+{
+    if (m_pLock)
+    {
+        m_pLock->unlockExclusive();
+    }
 }
\ No newline at end of file
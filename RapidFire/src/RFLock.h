@@ -22,8 +22,6 @@
 
 #pragma once
 
-#include <queue>
-
 #include <Windows.h>
 
 // RFLock implements a critical section.
@@ -46,6 +44,9 @@ private:
     RFLock& operator= (const RFLock& rhs);
 
     CRITICAL_SECTION m_cs;
+
+    // RFCondition releases the critical section while waiting.
+    friend class RFCondition;
 };
 
 
@@ -73,47 +74,97 @@ private:
 };
 
 
-template <class T>
-class RFLockedQueue
+// RFCondition allows a thread to wait until another thread signals a change of a state that is protected by an RFLock.
+class RFCondition
 {
 public:
 
-    inline size_t size()
-    {
-        RFReadWriteAccess qlock(&m_Lock);
+    RFCondition();
 
-        return m_queue.size();
-    }
+    // Releases pLock, which has to be held by the caller, and waits until notifyAll is called or uiTimeoutMs
+    // elapsed. pLock is acquired again before returning. Returns false if the wait timed out.
+    bool wait(RFLock* pLock, unsigned int uiTimeoutMs);
 
-    inline void push(T elem)
-    {
-        RFReadWriteAccess qlock(&m_Lock);
+    // Wakes up all threads that are waiting.
+    void notifyAll();
 
-        m_queue.push(elem);
-    }
+private:
 
-    inline T front()
-    {
-        RFReadWriteAccess qlock(&m_Lock);
+    // Disable copy constructor.
+    RFCondition(const RFCondition& other);
+    // Disable assignment operator.
+    RFCondition& operator= (const RFCondition& rhs);
 
-        return m_queue.front();
-    }
+    CONDITION_VARIABLE m_cv;
+};
 
-    inline T pop()
-    {
-        RFReadWriteAccess qlock(&m_Lock);
 
-        T elem = m_queue.front();
+// RFSharedLock implements a slim reader/writer lock. Any number of threads can hold the lock shared
+// at the same time while an exclusive owner waits until all shared owners released it.
+class RFSharedLock
+{
+public:
 
-        m_queue.pop();
+    RFSharedLock();
+
+    void lockShared();
+    void unlockShared();
+
+    void lockExclusive();
+    void unlockExclusive();
+
+private:
+
+    // Disable copy constructor.
+    RFSharedLock(const RFSharedLock& other);
+    // Disable assignment operator.
+    RFSharedLock& operator= (const RFSharedLock& rhs);
+
+    SRWLOCK m_srw;
+};
 
-        return elem;
-    }
+
+// Class to acquire shared ownership of an RFSharedLock for the lifetime of the instance.
+class RFSharedAccess
+{
+public:
+
+    RFSharedAccess(RFSharedLock* pLock);
+    ~RFSharedAccess();
 
 private:
 
-    RFLock              m_Lock;
-    std::queue<T>       m_queue;
+    RFSharedLock*  m_pLock;
+
+    // Disable default constructor.
+    RFSharedAccess();
+    // Disable assignment operator.
+    RFSharedAccess& operator= (const RFSharedAccess& rhs);
+    // Disable new operator.
+    void* operator new  (size_t size);
+    void* operator new[](size_t size);
+};
+
+
+// Class to acquire exclusive ownership of an RFSharedLock for the lifetime of the instance.
+class RFExclusiveAccess
+{
+public:
+
+    RFExclusiveAccess(RFSharedLock* pLock);
+    ~RFExclusiveAccess();
+
+private:
+
+    RFSharedLock*  m_pLock;
+
+    // Disable default constructor.
+    RFExclusiveAccess();
+    // Disable assignment operator.
+    RFExclusiveAccess& operator= (const RFExclusiveAccess& rhs);
+    // Disable new operator.
+    void* operator new  (size_t size);
+    void* operator new[](size_t size);
 };
 
 
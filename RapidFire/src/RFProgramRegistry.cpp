@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFProgramRegistry.h"
+
+
+std::map<RFProgramRegistry::ProgramKey, RFProgramRegistry::ProgramEntry>   RFProgramRegistry::s_Programs;
+std::map<uint64_t, std::vector<unsigned char>>                              RFProgramRegistry::s_Binaries;
+std::mutex                                                                  RFProgramRegistry::s_lock;
+
+
+cl_program RFProgramRegistry::acquire(cl_context clCtx, cl_device_id clDevId, uint64_t uiKey)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    auto it = s_Programs.find(ProgramKey(clCtx, clDevId, uiKey));
+
+    if (it == s_Programs.end())
+    {
+        return NULL;
+    }
+
+    ++it->second.uiRefCount;
+
+    return it->second.clProgram;
+}
+
+
+cl_program RFProgramRegistry::add(cl_context clCtx, cl_device_id clDevId, uint64_t uiKey, cl_program clProgram)
+{
+    if (!clProgram)
+    {
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    // The program holds a reference to the context. The context can therefore not be deleted, and its handle
+    // not be reused, while the entry exists.
+    auto it = s_Programs.find(ProgramKey(clCtx, clDevId, uiKey));
+
+    if (it != s_Programs.end())
+    {
+        clReleaseProgram(clProgram);
+
+        ++it->second.uiRefCount;
+
+        return it->second.clProgram;
+    }
+
+    ProgramEntry entry;
+
+    entry.clProgram  = clProgram;
+    entry.uiRefCount = 1;
+
+    s_Programs[ProgramKey(clCtx, clDevId, uiKey)] = entry;
+
+    return clProgram;
+}
+
+
+bool RFProgramRegistry::release(cl_program clProgram)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    for (auto it = s_Programs.begin(); it != s_Programs.end(); ++it)
+    {
+        if (it->second.clProgram == clProgram)
+        {
+            if (--it->second.uiRefCount == 0)
+            {
+                clReleaseProgram(it->second.clProgram);
+
+                s_Programs.erase(it);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool RFProgramRegistry::getBinary(uint64_t uiKey, std::vector<unsigned char>& Binary)
+{
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    auto it = s_Binaries.find(uiKey);
+
+    if (it == s_Binaries.end())
+    {
+        return false;
+    }
+
+    Binary = it->second;
+
+    return true;
+}
+
+
+void RFProgramRegistry::addBinary(uint64_t uiKey, const std::vector<unsigned char>& Binary)
+{
+    if (Binary.empty())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(s_lock);
+
+    s_Binaries[uiKey] = Binary;
+}
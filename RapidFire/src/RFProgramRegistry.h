@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <stdint.h>
+
+#include <CL/cl.h>
+
+// RFProgramRegistry shares built OpenCL programs between all sessions of a process. Programs are identified by
+// the context, the device and a key that is computed from the source code and the build options. Sessions that
+// use the same context get the same program and create their own kernels from it, so the kernel arguments stay
+// private to the session.
+// Since each session usually creates its own context, the registry additionally keeps the device binaries of all
+// built programs in memory. A program for a new context is created from this binary without compilation.
+class RFProgramRegistry
+{
+public:
+
+    // Returns the program that was registered for the context, device and key and increments its reference
+    // count. Returns NULL if no program was registered.
+    static cl_program   acquire(cl_context clCtx, cl_device_id clDevId, uint64_t uiKey);
+
+    // Registers a program that was built by the caller and takes ownership of it. If another thread registered a
+    // program with the same context, device and key in the meantime, the program of the caller is released and the
+    // registered program is returned. The program has to be released by calling release().
+    static cl_program   add(cl_context clCtx, cl_device_id clDevId, uint64_t uiKey, cl_program clProgram);
+
+    // Decrements the reference count of the program. The program is released if it is no longer used.
+    // Returns false if the program is not registered.
+    static bool         release(cl_program clProgram);
+
+    // Returns the device binary of a program that was built with the key.
+    static bool         getBinary(uint64_t uiKey, std::vector<unsigned char>& Binary);
+
+    static void         addBinary(uint64_t uiKey, const std::vector<unsigned char>& Binary);
+
+private:
+
+    // Disable constructor.
+    RFProgramRegistry();
+
+    typedef std::tuple<cl_context, cl_device_id, uint64_t>  ProgramKey;
+
+    struct ProgramEntry
+    {
+        cl_program      clProgram;
+        unsigned int    uiRefCount;
+    };
+
+    static std::map<ProgramKey, ProgramEntry>               s_Programs;
+    static std::map<uint64_t, std::vector<unsigned char>>   s_Binaries;
+    static std::mutex                                       s_lock;
+};
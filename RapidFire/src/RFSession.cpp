@@ -30,13 +30,15 @@
 #include "RFEncoderDM.h"
 #include "RFEncoderIdentity.h"
 #include "RFEncoderSettings.h"
+#include "RFEncoderTC.h"
 #include "RFMouseGrab.h"
 #include "RFUtils.h"
 
-// Global lock that can be used to make sure only one thread can work on a resource.
-// Required if multiple threads run a session.
-// Each session has a local lock m_SessionLock which is used to make sure that some functions
-// cannot be interrupted by another thread belonging to the same session.
+// Global lock that serializes context creation and session deletion of all sessions in the process.
+// Frame submission and retrieval never take it.
+// Within a session, submission and retrieval use separate locks (m_SubmitLock, m_RetrieveLock) so that
+// a reader thread does not wait for a running encodeFrame. Both sides hold m_StateLock shared, only
+// resize and teardown acquire it exclusive.
 static RFLock g_GlobalSessionLock;
 
 
@@ -47,12 +49,11 @@ RFSession::RFSession(RFEncoderID rfEncoder)
     , m_pContextCL(nullptr)
     , m_pEncoder(nullptr)
     , m_pEncoderSettings(nullptr)
+    , m_StateLock()
     , m_BufferQueue()
-    , m_SessionLock()
+    , m_SubmitLock()
+    , m_RetrieveLock()
 {
-    // Local lock: Make sure no other thread of the session interrupts the session creation.
-    RFReadWriteAccess enabler(&m_SessionLock);
-
     createSessionLog();
 
     try
@@ -62,6 +63,8 @@ RFSession::RFSession(RFEncoderID rfEncoder)
         m_ParameterMap.addParameter(RF_FLIP_SOURCE, RFParameterAttr("RF_FLIP_SOURCE", RF_PARAMETER_BOOL, 0));
         m_ParameterMap.addParameter(RF_ASYNC_SOURCE_COPY, RFParameterAttr("RF_ASYNC_SOURCE_COPY", RF_PARAMETER_BOOL, 0));
         m_ParameterMap.addParameter(RF_ENCODER_BLOCKING_READ, RFParameterAttr("RF_ENCODER_BLOCKING_READ", RF_PARAMETER_BOOL, 0));
+        m_ParameterMap.addParameter(RF_PIPELINE_DEPTH, RFParameterAttr("RF_PIPELINE_DEPTH", RF_PARAMETER_UINT, DEFAULT_NUM_RESULT_BUFFERS));
+        m_ParameterMap.addParameter(RF_MAX_RENDER_TARGETS, RFParameterAttr("RF_MAX_RENDER_TARGETS", RF_PARAMETER_UINT, DEFAULT_NUM_RENDER_TARGETS));
     }
     catch (const std::exception& e)
     {
@@ -91,21 +94,61 @@ RFSession::~RFSession()
 }
 
 
+void RFSession::lockForTeardown()
+{
+    // A DOPP session may wait for a desktop change in encodeFrame or for a cursor change in getMouseData while
+    // holding m_StateLock shared. Wake them up, otherwise the exclusive lock is never granted. This only covers
+    // calls that are already waiting, the application must not call into the session while deleting it.
+    releaseSessionEvents(RFDesktopNotification);
+    releaseSessionEvents(RFMouseShapeNotification);
+
+    // Wait for running submission and retrieval calls. The lock is not released since the session
+    // is deleted while holding it.
+    m_StateLock.lockExclusive();
+}
+
+
 RFStatus RFSession::createContext()
 {
     // Global lock: Some encoders like AMF fail to initialize if the context
     // creation is interrupted by another thread.
     RFReadWriteAccess enabler(&g_GlobalSessionLock);
 
+    unsigned int uiPipelineDepth    = DEFAULT_NUM_RESULT_BUFFERS;
+    unsigned int uiMaxRenderTargets = DEFAULT_NUM_RENDER_TARGETS;
+
+    m_ParameterMap.getParameterValue(RF_PIPELINE_DEPTH, uiPipelineDepth);
+    m_ParameterMap.getParameterValue(RF_MAX_RENDER_TARGETS, uiMaxRenderTargets);
+
+    if (uiPipelineDepth < MIN_NUM_RESULT_BUFFERS || uiPipelineDepth > MAX_NUM_RESULT_BUFFERS)
+    {
+        std::stringstream oss;
+
+        oss << "[CreateContext]: RF_PIPELINE_DEPTH has to be in the range " << MIN_NUM_RESULT_BUFFERS << " - " << MAX_NUM_RESULT_BUFFERS;
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, oss.str());
+
+        return RF_STATUS_INVALID_SESSION_PROPERTIES;
+    }
+
+    if (uiMaxRenderTargets == 0 || uiMaxRenderTargets > MAX_NUM_RENDER_TARGETS)
+    {
+        std::stringstream oss;
+
+        oss << "[CreateContext]: RF_MAX_RENDER_TARGETS has to be in the range 1 - " << MAX_NUM_RENDER_TARGETS;
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, oss.str());
+
+        return RF_STATUS_INVALID_SESSION_PROPERTIES;
+    }
+
     try
     {
         if (m_Properties.EncoderId == RF_AMF)
         {
-            m_pContextCL = std::unique_ptr<RFContextAMF>(new RFContextAMF);
+            m_pContextCL = std::unique_ptr<RFContextAMF>(new RFContextAMF(uiPipelineDepth, uiMaxRenderTargets));
         }
         else
         {
-            m_pContextCL = std::unique_ptr<RFContextCL>(new RFContextCL);
+            m_pContextCL = std::unique_ptr<RFContextCL>(new RFContextCL(uiPipelineDepth, uiMaxRenderTargets));
         }
 
     }
@@ -174,8 +217,9 @@ RFStatus RFSession::createEncoder(unsigned int uiWidth, unsigned int uiHeight, c
 
 RFStatus RFSession::registerRenderTarget(RFTexture rt, unsigned int uiWidth, unsigned int uiHeight, unsigned int& idx)
 {
-    // Local lock: Make sure no other thread of this session is using the resources.
-    RFReadWriteAccess enabler(&m_SessionLock);
+    // Render targets are only used by the submitting side.
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess SubmitAccess(&m_SubmitLock);
 
     if (!rt.rfRT)
     {
@@ -223,8 +267,9 @@ RFStatus RFSession::registerRenderTarget(RFTexture rt, unsigned int uiWidth, uns
 
 RFStatus RFSession::removeRenderTarget(unsigned int idx)
 {
-    // Local lock: Make sure no other thread of this session is using the resources
-    RFReadWriteAccess enabler(&m_SessionLock);
+    // Render targets are only used by the submitting side.
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess SubmitAccess(&m_SubmitLock);
 
     SAFE_CALL_RF(m_pContextCL->removeCLInputMemObj(idx));
 
@@ -251,8 +296,10 @@ RFStatus RFSession::getRenderTargetState(RFRenderTargetState* state, unsigned in
 // the application.
 RFStatus RFSession::encodeFrame(unsigned int idx)
 {
-    // Local lock: Make sure no other thread of this session is using the resources
-    RFReadWriteAccess enabler(&m_SessionLock);
+    // Only other submitting threads are blocked. A reader thread can retrieve frames while the
+    // frame is processed, m_BufferQueue is safe for one producer and one consumer.
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess SubmitAccess(&m_SubmitLock);
 
     // Check if we have a valid encoder. Having a valid encoder implies thet we have a valid
     // context as well.
@@ -296,7 +343,17 @@ RFStatus RFSession::encodeFrame(unsigned int idx)
     SAFE_CALL_RF(m_pContextCL->processBuffer(m_Properties.bEncoderCSC, m_Properties.bInvertInput, idx, m_uiResultBuffer));
 
     // Encode frame
-    SAFE_CALL_RF(m_pEncoder->encode(m_uiResultBuffer, !m_Properties.bEncoderCSC));
+    rfStatus = m_pEncoder->encode(m_uiResultBuffer, !m_Properties.bEncoderCSC);
+
+    if (rfStatus != RF_STATUS_OK)
+    {
+        // The frame is dropped. A diff map computed by processBuffer for the next frame must not be based on it.
+        m_pContextCL->invalidateDiffSignatures();
+
+        rfError(rfStatus, getErrorStringRF(rfStatus), __FILE__, __LINE__);
+
+        return rfStatus;
+    }
 
     // Store result buffer index in queue since processBuffer filled a new resultBuffer. The ResultBuffer
     // should only be considered as valid if the enode call succeeded. Only in this case a valid pair of
@@ -312,6 +369,9 @@ RFStatus RFSession::encodeFrame(unsigned int idx)
 
 RFStatus RFSession::getEncodedFrame(unsigned int& uiSize, void* &pBitStream)
 {
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess RetrieveAccess(&m_RetrieveLock);
+
     if (!m_pEncoder)
     {
         return RF_STATUS_INVALID_ENCODER;
@@ -330,39 +390,133 @@ RFStatus RFSession::getEncodedFrame(unsigned int& uiSize, void* &pBitStream)
         m_BufferQueue.pop();
     }
 
+    if (status == RF_STATUS_OK && m_pCompressor)
+    {
+        if (!m_pCompressor->compress(pBitStream, uiSize, pBitStream, uiSize))
+        {
+            uiSize     = 0;
+            pBitStream = nullptr;
+
+            return RF_STATUS_MEMORY_FAIL;
+        }
+    }
+
     return status;
 }
 
 
-RFStatus RFSession::getSourceFrame(unsigned int& uiSize, void* &pBitStream)
+RFStatus RFSession::getEncodedFrameCL(RFEncodedFrameCL& Frame)
 {
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess RetrieveAccess(&m_RetrieveLock);
+
     if (!m_pEncoder)
     {
         return RF_STATUS_INVALID_ENCODER;
     }
 
-    uiSize = 0;
-    pBitStream = nullptr;
+    Frame.clOutput     = nullptr;
+    Frame.clSource     = nullptr;
+    Frame.clEvent      = nullptr;
+    Frame.uiOutputSize = 0;
+    Frame.uiSourceSize = 0;
 
-    unsigned int idx = 0;
+    return m_pEncoder->getEncodedFrameCL(Frame);
+}
 
+
+RFStatus RFSession::releaseEncodedFrameCL()
+{
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess RetrieveAccess(&m_RetrieveLock);
+
+    if (!m_pEncoder)
     {
-        // Local lock: Ensure that m_BufferQueue is not accessed by other threads.
-        // This is required if an async reader thread is used. In this case encodeFrame
-        // might access the queue while we read the front index.
-        RFReadWriteAccess enabler(&m_SessionLock);
+        return RF_STATUS_INVALID_ENCODER;
+    }
 
-        if (m_BufferQueue.size() == 0)
-        {
-            return RF_STATUS_NO_ENCODED_FRAME;
-        }
+    RFStatus status = m_pEncoder->releaseEncodedFrameCL();
+
+    if (status == RF_STATUS_OK && m_BufferQueue.size() > 0)
+    {
+        // The result buffer that was the source of the frame can be reused by encodeFrame.
+        m_BufferQueue.pop();
+    }
+
+    return status;
+}
+
+
+RFStatus RFSession::createDiffConsumer(unsigned int& uiConsumer)
+{
+    // The encoder synchronizes its consumers.
+    RFSharedAccess StateAccess(&m_StateLock);
+
+    if (!m_pEncoder)
+    {
+        return RF_STATUS_INVALID_ENCODER;
+    }
+
+    return m_pEncoder->createConsumer(uiConsumer);
+}
+
+
+RFStatus RFSession::deleteDiffConsumer(unsigned int uiConsumer)
+{
+    // The encoder synchronizes its consumers.
+    RFSharedAccess StateAccess(&m_StateLock);
+
+    if (!m_pEncoder)
+    {
+        return RF_STATUS_INVALID_ENCODER;
+    }
+
+    return m_pEncoder->deleteConsumer(uiConsumer);
+}
+
+
+RFStatus RFSession::getDiffConsumerFrame(unsigned int uiConsumer, unsigned int& uiSize, void* &pDiffMap)
+{
+    // The encoder synchronizes its consumers.
+    RFSharedAccess StateAccess(&m_StateLock);
+
+    if (!m_pEncoder)
+    {
+        return RF_STATUS_INVALID_ENCODER;
+    }
+
+    uiSize   = 0;
+    pDiffMap = nullptr;
 
-        // Get index of the oldest element in the queue. This is the index that will be used for the next call to
-        // get getEncodedFrame. If getSourceFrame is called prior to getEncoded frame the source frame is the one
-        // that was used to generate the encoded frame.
-        idx = m_BufferQueue.front();
+    return m_pEncoder->getConsumerFrame(uiConsumer, uiSize, pDiffMap);
+}
+
+
+RFStatus RFSession::getSourceFrame(unsigned int& uiSize, void* &pBitStream)
+{
+    // The retrieve lock keeps the front index valid until the result buffer was read. encodeFrame
+    // only pushes to m_BufferQueue and does not need to be blocked.
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess RetrieveAccess(&m_RetrieveLock);
+
+    if (!m_pEncoder)
+    {
+        return RF_STATUS_INVALID_ENCODER;
+    }
+
+    uiSize = 0;
+    pBitStream = nullptr;
+
+    if (m_BufferQueue.size() == 0)
+    {
+        return RF_STATUS_NO_ENCODED_FRAME;
     }
 
+    // Get index of the oldest element in the queue. This is the index that will be used for the next call to
+    // get getEncodedFrame. If getSourceFrame is called prior to getEncoded frame the source frame is the one
+    // that was used to generate the encoded frame.
+    unsigned int idx = m_BufferQueue.front();
+
     void* pBuffer = nullptr;
 
     m_pContextCL->getResultBuffer(idx, pBuffer);
@@ -382,17 +536,16 @@ RFStatus RFSession::getSourceFrame(unsigned int& uiSize, void* &pBitStream)
 
 RFStatus RFSession::releaseEvent(RFNotification const rfEvent)
 {
-    // Local lock: Make sure no other thread of this session is using the resources.
-    RFReadWriteAccess enabler(&m_SessionLock);
-
+    // No lock: releaseSessionEvents only signals events and has to wake up an encodeFrame or resize that
+    // is waiting for a desktop change while holding the session locks.
     return releaseSessionEvents(rfEvent);
 }
 
 
 RFStatus RFSession::resize(unsigned int uiWidth, unsigned int uiHeight)
 {
-    // Local lock: Make sure no other thread of this session is using the resources.
-    RFReadWriteAccess enabler(&m_SessionLock);
+    // Exclusive lock: All buffers are recreated, wait until submission and retrieval calls returned.
+    RFExclusiveAccess StateAccess(&m_StateLock);
 
     m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_INFO, "Changing resolution");
 
@@ -611,8 +764,15 @@ RFStatus RFSession::createEncoder()
         {
             pEncoder = new (std::nothrow)RFEncoderIdentity;
 
+            bool bCompact = false;
+
+            // Compacted frames are transferred by the encoder, the full frame does not need to be copied to sys mem.
+            if (m_pEncoderSettings->getParameterValue(RF_IDENTITY_ENCODER_COMPACT, bCompact) && bCompact)
+            {
+                m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_INFO, "[rfCreateEncoder] IDENTITY encoder compacts frames before readback");
+            }
             // Try to update parameter. If user set value explicitly this will fail.
-            if (m_ParameterMap.setParameterValue(RF_ASYNC_SOURCE_COPY, 1))
+            else if (m_ParameterMap.setParameterValue(RF_ASYNC_SOURCE_COPY, 1))
             {
                 m_Properties.bAsyncCopyToSysMem = true;
             }
@@ -640,6 +800,32 @@ RFStatus RFSession::createEncoder()
             break;
         }
 
+        case RF_TILE_CACHE:
+        {
+            pEncoder = new (std::nothrow)RFEncoderTC;
+
+            if (!pEncoder)
+            {
+                m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] Failed to create TILE CACHE encoder");
+                return RF_STATUS_FAIL;
+            }
+
+            // The pixels of new tiles are read from the copy of the frame in system memory.
+            // Try to update parameter. If user set value explicitly this will fail.
+            if (m_ParameterMap.setParameterValue(RF_ASYNC_SOURCE_COPY, 1))
+            {
+                m_Properties.bAsyncCopyToSysMem = true;
+            }
+            else if (m_Properties.bAsyncCopyToSysMem == false)
+            {
+                delete pEncoder;
+
+                m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] TILE CACHE encoder requires RF_ASYNC_SOURCE_COPY but application requested to turn it off");
+                return RF_STATUS_INVALID_ENCODER_PARAMETER;
+            }
+            break;
+        }
+
         default:
             m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] No encoder defined");
             return RF_STATUS_INVALID_ENCODER;
@@ -670,6 +856,16 @@ RFStatus RFSession::createEncoder()
         return rfStatus;
     }
 
+    rfStatus = createCompressor();
+
+    if (rfStatus != RF_STATUS_OK)
+    {
+        m_pEncoder.reset();
+        m_pEncoder = nullptr;
+
+        return rfStatus;
+    }
+
     // Update m_pEncoderSettings with the values actually useed by the encoder.
     validateEncoderSettings();
 
@@ -696,10 +892,12 @@ RFStatus RFSession::createEncoder()
         m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_INFO, oss.str());
     }
 
-    // Make sure the buffer queue is empty.
-    while (m_BufferQueue.size() > 0)
+    // Make sure the buffer queue is empty and can hold a frame per result buffer.
+    if (!m_BufferQueue.init(m_pContextCL->getNumResultBuffers()))
     {
-        m_BufferQueue.pop();
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] Failed to create buffer queue");
+
+        return RF_STATUS_MEMORY_FAIL;
     }
 
     m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_INFO, "[rfCreateEncoder] RFEncoder create successfully");
@@ -712,6 +910,51 @@ RFStatus RFSession::createEncoder()
 }
 
 
+RFStatus RFSession::createCompressor()
+{
+    bool bCompress = false;
+
+    m_pCompressor.reset();
+
+    if (!m_pEncoderSettings->getParameterValue(RF_OUTPUT_COMPRESSION, bCompress) || !bCompress)
+    {
+        return RF_STATUS_OK;
+    }
+
+    if (m_Properties.EncoderId != RF_IDENTITY && m_Properties.EncoderId != RF_DIFFERENCE)
+    {
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] RF_OUTPUT_COMPRESSION is only supported by the IDENTITY and DIFFERENCE encoder");
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    unsigned int uiChunkSize  = m_pEncoderSettings->getParameterValue<unsigned int>(RF_OUTPUT_COMPRESSION_CHUNK_SIZE);
+    unsigned int uiNumThreads = m_pEncoderSettings->getParameterValue<unsigned int>(RF_OUTPUT_COMPRESSION_THREADS);
+
+    if (uiChunkSize == 0)
+    {
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] RF_OUTPUT_COMPRESSION_CHUNK_SIZE has to be larger than 0");
+        return RF_STATUS_INVALID_ENCODER_PARAMETER;
+    }
+
+    try
+    {
+        m_pCompressor = std::unique_ptr<RFCompressor>(new RFCompressor(uiChunkSize, uiNumThreads));
+    }
+    catch (...)
+    {
+        m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_ERROR, "[rfCreateEncoder] Failed to create output compressor");
+        return RF_STATUS_MEMORY_FAIL;
+    }
+
+    std::stringstream oss;
+
+    oss << "[rfCreateEncoder] Output compression with " << m_pCompressor->getNumThreads() << " threads and chunks of " << uiChunkSize << " bytes";
+    m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_INFO, oss.str());
+
+    return RF_STATUS_OK;
+}
+
+
 void RFSession::createSessionLog()
 {
     DWORD dwThreadId = GetCurrentThreadId();
@@ -798,13 +1041,12 @@ RFStatus RFSession::setEncodeParameter(const int param, RFProperties value)
         return RF_STATUS_INVALID_ENCODER_PARAMETER;
     }
 
-    // Local lock: Lock update of parameters.
-    m_SessionLock.lock();
+    // The encoder parameters are only used while submitting frames.
+    RFSharedAccess    StateAccess(&m_StateLock);
+    RFReadWriteAccess SubmitAccess(&m_SubmitLock);
 
     RFStatus rfErr = m_pEncoder->setParameter(param, rfType, value);
 
-    m_SessionLock.unlock();
-
     if (rfErr != RF_STATUS_OK)
     {
         return RF_STATUS_INVALID_ENCODER_PARAMETER;
@@ -1095,6 +1337,11 @@ void RFSession::dumpContextProperties()
 
         oss << "\t\t\t Async Copy : " << m_pContextCL->getAsyncCopy() << std::endl;
 
+        if (m_pContextCL->getHostCSCInstructionSet())
+        {
+            oss << "\t\t\t Host CSC   : " << m_pContextCL->getHostCSCInstructionSet() << std::endl;
+        }
+
         m_pSessionLog->logMessage(RFLogFile::MessageType::RF_LOG_INFO, oss.str());
     }
 }
\ No newline at end of file
@@ -23,12 +23,13 @@
 #pragma once
 
 #include <memory>
-#include <queue>
 
+#include "RFCompressor.h"
 #include "RFContext.h"
 #include "RFEncoder.h"
 #include "RFLock.h"
 #include "RFPropertyMap.h"
+#include "RFSpscQueue.h"
 
 class RFEncoderSettings;
 class RFMouseGrab;
@@ -41,6 +42,11 @@ public:
     explicit RFSession(RFEncoderID rfEncoder);
     virtual ~RFSession();
 
+    // Releases the session events and waits until all calls of other threads into this session returned.
+    // Blocks new calls. Has to be called before the session is deleted. The application has to stop calling
+    // into the session before, calls that start waiting for an event afterwards are not released.
+    void                  lockForTeardown();
+
     // Creates the graphics context that is used by the calling application and
     // the OpenCL context that is required for the color space conversion.
     RFStatus              createContext();
@@ -63,6 +69,18 @@ public:
 
     RFStatus              getSourceFrame(unsigned int& uiSize, void* &pBitStream);
 
+    // Returns the GPU buffers of the encoded frame. The frame and its source stay reserved until releaseEncodedFrameCL is called.
+    RFStatus              getEncodedFrameCL(RFEncodedFrameCL& Frame);
+
+    RFStatus              releaseEncodedFrameCL();
+
+    // Creates a consumer that accumulates the diff maps of all frames encoded since its last call to getDiffConsumerFrame.
+    RFStatus              createDiffConsumer(unsigned int& uiConsumer);
+
+    RFStatus              deleteDiffConsumer(unsigned int uiConsumer);
+
+    RFStatus              getDiffConsumerFrame(unsigned int uiConsumer, unsigned int& uiSize, void* &pDiffMap);
+
     RFStatus              releaseEvent(const RFNotification rfEvent);
 
     RFStatus              resize(unsigned int uiWidth, unsigned int uiHeight);
@@ -108,6 +126,10 @@ protected:
 
     std::unique_ptr<RFLogFile>            m_pSessionLog;
 
+    // Held shared by submission and retrieval calls and by getMouseData. resize and teardown hold it exclusive
+    // since they replace the buffers that both sides are using. Mutable since getMouseData is const.
+    mutable RFSharedLock                  m_StateLock;
+
 private:
 
     // This function needs to be implemented by a derived class to create the OpenCL context based
@@ -144,6 +166,10 @@ private:
 
     RFStatus                    createEncoder();
 
+    // Creates m_pCompressor if RF_OUTPUT_COMPRESSION is set. Has to be called before validateEncoderSettings since
+    // the compression parameters are not used by the encoder.
+    RFStatus                    createCompressor();
+
     // Returns the path to the RF DLL that was loaded and the version of the DLL
     bool                        getModuleInformation(std::string& strPath, std::string& strVersion);
 
@@ -156,10 +182,19 @@ private:
     // The encoder that is used by the session
     std::unique_ptr<RFEncoder>                      m_pEncoder;
 
-    // List of submitted buffers
-    RFLockedQueue<unsigned int>                     m_BufferQueue;
+    // Compresses the output of the encoder if RF_OUTPUT_COMPRESSION is set.
+    std::unique_ptr<RFCompressor>                   m_pCompressor;
+
+    // List of submitted buffers. Pushed by encodeFrame and popped by the thread that retrieves the frames.
+    // Besides the queue the encoders share state between encode and getEncodedFrame, each encoder has to
+    // synchronize it since both may run concurrently.
+    RFSpscQueue<unsigned int>                       m_BufferQueue;
+
+    // Serializes the threads that submit frames or change the encoder state.
+    RFLock                                          m_SubmitLock;
 
-    RFLock                                          m_SessionLock;
+    // Serializes the threads that retrieve frames. m_BufferQueue allows only one consumer at a time.
+    RFLock                                          m_RetrieveLock;
 };
 
 extern RFStatus createRFSession(RFSession** session, const RFProperties* properties);
\ No newline at end of file
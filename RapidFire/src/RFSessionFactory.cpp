@@ -59,6 +59,7 @@ RFStatus createRFSession(RFSession** pSession, const RFProperties* properties)
     unsigned int            uiDesktop = 0;
     unsigned int            uiDisplay = 0;
     unsigned int            uiInternalDisplayId = UINT_MAX;
+    bool                    bHostMemory = false;
 
     RFEncoderID             rfEncoder = RF_ENCODER_UNKNOWN;
 
@@ -72,6 +73,7 @@ RFStatus createRFSession(RFSession** pSession, const RFProperties* properties)
     //          c. Dx9Ex          -> RF_D3D9EX_DEVICE needs to be set
     //          d. Dx11           -> RF_D3D11_DEVICE needs to be set
     //          e. Desktop        -> RF_DESKTOP or RF_DESKTOP_DSP_ID need to be set
+    //          f. System memory  -> RF_HOST_MEMORY needs to be set
     //
     // All remaining properties are optional and are passed to the session. Depending on the session
     // type different parameters are supported
@@ -118,6 +120,10 @@ RFStatus createRFSession(RFSession** pSession, const RFProperties* properties)
                 uiInternalDisplayId = static_cast<unsigned int>(p->ptr);
                 break;
 
+            case RF_HOST_MEMORY:
+                bHostMemory = (p->ptr != 0);
+                break;
+
             default:
                 parameters[p->name] = p->ptr;
         }
@@ -169,6 +175,11 @@ RFStatus createRFSession(RFSession** pSession, const RFProperties* properties)
             // Desktop session based on internal Display ID
             *pSession = new RFDOPPSession(rfEncoder, hDC, hGLRC);
         }
+        else if (bHostMemory && hDC == NULL && hGLRC == NULL && pDX9 == nullptr && pDX9Ex == nullptr && pDX11 == nullptr && uiDesktop == 0 && uiDisplay == 0 && uiInternalDisplayId == UINT_MAX)
+        {
+            // Session reading from system memory
+            *pSession = new RFHostSession(rfEncoder);
+        }
     }
     catch (...)
     {
@@ -0,0 +1,142 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+// Size of the padding that keeps the indices of RFSpscQueue on separate cache lines.
+#define RF_CACHE_LINE_SIZE  64
+
+// RFSpscQueue is a bounded FIFO for exactly one producer thread and one consumer thread. push is only called by the
+// producer, front and pop only by the consumer, size by both. No operation blocks or takes a lock. The producer
+// publishes an element by a release store of the tail that the consumer reads with acquire, and the consumer
+// returns a slot by a release store of the head. The indices are on separate cache lines to avoid false sharing.
+template <class T>
+class RFSpscQueue
+{
+public:
+
+    RFSpscQueue()
+        : m_uiCapacity(0)
+        , m_uiHead(0)
+        , m_uiTail(0)
+    {}
+
+    // Allocates storage for uiCapacity elements and removes all elements. Must not be called while other threads
+    // access the queue.
+    bool init(size_t uiCapacity)
+    {
+        m_pElements.reset((uiCapacity > 0) ? new (std::nothrow) T[uiCapacity] : nullptr);
+
+        m_uiCapacity = (m_pElements) ? uiCapacity : 0;
+
+        m_uiHead.store(0, std::memory_order_relaxed);
+        m_uiTail.store(0, std::memory_order_release);
+
+        return (m_uiCapacity == uiCapacity);
+    }
+
+    // Returns the number of elements. The head is read first so that the result never underflows while the other
+    // thread modifies the queue.
+    inline size_t size() const
+    {
+        const size_t uiHead = m_uiHead.load(std::memory_order_acquire);
+
+        return m_uiTail.load(std::memory_order_acquire) - uiHead;
+    }
+
+    inline size_t capacity() const
+    {
+        return m_uiCapacity;
+    }
+
+    // Appends elem. Returns false if the queue is full.
+    inline bool push(const T& elem)
+    {
+        const size_t uiTail = m_uiTail.load(std::memory_order_relaxed);
+
+        if (uiTail - m_uiHead.load(std::memory_order_acquire) >= m_uiCapacity)
+        {
+            return false;
+        }
+
+        m_pElements[uiTail % m_uiCapacity] = elem;
+
+        m_uiTail.store(uiTail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Returns the oldest element or T() if the queue is empty.
+    inline T front() const
+    {
+        const size_t uiHead = m_uiHead.load(std::memory_order_relaxed);
+
+        if (m_uiTail.load(std::memory_order_acquire) == uiHead)
+        {
+            return T();
+        }
+
+        return m_pElements[uiHead % m_uiCapacity];
+    }
+
+    // Removes and returns the oldest element or T() if the queue is empty.
+    inline T pop()
+    {
+        const size_t uiHead = m_uiHead.load(std::memory_order_relaxed);
+
+        if (m_uiTail.load(std::memory_order_acquire) == uiHead)
+        {
+            return T();
+        }
+
+        T elem = m_pElements[uiHead % m_uiCapacity];
+
+        m_uiHead.store(uiHead + 1, std::memory_order_release);
+
+        return elem;
+    }
+
+private:
+
+    // Disable copy constructor.
+    RFSpscQueue(const RFSpscQueue& other);
+    // Disable assignment operator.
+    RFSpscQueue& operator=(const RFSpscQueue& rhs);
+
+    std::unique_ptr<T[]>    m_pElements;
+    size_t                  m_uiCapacity;
+
+    // Index of the next element to pop, written by the consumer.
+    char                    m_HeadPadding[RF_CACHE_LINE_SIZE];
+    std::atomic<size_t>     m_uiHead;
+
+    // Index of the next element to push, written by the producer.
+    char                    m_TailPadding[RF_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t>     m_uiTail;
+    char                    m_EndPadding[RF_CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+};
@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFThreadPool.h"
+
+#include <algorithm>
+
+
+RFThreadPool::RFThreadPool(unsigned int uiNumThreads)
+    : m_uiNumThreads(uiNumThreads)
+    , m_pJob(nullptr)
+    , m_uiJobCount(0)
+    , m_uiJobRange(0)
+    , m_uiJobGeneration(0)
+    , m_uiPendingWorkers(0)
+    , m_bTerminate(false)
+{
+    if (m_uiNumThreads == 0)
+    {
+        m_uiNumThreads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // The calling thread works on the first range, so one thread less needs to be created.
+    for (unsigned int i = 1; i < m_uiNumThreads; ++i)
+    {
+        try
+        {
+            m_Workers.push_back(std::thread(&RFThreadPool::workerLoop, this, i));
+        }
+        catch (...)
+        {
+            // Continue with the threads that could be created.
+            break;
+        }
+    }
+
+    m_uiNumThreads = static_cast<unsigned int>(m_Workers.size()) + 1;
+}
+
+
+RFThreadPool::~RFThreadPool()
+{
+    {
+        RFReadWriteAccess access(&m_Lock);
+
+        m_bTerminate = true;
+    }
+
+    m_WorkAvailable.notifyAll();
+
+    for (auto& t : m_Workers)
+    {
+        if (t.joinable())
+        {
+            t.join();
+        }
+    }
+}
+
+
+void RFThreadPool::run(unsigned int uiCount, unsigned int uiMinRange, const RFRangeFunction& fn)
+{
+    if (uiCount == 0)
+    {
+        return;
+    }
+
+    uiMinRange = std::max(1U, uiMinRange);
+
+    // Size of the range each thread is processing.
+    unsigned int uiRange = std::max(uiMinRange, (uiCount + m_uiNumThreads - 1) / m_uiNumThreads);
+
+    if (m_Workers.empty() || uiRange >= uiCount)
+    {
+        fn(0, uiCount);
+        return;
+    }
+
+    RFReadWriteAccess runAccess(&m_RunLock);
+
+    {
+        RFReadWriteAccess access(&m_Lock);
+
+        m_pJob             = &fn;
+        m_uiJobCount       = uiCount;
+        m_uiJobRange       = uiRange;
+        m_uiPendingWorkers = static_cast<unsigned int>(m_Workers.size());
+
+        ++m_uiJobGeneration;
+    }
+
+    m_WorkAvailable.notifyAll();
+
+    // The calling thread processes the first range.
+    fn(0, uiRange);
+
+    RFReadWriteAccess access(&m_Lock);
+
+    while (m_uiPendingWorkers > 0)
+    {
+        m_WorkDone.wait(&m_Lock, INFINITE);
+    }
+
+    m_pJob = nullptr;
+}
+
+
+void RFThreadPool::workerLoop(unsigned int uiWorkerIdx)
+{
+    uint64_t uiLastGeneration = 0;
+
+    for (;;)
+    {
+        const RFRangeFunction* pJob = nullptr;
+        unsigned int uiBegin = 0;
+        unsigned int uiEnd   = 0;
+
+        {
+            RFReadWriteAccess access(&m_Lock);
+
+            while (!m_bTerminate && m_uiJobGeneration == uiLastGeneration)
+            {
+                m_WorkAvailable.wait(&m_Lock, INFINITE);
+            }
+
+            if (m_bTerminate)
+            {
+                return;
+            }
+
+            uiLastGeneration = m_uiJobGeneration;
+
+            pJob    = m_pJob;
+            uiBegin = std::min(m_uiJobCount, uiWorkerIdx * m_uiJobRange);
+            uiEnd   = std::min(m_uiJobCount, uiBegin + m_uiJobRange);
+        }
+
+        if (pJob && uiBegin < uiEnd)
+        {
+            (*pJob)(uiBegin, uiEnd);
+        }
+
+        bool bLastWorker = false;
+
+        {
+            RFReadWriteAccess access(&m_Lock);
+
+            bLastWorker = (--m_uiPendingWorkers == 0);
+        }
+
+        if (bLastWorker)
+        {
+            m_WorkDone.notifyAll();
+        }
+    }
+}
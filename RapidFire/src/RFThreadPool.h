@@ -0,0 +1,80 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "RFLock.h"
+
+// RFThreadPool keeps a set of worker threads alive for the lifetime of the pool and splits
+// a range of work items between them. It is used for the CPU side image processing where
+// the same job is executed once per frame and creating threads per frame would be too costly.
+class RFThreadPool
+{
+public:
+
+    typedef std::function<void(unsigned int uiBegin, unsigned int uiEnd)> RFRangeFunction;
+
+    // Creates a pool with uiNumThreads threads including the calling thread. If uiNumThreads
+    // is 0 the number of hardware threads is used.
+    explicit RFThreadPool(unsigned int uiNumThreads = 0);
+    ~RFThreadPool();
+
+    // Splits [0, uiCount) into contiguous ranges of at least uiMinRange items and calls fn for
+    // each range. The calling thread processes the first range. run blocks until all ranges are done.
+    void            run(unsigned int uiCount, unsigned int uiMinRange, const RFRangeFunction& fn);
+
+    unsigned int    getNumThreads() const { return m_uiNumThreads; }
+
+private:
+
+    // Disable copy constructor.
+    RFThreadPool(const RFThreadPool& other);
+    // Disable assignment operator.
+    RFThreadPool& operator=(const RFThreadPool& rhs);
+
+    void            workerLoop(unsigned int uiWorkerIdx);
+
+    unsigned int                m_uiNumThreads;
+    std::vector<std::thread>    m_Workers;
+
+    // Serializes concurrent calls to run.
+    RFLock                      m_RunLock;
+
+    // Protects the job description and the worker state below.
+    RFLock                      m_Lock;
+    RFCondition                 m_WorkAvailable;
+    RFCondition                 m_WorkDone;
+
+    // Description of the job that is currently executed.
+    const RFRangeFunction*      m_pJob;
+    unsigned int                m_uiJobCount;
+    unsigned int                m_uiJobRange;
+    uint64_t                    m_uiJobGeneration;
+    unsigned int                m_uiPendingWorkers;
+
+    bool                        m_bTerminate;
+};
@@ -0,0 +1,82 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#include "RFTileCache.h"
+
+
+RFTileCache::RFTileCache()
+{}
+
+
+void RFTileCache::reset(unsigned int uiNumSlots)
+{
+    m_Slots.resize(uiNumSlots);
+    m_LRU.clear();
+    m_SlotMap.clear();
+
+    for (unsigned int i = 0; i < uiNumSlots; ++i)
+    {
+        m_Slots[i].uiHash = 0;
+        m_Slots[i].bValid = false;
+        m_Slots[i].itLRU  = m_LRU.insert(m_LRU.end(), i);
+    }
+}
+
+
+bool RFTileCache::lookup(uint64_t uiHash, unsigned int& uiSlot)
+{
+    if (m_Slots.empty())
+    {
+        return false;
+    }
+
+    auto itSlot = m_SlotMap.find(uiHash);
+
+    if (itSlot != m_SlotMap.end())
+    {
+        uiSlot = itSlot->second;
+
+        m_LRU.splice(m_LRU.begin(), m_LRU, m_Slots[uiSlot].itLRU);
+
+        return true;
+    }
+
+    // Replace the least recently used tile. Unused slots are at the end of the list.
+    uiSlot = m_LRU.back();
+
+    Slot& s = m_Slots[uiSlot];
+
+    if (s.bValid)
+    {
+        m_SlotMap.erase(s.uiHash);
+    }
+
+    s.uiHash = uiHash;
+    s.bValid = true;
+
+    m_SlotMap[uiHash] = uiSlot;
+
+    m_LRU.splice(m_LRU.begin(), m_LRU, s.itLRU);
+
+    return false;
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// RFTileCache mirrors the tile store of a client. It maps the content hash of a tile to one of
+// uiNumSlots slots and evicts the least recently used tile if a new tile needs to be stored.
+// The client has to apply the hits and misses in the same order as they were returned by lookup.
+class RFTileCache
+{
+public:
+
+    RFTileCache();
+
+    // Removes all tiles and sets the number of slots.
+    void            reset(unsigned int uiNumSlots);
+
+    // Returns true and the slot of the tile if a tile with uiHash is stored. Otherwise the tile is
+    // stored in the least recently used slot which is returned in uiSlot.
+    bool            lookup(uint64_t uiHash, unsigned int& uiSlot);
+
+    unsigned int    getNumSlots() const { return static_cast<unsigned int>(m_Slots.size()); }
+
+private:
+
+    // Disable copy constructor.
+    RFTileCache(const RFTileCache& other);
+    // Disable assignment operator.
+    RFTileCache& operator=(const RFTileCache& rhs);
+
+    struct Slot
+    {
+        uint64_t                            uiHash;
+        bool                                bValid;
+        std::list<unsigned int>::iterator   itLRU;
+    };
+
+    std::vector<Slot>                           m_Slots;
+
+    // Slots ordered by their last use, the most recently used slot is at the front.
+    std::list<unsigned int>                     m_LRU;
+
+    std::unordered_map<uint64_t, unsigned int>  m_SlotMap;
+};
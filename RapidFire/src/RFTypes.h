@@ -24,14 +24,25 @@
 
 #include "RapidFire.h"
 
-/* Support of multiple render targets
+/* Number of render targets that can be registered with a session. Can be changed with RF_MAX_RENDER_TARGETS.
    1 : allow only single buffering
    2 : allow double buffering
    3 : allow triple buffering
  */
-#define MAX_NUM_RENDER_TARGETS                        3
+#define DEFAULT_NUM_RENDER_TARGETS                    3
+#define MAX_NUM_RENDER_TARGETS                        16
 
-#define NUM_RESULT_BUFFERS                            3
+/* Number of frames that can be in flight between rfEncodeFrame and rfGetEncodedFrame. Can be changed with
+   RF_PIPELINE_DEPTH. The difference encoder needs at least 2 result buffers.
+ */
+#define DEFAULT_NUM_RESULT_BUFFERS                    3
+#define MIN_NUM_RESULT_BUFFERS                        2
+#define MAX_NUM_RESULT_BUFFERS                        16
+
+/* Time in ms rfEncodeFrame waits for a free diff map buffer of the difference encoder. Can be changed with
+   RF_DIFF_ENCODER_QUEUE_TIMEOUT. The default gives a reader thread a short time to retrieve a diff map.
+ */
+#define DEFAULT_DIFF_MAP_QUEUE_TIMEOUT                5
 
 enum RFParameterType { RF_PARAMETER_UNKNOWN = -1, RF_PARAMETER_BOOL = 0, RF_PARAMETER_INT = 1, RF_PARAMETER_UINT = 2, RF_PARAMETER_PTR = 3 };
 
@@ -25,7 +25,10 @@
 #include <limits.h>
 
 #if defined WIN32 || defined _WIN32
+#include <intrin.h>
 #include <windows.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
 #endif
 
 float Timer::s_clockTime = 0.0;
@@ -139,6 +142,20 @@ bool utilIsPropertyValid(size_t Property)
 }
 
 
+uint64_t utilHash64(const void* pData, size_t uiSize, uint64_t uiHash)
+{
+    const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+
+    for (size_t i = 0; i < uiSize; ++i)
+    {
+        uiHash ^= pBytes[i];
+        uiHash *= 1099511628211ULL;
+    }
+
+    return uiHash;
+}
+
+
 #ifdef _DEBUG
 
 void dumpCLBuffer(cl_mem clBuffer, RFContextCL* pContext, unsigned int uiWidth, unsigned int uiHeight, RFFormat rfFormat, const char* pFileName)
@@ -217,4 +234,81 @@ void dumpCLBuffer(cl_mem clBuffer, RFContextCL* pContext, unsigned int uiWidth,
 
 #endif // _DEBUG
 
-#endif // if defined WIN32 || defined _WIN32
\ No newline at end of file
+#endif // if defined WIN32 || defined _WIN32
+
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+
+static void utilCpuId(int iLeaf, int iSubLeaf, int pRegs[4])
+{
+#if defined WIN32 || defined _WIN32
+    __cpuidex(pRegs, iLeaf, iSubLeaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(iLeaf, iSubLeaf, a, b, c, d);
+    pRegs[0] = a; pRegs[1] = b; pRegs[2] = c; pRegs[3] = d;
+#endif
+}
+
+
+bool utilCpuSupportsSSE41()
+{
+    int pRegs[4] = { 0 };
+
+    utilCpuId(1, 0, pRegs);
+
+    return (pRegs[2] & (1 << 19)) != 0;
+}
+
+
+bool utilCpuSupportsAVX2()
+{
+    int pRegs[4] = { 0 };
+
+    utilCpuId(0, 0, pRegs);
+
+    if (pRegs[0] < 7)
+    {
+        return false;
+    }
+
+    utilCpuId(1, 0, pRegs);
+
+    // AVX and OSXSAVE are required to check if the OS saves the YMM registers.
+    if ((pRegs[2] & (1 << 27)) == 0 || (pRegs[2] & (1 << 28)) == 0)
+    {
+        return false;
+    }
+
+#if defined WIN32 || defined _WIN32
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int uiEax, uiEdx;
+    __asm__ ("xgetbv" : "=a"(uiEax), "=d"(uiEdx) : "c"(0));
+    unsigned long long xcr0 = (static_cast<unsigned long long>(uiEdx) << 32) | uiEax;
+#endif
+
+    if ((xcr0 & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    utilCpuId(7, 0, pRegs);
+
+    return (pRegs[1] & (1 << 5)) != 0;
+}
+
+#else
+
+bool utilCpuSupportsSSE41()
+{
+    return false;
+}
+
+
+bool utilCpuSupportsAVX2()
+{
+    return false;
+}
+
+#endif
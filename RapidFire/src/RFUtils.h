@@ -52,6 +52,16 @@ bool utilIsBitrateValid(size_t bitrate);
 
 bool utilIsPropertyValid(size_t Property);
 
+// Computes a 64 bit FNV-1a hash of uiSize bytes. The hash of multiple blocks can be computed by passing
+// the result of the previous call as uiHash.
+uint64_t utilHash64(const void* pData, size_t uiSize, uint64_t uiHash = 14695981039346656037ULL);
+
+// Returns true if the CPU and the OS support the SSE4.1 instruction set.
+bool utilCpuSupportsSSE41();
+
+// Returns true if the CPU and the OS support the AVX2 instruction set.
+bool utilCpuSupportsAVX2();
+
 #ifdef _DEBUG
 #include <CL/cl.h>
 
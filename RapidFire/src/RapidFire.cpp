@@ -64,6 +64,8 @@ RFStatus RAPIDFIRE_API rfDeleteEncodeSession(RFEncodeSession* s)
         return RF_STATUS_INVALID_SESSION;
     }
 
+    pEncodeSession->lockForTeardown();
+
     delete pEncodeSession;
     *s = nullptr;
     return RF_STATUS_OK;
@@ -267,6 +269,86 @@ RFStatus RAPIDFIRE_API rfGetSourceFrame(RFEncodeSession session, unsigned int* u
 }
 
 
+RFStatus RAPIDFIRE_API rfGetEncodedFrameCL(RFEncodeSession session, RFEncodedFrameCL* pFrame)
+{
+    RFSession* pEncodeSession = reinterpret_cast<RFSession*>(session);
+
+    if (!pEncodeSession)
+    {
+        return RF_STATUS_INVALID_SESSION;
+    }
+
+    if (!pFrame)
+    {
+        return RF_STATUS_INVALID_PARAMETER;
+    }
+
+    return pEncodeSession->getEncodedFrameCL(*pFrame);
+}
+
+
+RFStatus RAPIDFIRE_API rfReleaseEncodedFrameCL(RFEncodeSession session)
+{
+    RFSession* pEncodeSession = reinterpret_cast<RFSession*>(session);
+
+    if (!pEncodeSession)
+    {
+        return RF_STATUS_INVALID_SESSION;
+    }
+
+    return pEncodeSession->releaseEncodedFrameCL();
+}
+
+
+RFStatus RAPIDFIRE_API rfCreateDiffConsumer(RFEncodeSession session, unsigned int* pConsumer)
+{
+    RFSession* pEncodeSession = reinterpret_cast<RFSession*>(session);
+
+    if (!pEncodeSession)
+    {
+        return RF_STATUS_INVALID_SESSION;
+    }
+
+    if (!pConsumer)
+    {
+        return RF_STATUS_INVALID_PARAMETER;
+    }
+
+    return pEncodeSession->createDiffConsumer(*pConsumer);
+}
+
+
+RFStatus RAPIDFIRE_API rfDeleteDiffConsumer(RFEncodeSession session, const unsigned int uiConsumer)
+{
+    RFSession* pEncodeSession = reinterpret_cast<RFSession*>(session);
+
+    if (!pEncodeSession)
+    {
+        return RF_STATUS_INVALID_SESSION;
+    }
+
+    return pEncodeSession->deleteDiffConsumer(uiConsumer);
+}
+
+
+RFStatus RAPIDFIRE_API rfGetDiffConsumerFrame(RFEncodeSession session, const unsigned int uiConsumer, unsigned int* uiSize, void** pDiffMap)
+{
+    RFSession* pEncodeSession = reinterpret_cast<RFSession*>(session);
+
+    if (!pEncodeSession)
+    {
+        return RF_STATUS_INVALID_SESSION;
+    }
+
+    if (!uiSize || !pDiffMap)
+    {
+        return RF_STATUS_INVALID_PARAMETER;
+    }
+
+    return pEncodeSession->getDiffConsumerFrame(uiConsumer, *uiSize, *pDiffMap);
+}
+
+
 RFStatus RAPIDFIRE_API rfGetMouseData(RFEncodeSession s, const int iWaitForShapeChange, RFMouseData* md)
 {
     RFSession* pEncodeSession = reinterpret_cast<RFSession*>(s);
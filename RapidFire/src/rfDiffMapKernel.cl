@@ -36,110 +36,1056 @@
 // DomainSizeY: Image height
 // uiLocalPxX: Number of pixels each work item compares in x direction
 // uiLocalPxY: Number of pixels each work item compares in y direction
+//
+// DIFF_MAP_SAD4 is defined by the build options. It is amd_sad4 on devices that support cl_amd_media_ops and
+// DiffMap_SAD4 otherwise.
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
 __constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_NONE | CLK_FILTER_NEAREST;
 
+// Returns c plus the sum of absolute differences of the bytes of a and b.
+unsigned int DiffMap_SAD4(uint4 a, uint4 b, unsigned int c)
+{
+    uchar16 d = abs_diff(as_uchar16(a), as_uchar16(b));
+    ushort8 s8 = convert_ushort8(d.s02468ace) + convert_ushort8(d.s13579bdf);
+    uint4 s4 = convert_uint4(s8.s0246) + convert_uint4(s8.s1357);
+
+    return c + s4.x + s4.y + s4.z + s4.w;
+}
+
+// The rows of a block are compared in passes of get_local_size(1) rows. The work group stops after the first pass
+// that found a difference. The second barrier guarantees that all work items read the flag before the next pass.
 __kernel void DiffMap_Image(__read_only image2d_t Image1, __read_only image2d_t Image2, __global unsigned char* DiffMap,
                             unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY)
 {
     __local unsigned int result;
-    result = 0;
+
+    unsigned int localX = get_local_id(0);
+    unsigned int localY = get_local_id(1);
+
+    if (localX == 0 && localY == 0)
+    {
+        result = 0;
+    }
+
     barrier(CLK_LOCAL_MEM_FENCE);
-    short groupX = get_group_id(0);
-    short groupY = get_group_id(1);
-    short groupIndex = groupX + get_num_groups(0) * groupY;
-    short groupSize = get_local_size(0) * get_local_size(1);
-    short localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
 
     // Offset into the image
-    unsigned int x_offset = groupX * uiLocalPxX;
-    unsigned int y_offset = groupY * uiLocalPxY;
+    unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+    unsigned int y_offset = get_group_id(1) * uiLocalPxY;
 
-    // Limit size to xDimension
-    unsigned int localBlockSize = uiLocalPxX * uiLocalPxY;
+    // Part of the block that is inside the image
+    unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+    unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
 
-    float4 pixels1;
-    float4 pixels2;
+    for (unsigned int y0 = 0; y0 < blockHeight; y0 += get_local_size(1))
+    {
+        unsigned int changed = 0;
+        unsigned int y = y0 + localY;
 
-    int2 pos = (int2)(x_offset, y_offset);
+        if (y < blockHeight)
+        {
+            for (unsigned int x = localX; x < blockWidth; x += get_local_size(0))
+            {
+                int2 pos = (int2)(x_offset + x, y_offset + y);
 
-    for (; localIndex < localBlockSize; localIndex += groupSize)
-    {
-        if (result != 0)
+                changed |= any(read_imagef(Image1, sampler, pos) != read_imagef(Image2, sampler, pos));
+            }
+        }
+
+        if (changed != 0)
         {
-            return;
+            result = 1;
         }
 
-        unsigned int x = localIndex % uiLocalPxX;
-        unsigned int y = localIndex / uiLocalPxX;
+        barrier(CLK_LOCAL_MEM_FENCE);
 
-        pixels1 = read_imagef(Image1, sampler, pos + (int2)(x, y));
-        pixels2 = read_imagef(Image2, sampler, pos + (int2)(x, y));
+        changed = result;
 
-        if (amd_sad4(as_uint4(pixels1), as_uint4(pixels2), 0) != 0)
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (changed != 0)
         {
-            result = 1;
-            DiffMap[groupIndex] = 1;
-            return;
+            break;
         }
     }
+
+    if (localX == 0 && localY == 0 && result != 0)
+    {
+        DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = 1;
+    }
 };
 
 
+// Each work item compares four neighbouring pixels of a row with one vector load and neighbouring work items load
+// neighbouring vectors. The position of a work item advances by the work group size in each pass. It is updated
+// incrementally to avoid an integer division in the loop.
 __kernel void DiffMap_Buffer(__global unsigned int* Image1, __global unsigned int* Image2, __global unsigned char* DiffMap,
                              unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY)
 {
     __local unsigned int result;
-    result = 0;
+
+    unsigned int groupSize = get_local_size(0) * get_local_size(1);
+    unsigned int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+
+    if (localIndex == 0)
+    {
+        result = 0;
+    }
+
     barrier(CLK_LOCAL_MEM_FENCE);
-    short groupX = get_group_id(0);
-    short groupY = get_group_id(1);
-    short groupIndex = groupX + get_num_groups(0) * groupY;
-    short groupSize = get_local_size(0) * get_local_size(1);
-    short localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
 
     // Offset into the image
-    unsigned int x_offset = groupX * uiLocalPxX;
-    unsigned int y_offset = groupY * uiLocalPxY;
+    unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+    unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+
+    // Part of the block that is inside the image
+    unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+    unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
+
+    // Number of vectors per row. The last vector of a row is partial if the width is not a multiple of 4.
+    unsigned int rowVectors = (blockWidth + 3) / 4;
+    unsigned int stepY = groupSize / rowVectors;
+    unsigned int stepX = groupSize - stepY * rowVectors;
+
+    unsigned int vx = localIndex % rowVectors;
+    unsigned int y = localIndex / rowVectors;
+
+    for (unsigned int i = 0; i < rowVectors * blockHeight; i += groupSize)
+    {
+        unsigned int changed = 0;
+
+        if (y < blockHeight)
+        {
+            unsigned int x = 4 * vx;
+            unsigned int idx = x_offset + x + (y_offset + y) * DomainSizeX;
+
+            if (x + 4 <= blockWidth)
+            {
+                changed = any(vload4(0, Image1 + idx) != vload4(0, Image2 + idx));
+            }
+            else
+            {
+                for (; x < blockWidth; ++x)
+                {
+                    changed |= (Image1[idx] != Image2[idx]);
+                    ++idx;
+                }
+            }
+        }
+
+        if (changed != 0)
+        {
+            result = 1;
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        changed = result;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (changed != 0)
+        {
+            break;
+        }
+
+        vx += stepX;
+        y += stepY;
+
+        if (vx >= rowVectors)
+        {
+            vx -= rowVectors;
+            ++y;
+        }
+    }
+
+    if (localIndex == 0 && result != 0)
+    {
+        DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = 1;
+    }
+};
+
+// Computes the sum of absolute differences of the channels of each block. A block is changed if the sum is larger than
+// uiThreshold. DiffMap stores 1 for changed blocks or, if uiMagnitude is set, the mean absolute difference of the
+// channels of the block rounded up. Each work group processes one block.
+__kernel void DiffMap_SADImage(__read_only image2d_t Image1, __read_only image2d_t Image2, __global unsigned char* DiffMap,
+                               unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY,
+                               const unsigned int uiThreshold, const unsigned int uiMagnitude)
+{
+    __local unsigned int sad;
 
-    // Offset into linear buffer
-    unsigned int idx = x_offset + (DomainSizeX * y_offset);
+    unsigned int localX = get_local_id(0);
+    unsigned int localY = get_local_id(1);
 
-    // Limit size to xDimension
+    if (localX == 0 && localY == 0)
+    {
+        sad = 0;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+    unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+    unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+    unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
     unsigned int localBlockSize = uiLocalPxX * uiLocalPxY;
+    unsigned int localSad = 0;
+
+    for (unsigned int y = localY; y < blockHeight; y += get_local_size(1))
+    {
+        for (unsigned int x = localX; x < blockWidth; x += get_local_size(0))
+        {
+            int2 pos = (int2)(x_offset + x, y_offset + y);
+            uint4 pixels1 = convert_uint4_sat_rte(read_imagef(Image1, sampler, pos) * 255.0f);
+            uint4 pixels2 = convert_uint4_sat_rte(read_imagef(Image2, sampler, pos) * 255.0f);
+            uint4 d = abs_diff(pixels1, pixels2);
+
+            localSad += d.x + d.y + d.z + d.w;
+        }
+    }
 
-    uint4 pixels1;
-    uint4 pixels2;
+    atomic_add(&sad, localSad);
 
-    for (; localIndex < localBlockSize; localIndex += 4 * groupSize)
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (localX == 0 && localY == 0)
     {
-        if(result != 0)
+        unsigned char result = 0;
+
+        if (sad > uiThreshold)
         {
-            return;
+            result = (uiMagnitude != 0) ? (unsigned char)min((sad + 4 * localBlockSize - 1) / (4 * localBlockSize), 255u) : 1;
         }
 
-        for (unsigned int i = 0; i < 4; ++i)
+        DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = result;
+    }
+};
+
+__kernel void DiffMap_SADBuffer(__global unsigned int* Image1, __global unsigned int* Image2, __global unsigned char* DiffMap,
+                                unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY,
+                                const unsigned int uiThreshold, const unsigned int uiMagnitude)
+{
+    __local unsigned int sad;
+
+    unsigned int groupSize = get_local_size(0) * get_local_size(1);
+    unsigned int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+
+    if (localIndex == 0)
+    {
+        sad = 0;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+    unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+    unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+    unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
+    unsigned int localBlockSize = uiLocalPxX * uiLocalPxY;
+    unsigned int localSad = 0;
+
+    // The vectors are distributed as in DiffMap_Buffer.
+    unsigned int rowVectors = (blockWidth + 3) / 4;
+    unsigned int stepY = groupSize / rowVectors;
+    unsigned int stepX = groupSize - stepY * rowVectors;
+
+    unsigned int vx = localIndex % rowVectors;
+    unsigned int y = localIndex / rowVectors;
+
+    for (unsigned int i = localIndex; i < rowVectors * blockHeight; i += groupSize)
+    {
+        unsigned int x = 4 * vx;
+        unsigned int idx = x_offset + x + (y_offset + y) * DomainSizeX;
+
+        if (x + 4 <= blockWidth)
         {
-            unsigned int localIndex_ = localIndex + i * groupSize;
-            unsigned int x = localIndex_ % uiLocalPxX;
-            unsigned int y = localIndex_ / uiLocalPxX;
-            if (x_offset + x < DomainSizeX && y_offset + y < DomainSizeY)
+            localSad = DIFF_MAP_SAD4(vload4(0, Image1 + idx), vload4(0, Image2 + idx), localSad);
+        }
+        else
+        {
+            for (; x < blockWidth; ++x)
             {
-                ((unsigned int*)&(pixels1))[i] = Image1[idx + x + y * DomainSizeX];
-                ((unsigned int*)&(pixels2))[i] = Image2[idx + x + y * DomainSizeX];
+                localSad = DIFF_MAP_SAD4((uint4)(Image1[idx], 0, 0, 0), (uint4)(Image2[idx], 0, 0, 0), localSad);
+                ++idx;
+            }
+        }
+
+        vx += stepX;
+        y += stepY;
+
+        if (vx >= rowVectors)
+        {
+            vx -= rowVectors;
+            ++y;
+        }
+    }
+
+    atomic_add(&sad, localSad);
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (localIndex == 0)
+    {
+        unsigned char result = 0;
+
+        if (sad > uiThreshold)
+        {
+            result = (uiMagnitude != 0) ? (unsigned char)min((sad + 4 * localBlockSize - 1) / (4 * localBlockSize), 255u) : 1;
+        }
+
+        DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = result;
+    }
+};
+
+
+// Compares the NV12 images of two result buffers byte by byte. The luma plane has DomainSizeX x DomainSizeY bytes and is
+// followed by the interleaved chroma plane with DomainSizeX x DomainSizeY / 2 bytes. If uiChroma is set the chroma rows
+// that belong to a block are compared after its luma rows. The rows are distributed as the vectors in DiffMap_Buffer,
+// each work item compares 8 bytes.
+__kernel void DiffMap_NV12Buffer(__global unsigned char* Image1, __global unsigned char* Image2, __global unsigned char* DiffMap,
+                                 unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY,
+                                 const unsigned int uiChroma)
+{
+    __local unsigned int result;
+
+    unsigned int groupSize = get_local_size(0) * get_local_size(1);
+    unsigned int localIndex = get_local_id(0) + get_local_size(0) * get_local_id(1);
+
+    if (localIndex == 0)
+    {
+        result = 0;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+    unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+    unsigned int blockWidth = min(uiLocalPxX, DomainSizeX - x_offset);
+    unsigned int blockHeight = min(uiLocalPxY, DomainSizeY - y_offset);
+
+    // Each UV pair covers 2x2 luma samples, hence the chroma rows of a block have the same width in bytes.
+    // The chroma plane has DomainSizeY / 2 rows, the last block of an image with an odd height gets one row less.
+    unsigned int chromaHeight = (uiChroma != 0) ? min((blockHeight + 1) / 2, DomainSizeY / 2 - y_offset / 2) : 0;
+    unsigned int chromaOffset = DomainSizeX * DomainSizeY + x_offset + (y_offset / 2) * DomainSizeX;
+    unsigned int numRows = blockHeight + chromaHeight;
+
+    unsigned int rowVectors = (blockWidth + 7) / 8;
+    unsigned int stepY = groupSize / rowVectors;
+    unsigned int stepX = groupSize - stepY * rowVectors;
+
+    unsigned int vx = localIndex % rowVectors;
+    unsigned int y = localIndex / rowVectors;
+
+    for (unsigned int i = 0; i < rowVectors * numRows; i += groupSize)
+    {
+        unsigned int changed = 0;
+
+        if (y < numRows)
+        {
+            unsigned int x = 8 * vx;
+            unsigned int idx = (y < blockHeight) ? x_offset + x + (y_offset + y) * DomainSizeX : chromaOffset + x + (y - blockHeight) * DomainSizeX;
+
+            if (x + 8 <= blockWidth)
+            {
+                changed = any(vload8(0, Image1 + idx) != vload8(0, Image2 + idx));
             }
             else
             {
-                ((unsigned int*)&(pixels1))[i] = 0;
-                ((unsigned int*)&(pixels2))[i] = 0;
+                for (; x < blockWidth; ++x)
+                {
+                    changed |= (Image1[idx] != Image2[idx]);
+                    ++idx;
+                }
             }
         }
-        if (amd_sad4(pixels1, pixels2, 0) != 0)
+
+        if (changed != 0)
         {
             result = 1;
-            DiffMap[groupIndex] = 1;
-            return;
+        }
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        changed = result;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        if (changed != 0)
+        {
+            break;
+        }
+
+        vx += stepX;
+        y += stepY;
+
+        if (vx >= rowVectors)
+        {
+            vx -= rowVectors;
+            ++y;
+        }
+    }
+
+    if (localIndex == 0 && result != 0)
+    {
+        DiffMap[get_group_id(0) + get_num_groups(0) * get_group_id(1)] = 1;
+    }
+};
+
+
+// Computes a coarser level of the diff map pyramid. Each entry is the maximum of uiFactor x uiFactor entries of the
+// finer level. Both levels are stored in DiffMap at the given offsets.
+__kernel void DiffMap_Reduce(__global unsigned char* DiffMap, const unsigned int uiSrcOffset, const unsigned int uiSrcWidth, const unsigned int uiSrcHeight,
+                             const unsigned int uiDstOffset, const unsigned int uiDstWidth, const unsigned int uiFactor)
+{
+    unsigned int x = get_global_id(0);
+    unsigned int y = get_global_id(1);
+
+    unsigned int x0 = x * uiFactor;
+    unsigned int y0 = y * uiFactor;
+    unsigned int x1 = min(x0 + uiFactor, uiSrcWidth);
+    unsigned int y1 = min(y0 + uiFactor, uiSrcHeight);
+
+    unsigned char result = 0;
+
+    for (unsigned int j = y0; j < y1; ++j)
+    {
+        for (unsigned int i = x0; i < x1; ++i)
+        {
+            result = max(result, DiffMap[uiSrcOffset + j * uiSrcWidth + i]);
         }
     }
+
+    DiffMap[uiDstOffset + y * uiDstWidth + x] = result;
+};
+
+// Adds the diff map of the current frame to the map accumulated for a consumer. Entries keep the maximum to preserve the
+// magnitude of changed blocks.
+__kernel void DiffMap_Accumulate(__global unsigned char* DiffMap, __global unsigned char* Accumulated)
+{
+    unsigned int i = get_global_id(0);
+
+    Accumulated[i] = max(Accumulated[i], DiffMap[i]);
+};
+
+// Detects blocks that alternate between a few states like a blinking caret. Each work item processes one block of the
+// first level. History stores the signatures of the last uiHistory distinct states of each block and State the number of
+// stored signatures, the index of the next signature that is replaced and the number of consecutive changes to a stored
+// state. A changed block whose last uiHistory changes returned to a stored state is removed from the diff map and marked
+// in PeriodicMap.
+__kernel void DiffMap_Periodic(__global unsigned int* Image, __global unsigned char* DiffMap, __global ulong* History, __global unsigned int* State,
+                               __global unsigned char* PeriodicMap, const unsigned int uiHistory, const unsigned int uiWidth, const unsigned int uiHeight,
+                               const unsigned int uiBlockWidth, const unsigned int uiBlockHeight)
+{
+    unsigned int bx = get_global_id(0);
+    unsigned int by = get_global_id(1);
+    unsigned int block = by * get_global_size(0) + bx;
+
+    PeriodicMap[block] = 0;
+
+    if (DiffMap[block] == 0)
+    {
+        return;
+    }
+
+    unsigned int x0 = bx * uiBlockWidth;
+    unsigned int y0 = by * uiBlockHeight;
+    unsigned int x1 = min(x0 + uiBlockWidth, uiWidth);
+    unsigned int y1 = min(y0 + uiBlockHeight, uiHeight);
+
+    ulong hash = 14695981039346656037UL;
+
+    for (unsigned int y = y0; y < y1; ++y)
+    {
+        for (unsigned int x = x0; x < x1; ++x)
+        {
+            hash = (hash ^ Image[y * uiWidth + x]) * 1099511628211UL;
+        }
+    }
+
+    __global ulong* Signatures = History + block * uiHistory;
+
+    unsigned int state    = State[block];
+    unsigned int stored   = state & 0xFF;
+    unsigned int next     = (state >> 8) & 0xFF;
+    unsigned int revisits = state >> 16;
+    unsigned int known    = 0;
+
+    for (unsigned int i = 0; i < stored; ++i)
+    {
+        known |= (Signatures[i] == hash) ? 1 : 0;
+    }
+
+    if (known)
+    {
+        revisits = min(revisits + 1, 0xFFFFu);
+    }
+    else
+    {
+        Signatures[next] = hash;
+
+        next     = (next + 1) % uiHistory;
+        stored   = min(stored + 1, uiHistory);
+        revisits = 0;
+    }
+
+    State[block] = stored | (next << 8) | (revisits << 16);
+
+    if (revisits >= uiHistory)
+    {
+        DiffMap[block]     = 0;
+        PeriodicMap[block] = 1;
+    }
+};
+
+// Packs the entries of one level of the diff map into one bit per entry. Each work item writes one byte, rows of the
+// packed map have uiPitch bytes. The first entry of a byte is stored in the least significant bit.
+__kernel void DiffMap_Pack(__global unsigned char* DiffMap, const unsigned int uiSrcOffset, const unsigned int uiSrcWidth,
+                           __global unsigned char* Bits, const unsigned int uiDstOffset, const unsigned int uiPitch)
+{
+    unsigned int x = get_global_id(0);
+    unsigned int y = get_global_id(1);
+
+    unsigned int x0 = x * 8;
+    unsigned int x1 = min(x0 + 8, uiSrcWidth);
+
+    unsigned char bits = 0;
+
+    for (unsigned int i = x0; i < x1; ++i)
+    {
+        if (DiffMap[uiSrcOffset + y * uiSrcWidth + i] != 0)
+        {
+            bits |= (unsigned char)(1 << (i - x0));
+        }
+    }
+
+    Bits[uiDstOffset + y * uiPitch + x] = bits;
+};
+
+// Finds the maximal horizontal runs of changed blocks. Each work item processes one row and stores up to uiMaxRuns
+// runs as {start, end} in Runs.
+__kernel void DiffMap_Runs(__global unsigned char* DiffMap, const unsigned int uiWidth, const unsigned int uiMaxRuns,
+                           __global uint2* Runs, __global unsigned int* RunCount)
+{
+    unsigned int y = get_global_id(0);
+
+    __global unsigned char* Row = DiffMap + y * uiWidth;
+    __global uint2* RowRuns = Runs + y * uiMaxRuns;
+
+    unsigned int n = 0;
+    unsigned int x = 0;
+
+    while (x < uiWidth)
+    {
+        if (Row[x] == 0)
+        {
+            ++x;
+            continue;
+        }
+
+        unsigned int x0 = x;
+
+        while (x < uiWidth && Row[x] != 0)
+        {
+            ++x;
+        }
+
+        RowRuns[n] = (uint2)(x0, x);
+        ++n;
+    }
+
+    RunCount[y] = n;
+};
+
+// Merges the runs found by DiffMap_Runs into rectangles. A run is appended to the rectangle of the run in the row above
+// if both have the same extent. Runs with no match start a new rectangle. Executed by a single work item since each
+// row depends on the previous one. Rects contains the number of rectangles followed by {x, y, width, height}.
+__kernel void DiffMap_Rects(__global uint2* Runs, __global unsigned int* RunCount, __global unsigned int* RunRect,
+                            const unsigned int uiHeight, const unsigned int uiMaxRuns, __global unsigned int* Rects)
+{
+    unsigned int uiNumRects = 0;
+    unsigned int uiPrevCount = 0;
+
+    for (unsigned int y = 0; y < uiHeight; ++y)
+    {
+        unsigned int uiCount = RunCount[y];
+        unsigned int uiPrev = 0;
+
+        for (unsigned int i = 0; i < uiCount; ++i)
+        {
+            uint2 run = Runs[y * uiMaxRuns + i];
+
+            // Runs of both rows are sorted, skip the runs of the previous row that start left of this one.
+            while (uiPrev < uiPrevCount && Runs[(y - 1) * uiMaxRuns + uiPrev].x < run.x)
+            {
+                ++uiPrev;
+            }
+
+            unsigned int uiRect;
+
+            if (uiPrev < uiPrevCount && Runs[(y - 1) * uiMaxRuns + uiPrev].x == run.x && Runs[(y - 1) * uiMaxRuns + uiPrev].y == run.y)
+            {
+                uiRect = RunRect[(y - 1) * uiMaxRuns + uiPrev];
+                Rects[1 + 4 * uiRect + 3] += 1;
+                ++uiPrev;
+            }
+            else
+            {
+                uiRect = uiNumRects;
+                ++uiNumRects;
+
+                Rects[1 + 4 * uiRect + 0] = run.x;
+                Rects[1 + 4 * uiRect + 1] = y;
+                Rects[1 + 4 * uiRect + 2] = run.y - run.x;
+                Rects[1 + 4 * uiRect + 3] = 1;
+            }
+
+            RunRect[y * uiMaxRuns + i] = uiRect;
+        }
+
+        uiPrevCount = uiCount;
+    }
+
+    Rects[0] = uiNumRects;
+};
+
+// Computes the exclusive prefix sum of the changed blocks inside each work group. TileOffsets receives the position of
+// each changed block among the changed blocks of its group and GroupSums the number of changed blocks of each group.
+// Scan needs one entry per work item.
+__kernel void DiffMap_TileScan(__global unsigned char* DiffMap, const unsigned int uiNumBlocks, __global unsigned int* TileOffsets,
+                               __global unsigned int* GroupSums, __local unsigned int* Scan)
+{
+    unsigned int gid = get_global_id(0);
+    unsigned int lid = get_local_id(0);
+    unsigned int groupSize = get_local_size(0);
+
+    unsigned int changed = (gid < uiNumBlocks && DiffMap[gid] != 0) ? 1 : 0;
+
+    Scan[lid] = changed;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Inclusive scan in log2(groupSize) steps.
+    for (unsigned int offset = 1; offset < groupSize; offset *= 2)
+    {
+        unsigned int value = (lid >= offset) ? Scan[lid - offset] : 0;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        Scan[lid] += value;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (gid < uiNumBlocks)
+    {
+        TileOffsets[gid] = Scan[lid] - changed;
+    }
+
+    if (lid == groupSize - 1)
+    {
+        GroupSums[get_group_id(0)] = Scan[lid];
+    }
+};
+
+// Replaces the number of changed blocks of each group of DiffMap_TileScan with the number of changed blocks of all
+// previous groups and stores the total as the first value of Tiles. Executed by a single work item.
+__kernel void DiffMap_TileGroups(__global unsigned int* GroupSums, const unsigned int uiNumGroups, __global unsigned int* Tiles)
+{
+    unsigned int uiSum = 0;
+
+    for (unsigned int i = 0; i < uiNumGroups; ++i)
+    {
+        unsigned int uiCount = GroupSums[i];
+
+        GroupSums[i] = uiSum;
+        uiSum += uiCount;
+    }
+
+    Tiles[0] = uiSum;
+};
+
+// Copies the pixels of each changed block to its position in the compacted list. Tiles contains the number of
+// blocks n followed by n block indices and the pixels of the n blocks. Each work group processes one block.
+__kernel void DiffMap_TileGather(__global unsigned int* Image, __global unsigned char* DiffMap, __global unsigned int* TileOffsets,
+                                 __global unsigned int* GroupSums, const unsigned int uiScanGroupSize, __global unsigned int* Tiles,
+                                 unsigned int DomainSizeX, unsigned int DomainSizeY, const unsigned int uiLocalPxX, const unsigned int uiLocalPxY)
+{
+    unsigned int block = get_group_id(0) + get_num_groups(0) * get_group_id(1);
+
+    if (DiffMap[block] == 0)
+    {
+        return;
+    }
+
+    unsigned int localX = get_local_id(0);
+    unsigned int localY = get_local_id(1);
+    unsigned int tile = GroupSums[block / uiScanGroupSize] + TileOffsets[block];
+
+    if (localX == 0 && localY == 0)
+    {
+        Tiles[1 + tile] = block;
+    }
+
+    __global unsigned int* Tile = Tiles + 1 + Tiles[0] + tile * uiLocalPxX * uiLocalPxY;
+
+    unsigned int x_offset = get_group_id(0) * uiLocalPxX;
+    unsigned int y_offset = get_group_id(1) * uiLocalPxY;
+
+    for (unsigned int y = localY; y < uiLocalPxY; y += get_local_size(1))
+    {
+        for (unsigned int x = localX; x < uiLocalPxX; x += get_local_size(0))
+        {
+            unsigned int pixel = 0;
+
+            if (x_offset + x < DomainSizeX && y_offset + y < DomainSizeY)
+            {
+                pixel = Image[x_offset + x + (y_offset + y) * DomainSizeX];
+            }
+
+            Tile[x + y * uiLocalPxX] = pixel;
+        }
+    }
+};
+
+// Computes the bounding box of the changed blocks for the scroll detection and clears the scores. Executed by a single
+// work item. Scroll contains the box {x0, y0, x1, y1} in blocks followed by the RFDiffCopyRect.
+__kernel void DiffMap_Bounds(__global unsigned char* DiffMap, const unsigned int uiMapWidth, const unsigned int uiMapHeight,
+                             __global int* Scroll, __global unsigned int* Scores, const unsigned int uiNumScores)
+{
+    int4 box = (int4)(uiMapWidth, uiMapHeight, 0, 0);
+
+    for (unsigned int y = 0; y < uiMapHeight; ++y)
+    {
+        for (unsigned int x = 0; x < uiMapWidth; ++x)
+        {
+            if (DiffMap[y * uiMapWidth + x] != 0)
+            {
+                box = (int4)(min(box.x, (int)x), min(box.y, (int)y), max(box.z, (int)x + 1), max(box.w, (int)y + 1));
+            }
+        }
+    }
+
+    vstore4(box, 0, Scroll);
+
+    for (unsigned int i = 4; i < 10; ++i)
+    {
+        Scroll[i] = 0;
+    }
+
+    for (unsigned int i = 0; i < uiNumScores; ++i)
+    {
+        Scores[i] = 0;
+    }
+};
+
+// Maps work item i to a line of the scroll detection. Rows of the block columns are followed by columns of the block rows.
+// Returns false if the line is outside of the box found by DiffMap_Bounds, otherwise the line contains the pixels
+// [uiStart, uiEnd) of row or column uiLine.
+bool DiffMap_ScrollLine(unsigned int i, __global int* Scroll, const unsigned int uiWidth, const unsigned int uiHeight,
+                        const unsigned int uiBlockWidth, const unsigned int uiBlockHeight, const unsigned int uiMapWidth,
+                        bool* pRow, unsigned int* pLine, unsigned int* pStart, unsigned int* pEnd)
+{
+    unsigned int uiNumRowLines = uiMapWidth * uiHeight;
+
+    bool bRow = (i < uiNumRowLines);
+    int  k    = (bRow) ? i / uiHeight : (i - uiNumRowLines) / uiWidth;
+    int  j    = (bRow) ? i % uiHeight : (i - uiNumRowLines) % uiWidth;
+
+    if (bRow && (k < Scroll[0] || k >= Scroll[2] || j < Scroll[1] * (int)uiBlockHeight || j >= min(Scroll[3] * (int)uiBlockHeight, (int)uiHeight)))
+    {
+        return false;
+    }
+
+    if (!bRow && (k < Scroll[1] || k >= Scroll[3] || j < Scroll[0] * (int)uiBlockWidth || j >= min(Scroll[2] * (int)uiBlockWidth, (int)uiWidth)))
+    {
+        return false;
+    }
+
+    *pRow   = bRow;
+    *pLine  = j;
+    *pStart = k * ((bRow) ? uiBlockWidth : uiBlockHeight);
+    *pEnd   = min(*pStart + ((bRow) ? uiBlockWidth : uiBlockHeight), (bRow) ? uiWidth : uiHeight);
+
+    return true;
+};
+
+// Computes the FNV-1a hashes of the lines of both images. The hashes of Image1 are followed by the ones of Image2.
+// Each work item processes one line.
+__kernel void DiffMap_LineHashBuffer(__global unsigned int* Image1, __global unsigned int* Image2, __global int* Scroll, __global unsigned int* LineHashes,
+                                     const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                     const unsigned int uiMapWidth, const unsigned int uiNumLines)
+{
+    unsigned int i = get_global_id(0);
+
+    bool bRow;
+    unsigned int uiLine;
+    unsigned int uiStart;
+    unsigned int uiEnd;
+
+    if (!DiffMap_ScrollLine(i, Scroll, uiWidth, uiHeight, uiBlockWidth, uiBlockHeight, uiMapWidth, &bRow, &uiLine, &uiStart, &uiEnd))
+    {
+        return;
+    }
+
+    unsigned int uiHash1 = 2166136261u;
+    unsigned int uiHash2 = 2166136261u;
+
+    for (unsigned int t = uiStart; t < uiEnd; ++t)
+    {
+        unsigned int idx = (bRow) ? uiLine * uiWidth + t : t * uiWidth + uiLine;
+
+        uiHash1 = (uiHash1 ^ Image1[idx]) * 16777619u;
+        uiHash2 = (uiHash2 ^ Image2[idx]) * 16777619u;
+    }
+
+    LineHashes[i] = uiHash1;
+    LineHashes[uiNumLines + i] = uiHash2;
+};
+
+__kernel void DiffMap_LineHashImage(__read_only image2d_t Image1, __read_only image2d_t Image2, __global int* Scroll, __global unsigned int* LineHashes,
+                                    const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                    const unsigned int uiMapWidth, const unsigned int uiNumLines)
+{
+    unsigned int i = get_global_id(0);
+
+    bool bRow;
+    unsigned int uiLine;
+    unsigned int uiStart;
+    unsigned int uiEnd;
+
+    if (!DiffMap_ScrollLine(i, Scroll, uiWidth, uiHeight, uiBlockWidth, uiBlockHeight, uiMapWidth, &bRow, &uiLine, &uiStart, &uiEnd))
+    {
+        return;
+    }
+
+    unsigned int uiHash1 = 2166136261u;
+    unsigned int uiHash2 = 2166136261u;
+
+    for (unsigned int t = uiStart; t < uiEnd; ++t)
+    {
+        int2 pos = (bRow) ? (int2)(t, uiLine) : (int2)(uiLine, t);
+
+        uint4 pixels1 = as_uint4(read_imagef(Image1, sampler, pos));
+        uint4 pixels2 = as_uint4(read_imagef(Image2, sampler, pos));
+
+        for (unsigned int c = 0; c < 4; ++c)
+        {
+            uiHash1 = (uiHash1 ^ ((unsigned int*)&pixels1)[c]) * 16777619u;
+            uiHash2 = (uiHash2 ^ ((unsigned int*)&pixels2)[c]) * 16777619u;
+        }
+    }
+
+    LineHashes[i] = uiHash1;
+    LineHashes[uiNumLines + i] = uiHash2;
+};
+
+// Counts the lines in [iLow, iHigh) of Cur that are equal to the line shifted by s in Prev and that changed. With s = 0
+// the number of changed lines is returned.
+unsigned int DiffMap_CountLineMatches(__global unsigned int* Cur, __global unsigned int* Prev, int iLow, int iHigh, int s)
+{
+    unsigned int n = 0;
+
+    for (int j = max(iLow, iLow + s); j < min(iHigh, iHigh + s); ++j)
+    {
+        if ((s == 0 || Cur[j] == Prev[j - s]) && Cur[j] != Prev[j])
+        {
+            ++n;
+        }
+    }
+
+    return n;
+};
+
+// Scores the shifts of the scroll detection. Work item (i, k) counts the lines of strip k that match with a shift of
+// i - iRange. The block columns [0, uiMapWidth) are scored as vertical shifts in Scores[0, 2 * iRange], the following
+// block rows as horizontal shifts. The score of a shift of 0 is the number of changed lines.
+__kernel void DiffMap_ScrollSearch(__global unsigned int* LineHashes, __global int* Scroll, __global unsigned int* Scores,
+                                   const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                   const unsigned int uiMapWidth, const unsigned int uiNumLines, const int iRange)
+{
+    int  s         = (int)get_global_id(0) - iRange;
+    int  k         = get_global_id(1);
+    bool bVertical = (k < (int)uiMapWidth);
+
+    k = (bVertical) ? k : k - (int)uiMapWidth;
+
+    if ((bVertical && (k < Scroll[0] || k >= Scroll[2])) || (!bVertical && (k < Scroll[1] || k >= Scroll[3])))
+    {
+        return;
+    }
+
+    int iLow  = (bVertical) ? Scroll[1] * (int)uiBlockHeight : Scroll[0] * (int)uiBlockWidth;
+    int iHigh = (bVertical) ? min(Scroll[3] * (int)uiBlockHeight, (int)uiHeight) : min(Scroll[2] * (int)uiBlockWidth, (int)uiWidth);
+
+    unsigned int uiOffset = (bVertical) ? k * uiHeight : uiMapWidth * uiHeight + k * uiWidth;
+
+    unsigned int n = DiffMap_CountLineMatches(LineHashes + uiOffset, LineHashes + uiNumLines + uiOffset, iLow, iHigh, s);
+
+    if (n > 0)
+    {
+        atomic_add(&Scores[((bVertical) ? 0 : 2 * iRange + 1) + get_global_id(0)], n);
+    }
+};
+
+// Selects the best shift scored by DiffMap_ScrollSearch and stores the RFDiffCopyRect in Scroll. A shift is accepted if
+// it matches at least uiMinLines lines and half of the changed lines. The copy covers the strips in which the shift
+// matches half of the changed lines. Executed by a single work item.
+__kernel void DiffMap_ScrollSelect(__global unsigned int* LineHashes, __global int* Scroll, __global unsigned int* Scores,
+                                   const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                   const unsigned int uiMapWidth, const unsigned int uiNumLines, const int iRange, const unsigned int uiMinLines)
+{
+    if (Scroll[2] == 0)
+    {
+        return;
+    }
+
+    unsigned int uiBest = 0;
+    int iBestIdx = -1;
+
+    for (int i = 0; i < 2 * (2 * iRange + 1); ++i)
+    {
+        bool bVertical = (i <= 2 * iRange);
+        unsigned int uiChanged = Scores[(bVertical) ? iRange : 3 * iRange + 1];
+
+        if (i != iRange && i != 3 * iRange + 1 && Scores[i] > uiBest && Scores[i] >= uiMinLines && 2 * Scores[i] >= uiChanged)
+        {
+            uiBest = Scores[i];
+            iBestIdx = i;
+        }
+    }
+
+    if (iBestIdx < 0)
+    {
+        return;
+    }
+
+    bool bVertical = (iBestIdx <= 2 * iRange);
+    int  s         = ((bVertical) ? iBestIdx : iBestIdx - 2 * iRange - 1) - iRange;
+
+    int iPx0 = Scroll[0] * (int)uiBlockWidth;
+    int iPy0 = Scroll[1] * (int)uiBlockHeight;
+    int iPx1 = min(Scroll[2] * (int)uiBlockWidth, (int)uiWidth);
+    int iPy1 = min(Scroll[3] * (int)uiBlockHeight, (int)uiHeight);
+
+    int iFirst = -1;
+    int iLast = -1;
+
+    for (int k = (bVertical) ? Scroll[0] : Scroll[1]; k < ((bVertical) ? Scroll[2] : Scroll[3]); ++k)
+    {
+        unsigned int uiOffset = (bVertical) ? k * uiHeight : uiMapWidth * uiHeight + k * uiWidth;
+
+        unsigned int uiMatches = DiffMap_CountLineMatches(LineHashes + uiOffset, LineHashes + uiNumLines + uiOffset, (bVertical) ? iPy0 : iPx0, (bVertical) ? iPy1 : iPx1, s);
+        unsigned int uiChanged = DiffMap_CountLineMatches(LineHashes + uiOffset, LineHashes + uiNumLines + uiOffset, (bVertical) ? iPy0 : iPx0, (bVertical) ? iPy1 : iPx1, 0);
+
+        if (uiMatches > 0 && 2 * uiMatches >= uiChanged)
+        {
+            iFirst = (iFirst < 0) ? k : iFirst;
+            iLast = k;
+        }
+    }
+
+    if (bVertical)
+    {
+        Scroll[4] = iFirst * uiBlockWidth;
+        Scroll[5] = (s > 0) ? iPy0 : iPy0 - s;
+        Scroll[6] = min((iLast + 1) * (int)uiBlockWidth, (int)uiWidth) - Scroll[4];
+        Scroll[7] = iPy1 - iPy0 - abs(s);
+        Scroll[9] = s;
+    }
+    else
+    {
+        Scroll[4] = (s > 0) ? iPx0 : iPx0 - s;
+        Scroll[5] = iFirst * uiBlockHeight;
+        Scroll[6] = iPx1 - iPx0 - abs(s);
+        Scroll[7] = min((iLast + 1) * (int)uiBlockHeight, (int)uiHeight) - Scroll[5];
+        Scroll[8] = s;
+    }
+};
+
+// Recomputes the entries of the diff map that overlap the destination of the copy selected by DiffMap_ScrollSelect.
+// Pixels inside of the destination are compared with the moved pixels of Image2. Each work item processes one block.
+__kernel void DiffMap_ResidualBuffer(__global unsigned int* Image1, __global unsigned int* Image2, __global unsigned char* DiffMap, __global int* Scroll,
+                                     const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                     const unsigned int uiMapWidth)
+{
+    if (Scroll[6] == 0)
+    {
+        return;
+    }
+
+    int4 dst = (int4)(Scroll[4] + Scroll[8], Scroll[5] + Scroll[9], Scroll[4] + Scroll[8] + Scroll[6], Scroll[5] + Scroll[9] + Scroll[7]);
+
+    int x0 = get_global_id(0) * uiBlockWidth;
+    int y0 = get_global_id(1) * uiBlockHeight;
+    int x1 = min(x0 + (int)uiBlockWidth, (int)uiWidth);
+    int y1 = min(y0 + (int)uiBlockHeight, (int)uiHeight);
+
+    if (x1 <= dst.x || x0 >= dst.z || y1 <= dst.y || y0 >= dst.w)
+    {
+        return;
+    }
+
+    unsigned char result = 0;
+
+    for (int y = y0; y < y1 && result == 0; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            bool bInside = (x >= dst.x && x < dst.z && y >= dst.y && y < dst.w);
+
+            int px = (bInside) ? x - Scroll[8] : x;
+            int py = (bInside) ? y - Scroll[9] : y;
+
+            if (Image1[y * uiWidth + x] != Image2[py * uiWidth + px])
+            {
+                result = 1;
+                break;
+            }
+        }
+    }
+
+    DiffMap[get_global_id(1) * uiMapWidth + get_global_id(0)] = result;
+};
+
+__kernel void DiffMap_ResidualImage(__read_only image2d_t Image1, __read_only image2d_t Image2, __global unsigned char* DiffMap, __global int* Scroll,
+                                    const unsigned int uiWidth, const unsigned int uiHeight, const unsigned int uiBlockWidth, const unsigned int uiBlockHeight,
+                                    const unsigned int uiMapWidth)
+{
+    if (Scroll[6] == 0)
+    {
+        return;
+    }
+
+    int4 dst = (int4)(Scroll[4] + Scroll[8], Scroll[5] + Scroll[9], Scroll[4] + Scroll[8] + Scroll[6], Scroll[5] + Scroll[9] + Scroll[7]);
+
+    int x0 = get_global_id(0) * uiBlockWidth;
+    int y0 = get_global_id(1) * uiBlockHeight;
+    int x1 = min(x0 + (int)uiBlockWidth, (int)uiWidth);
+    int y1 = min(y0 + (int)uiBlockHeight, (int)uiHeight);
+
+    if (x1 <= dst.x || x0 >= dst.z || y1 <= dst.y || y0 >= dst.w)
+    {
+        return;
+    }
+
+    unsigned char result = 0;
+
+    for (int y = y0; y < y1 && result == 0; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            bool bInside = (x >= dst.x && x < dst.z && y >= dst.y && y < dst.w);
+
+            int2 pos = (bInside) ? (int2)(x - Scroll[8], y - Scroll[9]) : (int2)(x, y);
+
+            if (any(as_uint4(read_imagef(Image1, sampler, (int2)(x, y))) != as_uint4(read_imagef(Image2, sampler, pos))))
+            {
+                result = 1;
+                break;
+            }
+        }
+    }
+
+    DiffMap[get_global_id(1) * uiMapWidth + get_global_id(0)] = result;
 };
\ No newline at end of file
@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Kernels of the identity encoder that compact a frame before it is transferred to system memory.
+// Each pixel is XORed with the previous frame and the frame is split into chunks of 32 pixels.
+// Only changed chunks are stored: a 32 bit mask of their changed pixels followed by the XORed values.
+//
+// Compact_Masks, Compact_Write : Global Work Size : uiNumPixels rounded up to the local size
+//                                Local Work Size  : multiple of 32
+// Compact_Scan                 : Global Work Size : uiNumChunks rounded up to the local size
+// Compact_Bitmap               : Global Work Size : ceil(uiNumChunks / 32)
+// Compact_Groups               : Global Work Size : 1
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Computes the mask of changed pixels of each chunk and the number of words the chunk occupies in the output,
+// 1 + number of changed pixels for changed chunks and 0 otherwise. LocalMasks stores one mask per chunk of the work group.
+__kernel void Compact_Masks(__global unsigned int* Current, __global unsigned int* Previous, const unsigned int uiKeyFrame, const unsigned int uiNumPixels,
+                            __global unsigned int* Masks, __global unsigned int* ChunkSizes, __local unsigned int* LocalMasks)
+{
+    unsigned int gid = get_global_id(0);
+    unsigned int lid = get_local_id(0);
+
+    if (lid < get_local_size(0) / 32)
+    {
+        LocalMasks[lid] = 0;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (gid < uiNumPixels)
+    {
+        unsigned int value = (uiKeyFrame) ? Current[gid] : Current[gid] ^ Previous[gid];
+
+        if (value != 0)
+        {
+            atomic_or(&LocalMasks[lid / 32], 1u << (lid % 32));
+        }
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    unsigned int chunk = gid / 32;
+
+    if (lid % 32 == 0 && gid < uiNumPixels)
+    {
+        unsigned int mask = LocalMasks[lid / 32];
+
+        Masks[chunk]      = mask;
+        ChunkSizes[chunk] = (mask != 0) ? 1 + popcount(mask) : 0;
+    }
+};
+
+// Computes the exclusive prefix sum of the chunk sizes within each work group and stores the sum of each group in GroupSums.
+__kernel void Compact_Scan(__global unsigned int* ChunkSizes, const unsigned int uiNumChunks, __global unsigned int* ChunkOffsets,
+                           __global unsigned int* GroupSums, __local unsigned int* Scan)
+{
+    unsigned int gid = get_global_id(0);
+    unsigned int lid = get_local_id(0);
+    unsigned int groupSize = get_local_size(0);
+
+    unsigned int size = (gid < uiNumChunks) ? ChunkSizes[gid] : 0;
+
+    Scan[lid] = size;
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Inclusive scan in log2(groupSize) steps.
+    for (unsigned int offset = 1; offset < groupSize; offset *= 2)
+    {
+        unsigned int value = (lid >= offset) ? Scan[lid - offset] : 0;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+
+        Scan[lid] += value;
+
+        barrier(CLK_LOCAL_MEM_FENCE);
+    }
+
+    if (gid < uiNumChunks)
+    {
+        ChunkOffsets[gid] = Scan[lid] - size;
+    }
+
+    if (lid == groupSize - 1)
+    {
+        GroupSums[get_group_id(0)] = Scan[lid];
+    }
+};
+
+// Replaces the sum of each group of Compact_Scan with the sum of all previous groups and writes the size of the output
+// in bytes and the key frame flag. uiHeaderSize is the number of words of the header including the bitmap.
+// Executed by a single work item.
+__kernel void Compact_Groups(__global unsigned int* GroupSums, const unsigned int uiNumGroups, const unsigned int uiHeaderSize,
+                             const unsigned int uiKeyFrame, __global unsigned int* Output)
+{
+    unsigned int uiSum = 0;
+
+    for (unsigned int i = 0; i < uiNumGroups; ++i)
+    {
+        unsigned int uiGroupSum = GroupSums[i];
+
+        GroupSums[i] = uiSum;
+        uiSum += uiGroupSum;
+    }
+
+    Output[0] = (uiHeaderSize + uiSum) * 4;
+    Output[1] = uiKeyFrame;
+};
+
+// Writes one word of the chunk bitmap. Bit i of word n is set if chunk 32 * n + i changed.
+__kernel void Compact_Bitmap(__global unsigned int* Masks, const unsigned int uiNumChunks, __global unsigned int* Output)
+{
+    unsigned int word = get_global_id(0);
+    unsigned int bits = 0;
+
+    for (unsigned int i = 0; i < 32; ++i)
+    {
+        unsigned int chunk = word * 32 + i;
+
+        if (chunk < uiNumChunks && Masks[chunk] != 0)
+        {
+            bits |= 1u << i;
+        }
+    }
+
+    Output[2 + word] = bits;
+};
+
+// Writes the mask and the XORed values of the changed pixels of each changed chunk behind the header.
+__kernel void Compact_Write(__global unsigned int* Current, __global unsigned int* Previous, const unsigned int uiKeyFrame, const unsigned int uiNumPixels,
+                            __global unsigned int* Masks, __global unsigned int* ChunkOffsets, __global unsigned int* GroupSums, const unsigned int uiScanGroupSize,
+                            const unsigned int uiHeaderSize, __global unsigned int* Output)
+{
+    unsigned int gid = get_global_id(0);
+
+    if (gid >= uiNumPixels)
+    {
+        return;
+    }
+
+    unsigned int chunk = gid / 32;
+    unsigned int lane  = gid % 32;
+    unsigned int mask  = Masks[chunk];
+
+    if (mask == 0)
+    {
+        return;
+    }
+
+    unsigned int offset = uiHeaderSize + GroupSums[chunk / uiScanGroupSize] + ChunkOffsets[chunk];
+
+    if (lane == 0)
+    {
+        Output[offset] = mask;
+    }
+
+    if (mask & (1u << lane))
+    {
+        unsigned int value = (uiKeyFrame) ? Current[gid] : Current[gid] ^ Previous[gid];
+
+        Output[offset + 1 + popcount(mask & ((1u << lane) - 1))] = value;
+    }
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+// Kernels of the tile cache encoder. Each work item computes the content hash of one block.
+//
+// Global Work Size : ceil(uiWidth / uiBlockWidth) x ceil(uiHeight / uiBlockHeight)
+// Local Work Size  : NULL
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+__constant sampler_t sampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+
+// Finalizes the hash of a tile. The FNV-1a steps only mix the lower bits into the upper bits.
+ulong TileCache_Finalize(ulong hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdUL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53UL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+// Computes a 64 bit hash of each block of uiBlockWidth x uiBlockHeight pixels. Each work item processes one block.
+// The hash is seeded with the size of the block such that clipped blocks at the borders do not match full blocks.
+__kernel void TileCache_HashBuffer(__global unsigned int* Image, __global ulong* Hashes, const unsigned int uiWidth, const unsigned int uiHeight,
+                                   const unsigned int uiBlockWidth, const unsigned int uiBlockHeight)
+{
+    unsigned int bx = get_global_id(0);
+    unsigned int by = get_global_id(1);
+
+    unsigned int x0 = bx * uiBlockWidth;
+    unsigned int y0 = by * uiBlockHeight;
+    unsigned int x1 = min(x0 + uiBlockWidth, uiWidth);
+    unsigned int y1 = min(y0 + uiBlockHeight, uiHeight);
+
+    ulong hash = 14695981039346656037UL ^ (((ulong)(x1 - x0) << 32) | (y1 - y0));
+
+    for (unsigned int y = y0; y < y1; ++y)
+    {
+        for (unsigned int x = x0; x < x1; ++x)
+        {
+            hash = (hash ^ Image[y * uiWidth + x]) * 1099511628211UL;
+        }
+    }
+
+    Hashes[by * get_global_size(0) + bx] = TileCache_Finalize(hash);
+};
+
+// Same as TileCache_HashBuffer for an RGBA8 image. The pixels are packed into the byte order of the buffer.
+__kernel void TileCache_HashImage(__read_only image2d_t Image, __global ulong* Hashes, const unsigned int uiWidth, const unsigned int uiHeight,
+                                  const unsigned int uiBlockWidth, const unsigned int uiBlockHeight)
+{
+    unsigned int bx = get_global_id(0);
+    unsigned int by = get_global_id(1);
+
+    unsigned int x0 = bx * uiBlockWidth;
+    unsigned int y0 = by * uiBlockHeight;
+    unsigned int x1 = min(x0 + uiBlockWidth, uiWidth);
+    unsigned int y1 = min(y0 + uiBlockHeight, uiHeight);
+
+    ulong hash = 14695981039346656037UL ^ (((ulong)(x1 - x0) << 32) | (y1 - y0));
+
+    for (unsigned int y = y0; y < y1; ++y)
+    {
+        for (unsigned int x = x0; x < x1; ++x)
+        {
+            uint4 c = convert_uint4(read_imagef(Image, sampler, (int2)(x, y)) * 255.0f + 0.5f);
+
+            hash = (hash ^ (c.x | (c.y << 8) | (c.z << 16) | (c.w << 24))) * 1099511628211UL;
+        }
+    }
+
+    Hashes[by * get_global_size(0) + bx] = TileCache_Finalize(hash);
+};
\ No newline at end of file
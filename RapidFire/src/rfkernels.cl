@@ -120,6 +120,124 @@ __kernel void rgbaTonv12_image2d(read_only image2d_t pIn, __global uchar * pOut,
 }
 
 
+// Reads 8 consecutive pixels starting at pos and returns the R, G and B channels in separate vectors.
+void readPixels8(read_only image2d_t pIn, int2 pos, int8* pR, int8* pG, int8* pB)
+{
+    uchar4 p0 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos));
+    uchar4 p1 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(1, 0)));
+    uchar4 p2 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(2, 0)));
+    uchar4 p3 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(3, 0)));
+    uchar4 p4 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(4, 0)));
+    uchar4 p5 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(5, 0)));
+    uchar4 p6 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(6, 0)));
+    uchar4 p7 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, pos + (int2)(7, 0)));
+
+    *pR = convert_int8((uchar8)(p0.x, p1.x, p2.x, p3.x, p4.x, p5.x, p6.x, p7.x));
+    *pG = convert_int8((uchar8)(p0.y, p1.y, p2.y, p3.y, p4.y, p5.y, p6.y, p7.y));
+    *pB = convert_int8((uchar8)(p0.z, p1.z, p2.z, p3.z, p4.z, p5.z, p6.z, p7.z));
+}
+
+
+// Same conversion as rgbaTonv12_image2d but each work item computes a strip of 8x2 pixels. The Y values are
+// written with one vstore8 per row and the 4 interleaved UV samples with one vstore8.
+// The width of the image and the aligned width need to be a multiple of 8.
+//
+// Global work size is width/8, height/2.
+//
+__kernel void rgbaTonv12_image2d_vec8(read_only image2d_t pIn, __global uchar * pOut, const int4 vDim, const int mirror)
+{
+    uint uiGlobalIdX = get_global_id(0);    // 0 - width /8
+    uint uiGlobalIdY = get_global_id(1);    // 0 - height/2
+
+    if (uiGlobalIdX >= vDim.x / 8 || uiGlobalIdY >= vDim.y / 2)
+    {
+        return;
+    }
+
+    int8 R0, G0, B0, R1, G1, B1;
+
+    // Read 8 pixels of row y and 8 pixels of row y+1.
+    readPixels8(pIn, (int2)(uiGlobalIdX * 8, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 1) : 2 * uiGlobalIdY), &R0, &G0, &B0);
+    readPixels8(pIn, (int2)(uiGlobalIdX * 8, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 2) : 2 * uiGlobalIdY + 1), &R1, &G1, &B1);
+
+    uchar8 Y0 = convert_uchar8(((66 * R0 + 129 * G0 + 25 * B0 + 128) >> 8) + 16);
+    uchar8 Y1 = convert_uchar8(((66 * R1 + 129 * G1 + 25 * B1 + 128) >> 8) + 16);
+
+    uint uiYPlaneOffset = uiGlobalIdX * 8 + uiGlobalIdY * 2 * vDim.z;
+
+    vstore8(Y0, 0, pOut + uiYPlaneOffset);
+    vstore8(Y1, 0, pOut + uiYPlaneOffset + vDim.z);
+
+    // Take average color of each 2x2 quad.
+    int4 R = (R0.even + R0.odd + R1.even + R1.odd) >> 2;
+    int4 G = (G0.even + G0.odd + G1.even + G1.odd) >> 2;
+    int4 B = (B0.even + B0.odd + B1.even + B1.odd) >> 2;
+
+    uchar4 U = convert_uchar4(((-38 * R - 74 * G + 112 * B + 128) >> 8) + 128);
+    uchar4 V = convert_uchar4(((112 * R - 94 * G - 18  * B + 128) >> 8) + 128);
+
+    // Write interleaved UV plane.
+    uint uiUVPlaneOffset = vDim.z * vDim.y + uiGlobalIdX * 8 + uiGlobalIdY * vDim.z;
+
+    vstore8((uchar8)(U.x, V.x, U.y, V.y, U.z, V.z, U.w, V.w), 0, pOut + uiUVPlaneOffset);
+}
+
+
+// Same conversion as rgbaTonv12_image2d using a tile in local memory. Each work item reads and converts
+// 2 pixels of one column, consecutive work items write consecutive Y values. The sums of the vertical
+// pixel pairs are stored in local memory and used by the first half of the work items to compute the UV
+// samples which are written as uchar2.
+//
+// Global work size is width, height/2.
+// Local  work size is NV12_TILE_WIDTH x NV12_TILE_HEIGHT.
+//
+#define NV12_TILE_WIDTH  32
+#define NV12_TILE_HEIGHT 8
+
+__kernel __attribute__((reqd_work_group_size(NV12_TILE_WIDTH, NV12_TILE_HEIGHT, 1)))
+void rgbaTonv12_image2d_tiled(read_only image2d_t pIn, __global uchar * pOut, const int4 vDim, const int mirror)
+{
+    __local ushort4 ColumnSum[NV12_TILE_HEIGHT][NV12_TILE_WIDTH];
+
+    uint uiLocalIdX  = get_local_id(0);
+    uint uiLocalIdY  = get_local_id(1);
+    uint uiGlobalIdX = get_global_id(0);    // 0 - width
+    uint uiGlobalIdY = get_global_id(1);    // 0 - height/2
+
+    // Work items outside of the image still need to reach the barrier. Like rgbaTonv12_image2d the last column
+    // of an image with an odd width is not converted.
+    if (uiGlobalIdX < (vDim.x / 2) * 2 && uiGlobalIdY < vDim.y / 2)
+    {
+        uchar4 RGBA0 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, (int2)(uiGlobalIdX, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 1) : 2 * uiGlobalIdY)));
+        uchar4 RGBA1 = convert_uchar4_sat_rte(255 * read_imagef(pIn, imageSampler, (int2)(uiGlobalIdX, (mirror == 1) ? (vDim.y - 2 * uiGlobalIdY - 2) : 2 * uiGlobalIdY + 1)));
+
+        uint uiYPlaneOffset = uiGlobalIdX + uiGlobalIdY * 2 * vDim.z;
+
+        pOut[uiYPlaneOffset]          = ((66 * RGBA0.x + 129 * RGBA0.y + 25 * RGBA0.z + 128) >> 8) + 16;
+        pOut[uiYPlaneOffset + vDim.z] = ((66 * RGBA1.x + 129 * RGBA1.y + 25 * RGBA1.z + 128) >> 8) + 16;
+
+        ColumnSum[uiLocalIdY][uiLocalIdX] = convert_ushort4(RGBA0) + convert_ushort4(RGBA1);
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    // Each of the first NV12_TILE_WIDTH / 2 work items of a row computes one UV sample.
+    uint uiChromaX = get_group_id(0) * NV12_TILE_WIDTH / 2 + uiLocalIdX;
+
+    if (uiLocalIdX >= NV12_TILE_WIDTH / 2 || uiChromaX >= vDim.x / 2 || uiGlobalIdY >= vDim.y / 2)
+    {
+        return;
+    }
+
+    ushort4 RGBA = (ColumnSum[uiLocalIdY][2 * uiLocalIdX] + ColumnSum[uiLocalIdY][2 * uiLocalIdX + 1]) >> 2;
+
+    uchar2 UV = (uchar2)(((-38 * RGBA.x - 74 * RGBA.y + 112 * RGBA.z + 128) >> 8) + 128,
+                         ((112 * RGBA.x - 94 * RGBA.y - 18  * RGBA.z + 128) >> 8) + 128);
+
+    vstore2(UV, 0, pOut + vDim.z * vDim.y + 2 * uiChromaX + uiGlobalIdY * vDim.z);
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
 // converts RGBA input buffer into NV12 output image planes. The input image is shiftev by vShift.
 //
@@ -311,4 +429,92 @@ __kernel void copy_rgba_image2d(__read_only image2d_t rgbaIn, __global uchar *rg
         rgbaOut[uiBufferOffset + 2] = pixel.z;
         rgbaOut[uiBufferOffset + 3] = pixel.w;
     }
+}
+
+
+// Same as copy_rgba_image2d but additionally computes a difference map. Each work group processes one block of
+// vBlockDim.x x vBlockDim.y pixels. While the block is copied a 64 bit signature of the output pixels is computed.
+// The signature is compared with the signature of the previous frame which is stored in pSignatures. This way the
+// previous frame does not need to be read again.
+// If a signature differs, or if nForceDiff is set, the value of the block in pDiffMap is set to 1 otherwise to 0.
+//
+// Global Work Size : (number of blocks in x * 8) x (number of blocks in y * 8)
+// Local Work Size  : 8 x 8
+//
+__kernel void copy_rgba_diff_image2d(__read_only image2d_t rgbaIn, __global uchar *rgbaOut, const int4 vDim, const int mirror, const int nTargetOrdering,
+                                     __global uchar *pDiffMap, __global uint2 *pSignatures, const uint2 vBlockDim, const int nForceDiff)
+{
+    __local uint uiBlockSum;
+    __local uint uiBlockXor;
+
+    uint uiLocalId_X = get_local_id(0);
+    uint uiLocalId_Y = get_local_id(1);
+
+    if (uiLocalId_X == 0 && uiLocalId_Y == 0)
+    {
+        uiBlockSum = 0;
+        uiBlockXor = 0;
+    }
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    uint uiBlockOffset_X = get_group_id(0) * vBlockDim.x;
+    uint uiBlockOffset_Y = get_group_id(1) * vBlockDim.y;
+
+    uint uiSum = 0;
+    uint uiXor = 0;
+
+    for (uint by = uiLocalId_Y; by < vBlockDim.y && uiBlockOffset_Y + by < vDim.y; by += get_local_size(1))
+    {
+        uint y = uiBlockOffset_Y + by;
+
+        for (uint bx = uiLocalId_X; bx < vBlockDim.x && uiBlockOffset_X + bx < vDim.x; bx += get_local_size(0))
+        {
+            uint x = uiBlockOffset_X + bx;
+
+            int2 ImgCoord = (int2)(x, (mirror) ? vDim.y - (y + 1) : y);
+
+            uchar4 pixel = convert_uchar4_sat(255.0f * read_imagef(rgbaIn, imageSampler, ImgCoord));
+
+            if (nTargetOrdering == 1)
+            {
+                // ARGB
+                pixel = pixel.wxyz;
+            }
+            else if (nTargetOrdering == 2)
+            {
+                // BGRA
+                pixel = pixel.zyxw;
+            }
+
+            vstore4(pixel, x + y * vDim.z, rgbaOut);
+
+            // Mix the pixel value with its position inside the block. This way moved content changes the signature.
+            uint uiPixel = as_uint(pixel);
+            uint uiPos   = bx + by * vBlockDim.x;
+
+            uint h = (uiPixel ^ (uiPos * 0x9E3779B1u)) * 0x85EBCA77u;
+            h ^= h >> 13;
+            h *= 0xC2B2AE3Du;
+            h ^= h >> 16;
+
+            uiSum += h;
+            uiXor ^= rotate(uiPixel * 0x27D4EB2Fu + uiPos, uiPos & 31);
+        }
+    }
+
+    atomic_add(&uiBlockSum, uiSum);
+    atomic_xor(&uiBlockXor, uiXor);
+
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (uiLocalId_X == 0 && uiLocalId_Y == 0)
+    {
+        uint  uiBlockIdx = get_group_id(0) + get_group_id(1) * get_num_groups(0);
+        uint2 Signature  = (uint2)(uiBlockSum, uiBlockXor);
+
+        pDiffMap[uiBlockIdx] = (nForceDiff || any(Signature != pSignatures[uiBlockIdx])) ? 1 : 0;
+
+        pSignatures[uiBlockIdx] = Signature;
+    }
 }
\ No newline at end of file
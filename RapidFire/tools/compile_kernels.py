@@ -0,0 +1,204 @@
+#
+# Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be included in
+# all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+# THE SOFTWARE.
+#
+
+# Compiles the RapidFire OpenCL kernels offline to SPIR-V and writes src/RFKernelIL.inc.
+# The library embeds the modules if it is built with RF_USE_OFFLINE_KERNELS defined. The Visual Studio projects
+# run this script before compiling and define RF_USE_OFFLINE_KERNELS for RFKernelIL.cpp if the file was written.
+#
+# The modules are compiled from the source strings the library embeds, not from the .cl files. Each entry
+# stores the utilHash64 of its source. The library ignores modules whose hash does not match its source,
+# the script has to be run again after a kernel was changed.
+#
+# Requires clang with OpenCL support and llvm-spirv (SPIRV-LLVM-Translator):
+#   python compile_kernels.py [--clang <path>] [--llvm-spirv <path>]
+#
+# Kernels that fail to compile, e.g. because they use vendor extensions, are not embedded.
+# RapidFire builds them from source at runtime.
+
+import argparse
+import codecs
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+KERNEL_FILES = ['rfkernels.cl', 'rfDiffMapKernel.cl']
+
+# Source file and variable of the source string the library passes to RFProgramCL::Create.
+KERNEL_SOURCES = {'rfkernels.cl':       ('RFKernelCL.cpp', 'str_cl_kernels'),
+                  'rfDiffMapKernel.cl': ('RFEncoderDM.cpp', 'str_cl_DiffMapkernels')}
+
+# Macros that RapidFire passes as build options. The SPIR-V modules use the portable variants.
+KERNEL_DEFINES = {'rfDiffMapKernel.cl': ['-DDIFF_MAP_SAD4=DiffMap_SAD4']}
+
+# Address bits of the device and the matching SPIR target.
+TARGETS = [(32, 'spir-unknown-unknown'), (64, 'spir64-unknown-unknown')]
+
+
+def hash64(data):
+    # Same as utilHash64 in src/RFUtils.cpp (64 bit FNV-1a).
+    h = 14695981039346656037
+    for b in data:
+        h = ((h ^ b) * 1099511628211) & 0xffffffffffffffff
+    return h
+
+
+def embedded_source(args, src_dir, file_name):
+    cpp_file, var_name = KERNEL_SOURCES[file_name]
+
+    # Run the preprocessor on the .cpp file to expand MULTI_LINE_STR exactly like the compiler does.
+    # The includes are not needed for that and are removed.
+    with open(os.path.join(src_dir, cpp_file)) as f:
+        code = ''.join(line for line in f if not line.lstrip().startswith('#include'))
+
+    try:
+        result = subprocess.run([args.clang, '-E', '-P', '-x', 'c++', '-'], input=code, stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE, universal_newlines=True)
+    except OSError as e:
+        print('warning: cannot run %s: %s' % (args.clang, e))
+        return None
+
+    match = re.search(r'\b%s\s*=\s*((?:"(?:[^"\\\n]|\\.)*"\s*)+);' % var_name, result.stdout)
+    if result.returncode != 0 or not match:
+        print('warning: cannot find %s in %s:\n%s' % (var_name, cpp_file, result.stderr))
+        return None
+
+    literals = re.findall(r'"((?:[^"\\\n]|\\.)*)"', match.group(1))
+
+    return ''.join(codecs.decode(s, 'unicode_escape') for s in literals).encode('latin-1')
+
+
+def compile_kernel(args, src_file, target, tmp_dir):
+    bc_file = os.path.join(tmp_dir, 'kernel.bc')
+    spv_file = os.path.join(tmp_dir, 'kernel.spv')
+
+    clang_cmd = [args.clang, '-c', '-x', 'cl', '-cl-std=CL1.2', '-target', target, '-emit-llvm',
+                 '-Xclang', '-finclude-default-header', '-O2', '-o', bc_file, src_file]
+    clang_cmd[1:1] = KERNEL_DEFINES.get(os.path.basename(src_file), [])
+    spirv_cmd = [args.llvm_spirv, bc_file, '-o', spv_file]
+
+    for cmd in (clang_cmd, spirv_cmd):
+        try:
+            result = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+        except OSError as e:
+            print('warning: cannot run %s: %s' % (cmd[0], e))
+            return None
+
+        if result.returncode != 0:
+            print('warning: %s failed for %s (%s):\n%s' % (os.path.basename(cmd[0]), os.path.basename(src_file), target, result.stdout))
+            return None
+
+    with open(spv_file, 'rb') as f:
+        return f.read()
+
+
+def array_name(file_name, bits):
+    return 's_' + file_name.replace('.', '_') + '_il%d' % bits
+
+
+def write_array(out, name, data):
+    out.write('static const unsigned char %s[] =\n{\n' % name)
+    for i in range(0, len(data), 16):
+        out.write('    ' + ', '.join('0x%02x' % b for b in data[i:i + 16]) + ',\n')
+    out.write('};\n\n')
+
+
+def main():
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    src_dir = os.path.join(script_dir, '..', 'src')
+
+    parser = argparse.ArgumentParser(description='Compiles the RapidFire OpenCL kernels to SPIR-V.')
+    parser.add_argument('--clang', default='clang', help='path of clang')
+    parser.add_argument('--llvm-spirv', default='llvm-spirv', help='path of llvm-spirv')
+    parser.add_argument('--output', default=os.path.join(src_dir, 'RFKernelIL.inc'), help='generated file')
+    args = parser.parse_args()
+
+    modules = {}
+    hashes = {}
+    tmp_dir = tempfile.mkdtemp()
+
+    try:
+        for file_name in KERNEL_FILES:
+            source = embedded_source(args, src_dir, file_name)
+            if source is None:
+                continue
+
+            hashes[file_name] = hash64(source)
+
+            src_file = os.path.join(tmp_dir, file_name)
+            with open(src_file, 'wb') as f:
+                f.write(source)
+
+            for bits, target in TARGETS:
+                data = compile_kernel(args, src_file, target, tmp_dir)
+                if data:
+                    modules[(file_name, bits)] = data
+    finally:
+        for name in os.listdir(tmp_dir):
+            os.remove(os.path.join(tmp_dir, name))
+        os.rmdir(tmp_dir)
+
+    if not modules:
+        # Remove modules of a previous run, the build only defines RF_USE_OFFLINE_KERNELS if the file exists.
+        if os.path.exists(args.output):
+            os.remove(args.output)
+        print('no modules written, the kernels are built from source at runtime')
+        return 1
+
+    tmp_output = args.output + '.tmp'
+
+    with open(tmp_output, 'w', newline='\n') as out:
+        out.write('// Generated by tools/compile_kernels.py. Do not edit.\n\n')
+
+        for (file_name, bits), data in sorted(modules.items()):
+            write_array(out, array_name(file_name, bits), data)
+
+        out.write('static const RFKernelILEntry s_KernelIL[] =\n{\n')
+        for file_name in KERNEL_FILES:
+            entry = ['"%s"' % file_name, '0x%016xULL' % hashes.get(file_name, 0)]
+            for bits, _ in TARGETS:
+                if (file_name, bits) in modules:
+                    name = array_name(file_name, bits)
+                    entry += [name, 'sizeof(%s)' % name]
+                else:
+                    entry += ['nullptr', '0']
+            out.write('    { ' + ', '.join(entry) + ' },\n')
+        out.write('};\n')
+
+    # Keep the timestamp of an unchanged file so that RFKernelIL.cpp is not rebuilt.
+    if os.path.exists(args.output):
+        with open(args.output, 'rb') as old, open(tmp_output, 'rb') as new:
+            if old.read() == new.read():
+                os.remove(tmp_output)
+                print('%s is up to date' % args.output)
+                return 0
+
+    os.replace(tmp_output, args.output)
+
+    print('%d of %d modules written to %s' % (len(modules), len(KERNEL_FILES) * len(TARGETS), args.output))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,558 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Compares RFCSCHost with the rgbaTonv12_image2d kernel and the RGBA to NV12 kernels
+// with each other.
+//
+// The results of RFCSCHost are checked against a scalar reference of the integer BT.601
+// math of rgbaTonv12_image2d and rgbaToI420_image2d. If an OpenCL device is available the
+// kernel is run on the same input and its result has to match as well. The OpenCL time
+// includes the upload of the RGBA image and the readback of the NV12 image, which is the
+// path a host memory session would take without RFCSCHost.
+//
+// The nv12 benchmark runs rgbaTonv12_image2d, rgbaTonv12_image2d_vec8 and
+// rgbaTonv12_image2d_tiled with the launch configuration of RFContextCL::configureKernels.
+// It measures the kernel time without transfers and checks that the output of each kernel
+// is bit exact with the reference, with and without mirroring.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <CL/cl.h>
+
+#include "HostBenchmark.h"
+#include "RFCSCHost.h"
+
+using namespace std;
+
+// str_cl_kernels is defined in RFKernelCL.cpp and contains the kernel sources.
+extern const char* str_cl_kernels;
+
+
+// Converts an RGBA8 image like rgbaTonv12_image2d (uiChromaStep 2) or rgbaToI420_image2d (uiChromaStep 1).
+static void convertReference(const unsigned char* pRGBA, unsigned int uiWidth, unsigned int uiHeight, unsigned int uiPitch, bool bMirror,
+                             unsigned char* pY, unsigned char* pU, unsigned char* pV, unsigned int uiChromaStep)
+{
+    for (unsigned int y = 0; y < uiHeight / 2; ++y)
+    {
+        const unsigned int uiRow[2] = { bMirror ? (uiHeight - 2 * y - 1) : (2 * y),
+                                        bMirror ? (uiHeight - 2 * y - 2) : (2 * y + 1) };
+
+        for (unsigned int x = 0; x < uiWidth / 2; ++x)
+        {
+            int Sum[3] = { 0, 0, 0 };
+
+            for (unsigned int i = 0; i < 4; ++i)
+            {
+                const unsigned char* p = pRGBA + (uiRow[i / 2] * uiWidth + 2 * x + (i % 2)) * 4;
+
+                pY[(2 * y + i / 2) * uiPitch + 2 * x + (i % 2)] = static_cast<unsigned char>(((66 * p[0] + 129 * p[1] + 25 * p[2] + 128) >> 8) + 16);
+
+                Sum[0] += p[0];
+                Sum[1] += p[1];
+                Sum[2] += p[2];
+            }
+
+            const int r = Sum[0] >> 2;
+            const int g = Sum[1] >> 2;
+            const int b = Sum[2] >> 2;
+
+            pU[y * uiPitch + x * uiChromaStep] = static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            pV[y * uiPitch + x * uiChromaStep] = static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+
+static bool compare(const vector<unsigned char>& Result, const vector<unsigned char>& Reference, const char* strTest)
+{
+    for (size_t i = 0; i < Reference.size(); ++i)
+    {
+        if (Result[i] != Reference[i])
+        {
+            cerr << "   " << strTest << ": byte " << i << " is " << static_cast<int>(Result[i]) << " instead of " << static_cast<int>(Reference[i]) << endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// Checks NV12 and I420 results of RFCSCHost for an image of uiWidth x uiHeight pixels that is stored in
+// a buffer with a pitch of uiAlignedWidth.
+static bool checkHostCSC(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiAlignedWidth, unsigned int uiAlignedHeight)
+{
+    RFCSCHost                   csc;
+    vector<unsigned char>       Input;
+    bool                        bPassed = true;
+
+    createRandomImage(uiWidth * uiHeight * 4, uiWidth + uiHeight, Input);
+
+    csc.setDimension(uiWidth, uiHeight, uiAlignedWidth, uiAlignedHeight);
+
+    for (int iMirror = 0; iMirror < 2; ++iMirror)
+    {
+        const bool bMirror = (iMirror != 0);
+
+        // The UV plane of NV12 starts after uiHeight rows, the U and V planes of I420 after uiAlignedHeight rows.
+        // Bytes the kernels do not write, e.g. the last column of an odd width, have to stay unchanged.
+        vector<unsigned char> Reference(uiAlignedWidth * uiAlignedHeight * 2, 0x5A);
+        vector<unsigned char> Result(Reference);
+
+        convertReference(Input.data(), uiWidth, uiHeight, uiAlignedWidth, bMirror, Reference.data(), Reference.data() + uiAlignedWidth * uiHeight,
+                         Reference.data() + uiAlignedWidth * uiHeight + 1, 2);
+
+        if (!csc.convertToNV12(Input.data(), Result.data(), bMirror) || !compare(Result, Reference, "NV12"))
+        {
+            bPassed = false;
+        }
+
+        fill(Reference.begin(), Reference.end(), 0x5A);
+        fill(Result.begin(), Result.end(), 0x5A);
+
+        unsigned char* pU = Reference.data() + uiAlignedWidth * uiAlignedHeight;
+
+        convertReference(Input.data(), uiWidth, uiHeight, uiAlignedWidth, bMirror, Reference.data(), pU, pU + uiAlignedWidth * uiAlignedHeight / 2, 1);
+
+        if (!csc.convertToI420(Input.data(), Result.data(), bMirror) || !compare(Result, Reference, "I420"))
+        {
+            bPassed = false;
+        }
+    }
+
+    cout << "   Reference check " << uiWidth << "x" << uiHeight << " (" << uiAlignedWidth << "x" << uiAlignedHeight << "): "
+         << (bPassed ? "passed" : "FAILED") << endl;
+
+    return bPassed;
+}
+
+
+// Launch configuration of an RGBA to NV12 kernel as set up by RFContextCL::configureKernels. Each work item
+// converts uiItemWidth x 2 pixels.
+struct NV12Kernel
+{
+    const char*     strName;
+    unsigned int    uiItemWidth;
+    size_t          LocalSize[2];
+};
+
+static const NV12Kernel NV12Kernels[] = { { "rgbaTonv12_image2d",       2, { 16, 16 } },
+                                          { "rgbaTonv12_image2d_vec8",  8, { 16, 16 } },
+                                          { "rgbaTonv12_image2d_tiled", 1, { 32,  8 } } };
+
+static const unsigned int NUM_NV12_KERNELS = sizeof(NV12Kernels) / sizeof(NV12Kernels[0]);
+
+
+// Runs the RGBA to NV12 kernels on the first GPU or, if there is none, on the first OpenCL device.
+class CSCKernel
+{
+public:
+
+    CSCKernel()
+        : m_clDevice(nullptr)
+        , m_clContext(nullptr)
+        , m_clQueue(nullptr)
+        , m_clProgram(nullptr)
+    {
+        memset(m_clKernels, 0, sizeof(m_clKernels));
+    }
+
+    ~CSCKernel()
+    {
+        for (cl_kernel clKernel : m_clKernels)
+        {
+            if (clKernel)
+            {
+                clReleaseKernel(clKernel);
+            }
+        }
+
+        if (m_clProgram)
+        {
+            clReleaseProgram(m_clProgram);
+        }
+
+        if (m_clQueue)
+        {
+            clReleaseCommandQueue(m_clQueue);
+        }
+
+        if (m_clContext)
+        {
+            clReleaseContext(m_clContext);
+        }
+    }
+
+    bool init()
+    {
+        cl_uint uiNumPlatforms = 0;
+
+        if (clGetPlatformIDs(0, nullptr, &uiNumPlatforms) != CL_SUCCESS || uiNumPlatforms == 0)
+        {
+            return false;
+        }
+
+        vector<cl_platform_id> Platforms(uiNumPlatforms);
+
+        clGetPlatformIDs(uiNumPlatforms, Platforms.data(), nullptr);
+
+        const cl_device_type DeviceTypes[] = { CL_DEVICE_TYPE_GPU, CL_DEVICE_TYPE_ALL };
+
+        for (cl_device_type type : DeviceTypes)
+        {
+            for (cl_platform_id platform : Platforms)
+            {
+                if (!m_clDevice && clGetDeviceIDs(platform, type, 1, &m_clDevice, nullptr) != CL_SUCCESS)
+                {
+                    m_clDevice = nullptr;
+                }
+            }
+        }
+
+        if (!m_clDevice)
+        {
+            return false;
+        }
+
+        char strName[256] = {};
+
+        clGetDeviceInfo(m_clDevice, CL_DEVICE_NAME, sizeof(strName) - 1, strName, nullptr);
+
+        m_strDeviceName = strName;
+
+        cl_int nStatus = CL_SUCCESS;
+
+        m_clContext = clCreateContext(nullptr, 1, &m_clDevice, nullptr, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            return false;
+        }
+
+        m_clQueue = clCreateCommandQueue(m_clContext, m_clDevice, 0, &nStatus);
+        if (nStatus != CL_SUCCESS)
+        {
+            return false;
+        }
+
+        m_clProgram = clCreateProgramWithSource(m_clContext, 1, &str_cl_kernels, nullptr, &nStatus);
+        if (nStatus != CL_SUCCESS || clBuildProgram(m_clProgram, 1, &m_clDevice, nullptr, nullptr, nullptr) != CL_SUCCESS)
+        {
+            return false;
+        }
+
+        for (unsigned int i = 0; i < NUM_NV12_KERNELS; ++i)
+        {
+            m_clKernels[i] = clCreateKernel(m_clProgram, NV12Kernels[i].strName, &nStatus);
+            if (nStatus != CL_SUCCESS)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool upload(cl_mem clImage, const unsigned char* pRGBA, unsigned int uiWidth, unsigned int uiHeight)
+    {
+        const size_t Origin[3] = { 0, 0, 0 };
+        const size_t Region[3] = { uiWidth, uiHeight, 1 };
+
+        return (clEnqueueWriteImage(m_clQueue, clImage, CL_FALSE, Origin, Region, uiWidth * 4, 0, pRGBA, 0, nullptr, nullptr) == CL_SUCCESS);
+    }
+
+    // Enqueues the kernel NV12Kernels[uiKernel] without waiting for it to complete.
+    bool run(unsigned int uiKernel, cl_mem clImage, cl_mem clOutput, unsigned int uiWidth, unsigned int uiHeight, unsigned int uiAlignedWidth,
+             unsigned int uiAlignedHeight, bool bMirror)
+    {
+        const NV12Kernel& k             = NV12Kernels[uiKernel];
+        cl_kernel         clKernel      = m_clKernels[uiKernel];
+        const cl_int4     vDim          = { { static_cast<cl_int>(uiWidth), static_cast<cl_int>(uiHeight), static_cast<cl_int>(uiAlignedWidth),
+                                              static_cast<cl_int>(uiAlignedHeight) } };
+        const cl_int      nMirror       = bMirror ? 1 : 0;
+        const size_t      Items[2]      = { uiWidth / k.uiItemWidth, uiHeight / 2 };
+        const size_t      GlobalSize[2] = { ((Items[0] + k.LocalSize[0] - 1) / k.LocalSize[0]) * k.LocalSize[0],
+                                            ((Items[1] + k.LocalSize[1] - 1) / k.LocalSize[1]) * k.LocalSize[1] };
+
+        cl_int nStatus = clSetKernelArg(clKernel, 0, sizeof(cl_mem), &clImage);
+
+        nStatus |= clSetKernelArg(clKernel, 1, sizeof(cl_mem), &clOutput);
+        nStatus |= clSetKernelArg(clKernel, 2, sizeof(cl_int4), &vDim);
+        nStatus |= clSetKernelArg(clKernel, 3, sizeof(cl_int), &nMirror);
+        nStatus |= clEnqueueNDRangeKernel(m_clQueue, clKernel, 2, nullptr, GlobalSize, k.LocalSize, 0, nullptr, nullptr);
+
+        return (nStatus == CL_SUCCESS);
+    }
+
+    bool finish()
+    {
+        return (clFinish(m_clQueue) == CL_SUCCESS);
+    }
+
+    bool read(cl_mem clOutput, unsigned char* pData, size_t uiSize)
+    {
+        return (clEnqueueReadBuffer(m_clQueue, clOutput, CL_TRUE, 0, uiSize, pData, 0, nullptr, nullptr) == CL_SUCCESS);
+    }
+
+    bool write(cl_mem clOutput, const unsigned char* pData, size_t uiSize)
+    {
+        return (clEnqueueWriteBuffer(m_clQueue, clOutput, CL_TRUE, 0, uiSize, pData, 0, nullptr, nullptr) == CL_SUCCESS);
+    }
+
+    // Uploads pRGBA, converts it with rgbaTonv12_image2d and reads the NV12 image back into pNV12.
+    bool convert(cl_mem clImage, cl_mem clOutput, const unsigned char* pRGBA, unsigned char* pNV12, unsigned int uiWidth, unsigned int uiHeight,
+                 unsigned int uiAlignedWidth, unsigned int uiAlignedHeight)
+    {
+        return (upload(clImage, pRGBA, uiWidth, uiHeight) && run(0, clImage, clOutput, uiWidth, uiHeight, uiAlignedWidth, uiAlignedHeight, false) &&
+                read(clOutput, pNV12, uiAlignedWidth * uiAlignedHeight * 3 / 2));
+    }
+
+    cl_context          getContext()    const { return m_clContext; }
+    const string&       getDeviceName() const { return m_strDeviceName; }
+
+private:
+
+    cl_device_id        m_clDevice;
+    cl_context          m_clContext;
+    cl_command_queue    m_clQueue;
+    cl_program          m_clProgram;
+    cl_kernel           m_clKernels[NUM_NV12_KERNELS];
+    string              m_strDeviceName;
+};
+
+
+bool runCSCBenchmark()
+{
+    bool bPassed = true;
+
+    // Aligned sizes like the ones used by the encoders and an odd size with an unconverted last column and row.
+    bPassed &= checkHostCSC(1920, 1080, 1920, 1088);
+    bPassed &= checkHostCSC(3840, 2160, 3840, 2160);
+    bPassed &= checkHostCSC(1365, 767, 1376, 768);
+
+    CSCKernel kernel;
+
+    const bool bUseCL = kernel.init();
+
+    if (bUseCL)
+    {
+        cout << "   OpenCL device: " << kernel.getDeviceName() << endl;
+    }
+    else
+    {
+        cout << "   No OpenCL device, only RFCSCHost is measured" << endl;
+    }
+
+    for (unsigned int i = 0; i < g_uiNumBenchmarkSizes; ++i)
+    {
+        const unsigned int uiWidth  = g_BenchmarkSizes[i].uiWidth;
+        const unsigned int uiHeight = g_BenchmarkSizes[i].uiHeight;
+
+        RFCSCHost             csc;
+        vector<unsigned char> Input;
+        vector<unsigned char> HostOutput(uiWidth * uiHeight * 3 / 2, 0);
+
+        createDesktopImage(uiWidth, uiHeight, i, Input);
+
+        csc.setDimension(uiWidth, uiHeight, uiWidth, uiHeight);
+
+        const double dHostTime = measure([&]() { return csc.convertToNV12(Input.data(), HostOutput.data(), false); });
+
+        cout << "   " << setw(6) << g_BenchmarkSizes[i].strName << " RFCSCHost (" << csc.getInstructionSet() << "): "
+             << fixed << setprecision(3) << dHostTime << " ms" << endl;
+
+        if (!bUseCL)
+        {
+            continue;
+        }
+
+        cl_int          nStatus     = CL_SUCCESS;
+        cl_image_format ImageFormat = { CL_RGBA, CL_UNORM_INT8 };
+        cl_image_desc   ImageDesc;
+
+        memset(&ImageDesc, 0, sizeof(ImageDesc));
+
+        ImageDesc.image_type   = CL_MEM_OBJECT_IMAGE2D;
+        ImageDesc.image_width  = uiWidth;
+        ImageDesc.image_height = uiHeight;
+
+        cl_mem clImage  = clCreateImage(kernel.getContext(), CL_MEM_READ_ONLY, &ImageFormat, &ImageDesc, nullptr, &nStatus);
+        cl_mem clOutput = clCreateBuffer(kernel.getContext(), CL_MEM_WRITE_ONLY, HostOutput.size(), nullptr, &nStatus);
+
+        vector<unsigned char> CLOutput(HostOutput.size(), 0);
+
+        const double dCLTime = (clImage && clOutput) ?
+            measure([&]() { return kernel.convert(clImage, clOutput, Input.data(), CLOutput.data(), uiWidth, uiHeight, uiWidth, uiHeight); }) : -1.0;
+
+        if (clImage)
+        {
+            clReleaseMemObject(clImage);
+        }
+
+        if (clOutput)
+        {
+            clReleaseMemObject(clOutput);
+        }
+
+        if (dCLTime < 0.0)
+        {
+            cerr << "   Failed to run rgbaTonv12_image2d" << endl;
+            continue;
+        }
+
+        const bool bMatch = compare(CLOutput, HostOutput, "rgbaTonv12_image2d");
+
+        bPassed &= bMatch;
+
+        cout << "   " << setw(6) << g_BenchmarkSizes[i].strName << " OpenCL upload + kernel + readback: " << dCLTime << " ms, result "
+             << (bMatch ? "matches" : "DIFFERS") << endl;
+    }
+
+    return bPassed;
+}
+
+
+
+// Creates an image and an output buffer for the nv12 benchmark and releases them when it goes out of scope.
+struct NV12Buffers
+{
+    NV12Buffers(cl_context clContext, unsigned int uiWidth, unsigned int uiHeight, size_t uiOutputSize)
+        : clImage(nullptr)
+        , clOutput(nullptr)
+    {
+        cl_int          nStatus     = CL_SUCCESS;
+        cl_image_format ImageFormat = { CL_RGBA, CL_UNORM_INT8 };
+        cl_image_desc   ImageDesc;
+
+        memset(&ImageDesc, 0, sizeof(ImageDesc));
+
+        ImageDesc.image_type   = CL_MEM_OBJECT_IMAGE2D;
+        ImageDesc.image_width  = uiWidth;
+        ImageDesc.image_height = uiHeight;
+
+        clImage  = clCreateImage(clContext, CL_MEM_READ_ONLY, &ImageFormat, &ImageDesc, nullptr, &nStatus);
+        clOutput = clCreateBuffer(clContext, CL_MEM_READ_WRITE, uiOutputSize, nullptr, &nStatus);
+    }
+
+    ~NV12Buffers()
+    {
+        if (clImage)
+        {
+            clReleaseMemObject(clImage);
+        }
+
+        if (clOutput)
+        {
+            clReleaseMemObject(clOutput);
+        }
+    }
+
+    cl_mem  clImage;
+    cl_mem  clOutput;
+};
+
+
+bool runNV12KernelBenchmark()
+{
+    CSCKernel kernel;
+
+    if (!kernel.init())
+    {
+        cout << "   No OpenCL device, the kernels cannot be measured" << endl;
+        return true;
+    }
+
+    cout << "   OpenCL device: " << kernel.getDeviceName() << endl;
+
+    // The width of the last size is not a multiple of 8, which configureKernels runs with the tiled kernel.
+    const BenchmarkSize Sizes[] = { g_BenchmarkSizes[0], g_BenchmarkSizes[1], { 1366, 768, "1366x768" } };
+
+    bool bPassed = true;
+
+    for (unsigned int i = 0; i < sizeof(Sizes) / sizeof(Sizes[0]); ++i)
+    {
+        const unsigned int uiWidth      = Sizes[i].uiWidth;
+        const unsigned int uiHeight     = Sizes[i].uiHeight;
+        const size_t       uiOutputSize = uiWidth * uiHeight * 3 / 2;
+
+        NV12Buffers             Buffers(kernel.getContext(), uiWidth, uiHeight, uiOutputSize);
+        vector<unsigned char>   Input;
+
+        createDesktopImage(uiWidth, uiHeight, i, Input);
+
+        if (!Buffers.clImage || !Buffers.clOutput || !kernel.upload(Buffers.clImage, Input.data(), uiWidth, uiHeight))
+        {
+            cerr << "   Failed to create the OpenCL buffers" << endl;
+            return false;
+        }
+
+        // configureKernels uses the vec8 kernel if the width is a multiple of 8 and the tiled kernel otherwise.
+        const unsigned int uiDefault = ((uiWidth % 8) == 0) ? 1 : 2;
+
+        for (unsigned int k = 0; k < NUM_NV12_KERNELS; ++k)
+        {
+            if (NV12Kernels[k].uiItemWidth > 2 && (uiWidth % NV12Kernels[k].uiItemWidth) != 0)
+            {
+                cout << "   " << setw(8) << Sizes[i].strName << " " << setw(24) << NV12Kernels[k].strName << ": not supported for this width" << endl;
+                continue;
+            }
+
+            bool bMatch = true;
+
+            // Bytes the kernel does not write have to stay unchanged, hence the output is initialized with the same pattern.
+            for (int iMirror = 0; iMirror < 2; ++iMirror)
+            {
+                vector<unsigned char> Reference(uiOutputSize, 0x5A);
+                vector<unsigned char> Result(Reference);
+
+                convertReference(Input.data(), uiWidth, uiHeight, uiWidth, (iMirror != 0), Reference.data(), Reference.data() + uiWidth * uiHeight,
+                                 Reference.data() + uiWidth * uiHeight + 1, 2);
+
+                if (!kernel.write(Buffers.clOutput, Result.data(), uiOutputSize) ||
+                    !kernel.run(k, Buffers.clImage, Buffers.clOutput, uiWidth, uiHeight, uiWidth, uiHeight, (iMirror != 0)) ||
+                    !kernel.read(Buffers.clOutput, Result.data(), uiOutputSize) || !compare(Result, Reference, NV12Kernels[k].strName))
+                {
+                    bMatch = false;
+                }
+            }
+
+            const double dTime = measure([&]()
+            {
+                return kernel.run(k, Buffers.clImage, Buffers.clOutput, uiWidth, uiHeight, uiWidth, uiHeight, false) && kernel.finish();
+            });
+
+            bPassed &= bMatch;
+
+            cout << "   " << setw(8) << Sizes[i].strName << " " << setw(24) << NV12Kernels[k].strName << ": " << fixed << setprecision(3) << dTime
+                 << " ms, result " << (bMatch ? "matches" : "DIFFERS") << ((k == uiDefault) ? " (selected by configureKernels)" : "") << endl;
+        }
+    }
+
+    return bPassed;
+}
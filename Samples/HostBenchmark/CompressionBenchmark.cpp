@@ -0,0 +1,229 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Measures how RFCompressor scales with the number of threads.
+//
+// A desktop image in RGBA, which is the output of the identity encoder, is compressed with
+// 1, 2, 4, ... threads up to the number of hardware threads and with the default chunk size
+// of RF_OUTPUT_COMPRESSION_CHUNK_SIZE as well as a smaller one. Each output is decompressed
+// with a reference LZ4 block decoder and compared to the input.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "HostBenchmark.h"
+#include "RFCompressor.h"
+
+using namespace std;
+
+
+// Decodes one LZ4 block of uiSize bytes into uiDstSize bytes of pDst. Returns false if the block is malformed or does
+// not decode into exactly uiDstSize bytes.
+static bool decompressBlock(const unsigned char* pSrc, unsigned int uiSize, unsigned char* pDst, unsigned int uiDstSize)
+{
+    const unsigned char* pSrcEnd = pSrc + uiSize;
+    unsigned int         uiPos   = 0;
+
+    while (pSrc < pSrcEnd)
+    {
+        const unsigned int uiToken = *pSrc++;
+
+        size_t uiLiterals = uiToken >> 4;
+
+        if (uiLiterals == 15)
+        {
+            unsigned char Byte = 255;
+
+            while (Byte == 255 && pSrc < pSrcEnd)
+            {
+                Byte        = *pSrc++;
+                uiLiterals += Byte;
+            }
+        }
+
+        if (uiLiterals > static_cast<size_t>(pSrcEnd - pSrc) || uiLiterals > uiDstSize - uiPos)
+        {
+            return false;
+        }
+
+        memcpy(pDst + uiPos, pSrc, uiLiterals);
+
+        pSrc  += uiLiterals;
+        uiPos += static_cast<unsigned int>(uiLiterals);
+
+        // The last sequence only contains literals.
+        if (pSrc == pSrcEnd)
+        {
+            break;
+        }
+
+        if (pSrcEnd - pSrc < 2)
+        {
+            return false;
+        }
+
+        const unsigned int uiOffset = pSrc[0] | (pSrc[1] << 8);
+
+        pSrc += 2;
+
+        size_t uiMatch = uiToken & 0xF;
+
+        if (uiMatch == 15)
+        {
+            unsigned char Byte = 255;
+
+            while (Byte == 255 && pSrc < pSrcEnd)
+            {
+                Byte     = *pSrc++;
+                uiMatch += Byte;
+            }
+        }
+
+        uiMatch += 4;
+
+        if (uiOffset == 0 || uiOffset > uiPos || uiMatch > uiDstSize - uiPos)
+        {
+            return false;
+        }
+
+        // Matches may overlap their own output, hence they are copied byte by byte.
+        for (size_t i = 0; i < uiMatch; ++i, ++uiPos)
+        {
+            pDst[uiPos] = pDst[uiPos - uiOffset];
+        }
+    }
+
+    return (uiPos == uiDstSize);
+}
+
+
+// Restores the input of RFCompressor::compress from its output.
+static bool decompress(const unsigned char* pOutput, unsigned int uiOutputSize, vector<unsigned char>& Data)
+{
+    unsigned int uiNumChunks = 0;
+
+    if (uiOutputSize < sizeof(unsigned int))
+    {
+        return false;
+    }
+
+    memcpy(&uiNumChunks, pOutput, sizeof(unsigned int));
+
+    if (uiOutputSize < sizeof(unsigned int) + static_cast<size_t>(uiNumChunks) * sizeof(RFCompressedChunk))
+    {
+        return false;
+    }
+
+    const RFCompressedChunk* pChunks = reinterpret_cast<const RFCompressedChunk*>(pOutput + sizeof(unsigned int));
+
+    Data.clear();
+
+    for (unsigned int i = 0; i < uiNumChunks; ++i)
+    {
+        const RFCompressedChunk& Chunk = pChunks[i];
+
+        if (static_cast<size_t>(Chunk.uiOffset) + Chunk.uiSize > uiOutputSize)
+        {
+            return false;
+        }
+
+        const size_t uiPos = Data.size();
+
+        Data.resize(uiPos + Chunk.uiUncompressedSize);
+
+        if (Chunk.uiSize == Chunk.uiUncompressedSize)
+        {
+            memcpy(Data.data() + uiPos, pOutput + Chunk.uiOffset, Chunk.uiSize);
+        }
+        else if (!decompressBlock(pOutput + Chunk.uiOffset, Chunk.uiSize, Data.data() + uiPos, Chunk.uiUncompressedSize))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool runCompressionBenchmark()
+{
+    const unsigned int uiChunkSizes[]    = { 262144, 65536 };
+    const unsigned int uiHardwareThreads = max(1U, thread::hardware_concurrency());
+
+    bool bPassed = true;
+
+    for (unsigned int i = 0; i < g_uiNumBenchmarkSizes; ++i)
+    {
+        const unsigned int uiWidth  = g_BenchmarkSizes[i].uiWidth;
+        const unsigned int uiHeight = g_BenchmarkSizes[i].uiHeight;
+
+        vector<unsigned char> Image;
+
+        createDesktopImage(uiWidth, uiHeight, i, Image);
+
+        const unsigned int uiSize = static_cast<unsigned int>(Image.size());
+
+        for (unsigned int uiChunkSize : uiChunkSizes)
+        {
+            double dSingleThread = 0.0;
+
+            for (unsigned int uiNumThreads = 1; ; uiNumThreads = min(2 * uiNumThreads, uiHardwareThreads))
+            {
+                RFCompressor          Compressor(uiChunkSize, uiNumThreads);
+                void*                 pOutput      = nullptr;
+                unsigned int          uiOutputSize = 0;
+                vector<unsigned char> Decompressed;
+
+                const double dTime = measure([&]() { return Compressor.compress(Image.data(), uiSize, pOutput, uiOutputSize); });
+
+                const bool bMatch = (dTime >= 0.0 && decompress(static_cast<const unsigned char*>(pOutput), uiOutputSize, Decompressed) &&
+                                     Decompressed == Image);
+
+                if (uiNumThreads == 1)
+                {
+                    dSingleThread = dTime;
+                }
+
+                bPassed &= bMatch;
+
+                cout << "   " << setw(6) << g_BenchmarkSizes[i].strName << " " << setw(3) << uiChunkSize / 1024 << " KiB chunks, "
+                     << setw(2) << Compressor.getNumThreads() << " threads: " << fixed << setprecision(3) << dTime << " ms, speedup "
+                     << setprecision(2) << dSingleThread / dTime << ", ratio " << static_cast<double>(uiSize) / uiOutputSize
+                     << (bMatch ? "" : ", round trip FAILED") << endl;
+
+                if (uiNumThreads == uiHardwareThreads)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return bPassed;
+}
@@ -0,0 +1,303 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Compares RFDiffMapHost with the diff map kernels of the difference encoder.
+//
+// The diff maps of RFDiffMapHost are checked against a scalar reference of DiffMap_Buffer
+// and of DiffMap_SADBuffer for thresholds and magnitudes. The throughput of RFDiffMapHost
+// is measured for identical frames, where every block is compared completely, and for
+// frames with changed text lines, where most changed blocks exit early.
+// If RapidFire can be loaded, two host memory sessions with the difference encoder are
+// compared as well: one uses RF_DIFF_ENCODER_HOST_DIFF, the other uploads the frames and
+// runs the OpenCL kernels. Both sessions have to return the same diff maps.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "HostBenchmark.h"
+#include "RFDiffMapHost.h"
+#include "RFWrapper.hpp"
+
+using namespace std;
+
+#define BLOCK_WIDTH     16
+#define BLOCK_HEIGHT    16
+
+
+// Computes the diff map like DiffMap_Buffer if uiThreshold is 0 and bMagnitude is false, otherwise like
+// DiffMap_SADBuffer.
+static void diffMapReference(const unsigned char* pImage1, const unsigned char* pImage2, unsigned int uiWidth, unsigned int uiHeight,
+                             unsigned int uiBlockWidth, unsigned int uiBlockHeight, unsigned int uiThreshold, bool bMagnitude, unsigned char* pDiffMap)
+{
+    const unsigned int uiMapWidth  = (uiWidth + uiBlockWidth - 1) / uiBlockWidth;
+    const unsigned int uiMapHeight = (uiHeight + uiBlockHeight - 1) / uiBlockHeight;
+    const bool         bSAD        = (uiThreshold > 0 || bMagnitude);
+
+    for (unsigned int by = 0; by < uiMapHeight; ++by)
+    {
+        for (unsigned int bx = 0; bx < uiMapWidth; ++bx)
+        {
+            unsigned int uiSAD    = 0;
+            bool         bChanged = false;
+
+            for (unsigned int y = by * uiBlockHeight; y < min((by + 1) * uiBlockHeight, uiHeight); ++y)
+            {
+                for (unsigned int x = bx * uiBlockWidth * 4; x < min((bx + 1) * uiBlockWidth, uiWidth) * 4; ++x)
+                {
+                    const int iDiff = abs(pImage1[y * uiWidth * 4 + x] - pImage2[y * uiWidth * 4 + x]);
+
+                    uiSAD    += iDiff;
+                    bChanged |= (iDiff != 0);
+                }
+            }
+
+            unsigned char Result = bChanged ? 1 : 0;
+
+            if (bSAD)
+            {
+                // The mean is computed for the full block size, also for blocks at the border.
+                const unsigned int uiBlockBytes = 4 * uiBlockWidth * uiBlockHeight;
+
+                Result = 0;
+
+                if (uiSAD > uiThreshold)
+                {
+                    Result = bMagnitude ? static_cast<unsigned char>(min((uiSAD + uiBlockBytes - 1) / uiBlockBytes, 255u)) : 1;
+                }
+            }
+
+            pDiffMap[bx + by * uiMapWidth] = Result;
+        }
+    }
+}
+
+
+// Checks the diff maps of RFDiffMapHost for two random images that differ in single bytes at random positions
+// including the last column and row of the image.
+static bool checkHostDiffMap(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiBlockWidth, unsigned int uiBlockHeight)
+{
+    vector<unsigned char> Image1;
+    vector<unsigned char> Noise;
+
+    createRandomImage(uiWidth * uiHeight * 4, uiWidth * uiHeight, Image1);
+    createRandomImage(uiWidth * uiHeight / 8, uiBlockWidth + uiBlockHeight, Noise);
+
+    vector<unsigned char> Image2(Image1);
+
+    for (size_t i = 0; i + 4 <= Noise.size(); i += 4)
+    {
+        const unsigned int uiPos = (Noise[i] | (Noise[i + 1] << 8) | (Noise[i + 2] << 16)) % (uiWidth * uiHeight * 4);
+
+        if (Noise[i + 3] < 4)
+        {
+            Image2[uiPos] = static_cast<unsigned char>(Image2[uiPos] + 1 + (Noise[i + 3] & 1) * 100);
+        }
+    }
+
+    Image2.back() ^= 1;
+    Image2[(uiWidth - 1) * 4] ^= 0x80;
+
+    const unsigned int uiMapSize = ((uiWidth + uiBlockWidth - 1) / uiBlockWidth) * ((uiHeight + uiBlockHeight - 1) / uiBlockHeight);
+
+    struct ThresholdSetting
+    {
+        unsigned int    uiThreshold;
+        bool            bMagnitude;
+    };
+
+    const ThresholdSetting Settings[] = { { 0, false }, { 0, true }, { 60, false }, { 60, true } };
+
+    bool          bPassed = true;
+    RFDiffMapHost diff;
+
+    diff.setDimension(uiWidth, uiHeight, uiBlockWidth, uiBlockHeight);
+
+    for (const ThresholdSetting& s : Settings)
+    {
+        vector<unsigned char> Reference(uiMapSize, 0);
+        vector<unsigned char> Result(uiMapSize, 0xFF);
+
+        diffMapReference(Image1.data(), Image2.data(), uiWidth, uiHeight, uiBlockWidth, uiBlockHeight, s.uiThreshold, s.bMagnitude, Reference.data());
+
+        diff.setThreshold(s.uiThreshold, s.bMagnitude);
+
+        if (!diff.computeDiffMap(Image1.data(), Image2.data(), Result.data()) || Result != Reference)
+        {
+            const size_t uiFirst = mismatch(Result.begin(), Result.end(), Reference.begin()).first - Result.begin();
+
+            cerr << "   Threshold " << s.uiThreshold << (s.bMagnitude ? " with magnitude" : "") << ": block " << uiFirst << " is "
+                 << static_cast<int>(Result[uiFirst]) << " instead of " << static_cast<int>(Reference[uiFirst]) << endl;
+
+            bPassed = false;
+        }
+    }
+
+    cout << "   Reference check " << uiWidth << "x" << uiHeight << " with " << uiBlockWidth << "x" << uiBlockHeight << " blocks: "
+         << (bPassed ? "passed" : "FAILED") << endl;
+
+    return bPassed;
+}
+
+
+// Encodes the two images alternately with a host memory session and the difference encoder. Returns the average
+// time of rfEncodeFrame and rfGetEncodedFrame in ms and the diff maps of the first frames in Outputs.
+static double measureSession(const RFWrapper& rfDll, bool bHostDiff, unsigned int uiWidth, unsigned int uiHeight, vector<unsigned char>& Image1,
+                             vector<unsigned char>& Image2, vector<vector<unsigned char>>& Outputs)
+{
+    RFEncodeSession rfSession = nullptr;
+
+    RFProperties props[] = { RF_ENCODER,               static_cast<RFProperties>(RF_DIFFERENCE),
+                             RF_HOST_MEMORY,           static_cast<RFProperties>(1),
+                             RF_ENCODER_BLOCKING_READ, static_cast<RFProperties>(1),
+                             0 };
+
+    if (rfDll.rfFunc.rfCreateEncodeSession(&rfSession, props) != RF_STATUS_OK)
+    {
+        return -1.0;
+    }
+
+    RFProperties encoderProps[] = { RF_ENCODER_FORMAT,         RF_RGBA8,
+                                    RF_DIFF_ENCODER_BLOCK_S,   BLOCK_WIDTH,
+                                    RF_DIFF_ENCODER_BLOCK_T,   BLOCK_HEIGHT,
+                                    RF_DIFF_ENCODER_HOST_DIFF, static_cast<RFProperties>(bHostDiff ? 1 : 0),
+                                    0 };
+
+    unsigned int uiIndex[2] = {};
+
+    if (rfDll.rfFunc.rfCreateEncoder2(rfSession, uiWidth, uiHeight, encoderProps) != RF_STATUS_OK ||
+        rfDll.rfFunc.rfRegisterRenderTarget(rfSession, Image1.data(), uiWidth, uiHeight, &uiIndex[0]) != RF_STATUS_OK ||
+        rfDll.rfFunc.rfRegisterRenderTarget(rfSession, Image2.data(), uiWidth, uiHeight, &uiIndex[1]) != RF_STATUS_OK)
+    {
+        rfDll.rfFunc.rfDeleteEncodeSession(&rfSession);
+        return -1.0;
+    }
+
+    unsigned int uiFrame = 0;
+
+    const double dTime = measure([&]()
+    {
+        unsigned int    uiSize  = 0;
+        void*           pOutput = nullptr;
+
+        if (rfDll.rfFunc.rfEncodeFrame(rfSession, uiIndex[uiFrame % 2]) != RF_STATUS_OK ||
+            rfDll.rfFunc.rfGetEncodedFrame(rfSession, &uiSize, &pOutput) != RF_STATUS_OK)
+        {
+            return false;
+        }
+
+        if (uiFrame < Outputs.size())
+        {
+            Outputs[uiFrame].assign(static_cast<unsigned char*>(pOutput), static_cast<unsigned char*>(pOutput) + uiSize);
+        }
+
+        ++uiFrame;
+
+        return true;
+    });
+
+    rfDll.rfFunc.rfDeleteEncodeSession(&rfSession);
+
+    return dTime;
+}
+
+
+bool runDiffMapBenchmark()
+{
+    bool bPassed = true;
+
+    bPassed &= checkHostDiffMap(1920, 1080, 16, 16);
+    bPassed &= checkHostDiffMap(1366, 767, 16, 16);
+    bPassed &= checkHostDiffMap(1366, 767, 32, 8);
+    bPassed &= checkHostDiffMap(1023, 511, 8, 8);
+
+    const RFWrapper& rfDll = RFWrapper::getInstance();
+
+    if (!rfDll)
+    {
+        cout << "   RapidFire could not be loaded, only RFDiffMapHost is measured" << endl;
+    }
+
+    for (unsigned int i = 0; i < g_uiNumBenchmarkSizes; ++i)
+    {
+        const unsigned int uiWidth  = g_BenchmarkSizes[i].uiWidth;
+        const unsigned int uiHeight = g_BenchmarkSizes[i].uiHeight;
+
+        vector<unsigned char> Image1;
+        vector<unsigned char> Image2;
+
+        createDesktopImage(uiWidth, uiHeight, i, Image1);
+
+        // Change the text of every tenth line of text, which touches about 10% of the blocks of the window.
+        Image2 = Image1;
+
+        for (unsigned int y = 0; y < uiHeight; y += 200)
+        {
+            for (unsigned int j = y * uiWidth * 4; j < min(y + 14, uiHeight) * uiWidth * 4; ++j)
+            {
+                Image2[j] = static_cast<unsigned char>(255 - Image2[j]);
+            }
+        }
+
+        RFDiffMapHost           diff;
+        vector<unsigned char>   DiffMap(((uiWidth + BLOCK_WIDTH - 1) / BLOCK_WIDTH) * ((uiHeight + BLOCK_HEIGHT - 1) / BLOCK_HEIGHT));
+
+        diff.setDimension(uiWidth, uiHeight, BLOCK_WIDTH, BLOCK_HEIGHT);
+
+        const double dUnchanged = measure([&]() { return diff.computeDiffMap(Image1.data(), Image1.data(), DiffMap.data()); });
+        const double dChanged   = measure([&]() { return diff.computeDiffMap(Image1.data(), Image2.data(), DiffMap.data()); });
+
+        cout << "   " << setw(6) << g_BenchmarkSizes[i].strName << " RFDiffMapHost (" << diff.getInstructionSet() << "): " << fixed << setprecision(3)
+             << dUnchanged << " ms unchanged, " << dChanged << " ms with changed lines" << endl;
+
+        if (!rfDll)
+        {
+            continue;
+        }
+
+        vector<vector<unsigned char>> HostOutputs(4);
+        vector<vector<unsigned char>> CLOutputs(4);
+
+        const double dHostSession = measureSession(rfDll, true, uiWidth, uiHeight, Image1, Image2, HostOutputs);
+        const double dCLSession   = measureSession(rfDll, false, uiWidth, uiHeight, Image1, Image2, CLOutputs);
+
+        if (dHostSession < 0.0 || dCLSession < 0.0)
+        {
+            cerr << "   Failed to run the host memory sessions" << endl;
+            continue;
+        }
+
+        const bool bMatch = (HostOutputs == CLOutputs);
+
+        bPassed &= bMatch;
+
+        cout << "   " << setw(6) << g_BenchmarkSizes[i].strName << " session with RF_DIFF_ENCODER_HOST_DIFF: " << dHostSession << " ms, with OpenCL: "
+             << dCLSession << " ms, diff maps " << (bMatch ? "match" : "DIFFER") << endl;
+    }
+
+    return bPassed;
+}
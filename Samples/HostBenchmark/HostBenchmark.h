@@ -0,0 +1,54 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+// Dimension of the frames used by the benchmarks.
+struct BenchmarkSize
+{
+    unsigned int    uiWidth;
+    unsigned int    uiHeight;
+    const char*     strName;
+};
+
+extern const BenchmarkSize  g_BenchmarkSizes[];
+extern const unsigned int   g_uiNumBenchmarkSizes;
+
+// Fills Image with uiSize pseudo random bytes. The same seed always produces the same bytes.
+void    createRandomImage(unsigned int uiSize, unsigned int uiSeed, std::vector<unsigned char>& Image);
+
+// Fills Image with an RGBA8 image that resembles a desktop: flat areas, gradients and lines of text-like noise.
+void    createDesktopImage(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiSeed, std::vector<unsigned char>& Image);
+
+// Calls fn until it was called at least uiMinIterations times and fMinTime seconds have passed. Returns the average
+// time of a call in ms or a negative value if a call returned false.
+double  measure(const std::function<bool()>& fn, unsigned int uiMinIterations = 10, float fMinTime = 1.0f);
+
+// Each benchmark prints its results and returns false if a result does not match the reference.
+bool    runCSCBenchmark();
+bool    runNV12KernelBenchmark();
+bool    runDiffMapBenchmark();
+bool    runCompressionBenchmark();
+bool    runQueueBenchmark();
@@ -0,0 +1,186 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// Measures the contention of RFSpscQueue between the encoding and the reading thread.
+//
+// A producer thread pushes a sequence of elements while a consumer thread pops them, like
+// encodeFrame and getEncodedFrame of the encoders. Both threads yield if the queue is full
+// or empty. RFSpscQueue is compared to a std::queue protected by an RFLock, which the
+// encoders used before, for the capacities of the default number of target buffers and of
+// a deep queue. The consumer checks that the elements arrive complete and in order.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <iomanip>
+#include <iostream>
+#include <queue>
+#include <thread>
+
+#include "HostBenchmark.h"
+#include "RFLock.h"
+#include "RFSpscQueue.h"
+
+using namespace std;
+
+#define NUM_ELEMENTS    100000
+
+
+// RFLockedQueue the encoders used before RFSpscQueue. It takes an RFLock for every operation and push fails if
+// uiCapacity elements are queued, like the encoders limited the queue before.
+template <class T>
+class RFLockedQueue
+{
+public:
+
+    RFLockedQueue()
+        : m_uiCapacity(0)
+    {}
+
+    bool init(size_t uiCapacity)
+    {
+        m_uiCapacity = uiCapacity;
+
+        return true;
+    }
+
+    size_t size()
+    {
+        RFReadWriteAccess Access(&m_Lock);
+
+        return m_Queue.size();
+    }
+
+    bool push(const T& elem)
+    {
+        RFReadWriteAccess Access(&m_Lock);
+
+        if (m_Queue.size() >= m_uiCapacity)
+        {
+            return false;
+        }
+
+        m_Queue.push(elem);
+
+        return true;
+    }
+
+    T pop()
+    {
+        RFReadWriteAccess Access(&m_Lock);
+
+        if (m_Queue.empty())
+        {
+            return T();
+        }
+
+        T elem = m_Queue.front();
+
+        m_Queue.pop();
+
+        return elem;
+    }
+
+private:
+
+    RFLock          m_Lock;
+    std::queue<T>   m_Queue;
+    size_t          m_uiCapacity;
+};
+
+
+// Transfers NUM_ELEMENTS elements from a producer thread to the calling thread. Returns false if an element was lost
+// or arrived out of order.
+template <class Queue>
+static bool transfer(Queue& q)
+{
+    thread Producer([&q]()
+    {
+        for (size_t i = 1; i <= NUM_ELEMENTS; ++i)
+        {
+            while (!q.push(i))
+            {
+                this_thread::yield();
+            }
+        }
+    });
+
+    bool bInOrder = true;
+
+    for (size_t uiExpected = 1; uiExpected <= NUM_ELEMENTS; ++uiExpected)
+    {
+        // Poll the size first like the readers of the encoders do.
+        while (q.size() == 0)
+        {
+            this_thread::yield();
+        }
+
+        bInOrder &= (q.pop() == uiExpected);
+    }
+
+    Producer.join();
+
+    return (bInOrder && q.size() == 0);
+}
+
+
+template <class Queue>
+static double measureQueue(size_t uiCapacity)
+{
+    Queue q;
+
+    if (!q.init(uiCapacity))
+    {
+        return -1.0;
+    }
+
+    return measure([&q]() { return transfer(q); });
+}
+
+
+bool runQueueBenchmark()
+{
+    // 3 is the default number of target buffers of the encoders.
+    const size_t uiCapacities[] = { 3, 16 };
+
+    bool bPassed = true;
+
+    for (size_t uiCapacity : uiCapacities)
+    {
+        const double dSpsc   = measureQueue<RFSpscQueue<size_t>>(uiCapacity);
+        const double dLocked = measureQueue<RFLockedQueue<size_t>>(uiCapacity);
+
+        if (dSpsc < 0.0 || dLocked < 0.0)
+        {
+            cerr << "   Elements were lost or reordered with capacity " << uiCapacity << endl;
+
+            bPassed = false;
+            continue;
+        }
+
+        // measure returns ms for NUM_ELEMENTS elements.
+        cout << "   Capacity " << setw(2) << uiCapacity << ": RFSpscQueue " << fixed << setprecision(1) << dSpsc * 1000000.0 / NUM_ELEMENTS
+             << " ns, locked std::queue " << dLocked * 1000000.0 / NUM_ELEMENTS << " ns per element" << endl;
+    }
+
+    return bPassed;
+}
@@ -0,0 +1,180 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+/////////////////////////////////////////////////////////////////////////////////////////
+//
+// HostBenchmark measures the CPU paths RapidFire uses for sessions with RF_HOST_MEMORY
+// and the OpenCL kernel variants, and checks their results against a reference of the
+// math of the OpenCL kernels.
+//
+// The benchmarks are selected by the command line, without arguments all are run:
+// csc:      RFCSCHost compared to rgbaTonv12_image2d including upload and readback.
+// nv12:     rgbaTonv12_image2d compared to the vec8 and tiled kernels without transfers.
+// diff:     RFDiffMapHost compared to the OpenCL difference encoder of a host memory session.
+// compress: RFCompressor with an increasing number of threads.
+// queue:    RFSpscQueue compared to a locked std::queue between two threads.
+//
+// The benchmark compiles the RapidFire sources it measures. It is always built with
+// optimizations, the Debug configurations of the solution build the Release configuration.
+/////////////////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include <iostream>
+
+#include "HostBenchmark.h"
+#include "RFUtils.h"
+
+using namespace std;
+
+const BenchmarkSize g_BenchmarkSizes[] = { { 1920, 1080, "1080p" }, { 3840, 2160, "4K" } };
+const unsigned int  g_uiNumBenchmarkSizes = sizeof(g_BenchmarkSizes) / sizeof(g_BenchmarkSizes[0]);
+
+
+void createRandomImage(unsigned int uiSize, unsigned int uiSeed, std::vector<unsigned char>& Image)
+{
+    Image.resize(uiSize);
+
+    unsigned int uiState = uiSeed * 2654435761u + 1;
+
+    for (unsigned int i = 0; i < uiSize; ++i)
+    {
+        uiState = uiState * 1664525u + 1013904223u;
+        Image[i] = static_cast<unsigned char>(uiState >> 24);
+    }
+}
+
+
+void createDesktopImage(unsigned int uiWidth, unsigned int uiHeight, unsigned int uiSeed, std::vector<unsigned char>& Image)
+{
+    std::vector<unsigned char> Noise;
+
+    createRandomImage(uiWidth * uiHeight, uiSeed, Noise);
+
+    Image.resize(uiWidth * uiHeight * 4);
+
+    for (unsigned int y = 0; y < uiHeight; ++y)
+    {
+        for (unsigned int x = 0; x < uiWidth; ++x)
+        {
+            unsigned char* p = &Image[(y * uiWidth + x) * 4];
+
+            // The desktop background is a vertical gradient. A window covers the center, it has a title bar
+            // and lines of text.
+            p[0] = static_cast<unsigned char>(40 + (y * 60) / uiHeight);
+            p[1] = static_cast<unsigned char>(80 + (y * 60) / uiHeight);
+            p[2] = 160;
+            p[3] = 255;
+
+            if (x >= uiWidth / 8 && x < uiWidth * 7 / 8 && y >= uiHeight / 8 && y < uiHeight * 7 / 8)
+            {
+                const unsigned int uiWindowY = y - uiHeight / 8;
+
+                if (uiWindowY < 32)
+                {
+                    p[0] = 30;
+                    p[1] = 30;
+                    p[2] = static_cast<unsigned char>(100 + (x * 100) / uiWidth);
+                }
+                else if ((uiWindowY % 20) < 14 && ((x / 6 + uiWindowY / 20) % 11) != 0 && Noise[y * uiWidth + x] < 90)
+                {
+                    p[0] = p[1] = p[2] = 20;
+                }
+                else
+                {
+                    p[0] = p[1] = p[2] = 240;
+                }
+            }
+        }
+    }
+}
+
+
+double measure(const std::function<bool()>& fn, unsigned int uiMinIterations, float fMinTime)
+{
+    Timer        timer;
+    unsigned int uiIterations = 0;
+
+    // The first call is not measured, it allocates buffers and starts the threads.
+    if (!fn())
+    {
+        return -1.0;
+    }
+
+    timer.reset();
+
+    do
+    {
+        if (!fn())
+        {
+            return -1.0;
+        }
+
+        ++uiIterations;
+    } while (uiIterations < uiMinIterations || timer.getTime() < fMinTime);
+
+    return 1000.0 * timer.getTime() / uiIterations;
+}
+
+
+int main(int argc, char** argv)
+{
+    struct Benchmark
+    {
+        const char*     strName;
+        bool            (*pfnRun)();
+    };
+
+    const Benchmark Benchmarks[] = { { "csc",      runCSCBenchmark },
+                                     { "nv12",     runNV12KernelBenchmark },
+                                     { "diff",     runDiffMapBenchmark },
+                                     { "compress", runCompressionBenchmark },
+                                     { "queue",    runQueueBenchmark } };
+
+    bool bPassed = true;
+
+    for (const Benchmark& b : Benchmarks)
+    {
+        bool bSelected = (argc < 2);
+
+        for (int i = 1; i < argc; ++i)
+        {
+            bSelected |= (strcmp(argv[i], b.strName) == 0);
+        }
+
+        if (bSelected)
+        {
+            cout << "--- " << b.strName << " ---" << endl;
+
+            bPassed &= b.pfnRun();
+
+            cout << endl;
+        }
+    }
+
+    if (!bPassed)
+    {
+        cerr << "Results do not match the reference!" << endl;
+        return -1;
+    }
+
+    return 0;
+}